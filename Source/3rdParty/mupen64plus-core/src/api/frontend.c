@@ -38,6 +38,7 @@
 #include "m64p_types.h"
 #include "main/cheat.h"
 #include "main/eventloop.h"
+#include "main/guest_profiler.h"
 #include "main/main.h"
 #include "main/rom.h"
 #include "main/savestates.h"
@@ -218,6 +219,31 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
             cheat_delete_all(&g_cheat_ctx);
             cheat_uninit(&g_cheat_ctx);
             return close_disk();
+        case M64CMD_STATE_SAVE_MEMORY:
+            if (ParamInt != sizeof(m64p_state_memory) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            return main_state_save_memory((m64p_state_memory *) ParamPtr);
+        case M64CMD_STATE_LOAD_MEMORY:
+            if (ParamInt != sizeof(m64p_state_memory) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            return main_state_load_memory((m64p_state_memory *) ParamPtr);
+        case M64CMD_STATE_SNAPSHOTS_INIT:
+            if (ParamInt < 0)
+                return M64ERR_INPUT_INVALID;
+            return main_state_snapshots_init((unsigned int) ParamInt,
+                (ParamPtr == NULL) ? M64CODEC_NONE : *(m64p_state_codec *) ParamPtr);
+        case M64CMD_STATE_SNAPSHOT_SAVE:
+            if (ParamInt != sizeof(m64p_state_snapshot) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            return main_state_snapshot_save((m64p_state_snapshot *) ParamPtr);
+        case M64CMD_STATE_SNAPSHOT_LOAD:
+            if (ParamInt != sizeof(m64p_state_snapshot) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            return main_state_snapshot_load((m64p_state_snapshot *) ParamPtr);
+        case M64CMD_STATE_SNAPSHOTS_SET_BUDGET:
+            if (ParamInt < 0)
+                return M64ERR_INPUT_INVALID;
+            return main_state_snapshots_set_budget((unsigned int) ParamInt);
         case M64CMD_PIF_OPEN:
             if (g_EmulatorRunning)
                 return M64ERR_INVALID_STATE;
@@ -318,6 +344,18 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
         case M64CMD_SET_FRAME_CALLBACK:
             *(void**)&g_FrameCallback = ParamPtr;
             return M64ERR_SUCCESS;
+        case M64CMD_SET_INPUT_POLL_CALLBACK:
+            *(void**)&g_InputPollCallback = ParamPtr;
+            return M64ERR_SUCCESS;
+        case M64CMD_PROFILER_ENABLE:
+            guest_profiler_enable(ParamInt != 0);
+            return M64ERR_SUCCESS;
+        case M64CMD_PROFILER_REPORT:
+            if (ParamInt != sizeof(m64p_profile_report) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            if (((m64p_profile_report *) ParamPtr)->entries == NULL && ((m64p_profile_report *) ParamPtr)->size != 0)
+                return M64ERR_INPUT_INVALID;
+            return guest_profiler_report((m64p_profile_report *) ParamPtr);
         case M64CMD_TAKE_NEXT_SCREENSHOT:
             if (!g_EmulatorRunning)
                 return M64ERR_INVALID_STATE;
@@ -455,4 +493,28 @@ EXPORT m64p_error CALL CoreGetRomSettings(m64p_rom_settings *RomSettings, int Ro
     return M64ERR_SUCCESS;
 }
 
+EXPORT m64p_error CALL CoreProbeRom(const void *RomImage, int RomSize, m64p_rom_header *RomHeader, int RomHeaderLength, m64p_rom_settings *RomSettings, int RomSettingsLength)
+{
+    if (!l_CoreInit)
+        return M64ERR_NOT_INIT;
+    if (RomImage == NULL || RomHeader == NULL || RomSettings == NULL)
+        return M64ERR_INPUT_ASSERT;
+    if (RomSize <= 0 || RomHeaderLength < (int)sizeof(m64p_rom_header) || RomSettingsLength < (int)sizeof(m64p_rom_settings))
+        return M64ERR_INPUT_INVALID;
+
+    return probe_rom((const unsigned char *) RomImage, (unsigned int) RomSize, RomHeader, RomSettings);
+}
+
+EXPORT m64p_error CALL CoreProbeRomStream(int RomSize, int (*ReadCallback)(void *, unsigned char *, int), void *Context, m64p_rom_header *RomHeader, int RomHeaderLength, m64p_rom_settings *RomSettings, int RomSettingsLength)
+{
+    if (!l_CoreInit)
+        return M64ERR_NOT_INIT;
+    if (ReadCallback == NULL || RomHeader == NULL || RomSettings == NULL)
+        return M64ERR_INPUT_ASSERT;
+    if (RomSize <= 0 || RomHeaderLength < (int)sizeof(m64p_rom_header) || RomSettingsLength < (int)sizeof(m64p_rom_settings))
+        return M64ERR_INPUT_INVALID;
+
+    return probe_rom_stream((unsigned int) RomSize, ReadCallback, Context, RomHeader, RomSettings);
+}
+
 
@@ -133,6 +133,27 @@ typedef m64p_error (*ptr_CoreGetRomSettings)(m64p_rom_settings *, int, int, int)
 EXPORT m64p_error CALL CoreGetRomSettings(m64p_rom_settings *, int, int, int);
 #endif
 
+/* CoreProbeRom()
+ *
+ * This function will retrieve the ROM header and the ROM settings of the given
+ * ROM image without opening it. It doesn't change the state of the core, so it
+ * may be called from several threads at the same time.
+ */
+typedef m64p_error (*ptr_CoreProbeRom)(const void *, int, m64p_rom_header *, int, m64p_rom_settings *, int);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL CoreProbeRom(const void *, int, m64p_rom_header *, int, m64p_rom_settings *, int);
+#endif
+
+/* CoreProbeRomStream()
+ *
+ * This function is the same as CoreProbeRom(), but the ROM image is read in
+ * parts with the given callback, so the ROM image doesn't have to be in memory.
+ */
+typedef m64p_error (*ptr_CoreProbeRomStream)(int, int (*)(void *, unsigned char *, int), void *, m64p_rom_header *, int, m64p_rom_settings *, int);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL CoreProbeRomStream(int, int (*)(void *, unsigned char *, int), void *, m64p_rom_header *, int, m64p_rom_settings *, int);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,7 @@
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rcp/vi/vi_controller.h"
 #include "device/rdram/rdram.h"
+#include "main/main.h"
 #include "main/rom.h"
 #include "plugin/plugin.h"
 
@@ -45,8 +46,15 @@ static void audio_plugin_push_samples(void* aout, const void* buffer, size_t siz
 {
     /* abuse core & audio plugin implementation to approximate desired effect */
     struct ai_controller* ai = (struct ai_controller*)aout;
-    uint32_t saved_ai_length = ai->regs[AI_LEN_REG];
-    uint32_t saved_ai_dram = ai->regs[AI_DRAM_ADDR_REG];
+    uint32_t saved_ai_length;
+    uint32_t saved_ai_dram;
+
+    /* resimulated frames have already been heard */
+    if (main_is_resimulating())
+        return;
+
+    saved_ai_length = ai->regs[AI_LEN_REG];
+    saved_ai_dram = ai->regs[AI_DRAM_ADDR_REG];
 
     /* exploit the fact that buffer points in g_dev.rdram.dram to retreive dram_addr_reg value */
     ai->regs[AI_DRAM_ADDR_REG] = (uint32_t)((uint8_t*)buffer - (uint8_t*)ai->ri->rdram->dram);
@@ -65,6 +65,10 @@ static m64p_error input_plugin_get_input(void* opaque, uint32_t* input_)
     {
         if (input.getKeys)
             input.getKeys(cin_compat->control_id, &keys);
+
+        /* let the front-end record or replace the input */
+        if (g_InputPollCallback != NULL)
+            g_InputPollCallback(cin_compat->control_id, &keys.Value);
     }
     else
     {
@@ -21,6 +21,7 @@
 
 #include "device.h"
 
+#include "main/guest_profiler.h"
 #include "main/util.h"
 #include "memory/memory.h"
 #include "pif/pif.h"
@@ -129,6 +130,7 @@ void init_device(struct device* dev,
         { &dev->dd,        dd_mecha_int_handler        }, /* DD MECHA */
         { &dev->dd,        dd_bm_int_handler           }, /* DD BM */
         { &dev->dd,        dd_dv_int_handler           }, /* DD DRIVE */
+        { &dev->r4300,     guest_profiler_event        }, /* PROFILER */
     };
 
 #define R(x) read_ ## x
@@ -178,10 +180,11 @@ void init_device(struct device* dev,
 #undef W
 #undef RW
 
-    init_memory(&dev->mem, mappings, ARRAY_SIZE(mappings), base, &dbg_handler);
-
+    /* the RDRAM size has to be known when the RDRAM handlers are mapped */
     init_rdram(&dev->rdram, mem_base_u32(base, MM_RDRAM_DRAM), dram_size, &dev->r4300);
 
+    init_memory(&dev->mem, mappings, ARRAY_SIZE(mappings), base, &dbg_handler);
+
     init_r4300(&dev->r4300, &dev->mem, &dev->mi, &dev->rdram, interrupt_handlers,
             emumode, count_per_op, count_per_op_denom_pot, no_compiled_jump, randomize_interrupt, start_address);
     init_rdp(&dev->dp, &dev->sp, &dev->mi, &dev->mem, &dev->rdram, &dev->r4300);
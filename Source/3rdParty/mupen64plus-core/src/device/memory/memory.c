@@ -27,10 +27,9 @@
 #include "device/device.h"
 #include "device/rcp/rsp/rsp_core.h"
 #include "device/pif/pif.h"
+#include "device/rdram/rdram.h"
 
 #ifdef DBG
-#include <string.h>
-
 #include "device/r4300/r4300_core.h"
 
 #include "debugger/dbg_breakpoints.h"
@@ -41,11 +40,14 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef _WIN32
 #include <malloc.h>
 #endif
 
+static void update_fast_rdram_region(struct memory* mem, uint16_t region);
+
 #ifdef DBG
 enum
 {
@@ -97,6 +99,7 @@ void activate_memory_break_read(struct memory* mem, uint32_t address)
 
     /* activate bp read */
     *bp_check |= BP_CHECK_READ;
+    update_fast_rdram_region(mem, region);
 }
 
 void deactivate_memory_break_read(struct memory* mem, uint32_t address)
@@ -113,6 +116,7 @@ void deactivate_memory_break_read(struct memory* mem, uint32_t address)
     if (!(*bp_check & (BP_CHECK_READ | BP_CHECK_WRITE))) {
         *handler = *saved_handler;
     }
+    update_fast_rdram_region(mem, region);
 }
 
 void activate_memory_break_write(struct memory* mem, uint32_t address)
@@ -131,6 +135,7 @@ void activate_memory_break_write(struct memory* mem, uint32_t address)
 
     /* activate bp write */
     *bp_check |= BP_CHECK_WRITE;
+    update_fast_rdram_region(mem, region);
 }
 
 void deactivate_memory_break_write(struct memory* mem, uint32_t address)
@@ -147,6 +152,7 @@ void deactivate_memory_break_write(struct memory* mem, uint32_t address)
     if (!(*bp_check & (BP_CHECK_READ | BP_CHECK_WRITE))) {
         *handler = *saved_handler;
     }
+    update_fast_rdram_region(mem, region);
 }
 
 int get_memory_type(struct memory* mem, uint32_t address)
@@ -176,6 +182,7 @@ void init_memory(struct memory* mem,
 #endif
 
     mem->base = base;
+    memset(mem->fast_rdram, 0, sizeof(mem->fast_rdram));
 
     for(m = 0; m < mappings_count; ++m) {
         apply_mem_mapping(mem, &mappings[m]);
@@ -204,6 +211,33 @@ static void map_region(struct memory* mem,
         (void)type;
         mem->handlers[region] = *handler;
     }
+
+    update_fast_rdram_region(mem, region);
+}
+
+/* RDRAM regions mapped to the plain RDRAM handlers don't need them,
+ * the handlers can be replaced by the framebuffer handlers, the
+ * corrupted RDRAM handler or the breakpoint handler at any time */
+static void update_fast_rdram_region(struct memory* mem, uint16_t region)
+{
+    const struct mem_handler* handler = &mem->handlers[region];
+    unsigned char fast = 0;
+
+    if (region >= (RDRAM_MAX_SIZE >> 16)) {
+        return;
+    }
+
+    if (handler->read32 == read_rdram_dram
+     && ((uint32_t)region << 16) < ((const struct rdram*)handler->opaque)->dram_size) {
+        fast |= MEM_FAST_READ;
+    }
+
+    if (handler->write32 == write_rdram_dram
+     && ((uint32_t)region << 16) < ((const struct rdram*)handler->opaque)->dram_size) {
+        fast |= MEM_FAST_WRITE;
+    }
+
+    mem->fast_rdram[region] = fast;
 }
 
 void apply_mem_mapping(struct memory* mem, const struct mem_mapping* mapping)
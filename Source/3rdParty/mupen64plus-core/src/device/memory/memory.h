@@ -49,11 +49,23 @@ struct mem_mapping
     struct mem_handler handler;
 };
 
+/* flags of the RDRAM regions the r4300 accesses directly */
+enum
+{
+    MEM_FAST_READ  = 0x1,
+    MEM_FAST_WRITE = 0x2,
+};
+
 struct memory
 {
     struct mem_handler handlers[0x10000];
     void* base;
 
+    /* RDRAM regions which are mapped to the plain RDRAM handlers,
+     * these are read and written by the r4300 without going
+     * through the handlers, see update_fast_rdram_region() */
+    unsigned char fast_rdram[RDRAM_MAX_SIZE >> 16];
+
 #ifdef DBG
     int memtype[0x10000];
     unsigned char bp_checks[0x10000];
@@ -34,6 +34,7 @@
 #include "api/m64p_types.h"
 #include "device/r4300/r4300_core.h"
 #include "device/r4300/idec.h"
+#include "device/r4300/idle_loop.h"
 #include "main/main.h"
 #include "osal/preproc.h"
 
@@ -66,6 +67,33 @@
 #endif
 #define DECLARE_INSTRUCTION(name) void cached_interp_##name(void)
 
+/* Checks the loads of the idle loop ending with the current
+ * instruction, which are only known when the loop runs */
+static int cached_interp_idle_loop_is_stable(struct r4300_core* r4300, uint32_t target)
+{
+    const struct precomp_instr* inst = r4300->cached_interp.actual->block + ((target - r4300->cached_interp.actual->start) >> 2);
+    const struct precomp_instr* end = (*r4300_pc_struct(r4300)) + 2;
+
+    for (; inst < end; ++inst)
+    {
+        if (inst->ops == cached_interp_NOTCOMPILED || inst->ops == cached_interp_NOTCOMPILED2) {
+            return 0;
+        }
+
+        if (inst->ops == cached_interp_LB || inst->ops == cached_interp_LBU
+         || inst->ops == cached_interp_LH || inst->ops == cached_interp_LHU
+         || inst->ops == cached_interp_LW || inst->ops == cached_interp_LWU
+         || inst->ops == cached_interp_LD)
+        {
+            if (!r4300_idle_loop_address_is_stable((uint32_t)(*inst->f.i.rs + inst->f.i.immediate))) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
 #define DECLARE_JUMP(name, destination, condition, link, likely, cop1) \
 void cached_interp_##name(void) \
 { \
@@ -139,8 +167,9 @@ void cached_interp_##name##_IDLE(void) \
     uint32_t* cp0_regs = r4300_cp0_regs(&r4300->cp0); \
     int* cp0_cycle_count = r4300_cp0_cycle_count(&r4300->cp0); \
     const int take_jump = (condition); \
+    const uint32_t jump_target = (destination); \
     if (cop1 && check_cop1_unusable(r4300)) return; \
-    if (take_jump) \
+    if (take_jump && cached_interp_idle_loop_is_stable(r4300, jump_target)) \
     { \
         cp0_update_count(r4300); \
         if(*cp0_cycle_count < 0) \
@@ -861,6 +890,11 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
         /* decode instruction */
         opcode = r4300_decode(inst, r4300, r4300_get_idec(iw[i]), iw[i], iw[i+1], block);
 
+        /* use the idle version of branches closing a polling loop */
+        if (r4300_get_idle_loop_type(iw, i, length, block->start) != IDLE_LOOP_NONE) {
+            inst->ops = ci_table[opcode + 1];
+        }
+
         /* decode ending conditions */
         if (i >= length2) { finished = 2; }
         if (i >= (length-1)
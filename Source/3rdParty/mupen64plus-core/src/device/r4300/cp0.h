@@ -140,7 +140,7 @@ enum r4300_cp0_registers
 
 
 
-enum { INTERRUPT_NODES_POOL_CAPACITY = 16 };
+enum { INTERRUPT_NODES_POOL_CAPACITY = 17 };
 
 struct interrupt_event
 {
@@ -173,7 +173,7 @@ struct interrupt_handler
     void (*callback)(void*);
 };
 
-enum { CP0_INTERRUPT_HANDLERS_COUNT = 16 };
+enum { CP0_INTERRUPT_HANDLERS_COUNT = 17 };
 
 enum {
     INTR_UNSAFE_R4300 = 0x01,
@@ -0,0 +1,322 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - idle_loop.c                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "idle_loop.h"
+
+#include "device/device.h"
+#include "device/r4300/idec.h"
+#include "device/rcp/mi/mi_controller.h"
+#include "device/rcp/pi/pi_controller.h"
+#include "device/rcp/rsp/rsp_core.h"
+#include "device/rcp/si/si_controller.h"
+#include "device/rdram/rdram.h"
+
+/* longest loop which is analyzed, including its delay slot */
+enum { IDLE_LOOP_MAX_LENGTH = 16 };
+
+#define IW_RS(iw) (((iw) >> 21) & 0x1f)
+#define IW_RT(iw) (((iw) >> 16) & 0x1f)
+#define IW_RD(iw) (((iw) >> 11) & 0x1f)
+#define IW_IMM(iw) ((uint32_t)(int16_t)(iw))
+
+struct idle_loop_instr
+{
+    /* registers read and written by the instruction */
+    uint32_t reads;
+    uint32_t writes;
+};
+
+/* Decodes the registers used by an instruction of an idle loop,
+ * returns 0 if the instruction can't be part of one. */
+static int decode_idle_loop_instr(uint32_t iw, struct idle_loop_instr* instr)
+{
+    instr->reads = 0;
+    instr->writes = 0;
+
+    switch (r4300_get_idec(iw)->opcode)
+    {
+    case R4300_OP_NOP:
+        break;
+
+    /* loads, their address is checked separately */
+    case R4300_OP_LB:
+    case R4300_OP_LBU:
+    case R4300_OP_LH:
+    case R4300_OP_LHU:
+    case R4300_OP_LW:
+    case R4300_OP_LWU:
+    case R4300_OP_LD:
+    /* ALU operations without exceptions */
+    case R4300_OP_ADDIU:
+    case R4300_OP_DADDIU:
+    case R4300_OP_ANDI:
+    case R4300_OP_ORI:
+    case R4300_OP_XORI:
+    case R4300_OP_SLTI:
+    case R4300_OP_SLTIU:
+        instr->reads = UINT32_C(1) << IW_RS(iw);
+        instr->writes = UINT32_C(1) << IW_RT(iw);
+        break;
+
+    case R4300_OP_LUI:
+        instr->writes = UINT32_C(1) << IW_RT(iw);
+        break;
+
+    case R4300_OP_ADDU:
+    case R4300_OP_SUBU:
+    case R4300_OP_AND:
+    case R4300_OP_OR:
+    case R4300_OP_XOR:
+    case R4300_OP_NOR:
+    case R4300_OP_SLT:
+    case R4300_OP_SLTU:
+    case R4300_OP_DADDU:
+    case R4300_OP_DSUBU:
+    case R4300_OP_SLLV:
+    case R4300_OP_SRLV:
+    case R4300_OP_SRAV:
+    case R4300_OP_DSLLV:
+    case R4300_OP_DSRLV:
+    case R4300_OP_DSRAV:
+        instr->reads = (UINT32_C(1) << IW_RS(iw)) | (UINT32_C(1) << IW_RT(iw));
+        instr->writes = UINT32_C(1) << IW_RD(iw);
+        break;
+
+    case R4300_OP_SLL:
+    case R4300_OP_SRL:
+    case R4300_OP_SRA:
+    case R4300_OP_DSLL:
+    case R4300_OP_DSRL:
+    case R4300_OP_DSRA:
+    case R4300_OP_DSLL32:
+    case R4300_OP_DSRL32:
+    case R4300_OP_DSRA32:
+        instr->reads = UINT32_C(1) << IW_RT(iw);
+        instr->writes = UINT32_C(1) << IW_RD(iw);
+        break;
+
+    default:
+        return 0;
+    }
+
+    /* r0 is constant */
+    instr->reads &= ~UINT32_C(1);
+    instr->writes &= ~UINT32_C(1);
+    return 1;
+}
+
+static int is_idle_loop_load(uint32_t iw)
+{
+    switch (r4300_get_idec(iw)->opcode)
+    {
+    case R4300_OP_LB:
+    case R4300_OP_LBU:
+    case R4300_OP_LH:
+    case R4300_OP_LHU:
+    case R4300_OP_LW:
+    case R4300_OP_LWU:
+    case R4300_OP_LD:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Returns the target of the branch or jump closing a loop, the branches
+ * which link aren't accepted because loops don't call functions */
+static int get_idle_loop_branch_target(uint32_t iw, uint32_t pc, uint32_t* target, struct idle_loop_instr* instr)
+{
+    instr->reads = 0;
+    instr->writes = 0;
+
+    switch (r4300_get_idec(iw)->opcode)
+    {
+    case R4300_OP_BEQ:
+    case R4300_OP_BEQL:
+    case R4300_OP_BNE:
+    case R4300_OP_BNEL:
+        instr->reads = (UINT32_C(1) << IW_RT(iw));
+        /* fallthrough */
+    case R4300_OP_BLEZ:
+    case R4300_OP_BLEZL:
+    case R4300_OP_BGTZ:
+    case R4300_OP_BGTZL:
+    case R4300_OP_BLTZ:
+    case R4300_OP_BLTZL:
+    case R4300_OP_BGEZ:
+    case R4300_OP_BGEZL:
+        instr->reads |= (UINT32_C(1) << IW_RS(iw));
+        *target = pc + 4 + (IW_IMM(iw) << 2);
+        break;
+
+    case R4300_OP_J:
+        *target = ((pc + 4) & UINT32_C(0xf0000000)) | ((iw & UINT32_C(0x3ffffff)) << 2);
+        break;
+
+    default:
+        return 0;
+    }
+
+    instr->reads &= ~UINT32_C(1);
+    return 1;
+}
+
+enum idle_loop_type r4300_get_idle_loop_type(const uint32_t* iw, size_t index, size_t count, uint32_t start)
+{
+    struct idle_loop_instr instrs[IDLE_LOOP_MAX_LENGTH];
+    struct idle_loop_instr branch;
+    uint32_t values[32];
+    uint32_t known = UINT32_C(1);
+    uint32_t written = 0;
+    uint32_t loop_writes = 0;
+    uint32_t pc = start + (uint32_t)index * 4;
+    uint32_t target;
+    size_t first, length, i;
+    enum idle_loop_type type = IDLE_LOOP_STABLE;
+
+    /* the delay slot has to be known */
+    if (index + 1 >= count) {
+        return IDLE_LOOP_NONE;
+    }
+
+    if (!get_idle_loop_branch_target(iw[index], pc, &target, &branch)) {
+        return IDLE_LOOP_NONE;
+    }
+
+    /* only backward loops within iw */
+    if (target >= pc || target < start || (target & 3) != 0) {
+        return IDLE_LOOP_NONE;
+    }
+
+    first = (target - start) / 4;
+    length = index - first + 2;
+    if (length > IDLE_LOOP_MAX_LENGTH) {
+        return IDLE_LOOP_NONE;
+    }
+
+    /* the loop body, the branch and its delay slot */
+    for (i = 0; i < length; ++i)
+    {
+        size_t n = first + i;
+
+        if (n == index) {
+            instrs[i] = branch;
+        }
+        else if (!decode_idle_loop_instr(iw[n], &instrs[i])) {
+            return IDLE_LOOP_NONE;
+        }
+
+        loop_writes |= instrs[i].writes;
+    }
+
+    /* every register which is written by the loop has to be written before
+     * it's read in each iteration, so each iteration computes the same values */
+    for (i = 0; i < length; ++i)
+    {
+        if (instrs[i].reads & loop_writes & ~written) {
+            return IDLE_LOOP_NONE;
+        }
+
+        written |= instrs[i].writes;
+    }
+
+    /* the cached interpreter checks the addresses of the loads with the
+     * registers of the end of the loop, so their base registers can't be
+     * written by the load itself or after it */
+    written = 0;
+    for (i = length; i-- > 0; )
+    {
+        uint32_t w = iw[first + i];
+
+        written |= instrs[i].writes;
+        if (first + i != index && is_idle_loop_load(w) && ((written >> IW_RS(w)) & 1)) {
+            return IDLE_LOOP_NONE;
+        }
+    }
+
+    /* the addresses of the loads are stable when they're computed
+     * by the loop itself from constants */
+    values[0] = 0;
+    for (i = 0; i < length; ++i)
+    {
+        uint32_t w = iw[first + i];
+        uint32_t rs = IW_RS(w);
+        uint32_t rt = IW_RT(w);
+
+        if (first + i == index) {
+            continue;
+        }
+
+        if (is_idle_loop_load(w))
+        {
+            if (!((known >> rs) & 1)) {
+                type = IDLE_LOOP_DYNAMIC;
+            }
+            else if (!r4300_idle_loop_address_is_stable(values[rs] + IW_IMM(w))) {
+                return IDLE_LOOP_NONE;
+            }
+        }
+
+        switch (r4300_get_idec(w)->opcode)
+        {
+        case R4300_OP_LUI:
+            values[rt] = w << 16;
+            known |= UINT32_C(1) << rt;
+            break;
+        case R4300_OP_ADDIU:
+        case R4300_OP_DADDIU:
+            values[rt] = values[rs] + IW_IMM(w);
+            known = (known & ~(UINT32_C(1) << rt)) | (((known >> rs) & 1) << rt);
+            break;
+        case R4300_OP_ORI:
+            values[rt] = values[rs] | (w & 0xffff);
+            known = (known & ~(UINT32_C(1) << rt)) | (((known >> rs) & 1) << rt);
+            break;
+        default:
+            known &= ~instrs[i].writes;
+            break;
+        }
+
+        known |= UINT32_C(1);
+    }
+
+    return type;
+}
+
+int r4300_idle_loop_address_is_stable(uint32_t address)
+{
+    uint32_t paddr;
+
+    /* only KSEG0 and KSEG1, TLB mappings may change */
+    if ((address & UINT32_C(0xc0000000)) != UINT32_C(0x80000000)) {
+        return 0;
+    }
+
+    paddr = address & UINT32_C(0x1fffffff);
+
+    /* RDRAM and the status registers are only changed by CPU stores or
+     * events, registers like VI_CURRENT or AI_LEN change with the count */
+    return paddr < RDRAM_MAX_SIZE
+        || paddr == MM_MI_REGS + 4 * MI_INTR_REG
+        || paddr == MM_RSP_REGS + 4 * SP_STATUS_REG
+        || paddr == MM_PI_REGS + 4 * PI_STATUS_REG
+        || paddr == MM_SI_REGS + 4 * SI_STATUS_REG;
+}
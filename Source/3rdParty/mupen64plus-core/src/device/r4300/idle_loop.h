@@ -0,0 +1,53 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - idle_loop.h                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_R4300_IDLE_LOOP_H
+#define M64P_DEVICE_R4300_IDLE_LOOP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Idle loops are loops which only poll memory until an event changes it,
+ * such as waiting on a RAM flag set by an interrupt handler or on the
+ * busy bit of a DMA. Every iteration of such a loop computes the same
+ * values until the next event, so the CPU can skip straight to it.
+ */
+enum idle_loop_type
+{
+    IDLE_LOOP_NONE,
+    /* the loop loads from addresses which are known to be stable */
+    IDLE_LOOP_STABLE,
+    /* the loop loads from addresses which have to be checked
+     * with r4300_idle_loop_address_is_stable() when it runs */
+    IDLE_LOOP_DYNAMIC
+};
+
+/* Analyzes the loop closed by the backward branch or jump in iw[index].
+ * iw holds count instructions starting at the virtual address start.
+ * The loop has to start within iw and its delay slot has to be in iw too.
+ * Branches to themselves aren't handled here. */
+enum idle_loop_type r4300_get_idle_loop_type(const uint32_t* iw, size_t index, size_t count, uint32_t start);
+
+/* Returns whether the memory at the given virtual address can only
+ * change when an event is handled while the CPU runs an idle loop. */
+int r4300_idle_loop_address_is_stable(uint32_t address);
+
+#endif /* M64P_DEVICE_R4300_IDLE_LOOP_H */
@@ -43,6 +43,7 @@
 #include "device/r4300/recomp.h"
 #include "device/rcp/ai/ai_controller.h"
 #include "device/rcp/vi/vi_controller.h"
+#include "main/guest_profiler.h"
 #include "main/main.h"
 #include "main/savestates.h"
 
@@ -288,6 +289,19 @@ void translate_event_queue(struct cp0* cp0, unsigned int base)
     *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count;
 }
 
+/* The profiler event isn't part of the emulated state, so savestates
+ * are the same whether the profiler runs or not */
+unsigned int get_saved_next_interrupt(const struct cp0* cp0)
+{
+    struct node* e;
+
+    for (e = cp0->q.first; e != NULL && e->data.type == PROFILER_EVT; e = e->next);
+
+    return (e != NULL)
+        ? e->data.count
+        : 0;
+}
+
 int save_eventqueue_infos(const struct cp0* cp0, char *buf)
 {
     int len;
@@ -297,6 +311,9 @@ int save_eventqueue_infos(const struct cp0* cp0, char *buf)
 
     for (e = cp0->q.first; e != NULL; e = e->next)
     {
+        if (e->data.type == PROFILER_EVT)
+            continue;
+
         memcpy(buf + len    , &e->data.type , 4);
         memcpy(buf + len + 4, &e->data.count, 4);
         len += 8;
@@ -317,7 +334,8 @@ void load_eventqueue_infos(struct cp0* cp0, const char *buf)
     {
         int type = *((const unsigned int*)&buf[len]);
         unsigned int count = *((const unsigned int*)&buf[len+4]);
-        add_interrupt_event_count(cp0, type, count);
+        if (type != PROFILER_EVT)
+            add_interrupt_event_count(cp0, type, count);
         len += 8;
     }
 
@@ -656,6 +674,11 @@ void gen_interrupt(struct r4300_core* r4300)
             call_interrupt_handler(&r4300->cp0, 15);
             break;
 
+        case PROFILER_EVT:
+            remove_interrupt_event(&r4300->cp0);
+            call_interrupt_handler(&r4300->cp0, 16);
+            break;
+
         default:
             DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", r4300->cp0.q.first->data.type);
             remove_interrupt_event(&r4300->cp0);
@@ -663,8 +686,12 @@ void gen_interrupt(struct r4300_core* r4300)
             break;
     }
 
+    guest_profiler_update(r4300);
+
     if (!r4300->cp0.interrupt_unsafe_state)
     {
+        main_frame_safe_point();
+
         if (savestates_get_job() == savestates_job_save)
         {
             savestates_save();
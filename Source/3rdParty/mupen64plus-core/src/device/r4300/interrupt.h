@@ -44,6 +44,7 @@ int get_next_event_type(const struct interrupt_queue* q);
 unsigned int add_random_interrupt_time(struct r4300_core* r4300);
 void remove_interrupt_event(struct cp0* cp0);
 
+unsigned int get_saved_next_interrupt(const struct cp0* cp0);
 int save_eventqueue_infos(const struct cp0* cp0, char *buf);
 void load_eventqueue_infos(struct cp0* cp0, const char *buf);
 
@@ -69,5 +70,6 @@ void nmi_int_handler(void* opaque);
 #define DD_MC_INT   0x1000
 #define DD_BM_INT   0x2000
 #define DD_DV_INT   0x4000
+#define PROFILER_EVT 0x8000
 
 #endif /* M64P_DEVICE_R4300_INTERRUPT_H */
@@ -20,6 +20,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h> // needed for u_int, u_char, etc
@@ -29,25 +30,38 @@
 #define MAP_ANONYMOUS MAP_ANON
 #endif
 
+#define M64P_CORE_PROTOTYPES 1
 #include "new_dynarec.h"
 #include "api/m64p_types.h"
 #include "api/callbacks.h"
+#include "api/config.h"
+#include "api/m64p_config.h"
 #include "main/main.h"
 #include "main/rom.h"
 #include "device/memory/memory.h"
 #include "device/r4300/cached_interp.h"
 #include "device/r4300/cp0.h"
 #include "device/r4300/cp1.h"
+#include "device/r4300/idle_loop.h"
 #include "device/r4300/interrupt.h"
 #include "device/r4300/tlb.h"
 #include "device/r4300/fpu.h"
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/rsp/rsp_core.h"
+#include "device/rdram/rdram.h"
 
 #if !defined(WIN32)
 #include <sys/mman.h>
 #endif
 
+#if defined(__linux__) && !defined(RECOMP_DBG)
+#define JIT_SYMBOLS
+#include <elf.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
 #if defined(RECOMPILER_DEBUG) && !defined(RECOMP_DBG)
 void recomp_dbg_init(void);
 void recomp_dbg_cleanup(void);
@@ -185,6 +199,11 @@ void recomp_dbg_block(int addr);
 
 #define MAXBLOCK 4096
 #define MAX_OUTPUT_BLOCK_SIZE 262144
+#define HOT_BLOCK_HITS 4 // lookups after which an expiring block is translated again
+
+#if (1<<TARGET_SIZE_2) > NEW_DYNAREC_CACHE_MAX_SIZE
+#error The translation cache does not fit in extra_memory
+#endif
 #define CLOCK_DIVIDER g_dev.r4300.cp0.count_per_op
 
 struct regstat
@@ -212,6 +231,7 @@ struct ll_entry
   u_int reg32;
   u_int start;
   u_int length;
+  u_int hits; // number of times the block was looked up since it was added
 };
 
 /* linkage */
@@ -231,6 +251,7 @@ void *get_addr_ht(u_int vaddr);
 void *get_addr_32(u_int vaddr,u_int flags);
 
 static void load_regs_entry(int t);
+static void retain_hot_blocks(void);
 static void inline_readstub(int type,int i,u_int addr_const,char addr,struct regstat *i_regs,int target,int adj,u_int reglist);
 
 void *base_addr;
@@ -288,6 +309,26 @@ static int is_delayslot;
 static int cop1_usable;
 static char *copy;
 static int expirep;
+// The translation cache starts with the size set by DynarecCacheSize and
+// grows up to DynarecCacheMaxSize when too many of the blocks it has
+// expired have to be translated again
+static int target_size_2=TARGET_SIZE_2;
+static int max_target_size_2=TARGET_SIZE_2;
+static int cache_grow_checked;
+static u_int expired_vaddr[4096];
+// Hot blocks which expired, they are translated again right away
+// so they stay in the cache for another lap
+static u_int retain_vaddr[256];
+static int retain_count;
+static int retaining;
+static u_int cache_retained;
+static u_int cache_translations;
+static u_int cache_retranslations;
+static u_int cache_expirations;
+static u_int cache_hot_expirations;
+static u_int cache_wraps;
+static u_int lap_translations;
+static u_int lap_retranslations;
 static u_int dirty_entry_count;
 static u_int copy_size;
 static struct ll_entry* hash_table[65536][2];
@@ -2380,6 +2421,7 @@ static struct ll_entry *ll_add_32(struct ll_entry **head,int vaddr,u_int reg32,v
   new_entry->start=start;
   new_entry->copy=copy;
   new_entry->length=length;
+  new_entry->hits=0;
   new_entry->next=*head;
   *head=new_entry;
   return new_entry;
@@ -2391,6 +2433,20 @@ static struct ll_entry *ll_add(struct ll_entry **head,int vaddr,void *addr,void
   return ll_add_32(head,vaddr,0,addr,clean_addr,start,copy,length);
 }
 
+// Remember the blocks which expire from the cache, so the ones
+// which have to be translated again can be counted
+static void expire_entry(struct ll_entry *entry,int clean)
+{
+  expired_vaddr[(entry->vaddr>>2)&4095]=entry->vaddr;
+  if(clean) cache_expirations++;
+  if(entry->hits>=HOT_BLOCK_HITS) {
+    cache_hot_expirations++;
+    // Only unmapped blocks, mapped ones may not be there anymore
+    if(clean&&entry->vaddr>=0x80000000&&entry->vaddr<0xC0000000&&retain_count<256)
+      retain_vaddr[retain_count++]=entry->vaddr;
+  }
+}
+
 static void ll_remove_matching_addrs(struct ll_entry **head,intptr_t addr,int shift)
 {
   struct ll_entry **cur=head;
@@ -2399,6 +2455,10 @@ static void ll_remove_matching_addrs(struct ll_entry **head,intptr_t addr,int sh
     if((((uintptr_t)((*cur)->addr)-(uintptr_t)base_addr)>>shift)==((addr-(uintptr_t)base_addr)>>shift) ||
        (((uintptr_t)((*cur)->addr)-(uintptr_t)base_addr-MAX_OUTPUT_BLOCK_SIZE)>>shift)==((addr-(uintptr_t)base_addr)>>shift))
     {
+      if(head>=jump_in&&head<(jump_in+4096))
+        expire_entry(*cur,1);
+      else if(head>=jump_dirty&&head<(jump_dirty+4096))
+        expire_entry(*cur,0);
       if((*cur)->addr!=(*cur)->clean_addr){ //jump_dirty
         assert(head>=jump_dirty&&head<(jump_dirty+4096));
         u_int length=(*cur)->length;
@@ -2490,6 +2550,7 @@ static struct ll_entry *get_clean(struct r4300_core* r4300,u_int vaddr,u_int fla
   head=jump_in[page];
   while(head!=NULL) {
     if(head->vaddr==vaddr&&(head->reg32&flags)==0) {
+      head->hits++;
       return head;
     }
     head=head->next;
@@ -2510,7 +2571,7 @@ static struct ll_entry *get_dirty(struct r4300_core* r4300,u_int vaddr,u_int fla
   while(head!=NULL) {
     if(head->vaddr==vaddr&&(head->reg32&flags)==0) {
       // Don't restore blocks which are about to expire from the cache
-      if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
+      if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-target_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-target_size_2))) {
         if(verify_dirty(head)==0) {
           r4300->cached_interp.invalid_code[vaddr>>12]=0;
           r4300->new_dynarec_hot_state.memory_map[vaddr>>12]|=WRITE_PROTECT;
@@ -2522,6 +2583,7 @@ static struct ll_entry *get_dirty(struct r4300_core* r4300,u_int vaddr,u_int fla
             restore_candidate[vpage>>3]|=1<<(vpage&7);
           }
           else restore_candidate[page>>3]|=1<<(page&7);
+          head->hits++;
           return head;
         }
       }
@@ -2677,7 +2739,10 @@ void *get_addr(u_int vaddr)
   }
 
   int r=new_recompile_block(vaddr);
-  if(r==0) return get_addr(vaddr);
+  if(r==0) {
+    retain_hot_blocks();
+    return get_addr(vaddr);
+  }
   // Execute in unmapped page, generate pagefault execption
   assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
@@ -2690,8 +2755,14 @@ void *get_addr(u_int vaddr)
 void *get_addr_ht(u_int vaddr)
 {
   struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
-  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[0]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
-  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[1]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
+    ht_bin[0]->hits++;
+    return (void *)(((intptr_t)ht_bin[0]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  }
+  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) {
+    ht_bin[1]->hits++;
+    return (void *)(((intptr_t)ht_bin[1]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  }
   return get_addr(vaddr);
 }
 
@@ -2728,7 +2799,10 @@ void *get_addr_32(u_int vaddr,u_int flags)
   }
 
   int r=new_recompile_block(vaddr);
-  if(r==0) return get_addr(vaddr);
+  if(r==0) {
+    retain_hot_blocks();
+    return get_addr(vaddr);
+  }
   // Execute in unmapped page, generate pagefault execption
   assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
@@ -2744,11 +2818,11 @@ static void *check_addr(u_int vaddr)
   struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
 
   if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
-    if((((uintptr_t)ht_bin[0]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
+    if((((uintptr_t)ht_bin[0]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-target_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-target_size_2)))
       if(ht_bin[0]->addr==ht_bin[0]->clean_addr) return ht_bin[0]->addr; //jump_in
   }
   if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) {
-    if((((uintptr_t)ht_bin[1]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
+    if((((uintptr_t)ht_bin[1]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-target_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-target_size_2)))
       if(ht_bin[1]->addr==ht_bin[1]->clean_addr) return ht_bin[1]->addr; //jump_in
   }
 
@@ -2756,7 +2830,7 @@ static void *check_addr(u_int vaddr)
   struct ll_entry *head;
   head=get_clean(r4300,vaddr,~0);
   if(head!=NULL){
-    if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
+    if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-target_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-target_size_2))) {
       // Update existing entry with current address
       if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
         ht_bin[0]=head;
@@ -2780,6 +2854,23 @@ static void *check_addr(u_int vaddr)
   return NULL;
 }
 
+// Translate the hot blocks which just expired again, at most 64 at a time,
+// the ones expired by these translations are retained after the next one.
+// This is only done from the dispatcher, the dynamic linker is about to
+// patch the block it was called from, which must not expire meanwhile.
+static void retain_hot_blocks(void)
+{
+  int i;
+  retaining=1;
+  for(i=0;i<64&&retain_count>0;i++) {
+    u_int vaddr=retain_vaddr[--retain_count];
+    if(g_dev.r4300.cached_interp.invalid_code[vaddr>>12]) continue;
+    if(check_addr(vaddr)!=NULL) continue;
+    new_recompile_block(vaddr);
+  }
+  retaining=0;
+}
+
 // This is called when we write to a compiled block (see do_invstub)
 static void invalidate_page(u_int page)
 {
@@ -2818,6 +2909,8 @@ void invalidate_block(u_int block)
   if(block<0x100000&&page>262143&&g_dev.r4300.cp0.tlb.LUT_r[block]) page=(g_dev.r4300.cp0.tlb.LUT_r[block]^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
   inv_debug("INVALIDATE: %x (%d)\n",block<<12,page);
+  // Tell the snapshots the RDRAM page was written (see new_dynarec_trap_rdram_writes)
+  if(page<2048) rdram_mark_dirty(&g_dev.rdram,page<<12,4096);
   u_int first,last;
   first=last=page;
   struct ll_entry *head;
@@ -2888,6 +2981,35 @@ void invalidate_block(u_int block)
   #endif
 }
 
+static void trap_tlb_writes(u_int start,u_int end)
+{
+  u_int i;
+  for(i=start>>12;i<=end>>12;i++) {
+    if((i<0x80000||i>0xBFFFF)&&g_dev.r4300.cp0.tlb.LUT_w[i]&&g_dev.r4300.new_dynarec_hot_state.memory_map[i]!=(uintptr_t)-1) {
+      g_dev.r4300.cached_interp.invalid_code[i]=0;
+      g_dev.r4300.new_dynarec_hot_state.memory_map[i]|=WRITE_PROTECT;
+    }
+  }
+}
+
+// Trap the next write to each RDRAM page the same way as writes to compiled
+// code, so that invalidate_block() marks the page dirty. Pages without code
+// only get trapped once, invalidate_block() lets the following writes through.
+void new_dynarec_trap_rdram_writes(void)
+{
+  u_int i;
+  for(i=0x80000;i<0x80800;i++) {
+    g_dev.r4300.cached_interp.invalid_code[i]=0;
+    g_dev.r4300.new_dynarec_hot_state.memory_map[i]|=WRITE_PROTECT;
+  }
+  if(using_tlb) {
+    for(i=0;i<32;i++) {
+      trap_tlb_writes(g_dev.r4300.cp0.tlb.entries[i].start_even,g_dev.r4300.cp0.tlb.entries[i].end_even);
+      trap_tlb_writes(g_dev.r4300.cp0.tlb.entries[i].start_odd,g_dev.r4300.cp0.tlb.entries[i].end_odd);
+    }
+  }
+}
+
 // This is called when loading a save state.
 // Anything could have changed, so invalidate everything.
 static void invalidate_all_pages(void)
@@ -2956,7 +3078,7 @@ void clean_blocks(u_int page)
   while(head!=NULL) {
     if(!g_dev.r4300.cached_interp.invalid_code[head->vaddr>>12]) {
       // Don't restore blocks which are about to expire from the cache
-      if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
+      if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-target_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-target_size_2))) {
         if(verify_dirty(head)==0) {
           //DebugMessage(M64MSG_VERBOSE, "Possibly Restore %x (%x)",head->vaddr, (intptr_t)head->addr);
           u_int i,j;
@@ -2985,7 +3107,7 @@ void clean_blocks(u_int page)
             inv=1;
           }
           if(!inv) {
-            if((((uintptr_t)head->clean_addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
+            if((((uintptr_t)head->clean_addr-(uintptr_t)out)<<(32-target_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-target_size_2))) {
               u_int ppage=page;
               if(page<2048&&g_dev.r4300.cp0.tlb.LUT_r[head->vaddr>>12]) ppage=(g_dev.r4300.cp0.tlb.LUT_r[head->vaddr>>12]^0x80000000)>>12;
               inv_debug("INV: Restored %x (%x/%x)\n",head->vaddr, (intptr_t)head->addr, (intptr_t)head->clean_addr);
@@ -4456,6 +4578,35 @@ static void emit_extjump_ds(intptr_t addr, int target)
   emit_extjump2(addr, target, (intptr_t)dyna_linker_ds);
 }
 
+static int is_polling_loop(int i)
+{
+  return r4300_get_idle_loop_type(source,i,slen,start)==IDLE_LOOP_STABLE;
+}
+
+static int round_cc(int count)
+{
+  if(g_dev.r4300.cp0.count_per_op_denom_pot) {
+    count += (1 << g_dev.r4300.cp0.count_per_op_denom_pot) - 1;
+    count >>= g_dev.r4300.cp0.count_per_op_denom_pot;
+  }
+  return count;
+}
+
+// Raises the cycle count so that the next check, which adds
+// CLOCK_DIVIDER*(count+2) to it, reaches the next event
+static void do_idle_loop_skip(int i,int count)
+{
+  assem_debug("polling loop %x: skip to the next event",start+i*4);
+  emit_addimm(HOST_CCREG,CLOCK_DIVIDER*(count+2),HOST_CCREG);
+  emit_test(HOST_CCREG,HOST_CCREG);
+#if NEW_DYNAREC >= NEW_DYNAREC_ARM
+  emit_cmovs_imm(0,HOST_CCREG);
+#else
+  emit_cmovs(&const_zero,HOST_CCREG);
+#endif
+  emit_addimm(HOST_CCREG,-(int)CLOCK_DIVIDER*(count+2),HOST_CCREG);
+}
+
 static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int invert)
 {
   int count;
@@ -4477,6 +4628,12 @@ static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int i
     *adj=0;
   }
   count=ccadj[i];
+  if(taken==TAKEN && is_polling_loop(i)) {
+    // Polling loop, skip to the next event, the check below then
+    // handles it and the loop runs again afterwards
+    if(*adj==0||invert) do_idle_loop_skip(i,round_cc(count));
+    else do_idle_loop_skip(i,count);
+  }
   if(taken==TAKEN && i==(ba[i]-start)>>2 && source[i+1]==0) {
     // Idle loop
     idle=(intptr_t)out;
@@ -7285,6 +7442,10 @@ static void cjump_assemble(int i,struct regstat *i_regs)
   #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
   if(i>(ba[i]-start)>>2) invert=1;
   #endif
+  // The cycle count is checked before the branch when the delay slot is
+  // executed first, polling loops are skipped on the taken path instead
+  int polling_loop=ooo[i]&&is_polling_loop(i);
+  if(polling_loop) invert=1;
 
   if(ooo[i]) {
     s1l=get_reg(branch_regs[i].regmap,rs1[i]);
@@ -7466,6 +7627,7 @@ static void cjump_assemble(int i,struct regstat *i_regs)
       }
       if(invert) {
         if(taken) set_jump_target(taken,(intptr_t)out);
+        if(polling_loop) do_idle_loop_skip(i,round_cc(ccadj[i])-adj);
         #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
         if(match&&(!branch_internal||!is_ds[(ba[i]-start)>>2])) {
           if(adj) {
@@ -7674,6 +7836,10 @@ static void sjump_assemble(int i,struct regstat *i_regs)
   #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
   if(i>(ba[i]-start)>>2) invert=1;
   #endif
+  // The cycle count is checked before the branch when the delay slot is
+  // executed first, polling loops are skipped on the taken path instead
+  int polling_loop=ooo[i]&&is_polling_loop(i);
+  if(polling_loop) invert=1;
 
   //if(opcode2[i]>=0x10) return; // FIXME (BxxZAL)
   assert(opcode2[i]<0x10||rs1[i]==0); // FIXME (BxxZAL)
@@ -7821,6 +7987,7 @@ static void sjump_assemble(int i,struct regstat *i_regs)
       } // if(!only32)
 
       if(invert) {
+        if(polling_loop) do_idle_loop_skip(i,round_cc(ccadj[i])-adj);
         #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
         if(match&&(!branch_internal||!is_ds[(ba[i]-start)>>2])) {
           if(adj) {
@@ -8627,6 +8794,197 @@ static void pagespan_ds(void)
   load_regs_bt(regs[0].regmap,regs[0].is32,regs[0].dirty,start+4);
 }
 
+/**** JIT symbols ****/
+
+// Exports the assembled blocks for perf, so the time spent in the
+// translation cache can be attributed to the guest code, either as
+// /tmp/perf-<pid>.map or as /tmp/jit-<pid>.dump for 'perf inject --jit'.
+// A perf map can't express code which is freed and overwritten, the
+// records of a jitdump are timestamped so perf uses the block which
+// was at the address at the time of the sample.
+
+#define JIT_SYMBOLS_DISABLED 0
+#define JIT_SYMBOLS_PERF_MAP 1
+#define JIT_SYMBOLS_JITDUMP  2
+
+#ifdef JIT_SYMBOLS
+#define JITDUMP_MAGIC     0x4A695444
+#define JITDUMP_VERSION   1
+#define JIT_CODE_LOAD     0
+#define JIT_CODE_CLOSE    3
+
+#if NEW_DYNAREC == NEW_DYNAREC_X86
+#define JITDUMP_ELF_MACH EM_386
+#elif NEW_DYNAREC == NEW_DYNAREC_X64
+#define JITDUMP_ELF_MACH EM_X86_64
+#elif NEW_DYNAREC == NEW_DYNAREC_ARM
+#define JITDUMP_ELF_MACH EM_ARM
+#else
+#define JITDUMP_ELF_MACH EM_AARCH64
+#endif
+
+struct jitdump_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t total_size;
+  uint32_t elf_mach;
+  uint32_t pad1;
+  uint32_t pid;
+  uint64_t timestamp;
+  uint64_t flags;
+};
+
+struct jitdump_record_header
+{
+  uint32_t id;
+  uint32_t total_size;
+  uint64_t timestamp;
+};
+
+struct jitdump_code_load
+{
+  struct jitdump_record_header p;
+  uint32_t pid;
+  uint32_t tid;
+  uint64_t vma;
+  uint64_t code_addr;
+  uint64_t code_size;
+  uint64_t code_index;
+};
+
+static FILE *perf_map_file;
+static FILE *jitdump_file;
+static void *jitdump_mapping;
+static size_t jitdump_mapping_size;
+static uint64_t jitdump_code_index;
+
+// perf has to record with '-k mono' to match these
+static uint64_t jitdump_timestamp(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (uint64_t)ts.tv_sec*1000000000+(uint64_t)ts.tv_nsec;
+}
+#endif
+
+static void jit_symbols_open(int mode)
+{
+#ifdef JIT_SYMBOLS
+  char path[64];
+
+  if(mode==JIT_SYMBOLS_PERF_MAP)
+  {
+    snprintf(path,sizeof(path),"/tmp/perf-%d.map",(int)getpid());
+    perf_map_file=fopen(path,"a");
+    if(perf_map_file==NULL) {
+      DebugMessage(M64MSG_WARNING, "Couldn't open perf map: %s", path);
+      return;
+    }
+    DebugMessage(M64MSG_INFO, "Writing dynarec symbols to %s", path);
+  }
+  else if(mode==JIT_SYMBOLS_JITDUMP)
+  {
+    snprintf(path,sizeof(path),"/tmp/jit-%d.dump",(int)getpid());
+    // the dump is appended to when emulation is started again
+    jitdump_file=fopen(path,"a+");
+    if(jitdump_file==NULL) {
+      DebugMessage(M64MSG_WARNING, "Couldn't open jitdump: %s", path);
+      return;
+    }
+
+    fseek(jitdump_file,0,SEEK_END);
+    if(ftell(jitdump_file)==0)
+    {
+      struct jitdump_header header;
+      memset(&header,0,sizeof(header));
+      header.magic=JITDUMP_MAGIC;
+      header.version=JITDUMP_VERSION;
+      header.total_size=sizeof(header);
+      header.elf_mach=JITDUMP_ELF_MACH;
+      header.pid=(uint32_t)getpid();
+      header.timestamp=jitdump_timestamp();
+      fwrite(&header,sizeof(header),1,jitdump_file);
+      fflush(jitdump_file);
+    }
+
+    // perf finds the dump by the executable mapping of it
+    jitdump_mapping_size=(size_t)sysconf(_SC_PAGESIZE);
+    jitdump_mapping=mmap(NULL,jitdump_mapping_size,PROT_READ|PROT_EXEC,MAP_PRIVATE,fileno(jitdump_file),0);
+    if(jitdump_mapping==MAP_FAILED) {
+      DebugMessage(M64MSG_WARNING, "Couldn't map jitdump: %s", path);
+      fclose(jitdump_file);
+      jitdump_file=NULL;
+      jitdump_mapping=NULL;
+      return;
+    }
+    DebugMessage(M64MSG_INFO, "Writing dynarec symbols to %s", path);
+  }
+#else
+  if(mode!=JIT_SYMBOLS_DISABLED)
+    DebugMessage(M64MSG_WARNING, "Dynarec symbols aren't supported on this platform");
+#endif
+}
+
+static void jit_symbols_close(void)
+{
+#ifdef JIT_SYMBOLS
+  if(perf_map_file!=NULL)
+  {
+    fclose(perf_map_file);
+    perf_map_file=NULL;
+  }
+
+  if(jitdump_file!=NULL)
+  {
+    struct jitdump_record_header record;
+    record.id=JIT_CODE_CLOSE;
+    record.total_size=sizeof(record);
+    record.timestamp=jitdump_timestamp();
+    fwrite(&record,sizeof(record),1,jitdump_file);
+
+    munmap(jitdump_mapping,jitdump_mapping_size);
+    fclose(jitdump_file);
+    jitdump_file=NULL;
+    jitdump_mapping=NULL;
+  }
+#endif
+}
+
+// code is the address of the block in the writable mapping
+static void jit_symbols_add_block(u_int vaddr,int count,uintptr_t code,uintptr_t size)
+{
+#ifdef JIT_SYMBOLS
+  if(perf_map_file==NULL&&jitdump_file==NULL)
+    return;
+
+  uintptr_t code_rx=(code-(uintptr_t)base_addr)+(uintptr_t)base_addr_rx;
+  char name[64];
+  snprintf(name,sizeof(name),"n64_%08x (%d instructions)",vaddr,count);
+
+  if(perf_map_file!=NULL)
+    fprintf(perf_map_file,"%" PRIxPTR " %" PRIxPTR " %s\n",code_rx,size,name);
+
+  if(jitdump_file!=NULL)
+  {
+    struct jitdump_code_load record;
+    size_t name_size=strlen(name)+1;
+    record.p.id=JIT_CODE_LOAD;
+    record.p.total_size=(uint32_t)(sizeof(record)+name_size+size);
+    record.p.timestamp=jitdump_timestamp();
+    record.pid=(uint32_t)getpid();
+    record.tid=(uint32_t)syscall(SYS_gettid);
+    record.vma=code_rx;
+    record.code_addr=code_rx;
+    record.code_size=size;
+    record.code_index=jitdump_code_index++;
+    fwrite(&record,sizeof(record),1,jitdump_file);
+    fwrite(name,name_size,1,jitdump_file);
+    fwrite((void *)code,size,1,jitdump_file);
+  }
+#endif
+}
+
 /**** Recompiler ****/
 void new_dynarec_init(void)
 {
@@ -8687,7 +9045,7 @@ void new_dynarec_init(void)
 #else
 #if defined(WIN32)
   DWORD dummy;
-  BOOL res=VirtualProtect((void*)g_dev.r4300.extra_memory, 33554432, PAGE_EXECUTE_READWRITE, &dummy);
+  BOOL res=VirtualProtect((void*)g_dev.r4300.extra_memory, 1<<TARGET_SIZE_2, PAGE_EXECUTE_READWRITE, &dummy);
   assert(res!=0);
   base_addr = base_addr_rx = (void*)g_dev.r4300.extra_memory;
 #else
@@ -8704,6 +9062,28 @@ void new_dynarec_init(void)
   assert(((uintptr_t)g_dev.rdram.dram&7)==0); //8 bytes aligned
   out=(u_char *)base_addr;
 
+#if !defined(RECOMP_DBG)
+  // DynarecCacheSize and DynarecCacheMaxSize are in MB,
+  // rounded down to a power of two
+  int cache_max_size=ConfigGetParamInt(g_CoreConfig, "DynarecCacheMaxSize");
+  max_target_size_2=22;
+  while(max_target_size_2<TARGET_SIZE_2&&(2<<(max_target_size_2-20))<=cache_max_size)
+    max_target_size_2++;
+  int cache_size=ConfigGetParamInt(g_CoreConfig, "DynarecCacheSize");
+  target_size_2=22;
+  while(target_size_2<max_target_size_2&&(2<<(target_size_2-20))<=cache_size)
+    target_size_2++;
+#endif
+  cache_grow_checked=0;
+  memset(expired_vaddr,0xff,sizeof(expired_vaddr));
+  retain_count=0;
+  retaining=0;
+  cache_retained=0;
+  cache_translations=cache_retranslations=0;
+  cache_expirations=cache_hot_expirations=0;
+  cache_wraps=0;
+  lap_translations=lap_retranslations=0;
+
   g_dev.r4300.new_dynarec_hot_state.pc = &g_dev.r4300.new_dynarec_hot_state.fake_pc;
   g_dev.r4300.new_dynarec_hot_state.fake_pc.f.r.rs = &g_dev.r4300.new_dynarec_hot_state.rs;
   g_dev.r4300.new_dynarec_hot_state.fake_pc.f.r.rt = &g_dev.r4300.new_dynarec_hot_state.rt;
@@ -8735,6 +9115,10 @@ void new_dynarec_init(void)
 
   tlb_speed_hacks();
   arch_init();
+
+#if !defined(RECOMP_DBG)
+  jit_symbols_open(ConfigGetParamInt(g_CoreConfig, "DynarecSymbols"));
+#endif
 }
 
 void new_dynarec_cleanup(void)
@@ -8743,6 +9127,14 @@ void new_dynarec_cleanup(void)
   recomp_dbg_cleanup();
 #endif
 
+  jit_symbols_close();
+
+#if !defined(RECOMP_DBG)
+  DebugMessage(M64MSG_INFO, "new_dynarec: translation cache of %d MB, %d%% full, wrapped %u times, %u blocks translated, %u translated again, %u expired, %u of them in use, %u retained",
+               1<<(target_size_2-20), (int)((((uintptr_t)out-(uintptr_t)base_addr)*100)>>target_size_2), cache_wraps,
+               cache_translations, cache_retranslations, cache_expirations, cache_hot_expirations, cache_retained);
+#endif
+
   int n;
   for(n=0;n<4096;n++) ll_clear(jump_in+n);
   for(n=0;n<4096;n++) ll_clear(jump_out+n);
@@ -8762,6 +9154,83 @@ void new_dynarec_cleanup(void)
 #endif
 }
 
+// Expire the blocks in the cache up to the given expiry pointer
+static void expire_blocks(int end)
+{
+  int i;
+  while(expirep!=end)
+  {
+    int shift=target_size_2-3; // Divide into 8 blocks
+    intptr_t base=(intptr_t)base_addr+((expirep>>13)<<shift); // Base address of this block
+    inv_debug("EXP: Phase %d\n",expirep);
+    switch((expirep>>11)&3)
+    {
+      case 0:
+        // Clear jump_in and jump_dirty
+        ll_remove_matching_addrs(jump_in+(expirep&2047),base,shift);
+        ll_remove_matching_addrs(jump_dirty+(expirep&2047),base,shift);
+        ll_remove_matching_addrs(jump_in+2048+(expirep&2047),base,shift);
+        ll_remove_matching_addrs(jump_dirty+2048+(expirep&2047),base,shift);
+        break;
+      case 1:
+        // Clear pointers
+        ll_kill_pointers(jump_out[expirep&2047],base,shift);
+        ll_kill_pointers(jump_out[(expirep&2047)+2048],base,shift);
+        break;
+      case 2:
+        // Clear hash table
+        for(i=0;i<32;i++) {
+          struct ll_entry **ht_bin=hash_table[((expirep&2047)<<5)+i];
+          if(ht_bin[1]&&((((uintptr_t)ht_bin[1]->addr-(uintptr_t)base_addr)>>shift)==((base-(uintptr_t)base_addr)>>shift) ||
+             (((uintptr_t)ht_bin[1]->addr-(uintptr_t)base_addr-MAX_OUTPUT_BLOCK_SIZE)>>shift)==((base-(uintptr_t)base_addr)>>shift))) {
+            inv_debug("EXP: Remove hash %x -> %x\n",ht_bin[1]->vaddr,ht_bin[1]->addr);
+            ht_bin[1]=NULL;
+          }
+          if(ht_bin[0]&&((((uintptr_t)ht_bin[0]->addr-(uintptr_t)base_addr)>>shift)==((base-(uintptr_t)base_addr)>>shift) ||
+             (((uintptr_t)ht_bin[0]->addr-(uintptr_t)base_addr-MAX_OUTPUT_BLOCK_SIZE)>>shift)==((base-(uintptr_t)base_addr)>>shift))) {
+            inv_debug("EXP: Remove hash %x -> %x\n",ht_bin[0]->vaddr,ht_bin[0]->addr);
+            ht_bin[0]=ht_bin[1];
+            ht_bin[1]=NULL;
+          }
+        }
+        break;
+      case 3:
+        // Clear jump_out
+        #if NEW_DYNAREC >= NEW_DYNAREC_ARM
+        if((expirep&2047)==0)
+          do_clear_cache();
+        #endif
+        ll_remove_matching_addrs(jump_out+(expirep&2047),base,shift);
+        ll_remove_matching_addrs(jump_out+2048+(expirep&2047),base,shift);
+        break;
+    }
+    expirep=(expirep+1)&65535;
+  }
+}
+
+// Grow the cache if too many of the blocks translated since the last
+// check had expired before, returns whether the cache has grown
+static int grow_cache(void)
+{
+  u_int translations=lap_translations;
+  u_int retranslations=lap_retranslations;
+
+  lap_translations=lap_retranslations=0;
+  if(target_size_2>=max_target_size_2||retranslations*8<=translations)
+    return 0;
+
+  // Finish expiring the end of the cache before the expiry pointer is
+  // rescaled. out continues into the new half of the cache, which is
+  // empty, so expiry continues with the block after out.
+  expire_blocks(0);
+  target_size_2++;
+  expirep=(((((intptr_t)out-(intptr_t)base_addr)>>(target_size_2-3))+1)<<13)&65535;
+
+  DebugMessage(M64MSG_VERBOSE, "new_dynarec: translation cache grown to %d MB, %u of %u blocks were translated again",
+               1<<(target_size_2-20), retranslations, translations);
+  return 1;
+}
+
 int new_recompile_block(int addr)
 {
 #if defined(RECOMPILER_DEBUG) && !defined(RECOMP_DBG)
@@ -11820,10 +12289,33 @@ int new_recompile_block(int addr)
   cache_flush((char *)beginning_rx,(char *)out_rx);
   #endif
 
+  jit_symbols_add_block(start,slen,beginning,(uintptr_t)out-beginning);
+
+  // Retained blocks don't make the cache grow, only
+  // the ones which were missed after they expired
+  if(retaining) {
+    expired_vaddr[(start>>2)&4095]=(u_int)-1;
+    cache_retained++;
+  }
+  else {
+    cache_translations++;
+    lap_translations++;
+    if(expired_vaddr[(start>>2)&4095]==start) {
+      expired_vaddr[(start>>2)&4095]=(u_int)-1;
+      cache_retranslations++;
+      lap_retranslations++;
+    }
+  }
+
   // If we're within 256K of the end of the buffer,
   // start over from the beginning. (Is 256K enough?)
-  if(out > (u_char *)((u_char *)base_addr+(1<<TARGET_SIZE_2)-MAX_OUTPUT_BLOCK_SIZE-JUMP_TABLE_SIZE))
+  if(out > (u_char *)((u_char *)base_addr+(1<<target_size_2)-MAX_OUTPUT_BLOCK_SIZE-JUMP_TABLE_SIZE)) {
     out=(u_char *)base_addr;
+    cache_grow_checked=0;
+    cache_wraps++;
+    DebugMessage(M64MSG_VERBOSE, "new_dynarec: translation cache of %d MB wrapped, %u blocks translated, %u translated again, %u expired, %u of them in use, %u retained",
+                 1<<(target_size_2-20), cache_translations, cache_retranslations, cache_expirations, cache_hot_expirations, cache_retained);
+  }
 
   // Trap writes to any of the pages we compiled
   for(i=start>>12;i<=(int)((start+slen*4-4)>>12);i++) {
@@ -11841,54 +12333,14 @@ int new_recompile_block(int addr)
 
   /* Pass 10 - Free memory by expiring oldest blocks */
 
-  int end=((((intptr_t)out-(intptr_t)base_addr)>>(TARGET_SIZE_2-16))+16384)&65535;
-  while(expirep!=end)
-  {
-    int shift=TARGET_SIZE_2-3; // Divide into 8 blocks
-    intptr_t base=(intptr_t)base_addr+((expirep>>13)<<shift); // Base address of this block
-    inv_debug("EXP: Phase %d\n",expirep);
-    switch((expirep>>11)&3)
-    {
-      case 0:
-        // Clear jump_in and jump_dirty
-        ll_remove_matching_addrs(jump_in+(expirep&2047),base,shift);
-        ll_remove_matching_addrs(jump_dirty+(expirep&2047),base,shift);
-        ll_remove_matching_addrs(jump_in+2048+(expirep&2047),base,shift);
-        ll_remove_matching_addrs(jump_dirty+2048+(expirep&2047),base,shift);
-        break;
-      case 1:
-        // Clear pointers
-        ll_kill_pointers(jump_out[expirep&2047],base,shift);
-        ll_kill_pointers(jump_out[(expirep&2047)+2048],base,shift);
-        break;
-      case 2:
-        // Clear hash table
-        for(i=0;i<32;i++) {
-          struct ll_entry **ht_bin=hash_table[((expirep&2047)<<5)+i];
-          if(ht_bin[1]&&((((uintptr_t)ht_bin[1]->addr-(uintptr_t)base_addr)>>shift)==((base-(uintptr_t)base_addr)>>shift) ||
-             (((uintptr_t)ht_bin[1]->addr-(uintptr_t)base_addr-MAX_OUTPUT_BLOCK_SIZE)>>shift)==((base-(uintptr_t)base_addr)>>shift))) {
-            inv_debug("EXP: Remove hash %x -> %x\n",ht_bin[1]->vaddr,ht_bin[1]->addr);
-            ht_bin[1]=NULL;
-          }
-          if(ht_bin[0]&&((((uintptr_t)ht_bin[0]->addr-(uintptr_t)base_addr)>>shift)==((base-(uintptr_t)base_addr)>>shift) ||
-             (((uintptr_t)ht_bin[0]->addr-(uintptr_t)base_addr-MAX_OUTPUT_BLOCK_SIZE)>>shift)==((base-(uintptr_t)base_addr)>>shift))) {
-            inv_debug("EXP: Remove hash %x -> %x\n",ht_bin[0]->vaddr,ht_bin[0]->addr);
-            ht_bin[0]=ht_bin[1];
-            ht_bin[1]=NULL;
-          }
-        }
-        break;
-      case 3:
-        // Clear jump_out
-        #if NEW_DYNAREC >= NEW_DYNAREC_ARM
-        if((expirep&2047)==0)
-          do_clear_cache();
-        #endif
-        ll_remove_matching_addrs(jump_out+(expirep&2047),base,shift);
-        ll_remove_matching_addrs(jump_out+2048+(expirep&2047),base,shift);
-        break;
-    }
-    expirep=(expirep+1)&65535;
+  // Once the blocks at the start of the cache are about to expire,
+  // check whether the cache should grow instead
+  if(!cache_grow_checked&&((intptr_t)out-(intptr_t)base_addr)>=(3<<(target_size_2-2))) {
+    cache_grow_checked=1;
+    if(grow_cache()) cache_grow_checked=0;
   }
+
+  int end=((((intptr_t)out-(intptr_t)base_addr)>>(target_size_2-16))+16384)&65535;
+  expire_blocks(end);
   return 0;
 }
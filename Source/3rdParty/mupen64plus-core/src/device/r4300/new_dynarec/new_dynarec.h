@@ -34,6 +34,15 @@
 
 #define WRITE_PROTECT ((uintptr_t)1<<((sizeof(uintptr_t)<<3)-2))
 
+/* Size of the memory reserved for the translation cache, the ARM
+ * backends have to branch within +/-32MB and 32-bit x86 has little
+ * address space to spare */
+#if defined(NEW_DYNAREC) && (NEW_DYNAREC == NEW_DYNAREC_X64)
+#define NEW_DYNAREC_CACHE_MAX_SIZE 134217728
+#else
+#define NEW_DYNAREC_CACHE_MAX_SIZE 33554432
+#endif
+
 struct r4300_core;
 
 /* This struct contains "hot" variables used by the new_dynarec
@@ -93,5 +102,6 @@ void invalidate_cached_code_new_dynarec(struct r4300_core* r4300, uint32_t addre
 void new_dynarec_init(void);
 void new_dyna_start(void);
 void new_dynarec_cleanup(void);
+void new_dynarec_trap_rdram_writes(void);
 
 #endif /* M64P_DEVICE_R4300_NEW_DYNAREC_H */
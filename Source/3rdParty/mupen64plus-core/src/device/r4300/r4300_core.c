@@ -31,6 +31,9 @@
 #include "api/callbacks.h"
 #include "api/debugger.h"
 #include "api/m64p_types.h"
+
+#include "device/memory/memory.h"
+#include "device/rdram/rdram.h"
 #ifdef DBG
 #include "debugger/dbg_debugger.h"
 #endif
@@ -297,6 +300,18 @@ uint32_t *fast_mem_access(struct r4300_core* r4300, uint32_t address)
     return mem_base_u32(r4300->mem->base, address);
 }
 
+/* Most accesses go to RDRAM, so the RDRAM regions which are mapped to the
+ * plain RDRAM handlers are accessed directly instead of through the handlers.
+ * address is a physical address. */
+static osal_inline struct rdram* get_fast_rdram(const struct memory* mem, uint32_t address, unsigned char access)
+{
+    if (address >= RDRAM_MAX_SIZE || !(mem->fast_rdram[address >> 16] & access)) {
+        return NULL;
+    }
+
+    return (struct rdram*)mem->handlers[address >> 16].opaque;
+}
+
 /* Read aligned word from memory.
  * address may not be word-aligned for byte or hword accesses.
  * Alignment is taken care of when calling mem handler.
@@ -312,6 +327,12 @@ int r4300_read_aligned_word(struct r4300_core* r4300, uint32_t address, uint32_t
 
     address &= UINT32_C(0x1ffffffc);
 
+    const struct rdram* rdram = get_fast_rdram(r4300->mem, address, MEM_FAST_READ);
+    if (rdram != NULL) {
+        *value = rdram->dram[address >> 2];
+        return 1;
+    }
+
     mem_read32(mem_get_handler(r4300->mem, address), address & ~UINT32_C(3), value);
 
     return 1;
@@ -338,6 +359,12 @@ int r4300_read_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64_
 
     address &= UINT32_C(0x1ffffffc);
 
+    const struct rdram* rdram = get_fast_rdram(r4300->mem, address, MEM_FAST_READ);
+    if (rdram != NULL) {
+        *value = ((uint64_t)rdram->dram[(address >> 2) + 0] << 32) | rdram->dram[(address >> 2) + 1];
+        return 1;
+    }
+
     const struct mem_handler* handler = mem_get_handler(r4300->mem, address);
     mem_read32(handler, address + 0, &w[0]);
     mem_read32(handler, address + 4, &w[1]);
@@ -368,6 +395,13 @@ int r4300_write_aligned_word(struct r4300_core* r4300, uint32_t address, uint32_
 
     address &= UINT32_C(0x1ffffffc);
 
+    struct rdram* rdram = get_fast_rdram(r4300->mem, address, MEM_FAST_WRITE);
+    if (rdram != NULL) {
+        masked_write(&rdram->dram[address >> 2], value, mask);
+        rdram_mark_dirty(rdram, address, 4);
+        return 1;
+    }
+
     mem_write32(mem_get_handler(r4300->mem, address), address & ~UINT32_C(3), value, mask);
 
     return 1;
@@ -398,6 +432,14 @@ int r4300_write_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64
 
     address &= UINT32_C(0x1ffffffc);
 
+    struct rdram* rdram = get_fast_rdram(r4300->mem, address, MEM_FAST_WRITE);
+    if (rdram != NULL) {
+        masked_write(&rdram->dram[(address >> 2) + 0], value >> 32,      mask >> 32);
+        masked_write(&rdram->dram[(address >> 2) + 1], (uint32_t) value, (uint32_t) mask);
+        rdram_mark_dirty(rdram, address, 8);
+        return 1;
+    }
+
     const struct mem_handler* handler = mem_get_handler(r4300->mem, address);
     mem_write32(handler, address + 0, value >> 32,      mask >> 32);
     mem_write32(handler, address + 4, (uint32_t) value, (uint32_t) mask      );
@@ -422,6 +464,28 @@ void invalidate_r4300_cached_code(struct r4300_core* r4300, uint32_t address, si
     }
 }
 
+int r4300_track_rdram_writes(struct r4300_core* r4300)
+{
+    switch(r4300->emumode)
+    {
+    case EMUMODE_PURE_INTERPRETER:
+    case EMUMODE_INTERPRETER:
+        /* every store goes through r4300_write_aligned_word/dword */
+        return 1;
+
+    case EMUMODE_DYNAREC:
+#ifdef NEW_DYNAREC
+        new_dynarec_trap_rdram_writes();
+        return 1;
+#else
+        /* the old dynarec writes RDRAM inline */
+        return 0;
+#endif
+
+    default:
+        return 0;
+    }
+}
 
 void generic_jump_to(struct r4300_core* r4300, uint32_t address)
 {
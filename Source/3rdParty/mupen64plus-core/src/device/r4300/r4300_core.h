@@ -181,7 +181,7 @@ struct r4300_core
     /* FIXME: better put that near linkage_arm code
      * to help generate call beyond the +/-32MB range.
      */
-    ALIGN(4096, char extra_memory[33554432]);
+    ALIGN(4096, char extra_memory[NEW_DYNAREC_CACHE_MAX_SIZE]);
     struct new_dynarec_hot_state new_dynarec_hot_state;
 #endif /* NEW_DYNAREC */
 
@@ -247,6 +247,12 @@ int r4300_write_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64
  */
 void invalidate_r4300_cached_code(struct r4300_core* r4300, uint32_t address, size_t size);
 
+/* Make sure the next write to each RDRAM page gets marked with rdram_mark_dirty.
+ *
+ * Returns 0 if the current r4300 emulator writes RDRAM without marking it.
+ */
+int r4300_track_rdram_writes(struct r4300_core* r4300);
+
 /* Jump to the given address. This works for all r4300 emulator, but is slower.
  * Use this for common code which can be executed from any r4300 emulator. */
 void generic_jump_to(struct r4300_core* r4300, unsigned int address);
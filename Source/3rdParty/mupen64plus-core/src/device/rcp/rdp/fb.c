@@ -57,7 +57,9 @@ void pre_framebuffer_read(struct fb* fb, uint32_t address)
         uint32_t end   = fb->infos[i].addr + fb_buffer_size(&fb->infos[i]) - 1;
 
         if ((address >= begin) && (address <= end) && (fb->dirty_page[address >> 12])) {
+            rdram_begin_plugin_writes(fb->rdram);
             gfx.fBRead(address);
+            rdram_end_plugin_writes(fb->rdram);
             fb->dirty_page[address >> 12] = 0;
         }
     }
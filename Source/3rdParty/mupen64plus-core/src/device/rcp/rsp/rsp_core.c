@@ -60,6 +60,7 @@ static void do_sp_dma(struct rsp_core* sp, const struct sp_dma* dma)
                 memaddr++;
                 dramaddr++;
             }
+            rdram_mark_dirty(sp->ri->rdram, (dramaddr - length) & 0x7fffff, length);
             if (dramaddr <= 0x800000)
                 post_framebuffer_write(&sp->dp->fb, dramaddr - length, length);
             dramaddr+=skip;
@@ -338,7 +339,9 @@ void do_SP_Task(struct rsp_core* sp)
 #if defined(PROFILE)
         timed_section_start(TIMED_SECTION_GFX);
 #endif
+        rdram_begin_plugin_writes(sp->ri->rdram);
         rsp.doRspCycles(0xffffffff);
+        rdram_end_plugin_writes(sp->ri->rdram);
 #if defined(PROFILE)
         timed_section_end(TIMED_SECTION_GFX);
 #endif
@@ -366,7 +369,9 @@ void do_SP_Task(struct rsp_core* sp)
 #if defined(PROFILE)
         timed_section_start(TIMED_SECTION_AUDIO);
 #endif
+        rdram_begin_plugin_writes(sp->ri->rdram);
         rsp.doRspCycles(0xffffffff);
+        rdram_end_plugin_writes(sp->ri->rdram);
 #if defined(PROFILE)
         timed_section_end(TIMED_SECTION_AUDIO);
 #endif
@@ -377,7 +382,9 @@ void do_SP_Task(struct rsp_core* sp)
     else
     {
         sp->regs2[SP_PC_REG] &= 0xfff;
+        rdram_begin_plugin_writes(sp->ri->rdram);
         rsp.doRspCycles(0xffffffff);
+        rdram_end_plugin_writes(sp->ri->rdram);
         sp->regs2[SP_PC_REG] |= save_pc;
 
         sp_delay_time = 0;
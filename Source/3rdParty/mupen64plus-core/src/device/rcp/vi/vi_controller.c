@@ -27,6 +27,8 @@
 #include "device/memory/memory.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/mi/mi_controller.h"
+#include "device/rcp/rdp/rdp_core.h"
+#include "device/rdram/rdram.h"
 #include "main/main.h"
 #include "plugin/plugin.h"
 
@@ -165,8 +167,11 @@ void vi_vertical_interrupt_event(void* opaque)
     struct vi_controller* vi = (struct vi_controller*)opaque;
     if (vi->dp->do_on_unfreeze & DELAY_DP_INT)
         vi->dp->do_on_unfreeze |= DELAY_UPDATESCREEN;
-    else
+    else {
+        rdram_begin_plugin_writes(vi->dp->fb.rdram);
         gfx.updateScreen();
+        rdram_end_plugin_writes(vi->dp->fb.rdram);
+    }
 
     /* allow main module to do things on VI event */
     new_vi();
@@ -30,6 +30,15 @@
 
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define RDRAM_PROTECT_POSIX
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #define RDRAM_BCAST_ADDRESS_MASK UINT32_C(0x00080000)
 #define RDRAM_MODE_CE_MASK UINT32_C(0x80000000)
 
@@ -143,6 +152,8 @@ void init_rdram(struct rdram* rdram,
     rdram->dram_size = dram_size;
     rdram->r4300 = r4300;
     rdram->corrupted_handler = 0;
+    rdram->untracked_writes = 1;
+    rdram->protected_pages = 0;
 }
 
 void poweron_rdram(struct rdram* rdram)
@@ -151,6 +162,7 @@ void poweron_rdram(struct rdram* rdram)
     size_t modules = get_modules_count(rdram);
     memset(rdram->regs, 0, RDRAM_MAX_MODULES_COUNT*RDRAM_REGS_COUNT*sizeof(uint32_t));
     memset(rdram->dram, 0, rdram->dram_size);
+    memset(rdram->dirty_pages, 0xff, sizeof(rdram->dirty_pages));
 
     DebugMessage(M64MSG_INFO, "Initializing %u RDRAM modules for a total of %u MB",
         (uint32_t) modules, (uint32_t) rdram->dram_size / (1024*1024));
@@ -260,5 +272,213 @@ void write_rdram_dram(void* opaque, uint32_t address, uint32_t value, uint32_t m
     if (address < rdram->dram_size)
     {
         masked_write(&rdram->dram[addr], value, mask);
+        rdram_mark_dirty(rdram, address, 4);
+    }
+}
+
+void rdram_clear_dirty_pages(struct rdram* rdram)
+{
+    memset(rdram->dirty_pages, 0, sizeof(rdram->dirty_pages));
+    rdram->untracked_writes = 0;
+}
+
+
+/* RDRAM being protected while a plugin runs, the fault handler has no other way to find it */
+static struct rdram* volatile l_protected_rdram = NULL;
+static size_t l_host_page_size = 0;
+
+/* Plugins may fault from several threads at once */
+static void mark_dirty_atomic(struct rdram* rdram, uint32_t address, uint32_t length)
+{
+    uint32_t page;
+
+    for (page = address >> RDRAM_DIRTY_PAGE_SHIFT; page < (address + length) >> RDRAM_DIRTY_PAGE_SHIFT && page < RDRAM_DIRTY_PAGES_COUNT; ++page) {
+#ifdef _MSC_VER
+        _InterlockedOr((volatile long*)&rdram->dirty_pages[page >> 5], (long)(UINT32_C(1) << (page & 31)));
+#else
+        __sync_fetch_and_or(&rdram->dirty_pages[page >> 5], UINT32_C(1) << (page & 31));
+#endif
+    }
+}
+
+#ifdef _WIN32
+static PVOID l_fault_handler = NULL;
+
+static LONG CALLBACK rdram_write_fault(PEXCEPTION_POINTERS info)
+{
+    const EXCEPTION_RECORD* record = info->ExceptionRecord;
+    struct rdram* rdram = l_protected_rdram;
+    uintptr_t offset;
+    DWORD old;
+
+    if (rdram == NULL
+     || record->ExceptionCode != EXCEPTION_ACCESS_VIOLATION
+     || record->NumberParameters < 2
+     || record->ExceptionInformation[0] != 1) {
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
+
+    offset = (uintptr_t)record->ExceptionInformation[1] - (uintptr_t)rdram->dram;
+    if (offset >= rdram->dram_size) {
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
+
+    offset &= ~(uintptr_t)(l_host_page_size - 1);
+    if (!VirtualProtect((unsigned char*)rdram->dram + offset, l_host_page_size, PAGE_READWRITE, &old)) {
+        return EXCEPTION_CONTINUE_SEARCH;
     }
+
+    mark_dirty_atomic(rdram, (uint32_t)offset, (uint32_t)l_host_page_size);
+    return EXCEPTION_CONTINUE_EXECUTION;
+}
+
+static int install_fault_handler(void)
+{
+    SYSTEM_INFO system_info;
+
+    GetSystemInfo(&system_info);
+    l_host_page_size = system_info.dwPageSize;
+    l_fault_handler = AddVectoredExceptionHandler(1, rdram_write_fault);
+    return l_fault_handler != NULL;
+}
+
+static void remove_fault_handler(void)
+{
+    RemoveVectoredExceptionHandler(l_fault_handler);
+    l_fault_handler = NULL;
+}
+
+static int protect_rdram(struct rdram* rdram, int read_only)
+{
+    DWORD old;
+    return VirtualProtect(rdram->dram, rdram->dram_size, read_only ? PAGE_READONLY : PAGE_READWRITE, &old) != 0;
+}
+#elif defined(RDRAM_PROTECT_POSIX)
+static struct sigaction l_old_sigsegv;
+static struct sigaction l_old_sigbus;
+
+static void rdram_write_fault(int sig, siginfo_t* info, void* context)
+{
+    const struct sigaction* old = (sig == SIGBUS) ? &l_old_sigbus : &l_old_sigsegv;
+    struct rdram* rdram = l_protected_rdram;
+
+    if (rdram != NULL) {
+        uintptr_t offset = (uintptr_t)info->si_addr - (uintptr_t)rdram->dram;
+
+        if (offset < rdram->dram_size) {
+            offset &= ~(uintptr_t)(l_host_page_size - 1);
+            if (mprotect((unsigned char*)rdram->dram + offset, l_host_page_size, PROT_READ | PROT_WRITE) == 0) {
+                mark_dirty_atomic(rdram, (uint32_t)offset, (uint32_t)l_host_page_size);
+                return;
+            }
+        }
+    }
+
+    /* not a write to protected RDRAM, let the previous handler have it */
+    if (old->sa_flags & SA_SIGINFO) {
+        old->sa_sigaction(sig, info, context);
+    }
+    else if (old->sa_handler == SIG_DFL || old->sa_handler == SIG_IGN) {
+        /* the fault happens again once this returns */
+        signal(sig, SIG_DFL);
+    }
+    else {
+        old->sa_handler(sig);
+    }
+}
+
+static int install_fault_handler(void)
+{
+    struct sigaction action;
+
+    l_host_page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = rdram_write_fault;
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+
+    if (sigaction(SIGSEGV, &action, &l_old_sigsegv) != 0) {
+        return 0;
+    }
+    if (sigaction(SIGBUS, &action, &l_old_sigbus) != 0) {
+        sigaction(SIGSEGV, &l_old_sigsegv, NULL);
+        return 0;
+    }
+    return 1;
+}
+
+static void remove_fault_handler(void)
+{
+    sigaction(SIGSEGV, &l_old_sigsegv, NULL);
+    sigaction(SIGBUS, &l_old_sigbus, NULL);
+}
+
+static int protect_rdram(struct rdram* rdram, int read_only)
+{
+    return mprotect(rdram->dram, rdram->dram_size, read_only ? PROT_READ : (PROT_READ | PROT_WRITE)) == 0;
+}
+#endif
+
+int rdram_track_plugin_writes(struct rdram* rdram, int enable)
+{
+    if (!enable == !rdram->track_plugin_writes) {
+        return 1;
+    }
+
+#if defined(_WIN32) || defined(RDRAM_PROTECT_POSIX)
+    if (enable) {
+        if (!install_fault_handler()) {
+            return 0;
+        }
+    }
+    else {
+        remove_fault_handler();
+    }
+
+    rdram->track_plugin_writes = enable;
+    return 1;
+#else
+    return !enable;
+#endif
+}
+
+void rdram_begin_plugin_writes(struct rdram* rdram)
+{
+    if (rdram->protected_pages) {
+        return;
+    }
+
+    if (!rdram->track_plugin_writes) {
+        rdram->untracked_writes = 1;
+        return;
+    }
+
+#if defined(_WIN32) || defined(RDRAM_PROTECT_POSIX)
+    /* protection works on whole host pages, and RDRAM may come from malloc */
+    if (((uintptr_t)rdram->dram & (l_host_page_size - 1)) == 0
+     && (rdram->dram_size & (l_host_page_size - 1)) == 0) {
+        l_protected_rdram = rdram;
+        if (protect_rdram(rdram, 1)) {
+            rdram->protected_pages = 1;
+            return;
+        }
+        l_protected_rdram = NULL;
+    }
+#endif
+
+    rdram->untracked_writes = 1;
+}
+
+void rdram_end_plugin_writes(struct rdram* rdram)
+{
+#if defined(_WIN32) || defined(RDRAM_PROTECT_POSIX)
+    if (rdram->protected_pages) {
+        protect_rdram(rdram, 0);
+        rdram->protected_pages = 0;
+        l_protected_rdram = NULL;
+    }
+#else
+    (void)rdram;
+#endif
 }
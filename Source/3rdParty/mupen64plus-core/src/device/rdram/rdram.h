@@ -47,6 +47,11 @@ enum rdram_registers
 /* IPL3 rdram initialization accepts up to 8 RDRAM modules */
 enum { RDRAM_MAX_MODULES_COUNT = 8 };
 
+/* writes to RDRAM are tracked in 4KB pages (up to 8MB of RDRAM) */
+enum { RDRAM_DIRTY_PAGE_SHIFT = 12 };
+enum { RDRAM_DIRTY_PAGE_SIZE = 1 << RDRAM_DIRTY_PAGE_SHIFT };
+enum { RDRAM_DIRTY_PAGES_COUNT = 0x800000 >> RDRAM_DIRTY_PAGE_SHIFT };
+
 struct rdram
 {
     uint32_t regs[RDRAM_MAX_MODULES_COUNT][RDRAM_REGS_COUNT];
@@ -56,6 +61,17 @@ struct rdram
 
     uint8_t corrupted_handler;
 
+    /* pages written since the last rdram_clear_dirty_pages(). The r4300
+     * emulators, DMAs and cheats mark the pages they write, plugin writes
+     * are caught by write protecting RDRAM while plugins run (see
+     * rdram_begin_plugin_writes) */
+    uint32_t dirty_pages[RDRAM_DIRTY_PAGES_COUNT / 32];
+    /* set when RDRAM may have been written without marking the pages */
+    int untracked_writes;
+    /* whether plugin writes should be tracked, and RDRAM is protected */
+    int track_plugin_writes;
+    int protected_pages;
+
     struct r4300_core* r4300;
 };
 
@@ -69,6 +85,41 @@ static osal_inline uint32_t rdram_dram_address(uint32_t address)
     return (address & 0xffffff) >> 2;
 }
 
+static osal_inline void rdram_mark_dirty(struct rdram* rdram, uint32_t address, uint32_t length)
+{
+    uint32_t page;
+    uint32_t last;
+
+    address &= 0xffffff;
+    if (length == 0 || address >= 0x800000)
+        return;
+
+    if (length > 0x800000 - address)
+        length = 0x800000 - address;
+
+    last = (address + length - 1) >> RDRAM_DIRTY_PAGE_SHIFT;
+    for (page = address >> RDRAM_DIRTY_PAGE_SHIFT; page <= last; ++page)
+        rdram->dirty_pages[page >> 5] |= UINT32_C(1) << (page & 31);
+}
+
+static osal_inline int rdram_is_page_dirty(const struct rdram* rdram, uint32_t page)
+{
+    return (rdram->dirty_pages[page >> 5] >> (page & 31)) & 1;
+}
+
+void rdram_clear_dirty_pages(struct rdram* rdram);
+
+/* Plugins write RDRAM through their own pointer. Once tracking is enabled,
+ * the calls into plugins which may write RDRAM are wrapped by these, and the
+ * pages written in between get marked through a write fault. Where RDRAM
+ * can't be protected, untracked_writes is set instead. Writes which plugins
+ * make outside of their calls (threaded or GPU renderers) don't fault, the
+ * snapshots set untracked_writes for these plugins, see
+ * plugin_gfx_writes_rdram_async(). */
+int rdram_track_plugin_writes(struct rdram* rdram, int enable);
+void rdram_begin_plugin_writes(struct rdram* rdram);
+void rdram_end_plugin_writes(struct rdram* rdram);
+
 void init_rdram(struct rdram* rdram,
                 uint32_t* dram,
                 size_t dram_size,
@@ -75,6 +75,7 @@ static uint8_t read_address_8bit(struct r4300_core* r4300, uint32_t address)
 static void update_address_16bit(struct r4300_core* r4300, uint32_t address, uint16_t new_value)
 {
     *(uint16_t*)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S16))) = new_value;
+    rdram_mark_dirty(r4300->rdram, address, 2);
     /* mask out bit 24 which is used by GS codes to specify 8/16 bits */
     address &= 0xfeffffff;
     invalidate_r4300_cached_code(r4300, address, 2);
@@ -83,6 +84,7 @@ static void update_address_16bit(struct r4300_core* r4300, uint32_t address, uin
 static void update_address_8bit(struct r4300_core* r4300, uint32_t address, uint8_t new_value)
 {
     *(uint8_t*)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S8))) = new_value;
+    rdram_mark_dirty(r4300->rdram, address, 1);
     invalidate_r4300_cached_code(r4300, address, 1);
 }
 
@@ -0,0 +1,407 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - guest_profiler.c                                        *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "guest_profiler.h"
+
+#include <SDL.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/m64p_types.h"
+#include "device/r4300/interrupt.h"
+#include "device/r4300/r4300_core.h"
+#include "device/rdram/rdram.h"
+
+/* both must be powers of two */
+#define RING_SIZE      0x10000
+#define ENTRIES_SIZE   0x4000
+#define FUNCTIONS_SIZE 0x4000
+
+/* how far back a function start is looked for, in instructions */
+#define MAX_FUNCTION_SCAN 0x1000
+
+/* average cycles between two samples, each interval is
+ * picked at random within +/-50% of it, so the samples
+ * don't lock onto code which runs periodically */
+#define SAMPLE_INTERVAL 10000
+
+/* longer intervals come from loading a state or a reset */
+#define MAX_SAMPLE_CYCLES UINT32_C(0x1000000)
+
+#define OPCODE_JR_RA            UINT32_C(0x03E00008)
+#define OPCODE_ADDIU_SP_SP_NEG  UINT32_C(0x27BD8000)
+#define OPCODE_DADDIU_SP_SP_NEG UINT32_C(0x67BD8000)
+
+struct sample
+{
+    uint32_t function;
+    uint32_t caller;
+    uint32_t cycles;
+};
+
+struct entry
+{
+    uint32_t function;
+    uint32_t caller;
+    unsigned int samples;
+    uint64_t cycles;
+};
+
+struct function
+{
+    /* address of the sample | 1, 0 when unused */
+    uint32_t key;
+    uint32_t function;
+};
+
+static SDL_atomic_t l_enabled;
+static SDL_atomic_t l_dropped;
+
+/* head is only written by the emulator thread, tail by the consumer */
+static SDL_atomic_t l_head;
+static SDL_atomic_t l_tail;
+static struct sample l_ring[RING_SIZE];
+
+/* set when the function cache has to be cleared */
+static SDL_atomic_t l_clear_functions;
+
+/* only used by the emulator thread, functions are resolved when
+ * a sample is taken, while the guest code can't change */
+static const struct r4300_core* l_r4300;
+static uint32_t l_last_count;
+static uint32_t l_random = 1;
+static struct function l_functions[FUNCTIONS_SIZE];
+static unsigned int l_functions_count;
+
+/* only used with l_lock held */
+static SDL_SpinLock l_lock;
+static struct entry l_entries[ENTRIES_SIZE];
+static unsigned int l_entries_count;
+static unsigned int l_samples;
+static uint64_t l_cycles;
+
+static uint32_t hash32(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= UINT32_C(0x7feb352d);
+    value ^= value >> 15;
+    value *= UINT32_C(0x846ca68b);
+    value ^= value >> 16;
+    return value;
+}
+
+static int read_code(uint32_t address, uint32_t* word)
+{
+    uint32_t physical;
+
+    if ((address & UINT32_C(0xC0000000)) == UINT32_C(0x80000000)) {
+        physical = address & UINT32_C(0x1FFFFFFF);
+    }
+    else {
+        uint32_t lut = l_r4300->cp0.tlb.LUT_r[address >> 12];
+        if (lut == 0) {
+            return 0;
+        }
+        physical = ((lut & UINT32_C(0xFFFFF000)) | (address & UINT32_C(0xFFF))) & UINT32_C(0x1FFFFFFF);
+    }
+
+    /* code run from the cartridge or the RSP memory isn't resolved */
+    if ((size_t)physical + 4 > l_r4300->rdram->dram_size) {
+        return 0;
+    }
+
+    *word = l_r4300->rdram->dram[physical >> 2];
+    return 1;
+}
+
+static uint32_t scan_function(uint32_t address)
+{
+    uint32_t start = address;
+    uint32_t word;
+    unsigned int i;
+
+    for (i = 0; i < MAX_FUNCTION_SCAN; ++i, start -= 4) {
+        if (!read_code(start, &word)) {
+            break;
+        }
+
+        /* the stack frame is allocated by the first instruction */
+        if ((word & UINT32_C(0xFFFF8000)) == OPCODE_ADDIU_SP_SP_NEG
+         || (word & UINT32_C(0xFFFF8000)) == OPCODE_DADDIU_SP_SP_NEG) {
+            return start;
+        }
+
+        /* the previous function ends with 'jr ra' and its delay slot,
+         * this also finds leaf functions without a stack frame */
+        if (read_code(start - 8, &word) && word == OPCODE_JR_RA) {
+            return start;
+        }
+    }
+
+    return address;
+}
+
+static uint32_t find_function(uint32_t address)
+{
+    uint32_t key = address | 1;
+    uint32_t i = hash32(key) & (FUNCTIONS_SIZE - 1);
+
+    while (l_functions[i].key != 0) {
+        if (l_functions[i].key == key) {
+            return l_functions[i].function;
+        }
+        i = (i + 1) & (FUNCTIONS_SIZE - 1);
+    }
+
+    /* the cache only saves rescanning, so it's dropped when full */
+    if (l_functions_count >= FUNCTIONS_SIZE / 2) {
+        memset(l_functions, 0, sizeof(l_functions));
+        l_functions_count = 0;
+        i = hash32(key) & (FUNCTIONS_SIZE - 1);
+    }
+
+    l_functions[i].key = key;
+    l_functions[i].function = scan_function(address);
+    ++l_functions_count;
+    return l_functions[i].function;
+}
+
+static uint32_t find_caller(uint32_t ra, uint32_t function)
+{
+    uint32_t word;
+    uint32_t caller;
+
+    /* ra only points to the caller right after a jal or jalr */
+    if (!read_code(ra - 8, &word)) {
+        return 0;
+    }
+    if ((word >> 26) != 3 && (word & UINT32_C(0xFC00003F)) != 9) {
+        return 0;
+    }
+
+    caller = find_function(ra - 8);
+
+    /* ra was set by a call made by the function itself */
+    return (caller == function) ? 0 : caller;
+}
+
+static void add_sample(const struct sample* sample)
+{
+    uint32_t function = sample->function;
+    uint32_t caller = sample->caller;
+    uint32_t i = hash32(function ^ hash32(caller)) & (ENTRIES_SIZE - 1);
+
+    while (l_entries[i].samples != 0
+        && (l_entries[i].function != function || l_entries[i].caller != caller)) {
+        i = (i + 1) & (ENTRIES_SIZE - 1);
+    }
+
+    if (l_entries[i].samples == 0) {
+        /* once the table is full, new functions are
+         * added to the entry of function 0 */
+        if (l_entries_count >= ENTRIES_SIZE * 3 / 4) {
+            function = caller = 0;
+            i = hash32(0) & (ENTRIES_SIZE - 1);
+            while (l_entries[i].samples != 0
+                && (l_entries[i].function != 0 || l_entries[i].caller != 0)) {
+                i = (i + 1) & (ENTRIES_SIZE - 1);
+            }
+        }
+
+        if (l_entries[i].samples == 0) {
+            l_entries[i].function = function;
+            l_entries[i].caller = caller;
+            ++l_entries_count;
+        }
+    }
+
+    l_entries[i].samples++;
+    l_entries[i].cycles += sample->cycles;
+    l_samples++;
+    l_cycles += sample->cycles;
+}
+
+/* must be called with l_lock held */
+static void drain_samples(void)
+{
+    unsigned int head = (unsigned int)SDL_AtomicGet(&l_head);
+    unsigned int tail = (unsigned int)SDL_AtomicGet(&l_tail);
+
+    for (; tail != head; ++tail) {
+        add_sample(&l_ring[tail & (RING_SIZE - 1)]);
+    }
+
+    SDL_AtomicSet(&l_tail, (int)tail);
+}
+
+static int compare_entries(const void* a, const void* b)
+{
+    const struct entry* entry_a = (const struct entry*)a;
+    const struct entry* entry_b = (const struct entry*)b;
+
+    if (entry_a->cycles != entry_b->cycles) {
+        return (entry_a->cycles > entry_b->cycles) ? -1 : 1;
+    }
+
+    return 0;
+}
+
+void guest_profiler_enable(int enable)
+{
+    SDL_AtomicLock(&l_lock);
+
+    if (enable) {
+        /* drop the samples which weren't aggregated yet,
+         * the emulator thread only moves the head */
+        SDL_AtomicSet(&l_tail, SDL_AtomicGet(&l_head));
+        SDL_AtomicSet(&l_dropped, 0);
+        SDL_AtomicSet(&l_clear_functions, 1);
+        memset(l_entries, 0, sizeof(l_entries));
+        l_entries_count = 0;
+        l_samples = 0;
+        l_cycles = 0;
+    }
+
+    SDL_AtomicSet(&l_enabled, enable);
+    SDL_AtomicUnlock(&l_lock);
+}
+
+void guest_profiler_attach(void)
+{
+    /* code may have changed since the last run */
+    SDL_AtomicSet(&l_clear_functions, 1);
+}
+
+void guest_profiler_detach(void)
+{
+    SDL_AtomicLock(&l_lock);
+    drain_samples();
+    SDL_AtomicUnlock(&l_lock);
+}
+
+static unsigned int next_interval(void)
+{
+    /* xorshift, rand() would change the randomized interrupt timings */
+    l_random ^= l_random << 13;
+    l_random ^= l_random >> 17;
+    l_random ^= l_random << 5;
+
+    return SAMPLE_INTERVAL / 2 + l_random % SAMPLE_INTERVAL;
+}
+
+void guest_profiler_update(struct r4300_core* r4300)
+{
+    if (!SDL_AtomicGet(&l_enabled) || get_event(&r4300->cp0.q, PROFILER_EVT) != NULL) {
+        return;
+    }
+
+    /* the event is gone after starting the profiler,
+     * loading a state or a reset */
+    l_last_count = r4300_cp0_regs(&r4300->cp0)[CP0_COUNT_REG];
+    add_interrupt_event(&r4300->cp0, PROFILER_EVT, next_interval());
+}
+
+void guest_profiler_event(void* opaque)
+{
+    struct r4300_core* r4300 = (struct r4300_core*)opaque;
+    struct sample* sample;
+    unsigned int head;
+    uint32_t count;
+    uint32_t cycles;
+
+    /* the event isn't scheduled again once the profiler is stopped */
+    if (!SDL_AtomicGet(&l_enabled)) {
+        return;
+    }
+
+    count = r4300_cp0_regs(&r4300->cp0)[CP0_COUNT_REG];
+    cycles = count - l_last_count;
+    l_last_count = count;
+
+    add_interrupt_event(&r4300->cp0, PROFILER_EVT, next_interval());
+
+    if (cycles == 0 || cycles > MAX_SAMPLE_CYCLES) {
+        return;
+    }
+
+    head = (unsigned int)SDL_AtomicGet(&l_head);
+    if (head - (unsigned int)SDL_AtomicGet(&l_tail) >= RING_SIZE) {
+        SDL_AtomicAdd(&l_dropped, 1);
+        return;
+    }
+
+    if (SDL_AtomicSet(&l_clear_functions, 0)) {
+        memset(l_functions, 0, sizeof(l_functions));
+        l_functions_count = 0;
+    }
+
+    l_r4300 = r4300;
+    sample = &l_ring[head & (RING_SIZE - 1)];
+    sample->function = find_function(*r4300_pc(r4300));
+    sample->caller = find_caller((uint32_t)r4300_regs(r4300)[31], sample->function);
+    sample->cycles = cycles;
+
+    SDL_AtomicSet(&l_head, (int)(head + 1));
+}
+
+m64p_error guest_profiler_report(m64p_profile_report* report)
+{
+    struct entry* entries;
+    unsigned int count = 0;
+    unsigned int i;
+
+    SDL_AtomicLock(&l_lock);
+
+    drain_samples();
+
+    entries = malloc(l_entries_count * sizeof(entries[0]) + 1);
+    if (entries == NULL) {
+        SDL_AtomicUnlock(&l_lock);
+        return M64ERR_NO_MEMORY;
+    }
+
+    for (i = 0; i < ENTRIES_SIZE; ++i) {
+        if (l_entries[i].samples != 0) {
+            entries[count++] = l_entries[i];
+        }
+    }
+
+    report->total_entries = count;
+    report->samples = l_samples;
+    report->cycles = l_cycles;
+    report->dropped = (unsigned int)SDL_AtomicGet(&l_dropped);
+
+    SDL_AtomicUnlock(&l_lock);
+
+    qsort(entries, count, sizeof(entries[0]), compare_entries);
+
+    report->count = (count < report->size) ? count : report->size;
+    for (i = 0; i < report->count; ++i) {
+        report->entries[i].function = entries[i].function;
+        report->entries[i].caller = entries[i].caller;
+        report->entries[i].samples = entries[i].samples;
+        report->entries[i].cycles = entries[i].cycles;
+    }
+
+    free(entries);
+    return M64ERR_SUCCESS;
+}
@@ -0,0 +1,62 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - guest_profiler.h                                        *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_GUEST_PROFILER_H
+#define M64P_MAIN_GUEST_PROFILER_H
+
+#include "api/m64p_types.h"
+
+struct r4300_core;
+
+/* Sampling profiler of the emulated CPU.
+ *
+ * The guest PC is sampled by the emulator thread from a dedicated event
+ * in the interrupt queue, scheduled every SAMPLE_INTERVAL emulated cycles
+ * with a random jitter, so the samples are neither tied to the other
+ * events nor to periodic code. Each sample is weighted by the cycles
+ * elapsed since the previous one. The event isn't part of savestates.
+ *
+ * Guest code has no symbols, so the function of a sample is found by
+ * scanning the code backwards for a stack frame allocation or for the
+ * 'jr ra' ending the previous function. The caller is found from the
+ * return address register when it follows a call, which gives a
+ * two-level stack for flamegraphs. Both are resolved when the sample is
+ * taken, then the sample goes through a lock-free single producer,
+ * single consumer ring and is aggregated by the thread asking for a
+ * report. */
+
+/* enabling clears the previous samples */
+void guest_profiler_enable(int enable);
+
+/* called by the emulator thread before and after running */
+void guest_profiler_attach(void);
+void guest_profiler_detach(void);
+
+/* called by the emulator thread from gen_interrupt(),
+ * schedules the profiler event when it's missing */
+void guest_profiler_update(struct r4300_core* r4300);
+
+/* handler of the profiler event, takes a sample */
+void guest_profiler_event(void* opaque);
+
+m64p_error guest_profiler_report(m64p_profile_report* report);
+
+#endif /* M64P_MAIN_GUEST_PROFILER_H */
@@ -65,6 +65,7 @@
 #include "device/gb/gb_cart.h"
 #include "device/pif/bootrom_hle.h"
 #include "eventloop.h"
+#include "guest_profiler.h"
 #include "main.h"
 #include "osal/files.h"
 #include "osal/preproc.h"
@@ -76,6 +77,7 @@
 #include "rom.h"
 #include "savestates.h"
 #include "screenshot.h"
+#include "snapshots.h"
 #include "util.h"
 #include "netplay.h"
 
@@ -94,6 +96,7 @@
 m64p_handle g_CoreConfig = NULL;
 
 m64p_frame_callback g_FrameCallback = NULL;
+m64p_input_poll_callback g_InputPollCallback = NULL;
 
 int         g_RomWordsLittleEndian = 0; // after loading, ROM words are in native N64 byte order (big endian). We will swap them on x86
 int         g_EmulatorRunning = 0;      // need separate boolean to tell if emulator is running, since --nogui doesn't use a thread
@@ -123,6 +126,10 @@ static int   l_TakeScreenshot = 0;       // Tell OSD Rendering callback to take
 static int   l_SpeedFactor = 100;        // percentage of nominal game speed at which emulator is running
 static int   l_FrameAdvance = 0;         // variable to check if we pause on next frame
 static int   l_MainSpeedLimit = 1;       // insert delay during vi_interrupt to keep speed at real-time
+static int   l_FrameCallbackPending = 0; // frame callback is delivered at the next frame safe point
+static int   l_FrameCallbackIndex = 0;   // frame index passed to the pending frame callback
+static int   l_InFrameSafePoint = 0;     // set while the frame callback runs from a frame safe point
+static int   l_Resimulating = 0;         // set while the front-end re-emulates frames, audio and video output is suppressed
 
 static osd_message_t *l_msgVol = NULL;
 static osd_message_t *l_msgFF = NULL;
@@ -428,6 +435,7 @@ int main_set_core_defaults(void)
     ConfigSetDefaultInt(g_CoreConfig, "CountPerOp", 0, "Force number of cycles per emulated instruction");
     ConfigSetDefaultInt(g_CoreConfig, "CountPerOpDenomPot", 0, "Reduce number of cycles per update by power of two when set greater than 0 (overclock)");
     ConfigSetDefaultBool(g_CoreConfig, "AutoStateSlotIncrement", 0, "Increment the save state slot after each save operation");
+    ConfigSetDefaultInt(g_CoreConfig, "SaveStateCodec", M64CODEC_ZLIB, "Compression of Mupen64Plus save states (0: None, 1: Gzip, 2: LZ4, faster but only loadable by newer builds)");
     ConfigSetDefaultInt(g_CoreConfig, "CurrentStateSlot", 0, "Save state slot (0-9) to use when saving/loading the emulator state");
     ConfigSetDefaultBool(g_CoreConfig, "EnableDebugger", 0, "Activate the R4300 debugger when ROM execution begins, if core was built with Debugger support");
     ConfigSetDefaultString(g_CoreConfig, "ScreenshotPath", "", "Path to directory where screenshots are saved. If this is blank, the default value of ${UserDataPath}/screenshot will be used");
@@ -439,6 +447,9 @@ int main_set_core_defaults(void)
     ConfigSetDefaultString(g_CoreConfig, "GbCameraVideoCaptureBackend1", DEFAULT_VIDEO_CAPTURE_BACKEND, "Gameboy Camera Video Capture backend");
     ConfigSetDefaultInt(g_CoreConfig, "SaveDiskFormat", 1, "Disk Save Format (0: Full Disk Copy (*.ndr/*.d6r), 1: RAM Area Only (*.ram))");
     ConfigSetDefaultInt(g_CoreConfig, "SaveFilenameFormat", 1, "Save (SRAM/State) Filename Format (0: ROM Header Name, 1: Automatic (including partial MD5 hash))");
+    ConfigSetDefaultInt(g_CoreConfig, "DynarecSymbols", 0, "Export the blocks of the dynamic recompiler for perf on Linux (0: Disabled, 1: /tmp/perf-<pid>.map, 2: jitdump /tmp/jit-<pid>.dump, record with 'perf record -k mono')");
+    ConfigSetDefaultInt(g_CoreConfig, "DynarecCacheSize", 32, "Initial size of the translation cache of the dynamic recompiler in MB (4-128), it grows up to DynarecCacheMaxSize when translated code is evicted too often");
+    ConfigSetDefaultInt(g_CoreConfig, "DynarecCacheMaxSize", 128, "Maximum size of the translation cache of the dynamic recompiler in MB (4-128, 32 at most on 32-bit x86 and ARM)");
 
     /* handle upgrades */
     if (bUpgrade)
@@ -679,6 +690,101 @@ void main_state_save(int format, const char *filename)
         savestates_set_job(savestates_job_save, (savestates_type)format, filename);
 }
 
+m64p_error main_state_save_memory(m64p_state_memory *state)
+{
+    size_t used = 0;
+
+    if (state->buffer == NULL) // size query
+    {
+        state->used = (unsigned int)savestates_get_memory_size();
+        return M64ERR_SUCCESS;
+    }
+
+    if (!g_EmulatorRunning || !l_InFrameSafePoint || netplay_is_init())
+        return M64ERR_INVALID_STATE;
+
+    if (state->size < savestates_get_memory_size())
+        return M64ERR_INPUT_INVALID;
+
+    if (!savestates_save_memory(state->buffer, state->size, &used))
+        return M64ERR_INTERNAL;
+
+    state->used = (unsigned int)used;
+    return M64ERR_SUCCESS;
+}
+
+m64p_error main_state_load_memory(m64p_state_memory *state)
+{
+    if (!g_EmulatorRunning || !l_InFrameSafePoint || netplay_is_init())
+        return M64ERR_INVALID_STATE;
+
+    if (state->buffer == NULL)
+        return M64ERR_INPUT_INVALID;
+
+    if (!savestates_load_memory(state->buffer, state->size))
+        return M64ERR_INPUT_INVALID;
+
+    return M64ERR_SUCCESS;
+}
+
+m64p_error main_state_snapshots_init(unsigned int count, m64p_state_codec codec)
+{
+    /* the ring can't change under a running emulator */
+    if (g_EmulatorRunning && !l_InFrameSafePoint)
+        return M64ERR_INVALID_STATE;
+
+    if (codec != M64CODEC_NONE && codec != M64CODEC_ZLIB && codec != M64CODEC_LZ4)
+        return M64ERR_INPUT_INVALID;
+
+    if (!snapshots_init(count, codec))
+        return M64ERR_NO_MEMORY;
+
+    return M64ERR_SUCCESS;
+}
+
+m64p_error main_state_snapshots_set_budget(unsigned int megabytes)
+{
+    if (g_EmulatorRunning && !l_InFrameSafePoint)
+        return M64ERR_INVALID_STATE;
+
+    snapshots_set_budget((size_t)megabytes << 20);
+    return M64ERR_SUCCESS;
+}
+
+m64p_error main_state_snapshot_save(m64p_state_snapshot *snapshot)
+{
+    size_t size = 0;
+    size_t raw_size = 0;
+
+    if (!g_EmulatorRunning || !l_InFrameSafePoint || netplay_is_init())
+        return M64ERR_INVALID_STATE;
+
+    if (!snapshots_save(snapshot->id, &size, &raw_size, &snapshot->pages,
+                        &snapshot->state_hash, snapshot->rdram_hashes))
+        return M64ERR_INTERNAL;
+
+    snapshot->size = (unsigned int)size;
+    snapshot->raw_size = (unsigned int)raw_size;
+    return M64ERR_SUCCESS;
+}
+
+m64p_error main_state_snapshot_load(m64p_state_snapshot *snapshot)
+{
+    if (!g_EmulatorRunning || !l_InFrameSafePoint || netplay_is_init())
+        return M64ERR_INVALID_STATE;
+
+    switch (snapshots_load(snapshot->id))
+    {
+        case 1:
+            return M64ERR_SUCCESS;
+        case 0:
+            return M64ERR_INPUT_INVALID;
+        default:
+            /* the machine is inconsistent, the front-end has to restore a full state */
+            return M64ERR_INTERNAL;
+    }
+}
+
 m64p_error main_core_state_query(m64p_core_param param, int *rval)
 {
     switch (param)
@@ -729,6 +835,9 @@ m64p_error main_core_state_query(m64p_core_param param, int *rval)
         case M64CORE_INPUT_GAMESHARK:
             *rval = event_gameshark_active();
             break;
+        case M64CORE_RESIMULATING:
+            *rval = l_Resimulating;
+            break;
         // these are only used for callbacks; they cannot be queried or set
         case M64CORE_SCREENSHOT_CAPTURED:
         case M64CORE_STATE_LOADCOMPLETE:
@@ -825,6 +934,12 @@ m64p_error main_core_state_set(m64p_core_param param, int val)
                 return M64ERR_INVALID_STATE;
             event_set_gameshark(val);
             return M64ERR_SUCCESS;
+        case M64CORE_RESIMULATING:
+            /* clearing it is always allowed, it's cleared when emulation stops anyway */
+            if (val && !g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            l_Resimulating = val ? 1 : 0;
+            return M64ERR_SUCCESS;
         // these are only used for callbacks; they cannot be queried or set
         case M64CORE_STATE_LOADCOMPLETE:
         case M64CORE_STATE_SAVECOMPLETE:
@@ -834,6 +949,11 @@ m64p_error main_core_state_set(m64p_core_param param, int val)
     }
 }
 
+int main_is_resimulating(void)
+{
+    return l_Resimulating;
+}
+
 m64p_error main_get_screen_size(int *width, int *height)
 {
     gfx.readScreen(NULL, width, height, 0);
@@ -948,8 +1068,13 @@ static void video_plugin_render_callback(int bScreenRedrawn)
 
 void new_frame(void)
 {
+    /* new_frame() runs in the middle of an RSP task, so the frame callback
+     * is deferred to the next point where the machine state is consistent */
     if (g_FrameCallback != NULL)
-        (*g_FrameCallback)(l_CurrentFrame);
+    {
+        l_FrameCallbackPending = 1;
+        l_FrameCallbackIndex = l_CurrentFrame;
+    }
 
     /* advance the current frame */
     l_CurrentFrame++;
@@ -961,6 +1086,23 @@ void new_frame(void)
     }
 }
 
+void main_frame_safe_point(void)
+{
+    if (!l_FrameCallbackPending)
+        return;
+
+    l_FrameCallbackPending = 0;
+
+    if (g_FrameCallback == NULL)
+        return;
+
+    /* the frontend may use M64CMD_STATE_SAVE_MEMORY and
+     * M64CMD_STATE_LOAD_MEMORY from within the frame callback */
+    l_InFrameSafePoint = 1;
+    (*g_FrameCallback)(l_FrameCallbackIndex);
+    l_InFrameSafePoint = 0;
+}
+
 static void apply_speed_limiter(void)
 {
     static unsigned long totalVIs = 0;
@@ -1561,6 +1703,9 @@ void main_change_gb_cart(int control_id)
 
     change_gb_cart(tpk, gb_cart);
 
+    /* a GB cart adds its state to savestates */
+    savestates_init_pool(&g_dev);
+
     if (tpk->gb_cart != NULL) {
         const uint8_t* rom_data = gb_cart->irom_storage->data(gb_cart->rom_storage);
         DebugMessage(M64MSG_INFO, "Inserting GB cart %s into transferpak %u", rom_data + 0x134, control_id);
@@ -1940,6 +2085,8 @@ m64p_error main_run(void)
 
     /* initialize frame counter */
     l_CurrentFrame = 0;
+    l_FrameCallbackPending = 0;
+    l_Resimulating = 0;
 
     /* initialize the on-screen display */
     if (ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay"))
@@ -1970,7 +2117,12 @@ m64p_error main_run(void)
 
     poweron_device(&g_dev);
     pif_bootrom_hle_execute(&g_dev.r4300);
+
+    /* the state size is known from here on */
+    savestates_init_pool(&g_dev);
+    guest_profiler_attach();
     run_device(&g_dev);
+    guest_profiler_detach();
 
     /* now begin to shut down */
 #ifdef WITH_LIRC
@@ -2011,8 +2163,13 @@ m64p_error main_run(void)
     audio.romClosed();
     gfx.romClosed();
 
+    /* snapshots only make sense for the session they were taken in */
+    snapshots_deinit();
+    savestates_free_pool();
+
     // clean up
     g_EmulatorRunning = 0;
+    l_Resimulating = 0;
     StateChanged(M64CORE_EMU_STATE, M64EMU_STOPPED);
 
     return M64ERR_SUCCESS;
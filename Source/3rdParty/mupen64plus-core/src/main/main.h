@@ -52,6 +52,7 @@ extern struct device g_dev;
 extern m64p_media_loader g_media_loader;
 
 extern m64p_frame_callback g_FrameCallback;
+extern m64p_input_poll_callback g_InputPollCallback;
 
 extern int g_gs_vi_counter;
 
@@ -61,6 +62,7 @@ const char* get_savestatefilename(void);
 
 void new_frame(void);
 void new_vi(void);
+void main_frame_safe_point(void);
 
 void main_switch_next_pak(int control_id);
 void main_switch_plugin_pak(int control_id);
@@ -79,12 +81,20 @@ void main_speeddown(int percent);
 void main_set_fastforward(int enable);
 void main_speedlimiter_toggle(void);
 
+int main_is_resimulating(void);
+
 void main_take_next_screenshot(void);
 
 void main_state_set_slot(int slot);
 void main_state_inc_slot(void);
 void main_state_load(const char *filename);
 void main_state_save(int format, const char *filename);
+m64p_error main_state_save_memory(m64p_state_memory *state);
+m64p_error main_state_load_memory(m64p_state_memory *state);
+m64p_error main_state_snapshots_init(unsigned int count, m64p_state_codec codec);
+m64p_error main_state_snapshots_set_budget(unsigned int megabytes);
+m64p_error main_state_snapshot_save(m64p_state_snapshot *snapshot);
+m64p_error main_state_snapshot_load(m64p_state_snapshot *snapshot);
 
 m64p_error main_core_state_query(m64p_core_param param, int *rval);
 m64p_error main_core_state_set(m64p_core_param param, int val);
@@ -30,6 +30,11 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
+#include <SDL.h>
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 #define M64P_CORE_PROTOTYPES 1
 #include "api/callbacks.h"
 #include "api/config.h"
@@ -44,10 +49,20 @@
 #include "osal/preproc.h"
 #include "osd/osd.h"
 #include "rom.h"
+#include "rom_swap.h"
 #include "util.h"
 
 #define CHUNKSIZE 1024*128 /* Read files 128KB at a time. */
 
+/* Binary index of the ROM database in the user cache directory */
+#define ROMDATABASE_INDEX_FILENAME "mupen64plus.ini.idx"
+#define ROMDATABASE_INDEX_MAGIC "M64PRDBI"
+#define ROMDATABASE_INDEX_VERSION 1
+#define ROMDATABASE_INDEX_NONE 0xFFFFFFFFu
+
+/* Number of ROM images of which the MD5 is remembered */
+#define ROM_HASH_CACHE_SIZE 32
+
 /* Number of cpu cycles per instruction */
 enum { DEFAULT_COUNT_PER_OP = 2 };
 /* by default, extra mem is enabled */
@@ -59,8 +74,81 @@ enum { DEFAULT_AI_DMA_MODIFIER = 100 };
 
 static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5);
 
+/* The ROM database is looked up in a binary index with a hash table for the
+ * MD5s and one for the CRCs. The index is cached in the user cache directory,
+ * so the ROM database only has to be parsed again when it has changed.
+ */
+typedef struct
+{
+    int have_database;
+    int loaded;
+    SDL_mutex* lock;
+    unsigned char* index;
+    romdatabase_entry* entries;
+    const uint32_t* md5_table;
+    const uint32_t* crc_table;
+    uint32_t table_mask;
+} _romdatabase;
+
+/* The binary index starts with this header, followed by the entries,
+ * the MD5 hash table, the CRC hash table and the strings. The hash tables
+ * hold entry indices and use linear probing. The index is only ever read
+ * by the machine which wrote it, so it uses the native byte order.
+ */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    int64_t ini_mtime;
+    int64_t ini_size;
+    uint64_t ini_path_hash;
+    uint32_t entry_count;
+    uint32_t table_size;
+    uint32_t strings_size;
+    uint32_t reserved;
+} romdatabase_index_header;
+
+typedef struct
+{
+    md5_byte_t md5[16];
+    uint32_t crc1;
+    uint32_t crc2;
+    uint32_t goodname; /* offset in the strings or ROMDATABASE_INDEX_NONE */
+    uint32_t cheats; /* offset in the strings or ROMDATABASE_INDEX_NONE */
+    uint32_t sidmaduration;
+    uint32_t aidmamodifier;
+    uint32_t set_flags;
+    uint8_t status;
+    uint8_t savetype;
+    uint8_t players;
+    uint8_t rumble;
+    uint8_t countperop;
+    uint8_t disableextramem;
+    uint8_t transferpak;
+    uint8_t mempak;
+    uint8_t biopak;
+    uint8_t padding[3];
+} romdatabase_index_entry;
+
 static _romdatabase g_romdatabase;
 
+/* The MD5 of the last probed or opened ROM images, indexed by their size
+ * and XXH3 hash, which is a lot faster to compute than the MD5 itself.
+ * The header CRCs tell early on whether a ROM image may be known. */
+typedef struct
+{
+    XXH128_hash_t hash;
+    unsigned int size;
+    uint32_t crc1;
+    uint32_t crc2;
+    md5_byte_t digest[16];
+} rom_hash_cache_entry;
+
+static rom_hash_cache_entry l_rom_hash_cache[ROM_HASH_CACHE_SIZE];
+static unsigned int l_rom_hash_cache_next;
+static SDL_SpinLock l_rom_hash_cache_lock;
+
 /* Global loaded rom size. */
 int g_rom_size = 0;
 
@@ -87,62 +175,195 @@ static int is_valid_rom(const unsigned char *buffer, unsigned int size)
         return 0;
 }
 
-/* Copies the source block of memory to the destination block of memory while
- * switching the endianness of .v64 and .n64 images to the .z64 format, which
- * is native to the Nintendo 64. The data extraction routines and MD5 hashing
- * function may only act on the .z64 big-endian format.
+/* Returns the format of a ROM image from its first 4 bytes, V64IMAGE,
+ * N64IMAGE or Z64IMAGE. The data extraction routines and MD5 hashing
+ * function may only act on the .z64 big-endian format, the other formats
+ * are converted with swap_copy_rom_part().
  *
- * IN: src: The source block of memory. This must be a valid Nintendo 64 ROM
- *          image of 'len' bytes.
- *     len: The length of the source and destination, in bytes.
- * OUT: dst: The destination block of memory. This must be a valid buffer for
- *           at least 'len' bytes.
- *      imagetype: A pointer to a byte that gets updated with the value of
- *                 V64IMAGE, N64IMAGE or Z64IMAGE according to the format of
- *                 the source block. The value is undefined if 'src' does not
- *                 represent a valid Nintendo 64 ROM image.
+ * IN: src: The start of a valid Nintendo 64 ROM image.
+ * The value is undefined if 'src' does not represent a valid Nintendo 64 ROM
+ * image.
  */
-static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char* imagetype)
+static unsigned char rom_image_type(const void* src)
 {
     if (memcmp(src, V64_SIGNATURE, sizeof(V64_SIGNATURE)) == 0)
-    {
-        size_t i;
-        const uint16_t* src16 = (const uint16_t*) src;
-        uint16_t* dst16 = (uint16_t*) dst;
+        return V64IMAGE;
+    else if (memcmp(src, N64_SIGNATURE, sizeof(N64_SIGNATURE)) == 0)
+        return N64IMAGE;
+    else
+        return Z64IMAGE;
+}
 
-        *imagetype = V64IMAGE;
+/* Converts a ROM image with the given 'imagetype' to .z64 format, which allows
+ * a ROM image to be converted in several parts. 'len' must be a multiple of 4,
+ * unless it's the last part of the image.
+ */
+static void swap_copy_rom_part(void* dst, const void* src, size_t len, unsigned char imagetype)
+{
+    if (imagetype == V64IMAGE)
+    {
         /* .v64 images have byte-swapped half-words (16-bit). */
-        for (i = 0; i < len; i += 2)
+        swap_copy(dst, src, len, 2);
+    }
+    else if (imagetype == N64IMAGE)
+    {
+        /* .n64 images have byte-swapped words (32-bit). */
+        swap_copy(dst, src, len, 4);
+    }
+    else if (dst != src) {
+        memcpy(dst, src, len);
+    }
+}
+
+/* Returns 1 when a ROM image with the given 'size' and 'header' may be in
+ * the cache, 0 when it's certainly not, so its MD5 has to be computed.
+ */
+static int rom_hash_cache_may_contain(unsigned int size, const m64p_rom_header* header)
+{
+    int found = 0;
+    int i;
+
+    SDL_AtomicLock(&l_rom_hash_cache_lock);
+    for (i = 0; i < ROM_HASH_CACHE_SIZE; i++)
+    {
+        if (l_rom_hash_cache[i].size == size &&
+            l_rom_hash_cache[i].crc1 == header->CRC1 &&
+            l_rom_hash_cache[i].crc2 == header->CRC2)
         {
-            *dst16++ = m64p_swap16(*src16++);
+            found = 1;
+            break;
         }
     }
-    else if (memcmp(src, N64_SIGNATURE, sizeof(N64_SIGNATURE)) == 0)
-    {
-        size_t i;
-        const uint32_t* src32 = (const uint32_t*) src;
-        uint32_t* dst32 = (uint32_t*) dst;
+    SDL_AtomicUnlock(&l_rom_hash_cache_lock);
 
-        *imagetype = N64IMAGE;
-        /* .n64 images have byte-swapped words (32-bit). */
-        for (i = 0; i < len; i += 4)
+    return found;
+}
+
+/* Looks up the MD5 'digest' of the ROM image with the given 'size' and XXH3
+ * 'hash' of its .z64 format, returns 1 when it was found, 0 otherwise.
+ */
+static int rom_hash_cache_find(XXH128_hash_t hash, unsigned int size, md5_byte_t* digest)
+{
+    int found = 0;
+    int i;
+
+    SDL_AtomicLock(&l_rom_hash_cache_lock);
+    for (i = 0; i < ROM_HASH_CACHE_SIZE; i++)
+    {
+        if (l_rom_hash_cache[i].size == size &&
+            XXH128_isEqual(l_rom_hash_cache[i].hash, hash))
         {
-            *dst32++ = m64p_swap32(*src32++);
+            memcpy(digest, l_rom_hash_cache[i].digest, 16);
+            found = 1;
+            break;
         }
     }
-    else {
-        *imagetype = Z64IMAGE;
-        memcpy(dst, src, len);
+    SDL_AtomicUnlock(&l_rom_hash_cache_lock);
+
+    return found;
+}
+
+/* Remembers the MD5 'digest' of the ROM image with the given 'size', 'header'
+ * and XXH3 'hash', replacing the oldest ROM image when there's no room left.
+ */
+static void rom_hash_cache_add(XXH128_hash_t hash, unsigned int size, const m64p_rom_header* header,
+                               const md5_byte_t* digest)
+{
+    md5_byte_t found_digest[16];
+    rom_hash_cache_entry* entry;
+
+    if (rom_hash_cache_find(hash, size, found_digest))
+        return;
+
+    SDL_AtomicLock(&l_rom_hash_cache_lock);
+    entry = &l_rom_hash_cache[l_rom_hash_cache_next];
+    l_rom_hash_cache_next = (l_rom_hash_cache_next + 1) % ROM_HASH_CACHE_SIZE;
+    entry->hash = hash;
+    entry->size = size;
+    entry->crc1 = header->CRC1;
+    entry->crc2 = header->CRC2;
+    memcpy(entry->digest, digest, 16);
+    SDL_AtomicUnlock(&l_rom_hash_cache_lock);
+}
+
+/* Fills in 'settings' with the ROM database entry matching the MD5 'digest' or
+ * the CRCs of 'header', or with the defaults for an unknown ROM when there's no
+ * such entry. Only reads the ROM database, so it doesn't touch the open ROM.
+ *
+ * IN: digest: The MD5 digest of the ROM image in .z64 format.
+ *     header: The ROM header in .z64 format.
+ *     headername: The ROM name from the header, without trailing whitespace.
+ * OUT: settings: Receives the ROM settings, except for the MD5 string.
+ * Returns the ROM database entry or NULL if the ROM is unknown.
+ */
+static romdatabase_entry* rom_settings_from_database(md5_byte_t* digest, const m64p_rom_header* header,
+                                                     const char* headername, m64p_rom_settings* settings)
+{
+    romdatabase_entry* entry;
+
+    /* Look up this ROM in the .ini file and fill in goodname, etc */
+    if ((entry=ini_search_by_md5(digest)) != NULL ||
+        (entry=ini_search_by_crc(tohl(header->CRC1),tohl(header->CRC2))) != NULL)
+    {
+        strncpy(settings->goodname, entry->goodname, 255);
+        settings->goodname[255] = '\0';
+        settings->savetype = entry->savetype;
+        settings->status = entry->status;
+        settings->players = entry->players;
+        settings->rumble = entry->rumble;
+        settings->transferpak = entry->transferpak;
+        settings->mempak = entry->mempak;
+        settings->biopak = entry->biopak;
+        settings->countperop = entry->countperop;
+        settings->disableextramem = entry->disableextramem;
+        settings->sidmaduration = entry->sidmaduration;
+        settings->aidmamodifier = entry->aidmamodifier;
     }
+    else
+    {
+        strcpy(settings->goodname, headername);
+        strcat(settings->goodname, " (unknown rom)");
+        settings->status = 0;
+        settings->players = 4;
+        settings->rumble = 1;
+        settings->transferpak = 0;
+        settings->mempak = 1;
+        settings->biopak = 0;
+        settings->countperop = DEFAULT_COUNT_PER_OP;
+        settings->disableextramem = DEFAULT_DISABLE_EXTRA_MEM;
+        settings->sidmaduration = DEFAULT_SI_DMA_DURATION;
+        settings->aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
+
+        /* check if ROM has the Advanced Homebrew ROM Header (see https://n64brew.dev/wiki/ROM_Header) */
+        if (header->Cartridge_ID == 0x4445)
+        {
+            /* When current ROM has the Advanced Homebrew ROM Header, use the save type */
+            settings->savetype = rom_homebrew_savetype_to_savetype(header->Version >> 4);
+        }
+        else
+        {
+            /* There's no way to guess the save type, but 4K EEPROM is better than nothing */
+            settings->savetype = SAVETYPE_EEPROM_4K;
+        }
+    }
+
+    return entry;
 }
 
 m64p_error open_rom(const unsigned char* romimage, unsigned int size)
 {
     md5_state_t state;
     md5_byte_t digest[16];
+    XXH3_state_t hash_state;
+    XXH128_hash_t hash;
     romdatabase_entry* entry;
     char buffer[256];
+    uint32_t part[4096];
+    uint8_t* cart_rom;
     unsigned char imagetype;
+    unsigned int offset;
+    unsigned int len;
+    int known;
     int i;
 
     /* check input requirements */
@@ -154,17 +375,74 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
 
     /* Clear Byte-swapped flag, since ROM is now deleted. */
     g_RomWordsLittleEndian = 0;
-    /* allocate new buffer for ROM and copy into this buffer */
     g_rom_size = size;
-    swap_copy_rom((uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM), romimage, size, &imagetype);
-    /* ROM is now in N64 native (big endian) byte order */
+    cart_rom = (uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM);
+
+    /* Convert the image to N64 native (big endian) byte order in parts,
+     * hash every part while it's still in the cache and then store it in
+     * the cart ROM, so the image is only read once, which matters for
+     * large images which the front-end has mapped into memory. The MD5
+     * is computed in the same pass unless the ROM image may be known */
+    imagetype = rom_image_type(romimage);
+    known = 0;
+    XXH3_128bits_reset(&hash_state);
+    for (offset = 0; offset < size; offset += len)
+    {
+        len = size - offset;
+        if (len > sizeof(part))
+            len = sizeof(part);
 
-    memcpy(&ROM_HEADER, (uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM), sizeof(m64p_rom_header));
+        swap_copy_rom_part(part, romimage + offset, len, imagetype);
+        if (offset == 0)
+        {
+            memcpy(&ROM_HEADER, part, sizeof(m64p_rom_header));
+            known = rom_hash_cache_may_contain(size, &ROM_HEADER);
+            if (!known)
+                md5_init(&state);
+        }
+        XXH3_128bits_update(&hash_state, part, len);
+        if (!known)
+            md5_append(&state, (const md5_byte_t*)part, len);
+
+#if !defined(M64P_BIG_ENDIAN)
+        /* store the ROM words in host byte order right away,
+         * instead of swapping the whole cart ROM again when
+         * emulation is started, trailing bytes are left as is */
+        swap_copy(cart_rom + offset, part, len, 4);
+#else
+        memcpy(cart_rom + offset, part, len);
+#endif
+    }
+#if !defined(M64P_BIG_ENDIAN)
+    g_RomWordsLittleEndian = 1;
+#endif
+    hash = XXH3_128bits_digest(&hash_state);
 
-    /* Calculate MD5 hash  */
-    md5_init(&state);
-    md5_append(&state, (const md5_byte_t*)((uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM)), g_rom_size);
-    md5_finish(&state, digest);
+    if (!known)
+    {
+        md5_finish(&state, digest);
+        rom_hash_cache_add(hash, size, &ROM_HEADER, digest);
+    }
+    /* the header matched a cached ROM image, but the image differs */
+    else if (!rom_hash_cache_find(hash, size, digest))
+    {
+        md5_init(&state);
+        for (offset = 0; offset < size; offset += len)
+        {
+            len = size - offset;
+            if (len > sizeof(part))
+                len = sizeof(part);
+
+#if !defined(M64P_BIG_ENDIAN)
+            swap_copy(part, cart_rom + offset, len, 4);
+            md5_append(&state, (const md5_byte_t*)part, len);
+#else
+            md5_append(&state, (const md5_byte_t*)(cart_rom + offset), len);
+#endif
+        }
+        md5_finish(&state, digest);
+        rom_hash_cache_add(hash, size, &ROM_HEADER, digest);
+    }
     for ( i = 0; i < 16; ++i )
         sprintf(buffer+i*2, "%02X", digest[i]);
     buffer[32] = '\0';
@@ -179,52 +457,8 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
     trim(ROM_PARAMS.headername); /* Remove trailing whitespace from ROM name. */
 
     /* Look up this ROM in the .ini file and fill in goodname, etc */
-    if ((entry=ini_search_by_md5(digest)) != NULL ||
-        (entry=ini_search_by_crc(tohl(ROM_HEADER.CRC1),tohl(ROM_HEADER.CRC2))) != NULL)
-    {
-        strncpy(ROM_SETTINGS.goodname, entry->goodname, 255);
-        ROM_SETTINGS.goodname[255] = '\0';
-        ROM_SETTINGS.savetype = entry->savetype;
-        ROM_SETTINGS.status = entry->status;
-        ROM_SETTINGS.players = entry->players;
-        ROM_SETTINGS.rumble = entry->rumble;
-        ROM_SETTINGS.transferpak = entry->transferpak;
-        ROM_SETTINGS.mempak = entry->mempak;
-        ROM_SETTINGS.biopak = entry->biopak;
-        ROM_SETTINGS.countperop = entry->countperop;
-        ROM_SETTINGS.disableextramem = entry->disableextramem;
-        ROM_SETTINGS.sidmaduration = entry->sidmaduration;
-        ROM_SETTINGS.aidmamodifier = entry->aidmamodifier;
-        ROM_PARAMS.cheats = entry->cheats;
-    }
-    else
-    {
-        strcpy(ROM_SETTINGS.goodname, ROM_PARAMS.headername);
-        strcat(ROM_SETTINGS.goodname, " (unknown rom)");
-        ROM_SETTINGS.status = 0;
-        ROM_SETTINGS.players = 4;
-        ROM_SETTINGS.rumble = 1;
-        ROM_SETTINGS.transferpak = 0;
-        ROM_SETTINGS.mempak = 1;
-        ROM_SETTINGS.biopak = 0;
-        ROM_SETTINGS.countperop = DEFAULT_COUNT_PER_OP;
-        ROM_SETTINGS.disableextramem = DEFAULT_DISABLE_EXTRA_MEM;
-        ROM_SETTINGS.sidmaduration = DEFAULT_SI_DMA_DURATION;
-        ROM_SETTINGS.aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
-        ROM_PARAMS.cheats = NULL;
-
-        /* check if ROM has the Advanced Homebrew ROM Header (see https://n64brew.dev/wiki/ROM_Header) */
-        if (ROM_HEADER.Cartridge_ID == 0x4445)
-        {
-            /* When current ROM has the Advanced Homebrew ROM Header, use the save type */
-            ROM_SETTINGS.savetype = rom_homebrew_savetype_to_savetype(ROM_HEADER.Version >> 4);
-        }
-        else
-        {
-            /* There's no way to guess the save type, but 4K EEPROM is better than nothing */
-            ROM_SETTINGS.savetype = SAVETYPE_EEPROM_4K;
-        }
-    }
+    entry = rom_settings_from_database(digest, &ROM_HEADER, ROM_PARAMS.headername, &ROM_SETTINGS);
+    ROM_PARAMS.cheats = (entry != NULL) ? entry->cheats : NULL;
 
     /* print out a bunch of info about the ROM */
     DebugMessage(M64MSG_INFO, "Goodname: %s", ROM_SETTINGS.goodname);
@@ -249,6 +483,84 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
     return M64ERR_SUCCESS;
 }
 
+static int read_rom_image_part(void* context, unsigned char* buffer, int length)
+{
+    const unsigned char** romimage = (const unsigned char**)context;
+
+    memcpy(buffer, *romimage, length);
+    *romimage += length;
+    return length;
+}
+
+m64p_error probe_rom(const unsigned char* romimage, unsigned int size, m64p_rom_header* header, m64p_rom_settings* settings)
+{
+    if (romimage == NULL)
+        return M64ERR_INPUT_INVALID;
+
+    return probe_rom_stream(size, read_rom_image_part, &romimage, header, settings);
+}
+
+m64p_error probe_rom_stream(unsigned int size, int (*read)(void* context, unsigned char* buffer, int length), void* context,
+                            m64p_rom_header* header, m64p_rom_settings* settings)
+{
+    md5_state_t state;
+    md5_byte_t digest[16];
+    XXH3_state_t hash_state;
+    uint32_t buffer[4096];
+    char headername[21];
+    unsigned char imagetype = Z64IMAGE;
+    unsigned int offset;
+    unsigned int len;
+    int i;
+
+    /* check input requirements */
+    if (size < sizeof(m64p_rom_header))
+        return M64ERR_INPUT_INVALID;
+
+    /* read and convert the image to .z64 format in parts,
+     * so the image doesn't have to be in memory to be hashed */
+    md5_init(&state);
+    XXH3_128bits_reset(&hash_state);
+    for (offset = 0; offset < size; offset += len)
+    {
+        len = size - offset;
+        if (len > sizeof(buffer))
+            len = sizeof(buffer);
+
+        if (read(context, (unsigned char*)buffer, (int)len) != (int)len)
+            return M64ERR_FILES;
+
+        /* stop reading as soon as we know it isn't a ROM image */
+        if (offset == 0)
+        {
+            if (!is_valid_rom((const unsigned char*)buffer, size))
+                return M64ERR_INPUT_INVALID;
+
+            imagetype = rom_image_type(buffer);
+        }
+
+        swap_copy_rom_part(buffer, buffer, len, imagetype);
+        if (offset == 0)
+            memcpy(header, buffer, sizeof(m64p_rom_header));
+        md5_append(&state, (const md5_byte_t*)buffer, len);
+        XXH3_128bits_update(&hash_state, buffer, len);
+    }
+    md5_finish(&state, digest);
+
+    /* remember the MD5, so opening the ROM doesn't have to compute it again */
+    rom_hash_cache_add(XXH3_128bits_digest(&hash_state), size, header, digest);
+    for ( i = 0; i < 16; ++i )
+        sprintf(settings->MD5+i*2, "%02X", digest[i]);
+    settings->MD5[32] = '\0';
+
+    memcpy(headername, header->Name, 20);
+    headername[20] = '\0';
+    trim(headername); /* Remove trailing whitespace from ROM name. */
+
+    rom_settings_from_database(digest, header, headername, settings);
+    return M64ERR_SUCCESS;
+}
+
 m64p_error close_rom(void)
 {
     /* Clear Byte-swapped flag, since ROM is now deleted. */
@@ -443,18 +755,31 @@ static unsigned char rom_homebrew_savetype_to_savetype(uint8_t save_type)
     return m64p_save_type;
 }
 
-static size_t romdatabase_resolve_round(void)
+static romdatabase_entry* romdatabase_lists_search_by_md5(romdatabase_lists* lists, md5_byte_t* md5)
+{
+    romdatabase_search* search = lists->md5_lists[md5[0]];
+
+    while (search != NULL && memcmp(search->entry.md5, md5, 16) != 0)
+        search = search->next_md5;
+
+    if(search==NULL)
+        return NULL;
+
+    return &(search->entry);
+}
+
+static size_t romdatabase_resolve_round(romdatabase_lists* lists)
 {
     romdatabase_search *entry;
     romdatabase_entry *ref;
     size_t skipped = 0;
 
     /* Resolve RefMD5 references */
-    for (entry = g_romdatabase.list; entry; entry = entry->next_entry) {
+    for (entry = lists->list; entry; entry = entry->next_entry) {
         if (!entry->entry.refmd5)
             continue;
 
-        ref = ini_search_by_md5(entry->entry.refmd5);
+        ref = romdatabase_lists_search_by_md5(lists, entry->entry.refmd5);
         if (!ref) {
             DebugMessage(M64MSG_WARNING, "ROM Database: Error solving RefMD5s");
             continue;
@@ -560,13 +885,13 @@ static size_t romdatabase_resolve_round(void)
     return skipped;
 }
 
-static void romdatabase_resolve(void)
+static void romdatabase_resolve(romdatabase_lists* lists)
 {
     size_t last_skipped = (size_t)~0ULL;
     size_t skipped;
 
     do {
-        skipped = romdatabase_resolve_round();
+        skipped = romdatabase_resolve_round(lists);
         if (skipped == last_skipped) {
             DebugMessage(M64MSG_ERROR, "Unable to resolve rom database entries (loop)");
             break;
@@ -578,37 +903,34 @@ static void romdatabase_resolve(void)
 /********************************************************************************************/
 /* INI Rom database functions */
 
-void romdatabase_open(void)
+static void romdatabase_lists_free(romdatabase_lists* lists)
+{
+    while (lists->list != NULL)
+        {
+        romdatabase_search* search = lists->list->next_entry;
+        if(lists->list->entry.goodname)
+            free(lists->list->entry.goodname);
+        if(lists->list->entry.refmd5)
+            free(lists->list->entry.refmd5);
+        free(lists->list->entry.cheats);
+        free(lists->list);
+        lists->list = search;
+        }
+}
+
+static void romdatabase_parse(FILE *fPtr, romdatabase_lists* lists)
 {
-    FILE *fPtr;
     char buffer[256];
     romdatabase_search* search = NULL;
     romdatabase_search** next_search;
 
-    int counter, value, lineno;
+    int value, lineno;
     unsigned char index;
-    const char *pathname = ConfigGetSharedDataFilepath("mupen64plus.ini");
-
-    if(g_romdatabase.have_database)
-        return;
-
-    /* Open romdatabase. */
-    if (pathname == NULL || (fPtr = osal_file_open(pathname, "rb")) == NULL)
-    {
-        DebugMessage(M64MSG_ERROR, "Unable to open rom database file '%s'.", pathname);
-        return;
-    }
-
-    g_romdatabase.have_database = 1;
 
     /* Clear premade indices. */
-    for(counter = 0; counter < 255; ++counter)
-        g_romdatabase.crc_lists[counter] = NULL;
-    for(counter = 0; counter < 255; ++counter)
-        g_romdatabase.md5_lists[counter] = NULL;
-    g_romdatabase.list = NULL;
+    memset(lists, 0, sizeof(romdatabase_lists));
 
-    next_search = &g_romdatabase.list;
+    next_search = &lists->list;
 
     /* Parse ROM database file */
     for (lineno = 1; fgets(buffer, 255, fPtr) != NULL; lineno++)
@@ -633,6 +955,7 @@ void romdatabase_open(void)
 
             memset(search, 0, sizeof(romdatabase_search));
 
+            search->index = lists->count++;
             search->entry.goodname = NULL;
             memcpy(search->entry.md5, md5, 16);
             search->entry.refmd5 = NULL;
@@ -656,8 +979,8 @@ void romdatabase_open(void)
             search->next_crc = NULL;
             /* Index MD5s by first 8 bits. */
             index = search->entry.md5[0];
-            search->next_md5 = g_romdatabase.md5_lists[index];
-            g_romdatabase.md5_lists[index] = search;
+            search->next_md5 = lists->md5_lists[index];
+            lists->md5_lists[index] = search;
 
             break;
         }
@@ -677,13 +1000,17 @@ void romdatabase_open(void)
             else if(!strcmp(l.name, "CRC"))
             {
                 char garbage_sweeper;
-                if (sscanf(l.value, "%X %X%c", &search->entry.crc1,
+                if (isset_bitmask(search->entry.set_flags, ROMDATABASE_ENTRY_CRC))
+                {
+                    DebugMessage(M64MSG_WARNING, "ROM Database: Duplicate CRC on line %i", lineno);
+                }
+                else if (sscanf(l.value, "%X %X%c", &search->entry.crc1,
                     &search->entry.crc2, &garbage_sweeper) == 2)
                 {
                     /* Index CRCs by first 8 bits. */
                     index = search->entry.crc1 >> 24;
-                    search->next_crc = g_romdatabase.crc_lists[index];
-                    g_romdatabase.crc_lists[index] = search;
+                    search->next_crc = lists->crc_lists[index];
+                    lists->crc_lists[index] = search;
                     search->entry.set_flags |= ROMDATABASE_ENTRY_CRC;
                 }
                 else
@@ -865,70 +1192,443 @@ void romdatabase_open(void)
         }
     }
 
-    fclose(fPtr);
-    romdatabase_resolve();
+    romdatabase_resolve(lists);
 }
 
-void romdatabase_close(void)
+static uint32_t romdatabase_md5_slot(const md5_byte_t* md5)
 {
-    if (!g_romdatabase.have_database)
-        return;
+    uint32_t slot;
+
+    /* MD5s are evenly distributed already */
+    memcpy(&slot, md5, sizeof(slot));
+    return slot;
+}
+
+static uint32_t romdatabase_crc_slot(uint32_t crc1, uint32_t crc2)
+{
+    return crc1 ^ (crc2 * 0x9E3779B1u);
+}
+
+static uint32_t romdatabase_add_string(unsigned char* strings, uint32_t* offset, const char* string)
+{
+    uint32_t string_offset = *offset;
+    size_t size;
+
+    if (string == NULL)
+        return ROMDATABASE_INDEX_NONE;
+
+    size = strlen(string) + 1;
+    memcpy(strings + string_offset, string, size);
+    *offset += (uint32_t)size;
+    return string_offset;
+}
+
+/* Builds the binary index of the parsed ROM database, returns NULL on failure.
+ */
+static unsigned char* romdatabase_build_index(romdatabase_lists* lists, const romdatabase_index_header* ini_header, size_t* index_size)
+{
+    romdatabase_index_header* header;
+    romdatabase_index_entry* entries;
+    romdatabase_search* search;
+    unsigned char* index;
+    unsigned char* strings;
+    uint32_t* md5_table;
+    uint32_t* crc_table;
+    uint32_t table_size = 16;
+    uint32_t strings_offset = 0;
+    uint32_t slot;
+    size_t strings_size = 0;
+    size_t size;
+    int i;
 
-    while (g_romdatabase.list != NULL)
+    for (search = lists->list; search != NULL; search = search->next_entry)
+    {
+        if (search->entry.goodname != NULL)
+            strings_size += strlen(search->entry.goodname) + 1;
+        if (search->entry.cheats != NULL)
+            strings_size += strlen(search->entry.cheats) + 1;
+    }
+
+    /* keep the hash tables at most half full */
+    while (table_size < lists->count * 2)
+        table_size *= 2;
+
+    if (strings_size >= ROMDATABASE_INDEX_NONE)
+        return NULL;
+
+    size = sizeof(romdatabase_index_header) +
+           lists->count * sizeof(romdatabase_index_entry) +
+           table_size * sizeof(uint32_t) * 2 +
+           strings_size;
+    index = (unsigned char*)malloc(size);
+    if (index == NULL)
+        return NULL;
+
+    header = (romdatabase_index_header*)index;
+    entries = (romdatabase_index_entry*)(header + 1);
+    md5_table = (uint32_t*)(entries + lists->count);
+    crc_table = md5_table + table_size;
+    strings = (unsigned char*)(crc_table + table_size);
+
+    *header = *ini_header;
+    header->entry_count = lists->count;
+    header->table_size = table_size;
+    header->strings_size = (uint32_t)strings_size;
+    memset(md5_table, 0xFF, table_size * sizeof(uint32_t) * 2);
+
+    for (search = lists->list; search != NULL; search = search->next_entry)
+    {
+        romdatabase_index_entry* entry = &entries[search->index];
+
+        memset(entry, 0, sizeof(romdatabase_index_entry));
+        memcpy(entry->md5, search->entry.md5, 16);
+        entry->crc1 = search->entry.crc1;
+        entry->crc2 = search->entry.crc2;
+        entry->goodname = romdatabase_add_string(strings, &strings_offset, search->entry.goodname);
+        entry->cheats = romdatabase_add_string(strings, &strings_offset, search->entry.cheats);
+        entry->sidmaduration = search->entry.sidmaduration;
+        entry->aidmamodifier = search->entry.aidmamodifier;
+        entry->set_flags = search->entry.set_flags;
+        entry->status = search->entry.status;
+        entry->savetype = search->entry.savetype;
+        entry->players = search->entry.players;
+        entry->rumble = search->entry.rumble;
+        entry->countperop = search->entry.countperop;
+        entry->disableextramem = search->entry.disableextramem;
+        entry->transferpak = search->entry.transferpak;
+        entry->mempak = search->entry.mempak;
+        entry->biopak = search->entry.biopak;
+
+        /* a later entry with the same MD5 replaces the earlier one */
+        slot = romdatabase_md5_slot(entry->md5) & (table_size - 1);
+        while (md5_table[slot] != ROMDATABASE_INDEX_NONE &&
+               memcmp(entries[md5_table[slot]].md5, entry->md5, 16) != 0)
+            slot = (slot + 1) & (table_size - 1);
+        md5_table[slot] = search->index;
+    }
+
+    /* only the CRCs from the ROM database itself are indexed,
+     * not the ones which were resolved from a RefMD5 */
+    for (i = 0; i < 256; i++)
+    {
+        for (search = lists->crc_lists[i]; search != NULL; search = search->next_crc)
         {
-        romdatabase_search* search = g_romdatabase.list->next_entry;
-        if(g_romdatabase.list->entry.goodname)
-            free(g_romdatabase.list->entry.goodname);
-        if(g_romdatabase.list->entry.refmd5)
-            free(g_romdatabase.list->entry.refmd5);
-        free(g_romdatabase.list->entry.cheats);
-        free(g_romdatabase.list);
-        g_romdatabase.list = search;
+            slot = romdatabase_crc_slot(search->entry.crc1, search->entry.crc2) & (table_size - 1);
+            while (crc_table[slot] != ROMDATABASE_INDEX_NONE)
+                slot = (slot + 1) & (table_size - 1);
+            crc_table[slot] = search->index;
         }
+    }
 
-    g_romdatabase.have_database = 0;
+    *index_size = size;
+    return index;
 }
 
-static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5)
+/* Makes the given binary index the ROM database, takes ownership of
+ * the index, returns 0 when the index is invalid.
+ */
+static int romdatabase_use_index(unsigned char* index, size_t size)
 {
-    romdatabase_search* search;
+    const romdatabase_index_header* header = (const romdatabase_index_header*)index;
+    const romdatabase_index_entry* entries;
+    const unsigned char* strings;
+    const uint32_t* md5_table;
+    const uint32_t* crc_table;
+    romdatabase_entry* database_entries;
+    uint32_t i;
+
+    /* validate the sizes and offsets, so a corrupted
+     * index can't make us read out of bounds */
+    if (size < sizeof(romdatabase_index_header) ||
+        header->table_size == 0 ||
+        (header->table_size & (header->table_size - 1)) != 0 ||
+        header->table_size <= header->entry_count ||
+        size != sizeof(romdatabase_index_header) +
+                (size_t)header->entry_count * sizeof(romdatabase_index_entry) +
+                (size_t)header->table_size * sizeof(uint32_t) * 2 +
+                header->strings_size ||
+        (header->strings_size > 0 && index[size - 1] != '\0'))
+    {
+        return 0;
+    }
+
+    entries = (const romdatabase_index_entry*)(header + 1);
+    md5_table = (const uint32_t*)(entries + header->entry_count);
+    crc_table = md5_table + header->table_size;
+    strings = (const unsigned char*)(crc_table + header->table_size);
 
-    if(!g_romdatabase.have_database)
+    for (i = 0; i < header->table_size; i++)
+    {
+        if ((md5_table[i] != ROMDATABASE_INDEX_NONE && md5_table[i] >= header->entry_count) ||
+            (crc_table[i] != ROMDATABASE_INDEX_NONE && crc_table[i] >= header->entry_count))
+            return 0;
+    }
+
+    database_entries = (romdatabase_entry*)calloc(header->entry_count + 1, sizeof(romdatabase_entry));
+    if (database_entries == NULL)
+        return 0;
+
+    for (i = 0; i < header->entry_count; i++)
+    {
+        const romdatabase_index_entry* entry = &entries[i];
+        romdatabase_entry* database_entry = &database_entries[i];
+
+        if ((entry->goodname != ROMDATABASE_INDEX_NONE && entry->goodname >= header->strings_size) ||
+            (entry->cheats != ROMDATABASE_INDEX_NONE && entry->cheats >= header->strings_size))
+        {
+            free(database_entries);
+            return 0;
+        }
+
+        memcpy(database_entry->md5, entry->md5, 16);
+        database_entry->goodname = (entry->goodname != ROMDATABASE_INDEX_NONE) ? (char*)(strings + entry->goodname) : NULL;
+        database_entry->cheats = (entry->cheats != ROMDATABASE_INDEX_NONE) ? (char*)(strings + entry->cheats) : NULL;
+        database_entry->refmd5 = NULL;
+        database_entry->crc1 = entry->crc1;
+        database_entry->crc2 = entry->crc2;
+        database_entry->status = entry->status;
+        database_entry->savetype = entry->savetype;
+        database_entry->players = entry->players;
+        database_entry->rumble = entry->rumble;
+        database_entry->countperop = entry->countperop;
+        database_entry->disableextramem = entry->disableextramem;
+        database_entry->transferpak = entry->transferpak;
+        database_entry->mempak = entry->mempak;
+        database_entry->biopak = entry->biopak;
+        database_entry->sidmaduration = entry->sidmaduration;
+        database_entry->aidmamodifier = entry->aidmamodifier;
+        database_entry->set_flags = entry->set_flags;
+    }
+
+    g_romdatabase.index = index;
+    g_romdatabase.entries = database_entries;
+    g_romdatabase.md5_table = md5_table;
+    g_romdatabase.crc_table = crc_table;
+    g_romdatabase.table_mask = header->table_size - 1;
+    return 1;
+}
+
+/* Reads the cached binary index, returns NULL when it
+ * doesn't exist or when it belongs to another ROM database.
+ */
+static unsigned char* romdatabase_read_index(const char* filepath, const romdatabase_index_header* ini_header, size_t* index_size)
+{
+    romdatabase_index_header header;
+    unsigned char* index;
+    long size;
+    FILE* file;
+
+    file = osal_file_open(filepath, "rb");
+    if (file == NULL)
         return NULL;
 
-    search = g_romdatabase.md5_lists[md5[0]];
+    if (fread(&header, 1, sizeof(header), file) != sizeof(header) ||
+        memcmp(header.magic, ini_header->magic, sizeof(header.magic)) != 0 ||
+        header.version != ini_header->version ||
+        header.byte_order != ini_header->byte_order ||
+        header.ini_mtime != ini_header->ini_mtime ||
+        header.ini_size != ini_header->ini_size ||
+        header.ini_path_hash != ini_header->ini_path_hash ||
+        fseek(file, 0, SEEK_END) != 0 ||
+        (size = ftell(file)) < (long)sizeof(header) ||
+        fseek(file, 0, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return NULL;
+    }
 
-    while (search != NULL && memcmp(search->entry.md5, md5, 16) != 0)
-        search = search->next_md5;
+    index = (unsigned char*)malloc(size);
+    if (index == NULL || fread(index, 1, size, file) != (size_t)size)
+    {
+        free(index);
+        fclose(file);
+        return NULL;
+    }
 
-    if(search==NULL)
+    fclose(file);
+    *index_size = (size_t)size;
+    return index;
+}
+
+static void romdatabase_write_index(const char* filepath, const unsigned char* index, size_t size)
+{
+    char tmppath[PATH_MAX];
+    FILE* file;
+    int written;
+
+    snprintf(tmppath, sizeof(tmppath), "%s.tmp", filepath);
+
+    file = osal_file_open(tmppath, "wb");
+    if (file == NULL)
+    {
+        DebugMessage(M64MSG_WARNING, "ROM Database: Unable to write index '%s'", tmppath);
+        return;
+    }
+
+    written = fwrite(index, 1, size, file) == size;
+    written = (fclose(file) == 0) && written;
+    if (!written || osal_file_replace(tmppath, filepath) != 0)
+    {
+        DebugMessage(M64MSG_WARNING, "ROM Database: Unable to write index '%s'", filepath);
+        unlink(tmppath);
+    }
+}
+
+/* Loads the ROM database when it hasn't been loaded yet,
+ * must be called before looking up the ROM database.
+ */
+static void romdatabase_load(void)
+{
+    romdatabase_index_header ini_header;
+    romdatabase_lists lists;
+    unsigned char* index;
+    size_t index_size = 0;
+    char filepath[PATH_MAX];
+    const char *pathname;
+    FILE *fPtr;
+
+    if (!g_romdatabase.have_database)
+        return;
+
+    SDL_LockMutex(g_romdatabase.lock);
+    if (g_romdatabase.loaded)
+    {
+        SDL_UnlockMutex(g_romdatabase.lock);
+        return;
+    }
+    g_romdatabase.loaded = 1;
+
+    pathname = ConfigGetSharedDataFilepath("mupen64plus.ini");
+
+    memset(&ini_header, 0, sizeof(ini_header));
+    memcpy(ini_header.magic, ROMDATABASE_INDEX_MAGIC, sizeof(ini_header.magic));
+    ini_header.version = ROMDATABASE_INDEX_VERSION;
+    ini_header.byte_order = 0x01020304;
+
+    /* Open romdatabase. */
+    if (pathname == NULL ||
+        osal_file_info(pathname, &ini_header.ini_mtime, &ini_header.ini_size) != 0)
+    {
+        DebugMessage(M64MSG_ERROR, "Unable to open rom database file '%s'.", pathname);
+        SDL_UnlockMutex(g_romdatabase.lock);
+        return;
+    }
+    ini_header.ini_path_hash = XXH3_64bits(pathname, strlen(pathname));
+
+    snprintf(filepath, sizeof(filepath), "%s%s", ConfigGetUserCachePath(), ROMDATABASE_INDEX_FILENAME);
+
+    /* use the cached index when the ROM database hasn't changed */
+    index = romdatabase_read_index(filepath, &ini_header, &index_size);
+    if (index != NULL && romdatabase_use_index(index, index_size))
+    {
+        SDL_UnlockMutex(g_romdatabase.lock);
+        return;
+    }
+    free(index);
+
+    if ((fPtr = osal_file_open(pathname, "rb")) == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "Unable to open rom database file '%s'.", pathname);
+        SDL_UnlockMutex(g_romdatabase.lock);
+        return;
+    }
+
+    romdatabase_parse(fPtr, &lists);
+    fclose(fPtr);
+
+    index = romdatabase_build_index(&lists, &ini_header, &index_size);
+    romdatabase_lists_free(&lists);
+    if (index == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "ROM Database: Unable to build index");
+        SDL_UnlockMutex(g_romdatabase.lock);
+        return;
+    }
+
+    romdatabase_write_index(filepath, index, index_size);
+    if (!romdatabase_use_index(index, index_size))
+    {
+        DebugMessage(M64MSG_ERROR, "ROM Database: Invalid index");
+        free(index);
+    }
+
+    SDL_UnlockMutex(g_romdatabase.lock);
+}
+
+void romdatabase_open(void)
+{
+    if(g_romdatabase.have_database)
+        return;
+
+    g_romdatabase.lock = SDL_CreateMutex();
+    if (g_romdatabase.lock == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "ROM Database: Unable to create lock");
+        return;
+    }
+
+    /* the ROM database is loaded when it's first looked up, after
+     * the front-end had the chance to override the user cache path */
+    g_romdatabase.have_database = 1;
+    g_romdatabase.loaded = 0;
+}
+
+void romdatabase_close(void)
+{
+    if (!g_romdatabase.have_database)
+        return;
+
+    free(g_romdatabase.entries);
+    free(g_romdatabase.index);
+    SDL_DestroyMutex(g_romdatabase.lock);
+    memset(&g_romdatabase, 0, sizeof(g_romdatabase));
+}
+
+static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5)
+{
+    uint32_t slot;
+
+    romdatabase_load();
+    if(g_romdatabase.entries == NULL)
         return NULL;
 
-    return &(search->entry);
+    slot = romdatabase_md5_slot(md5) & g_romdatabase.table_mask;
+    while (g_romdatabase.md5_table[slot] != ROMDATABASE_INDEX_NONE)
+    {
+        romdatabase_entry* entry = &g_romdatabase.entries[g_romdatabase.md5_table[slot]];
+        if (memcmp(entry->md5, md5, 16) == 0)
+            return entry;
+
+        slot = (slot + 1) & g_romdatabase.table_mask;
+    }
+
+    return NULL;
 }
 
 romdatabase_entry* ini_search_by_crc(unsigned int crc1, unsigned int crc2)
 {
-    romdatabase_search* search;
     romdatabase_entry* found_entry = NULL;
+    uint32_t slot;
 
-    if(!g_romdatabase.have_database) 
+    romdatabase_load();
+    if(g_romdatabase.entries == NULL)
         return NULL;
 
-    search = g_romdatabase.crc_lists[((crc1 >> 24) & 0xff)];
+    slot = romdatabase_crc_slot(crc1, crc2) & g_romdatabase.table_mask;
 
     // because CRCs can be ambiguous (there can be multiple database entries with the same CRC),
     // we will prefer MD5 hashes instead. If the given CRC matches more than one entry in the
     // database, we will return no match.
-    while (search != NULL)
+    while (g_romdatabase.crc_table[slot] != ROMDATABASE_INDEX_NONE)
     {
-        if (search->entry.crc1 == crc1 && search->entry.crc2 == crc2)
+        romdatabase_entry* entry = &g_romdatabase.entries[g_romdatabase.crc_table[slot]];
+        if (entry->crc1 == crc1 && entry->crc2 == crc2)
         {
             if (found_entry != NULL)
                 return NULL;
-            found_entry = &search->entry;
+            found_entry = entry;
         }
-        search = search->next_crc;
+        slot = (slot + 1) & g_romdatabase.table_mask;
     }
 
     return found_entry;
@@ -41,6 +41,15 @@
 m64p_error open_rom(const unsigned char* romimage, unsigned int size);
 m64p_error close_rom(void);
 
+/* Retrieves the header and settings of a ROM image without opening it,
+ * only reads the ROM database, so it may be called from any thread. */
+m64p_error probe_rom(const unsigned char* romimage, unsigned int size, m64p_rom_header* header, m64p_rom_settings* settings);
+
+/* Same as probe_rom(), but the ROM image of 'size' bytes is read in parts
+ * with 'read', which must return the amount of bytes read into 'buffer'. */
+m64p_error probe_rom_stream(unsigned int size, int (*read)(void* context, unsigned char* buffer, int length), void* context,
+                            m64p_rom_header* header, m64p_rom_settings* settings);
+
 m64p_error open_disk(void);
 m64p_error close_disk(void);
 
@@ -136,9 +145,13 @@ typedef struct
 #define ROMDATABASE_ENTRY_SIDMADURATION BIT(12)
 #define ROMDATABASE_ENTRY_AIDMAMODIFIER BIT(13)
 
+/* The ROM database is parsed into these lists, which are only used
+ * to build the binary index of the ROM database.
+ */
 typedef struct _romdatabase_search
 {
     romdatabase_entry entry;
+    unsigned int index;
     struct _romdatabase_search* next_entry;
     struct _romdatabase_search* next_crc;
     struct _romdatabase_search* next_md5;
@@ -146,12 +159,15 @@ typedef struct _romdatabase_search
 
 typedef struct
 {
-    int have_database;
     romdatabase_search* crc_lists[256];
     romdatabase_search* md5_lists[256];
     romdatabase_search* list;
-} _romdatabase;
+    unsigned int count;
+} romdatabase_lists;
 
+/* Prepares the ROM database, it's loaded when it's first looked up,
+ * after which it may be looked up from several threads at the same time.
+ */
 void romdatabase_open(void);
 void romdatabase_close(void);
 /* Should be used by current cheat system (isn't), when cheat system is
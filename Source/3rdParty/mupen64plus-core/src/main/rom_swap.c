@@ -0,0 +1,135 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rom_swap.c                                              *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ROM_SWAP_SSE2
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ROM_SWAP_AVX2
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ROM_SWAP_NEON
+#endif
+
+#include "rom_swap.h"
+#include "util.h"
+
+/* Vectorized parts of swap_copy(), they return the amount of bytes they've
+ * swapped, which is always a multiple of their vector size.
+ */
+#if defined(ROM_SWAP_AVX2)
+__attribute__((target("avx2")))
+static size_t swap_copy_avx2(void* dst, const void* src, size_t len, size_t width)
+{
+    const __m256i mask = (width == 2) ?
+        _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                         1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14) :
+        _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                         3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i;
+
+    for (i = 0; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)((const uint8_t*)src + i));
+        _mm256_storeu_si256((__m256i*)((uint8_t*)dst + i), _mm256_shuffle_epi8(v, mask));
+    }
+
+    return i;
+}
+#endif
+
+#if defined(ROM_SWAP_SSE2)
+static size_t swap_copy_sse2(void* dst, const void* src, size_t len, size_t width)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)((const uint8_t*)src + i));
+        /* swap the bytes of the half-words, and the half-words of the words */
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        if (width == 4)
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i*)((uint8_t*)dst + i), v);
+    }
+
+    return i;
+}
+#endif
+
+#if defined(ROM_SWAP_NEON)
+static size_t swap_copy_neon(void* dst, const void* src, size_t len, size_t width)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= len; i += 16)
+    {
+        uint8x16_t v = vld1q_u8((const uint8_t*)src + i);
+        vst1q_u8((uint8_t*)dst + i, (width == 2) ? vrev16q_u8(v) : vrev32q_u8(v));
+    }
+
+    return i;
+}
+#endif
+
+void swap_copy(void* dst, const void* src, size_t len, size_t width)
+{
+    const uint8_t* src8 = (const uint8_t*)src;
+    uint8_t* dst8 = (uint8_t*)dst;
+    size_t i = 0;
+
+#if defined(ROM_SWAP_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        i = swap_copy_avx2(dst8, src8, len, width);
+#endif
+#if defined(ROM_SWAP_SSE2)
+    i += swap_copy_sse2(dst8 + i, src8 + i, len - i, width);
+#elif defined(ROM_SWAP_NEON)
+    i += swap_copy_neon(dst8 + i, src8 + i, len - i, width);
+#endif
+
+    for (; i + width <= len; i += width)
+    {
+        if (width == 2)
+        {
+            uint16_t v;
+            memcpy(&v, src8 + i, sizeof(v));
+            v = m64p_swap16(v);
+            memcpy(dst8 + i, &v, sizeof(v));
+        }
+        else
+        {
+            uint32_t v;
+            memcpy(&v, src8 + i, sizeof(v));
+            v = m64p_swap32(v);
+            memcpy(dst8 + i, &v, sizeof(v));
+        }
+    }
+
+    if (dst8 != src8)
+        memcpy(dst8 + i, src8 + i, len - i);
+}
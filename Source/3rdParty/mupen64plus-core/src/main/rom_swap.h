@@ -0,0 +1,35 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rom_swap.h                                              *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef __ROM_SWAP_H__
+#define __ROM_SWAP_H__
+
+#include <stddef.h>
+
+/* Copies 'len' bytes from 'src' to 'dst' and swaps the byte order of every
+ * 'width' (2 or 4) bytes, a trailing partial half-word or word is copied as is.
+ * 'dst' and 'src' may be the same, but they may not overlap otherwise.
+ * Uses SSE2/AVX2 or NEON when available, this is what converts .v64 and .n64
+ * images and stores the cart ROM in host byte order, see open_rom().
+ */
+void swap_copy(void* dst, const void* src, size_t len, size_t width);
+
+#endif /* __ROM_SWAP_H__ */
@@ -49,15 +49,32 @@
 #include "plugin/plugin.h"
 #include "rom.h"
 #include "savestates.h"
+#include "state_codec.h"
 #include "util.h"
-#include "workqueue.h"
 
 enum { GB_CART_FINGERPRINT_SIZE = 0x1c };
 enum { GB_CART_FINGERPRINT_OFFSET = 0x134 };
 
 enum { DD_DISK_ID_OFFSET = 0x43670 };
 
+/* layout of an uncompressed Mupen64Plus savestate */
+enum { SAVESTATE_M64P_HEADER_SIZE = 44 };
+enum { SAVESTATE_M64P_DATA_SIZE = 16788244 };
+enum { SAVESTATE_M64P_QUEUE_SIZE = 1024 };
+enum { SAVESTATE_M64P_USING_TLB_SIZE = 4 };
+enum { SAVESTATE_M64P_EXTRA_SIZE = 4096 };
+/* RDRAM and the TLB lookup tables, left out of snapshots */
+enum { SAVESTATE_M64P_MEMORY_SIZE = RDRAM_MAX_SIZE + 2 * 0x400000 };
+
+#define SAVESTATE_M64P_MIN_SIZE (SAVESTATE_M64P_HEADER_SIZE + SAVESTATE_M64P_DATA_SIZE + \
+                                 SAVESTATE_M64P_QUEUE_SIZE + SAVESTATE_M64P_USING_TLB_SIZE)
+#define SAVESTATE_M64P_MAX_SIZE (SAVESTATE_M64P_MIN_SIZE + SAVESTATE_M64P_EXTRA_SIZE)
+
 static const char* savestate_magic = "M64+SAVE";
+/* LZ4 compressed savestate: this magic, the uncompressed and compressed
+ * sizes (32-bit little endian) and then a LZ4 block holding the savestate */
+static const char* savestate_lz4_magic = "M64+LZ4C";
+enum { SAVESTATE_LZ4_HEADER_SIZE = 16 };
 static const int savestate_latest_version = 0x00010900;  /* 1.9 */
 static const unsigned char pj64_magic[4] = { 0xC8, 0xA6, 0xD8, 0x23 };
 
@@ -70,13 +87,136 @@ static int autoinc_save_slot = 0;
 
 static SDL_mutex *savestates_lock;
 
+/* used with savestates_lock held */
+static struct state_codec *savestates_lz4;
+
+/* Buffers for the savestates written to disk. Every state of the running
+ * ROM has the same size, so the buffers are allocated and their pages
+ * faulted in once when emulation starts instead of at every save. */
+enum { SAVESTATE_POOL_SIZE = 2 };
+static SDL_mutex *savestates_pool_lock;
+static unsigned char *savestates_pool[SAVESTATE_POOL_SIZE];
+static unsigned int savestates_pool_count;
+/* exact size of a state of the running ROM, 0 when not running */
+static size_t savestates_state_size;
+
+/* Savestates written to disk are serialized on the emulation thread into
+ * a pool buffer, the I/O thread compresses and writes them. At most
+ * SAVESTATE_POOL_SIZE states are in flight, further saves fail instead
+ * of stalling the emulation thread. */
+static SDL_Thread *savestates_io_thread;
+static SDL_mutex *savestates_io_lock;
+static SDL_cond *savestates_io_avail;
+static SDL_cond *savestates_io_done;
+static struct list_head savestates_io_queue;
+static unsigned int savestates_io_count;
+static int savestates_io_quit;
+
+/* used by the I/O thread only */
+static struct state_codec *savestates_io_lz4;
+static unsigned char *savestates_io_buffer;
+static size_t savestates_io_capacity;
+
+/* gzip states are compressed in chunks on several threads, every chunk
+ * is a gzip member and gzread() reads them back as a single stream */
+enum { SAVESTATE_GZIP_CHUNK_SIZE = 4 * 1024 * 1024 };
+enum { SAVESTATE_GZIP_MAX_CHUNKS = 8 };
+/* gzip header and trailer, compressBound() accounts for zlib's */
+enum { SAVESTATE_GZIP_OVERHEAD = 18 };
+
+static const unsigned char savestates_padding[SAVESTATE_M64P_EXTRA_SIZE];
+
 struct savestate_work {
+    savestates_type type;
     char *filepath;
-    char *data;
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    m64p_state_codec codec;
+    struct list_head list;
+};
+
+struct savestate_chunk {
+    const unsigned char *data;
+    size_t size;
+    size_t padding_size;
+    unsigned char *dst;
+    size_t capacity;
+    size_t used;
+};
+
+/* Reads a Mupen64Plus savestate either from the (gzip or uncompressed)
+ * file, or from the decompressed contents of a LZ4 savestate. */
+struct savestate_reader {
+    gzFile f;
+    unsigned char *data;
     size_t size;
-    struct work_struct work;
+    size_t pos;
 };
 
+static int savestates_read(struct savestate_reader *reader, void *dst, size_t len)
+{
+    if (reader->data == NULL)
+        return gzread(reader->f, dst, (unsigned int)len);
+
+    if (len > reader->size - reader->pos)
+        len = reader->size - reader->pos;
+    memcpy(dst, reader->data + reader->pos, len);
+    reader->pos += len;
+    return (int)len;
+}
+
+/* Decompresses the rest of a LZ4 savestate, the magic has already been read */
+static int savestates_read_lz4(struct savestate_reader *reader)
+{
+    unsigned char sizes[8];
+    unsigned char *block;
+    size_t block_size;
+
+    if (gzread(reader->f, sizes, sizeof(sizes)) != sizeof(sizes) || savestates_lz4 == NULL)
+        return 0;
+
+    reader->size = sizes[0] | (sizes[1] << 8) | (sizes[2] << 16) | ((size_t)sizes[3] << 24);
+    block_size   = sizes[4] | (sizes[5] << 8) | (sizes[6] << 16) | ((size_t)sizes[7] << 24);
+    if (reader->size > SAVESTATE_M64P_MAX_SIZE || block_size > state_codec_bound(M64CODEC_LZ4, reader->size))
+        return 0;
+
+    block = malloc(block_size);
+    reader->data = malloc(reader->size);
+    if (block == NULL || reader->data == NULL ||
+        gzread(reader->f, block, (unsigned int)block_size) != (int)block_size ||
+        !state_codec_decompress(savestates_lz4, block, block_size, reader->data, reader->size))
+    {
+        free(block);
+        free(reader->data);
+        reader->data = NULL;
+        return 0;
+    }
+
+    free(block);
+    reader->pos = 0;
+
+    /* LZ4 savestates are stored without the zero padding of the extra state */
+    if (reader->size >= SAVESTATE_M64P_MIN_SIZE && reader->size < SAVESTATE_M64P_MAX_SIZE)
+    {
+        unsigned char *data = realloc(reader->data, SAVESTATE_M64P_MAX_SIZE);
+        if (data == NULL)
+            return 0;
+
+        memset(data + reader->size, 0, SAVESTATE_M64P_MAX_SIZE - reader->size);
+        reader->data = data;
+        reader->size = SAVESTATE_M64P_MAX_SIZE;
+    }
+
+    return 1;
+}
+
+static void savestates_close_reader(struct savestate_reader *reader)
+{
+    gzclose(reader->f);
+    free(reader->data);
+}
+
 /* Returns the malloc'd full path of the currently selected savestate. */
 static char *savestates_generate_path(savestates_type type)
 {
@@ -185,126 +325,20 @@ static void savestates_clear_job(void)
 #define PUTDATA(buff, type, value) \
     do { type x = value; PUTARRAY(&x, buff, type, 1); } while(0)
 
-static int savestates_load_m64p(struct device* dev, char *filepath)
+/* Parses a state in the Mupen64Plus format. When with_memory is 0, the state
+ * doesn't contain the RDRAM and TLB lookup tables, RDRAM is left untouched and
+ * the lookup tables are rebuilt from the TLB entries. */
+static void savestates_load_m64p_data(struct device* dev, unsigned int version,
+                                      unsigned char *curr, char *queue,
+                                      unsigned char *using_tlb_data,
+                                      unsigned char *data_0001_0200,
+                                      int with_memory)
 {
-    unsigned char header[44];
-    gzFile f;
-    unsigned int version;
     int i;
     uint32_t FCR31;
 
-    size_t savestateSize;
-    unsigned char *savestateData, *curr;
-    char queue[1024];
-    unsigned char using_tlb_data[4];
-    unsigned char data_0001_0200[4096]; // 4k for extra state from v1.2
-
     uint32_t* cp0_regs = r4300_cp0_regs(&dev->r4300.cp0);
 
-    SDL_LockMutex(savestates_lock);
-
-    f = osal_gzopen(filepath, "rb");
-    if(f==NULL)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", filepath);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-
-    /* Read and check Mupen64Plus magic number. */
-    if (gzread(f, header, 44) != 44)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    curr = header;
-
-    if(strncmp((char *)curr, savestate_magic, 8)!=0)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s is not a valid Mupen64plus savestate.", filepath);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    curr += 8;
-
-    version = *curr++;
-    version = (version << 8) | *curr++;
-    version = (version << 8) | *curr++;
-    version = (version << 8) | *curr++;
-    if((version >> 16) != (savestate_latest_version >> 16))
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State version (%08x) isn't compatible. Please update Mupen64Plus.", version);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-
-    if(memcmp((char *)curr, ROM_SETTINGS.MD5, 32))
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State ROM MD5 does not match current ROM.");
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    curr += 32;
-
-    /* Read the rest of the savestate */
-    savestateSize = 16788244;
-    savestateData = curr = (unsigned char *)malloc(savestateSize);
-    if (savestateData == NULL)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    if (version == 0x00010000) /* original savestate version */
-    {
-        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
-            (gzread(f, queue, sizeof(queue)) % 4) != 0)
-        {
-            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.0 data from %s", filepath);
-            free(savestateData);
-            gzclose(f);
-            SDL_UnlockMutex(savestates_lock);
-            return 0;
-        }
-    }
-    else if (version == 0x00010100) // saves entire eventqueue plus 4-byte using_tlb flags
-    {
-        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
-            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
-            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data))
-        {
-            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.1 data from %s", filepath);
-            free(savestateData);
-            gzclose(f);
-            SDL_UnlockMutex(savestates_lock);
-            return 0;
-        }
-    }
-    else // version >= 0x00010200  saves entire eventqueue, 4-byte using_tlb flags and extra state
-    {
-        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
-            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
-            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data) ||
-            gzread(f, data_0001_0200, sizeof(data_0001_0200)) != sizeof(data_0001_0200))
-        {
-            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.2+ data from %s", filepath);
-            free(savestateData);
-            gzclose(f);
-            SDL_UnlockMutex(savestates_lock);
-            return 0;
-        }
-    }
-
-    gzclose(f);
-    SDL_UnlockMutex(savestates_lock);
-
-    // Parse savestate
     dev->rdram.regs[0][RDRAM_CONFIG_REG]       = GETDATA(curr, uint32_t);
     dev->rdram.regs[0][RDRAM_DEVICE_ID_REG]    = GETDATA(curr, uint32_t);
     dev->rdram.regs[0][RDRAM_DELAY_REG]        = GETDATA(curr, uint32_t);
@@ -419,7 +453,10 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
     dev->dp.dps_regs[DPS_BUFTEST_ADDR_REG] = GETDATA(curr, uint32_t);
     dev->dp.dps_regs[DPS_BUFTEST_DATA_REG] = GETDATA(curr, uint32_t);
 
-    COPYARRAY(dev->rdram.dram, curr, uint32_t, RDRAM_MAX_SIZE/4);
+    if (with_memory)
+    {
+        COPYARRAY(dev->rdram.dram, curr, uint32_t, RDRAM_MAX_SIZE/4);
+    }
     COPYARRAY(dev->sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
     COPYARRAY(dev->pif.ram, curr, uint8_t, PIF_RAM_SIZE);
 
@@ -428,8 +465,11 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
     /* by default, reset flashram state here and load it later if available */
     poweron_flashram(&dev->cart.flashram);
 
-    COPYARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
-    COPYARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    if (with_memory)
+    {
+        COPYARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
+        COPYARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    }
 
     *r4300_llbit(&dev->r4300) = GETDATA(curr, uint32_t);
     COPYARRAY(r4300_regs(&dev->r4300), curr, int64_t, 32);
@@ -471,6 +511,16 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
         dev->r4300.cp0.tlb.entries[i].phys_odd = GETDATA(curr, uint32_t);
     }
 
+    if (!with_memory)
+    {
+        memset(dev->r4300.cp0.tlb.LUT_r, 0, 0x400000);
+        memset(dev->r4300.cp0.tlb.LUT_w, 0, 0x400000);
+        for (i = 0; i < 32; i++)
+        {
+            tlb_map(&dev->r4300.cp0.tlb, i);
+        }
+    }
+
     savestates_load_set_pc(&dev->r4300, GETDATA(curr, uint32_t));
 
     *r4300_cp0_next_interrupt(&dev->r4300.cp0) = GETDATA(curr, uint32_t);
@@ -953,6 +1003,136 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
     dev->r4300.cp0.interrupt_unsafe_state = 0;
 
     *r4300_cp0_last_addr(&dev->r4300.cp0) = *r4300_pc(&dev->r4300);
+}
+
+static int savestates_load_m64p(struct device* dev, char *filepath)
+{
+    unsigned char header[44];
+    struct savestate_reader reader = { NULL, NULL, 0, 0 };
+    unsigned int version;
+
+    size_t savestateSize;
+    unsigned char *savestateData, *curr;
+    char queue[1024];
+    unsigned char using_tlb_data[4];
+    unsigned char data_0001_0200[4096]; // 4k for extra state from v1.2
+
+    SDL_LockMutex(savestates_lock);
+
+    reader.f = osal_gzopen(filepath, "rb");
+    if(reader.f==NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", filepath);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+
+    /* LZ4 savestates get decompressed in memory first */
+    if (gzread(reader.f, header, 8) == 8 && memcmp(header, savestate_lz4_magic, 8) == 0)
+    {
+        if (!savestates_read_lz4(&reader) || savestates_read(&reader, header, 8) != 8)
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not decompress state file %s", filepath);
+            savestates_close_reader(&reader);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+
+    /* Read and check Mupen64Plus magic number. */
+    if (savestates_read(&reader, header + 8, 36) != 36)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
+        savestates_close_reader(&reader);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+    curr = header;
+
+    if(strncmp((char *)curr, savestate_magic, 8)!=0)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s is not a valid Mupen64plus savestate.", filepath);
+        savestates_close_reader(&reader);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+    curr += 8;
+
+    version = *curr++;
+    version = (version << 8) | *curr++;
+    version = (version << 8) | *curr++;
+    version = (version << 8) | *curr++;
+    if((version >> 16) != (savestate_latest_version >> 16))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State version (%08x) isn't compatible. Please update Mupen64Plus.", version);
+        savestates_close_reader(&reader);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+
+    if(memcmp((char *)curr, ROM_SETTINGS.MD5, 32))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State ROM MD5 does not match current ROM.");
+        savestates_close_reader(&reader);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+    curr += 32;
+
+    /* Read the rest of the savestate */
+    savestateSize = 16788244;
+    savestateData = curr = (unsigned char *)malloc(savestateSize);
+    if (savestateData == NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
+        savestates_close_reader(&reader);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+    if (version == 0x00010000) /* original savestate version */
+    {
+        if (savestates_read(&reader, savestateData, savestateSize) != (int)savestateSize ||
+            (savestates_read(&reader, queue, sizeof(queue)) % 4) != 0)
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.0 data from %s", filepath);
+            free(savestateData);
+            savestates_close_reader(&reader);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+    else if (version == 0x00010100) // saves entire eventqueue plus 4-byte using_tlb flags
+    {
+        if (savestates_read(&reader, savestateData, savestateSize) != (int)savestateSize ||
+            savestates_read(&reader, queue, sizeof(queue)) != sizeof(queue) ||
+            savestates_read(&reader, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data))
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.1 data from %s", filepath);
+            free(savestateData);
+            savestates_close_reader(&reader);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+    else // version >= 0x00010200  saves entire eventqueue, 4-byte using_tlb flags and extra state
+    {
+        if (savestates_read(&reader, savestateData, savestateSize) != (int)savestateSize ||
+            savestates_read(&reader, queue, sizeof(queue)) != sizeof(queue) ||
+            savestates_read(&reader, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data) ||
+            savestates_read(&reader, data_0001_0200, sizeof(data_0001_0200)) != sizeof(data_0001_0200))
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.2+ data from %s", filepath);
+            free(savestateData);
+            savestates_close_reader(&reader);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+
+    savestates_close_reader(&reader);
+    SDL_UnlockMutex(savestates_lock);
+
+    savestates_load_m64p_data(dev, version, savestateData, queue, using_tlb_data, data_0001_0200, 1);
 
     free(savestateData);
     main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State loaded from: %s", namefrompath(filepath));
@@ -1404,6 +1584,9 @@ int savestates_load(void)
     char *filepath = NULL;
     int ret = 0;
 
+    /* the state may still be in flight */
+    savestates_io_wait();
+
     if (fname == NULL) // For slots, autodetect the savestate type
     {
         // try M64P type first
@@ -1478,87 +1661,421 @@ int savestates_load(void)
     return ret;
 }
 
-static void savestates_save_m64p_work(struct work_struct *work)
+int savestates_load_memory(void *buffer, size_t size)
 {
-    gzFile f;
-    int gzres;
-    struct savestate_work *save = container_of(work, struct savestate_work, work);
-
-    SDL_LockMutex(savestates_lock);
+    unsigned char *curr = (unsigned char *)buffer;
+    unsigned char data_0001_0200[SAVESTATE_M64P_EXTRA_SIZE];
+    unsigned int version;
+    size_t extra_size;
 
-    // Write the state to a GZIP file
-    f = osal_gzopen(save->filepath, "wb");
+    if (size < SAVESTATE_M64P_MIN_SIZE)
+    {
+        DebugMessage(M64MSG_ERROR, "Memory state is too small (%u bytes).", (unsigned int)size);
+        return 0;
+    }
 
-    if (f==NULL)
+    if (strncmp((char *)curr, savestate_magic, 8) != 0)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", save->filepath);
-        free(save->data);
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return;
+        DebugMessage(M64MSG_ERROR, "Memory state is not a valid Mupen64plus savestate.");
+        return 0;
     }
+    curr += 8;
 
-    gzres = gzwrite(f, save->data, save->size);
-    if ((gzres < 0) || ((size_t)gzres != save->size))
+    /* memory states never leave the core which created them,
+     * so only accept the version we write ourselves */
+    version = *curr++;
+    version = (version << 8) | *curr++;
+    version = (version << 8) | *curr++;
+    version = (version << 8) | *curr++;
+    if (version != (unsigned int)savestate_latest_version)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not write data to state file: %s", save->filepath);
-        gzclose(f);
-        free(save->data);
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return;
+        DebugMessage(M64MSG_ERROR, "Memory state version (%08x) isn't supported.", version);
+        return 0;
     }
 
-    gzclose(f);
-    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(save->filepath));
-    free(save->data);
-    free(save->filepath);
-    free(save);
+    if (memcmp((char *)curr, ROM_SETTINGS.MD5, 32))
+    {
+        DebugMessage(M64MSG_ERROR, "Memory state ROM MD5 does not match current ROM.");
+        return 0;
+    }
+    curr += 32;
 
-    SDL_UnlockMutex(savestates_lock);
-    StateChanged(M64CORE_STATE_SAVECOMPLETE, 1);
+    /* the extra state is variable in size, copy what we have
+     * and leave the rest zeroed like the file based loader does */
+    extra_size = size - SAVESTATE_M64P_MIN_SIZE;
+    if (extra_size > sizeof(data_0001_0200))
+        extra_size = sizeof(data_0001_0200);
+    memset(data_0001_0200, 0, sizeof(data_0001_0200));
+    memcpy(data_0001_0200, (unsigned char *)buffer + SAVESTATE_M64P_MIN_SIZE, extra_size);
+
+    savestates_load_m64p_data(&g_dev, version, curr,
+                              (char *)(curr + SAVESTATE_M64P_DATA_SIZE),
+                              curr + SAVESTATE_M64P_DATA_SIZE + SAVESTATE_M64P_QUEUE_SIZE,
+                              data_0001_0200, 1);
+    return 1;
 }
 
-static int savestates_save_m64p(const struct device* dev, char *filepath)
+int savestates_check_snapshot(const void *buffer, size_t size)
 {
-    unsigned char outbuf[4];
-    int i;
+    const size_t min_size = SAVESTATE_M64P_MIN_SIZE - SAVESTATE_M64P_MEMORY_SIZE;
 
-    char queue[1024];
+    /* snapshots are created by savestates_save_snapshot()
+     * during the same session, so only sanity check them */
+    return size >= min_size && strncmp((const char *)buffer, savestate_magic, 8) == 0;
+}
 
-    struct savestate_work *save;
-    char *curr;
+int savestates_load_snapshot(void *buffer, size_t size)
+{
+    unsigned char *curr = (unsigned char *)buffer + SAVESTATE_M64P_HEADER_SIZE;
+    unsigned char data_0001_0200[SAVESTATE_M64P_EXTRA_SIZE];
+    const size_t data_size = SAVESTATE_M64P_DATA_SIZE - SAVESTATE_M64P_MEMORY_SIZE;
+    const size_t min_size = SAVESTATE_M64P_MIN_SIZE - SAVESTATE_M64P_MEMORY_SIZE;
+    size_t extra_size;
 
-    /* OK to cast away const qualifier */
-    const uint32_t* cp0_regs = r4300_cp0_regs((struct cp0*)&dev->r4300.cp0);
+    if (!savestates_check_snapshot(buffer, size))
+        return 0;
 
-    save = malloc(sizeof(*save));
-    if (!save) {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
+    extra_size = size - min_size;
+    if (extra_size > sizeof(data_0001_0200))
+        extra_size = sizeof(data_0001_0200);
+    memset(data_0001_0200, 0, sizeof(data_0001_0200));
+    memcpy(data_0001_0200, (unsigned char *)buffer + min_size, extra_size);
+
+    savestates_load_m64p_data(&g_dev, (unsigned int)savestate_latest_version, curr,
+                              (char *)(curr + data_size),
+                              curr + data_size + SAVESTATE_M64P_QUEUE_SIZE,
+                              data_0001_0200, 0);
+    return 1;
+}
+
+/* Takes a buffer of at least savestates_state_size bytes from the pool,
+ * capacity receives its size */
+static unsigned char *savestates_pool_get(size_t *capacity)
+{
+    unsigned char *data = NULL;
+
+    SDL_LockMutex(savestates_pool_lock);
+    *capacity = (savestates_state_size != 0) ? savestates_state_size : SAVESTATE_M64P_MAX_SIZE;
+    if (savestates_pool_count > 0)
+        data = savestates_pool[--savestates_pool_count];
+    SDL_UnlockMutex(savestates_pool_lock);
+
+    /* only happens when more saves are in flight than the pool holds */
+    if (data == NULL)
+        data = malloc(*capacity);
+
+    return data;
+}
+
+static void savestates_pool_put(unsigned char *data, size_t capacity)
+{
+    SDL_LockMutex(savestates_pool_lock);
+    if (capacity == savestates_state_size && savestates_pool_count < SAVESTATE_POOL_SIZE)
+    {
+        savestates_pool[savestates_pool_count++] = data;
+        data = NULL;
+    }
+    SDL_UnlockMutex(savestates_pool_lock);
+
+    free(data);
+}
+
+/* Grows the output buffer of the I/O thread, it's kept for the next save */
+static int savestates_io_reserve(size_t capacity)
+{
+    if (savestates_io_capacity < capacity)
+    {
+        free(savestates_io_buffer);
+        savestates_io_buffer = malloc(capacity);
+        savestates_io_capacity = (savestates_io_buffer != NULL) ? capacity : 0;
+    }
+
+    return savestates_io_buffer != NULL;
+}
+
+static int savestates_deflate_chunk(void *data)
+{
+    struct savestate_chunk *chunk = data;
+    z_stream stream;
+    int ret;
+
+    chunk->used = 0;
+
+    /* 15 + 16 writes a gzip header, the level is the same as gzopen()'s */
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
         return 0;
+
+    stream.next_in = (Bytef *)chunk->data;
+    stream.avail_in = (uInt)chunk->size;
+    stream.next_out = chunk->dst;
+    stream.avail_out = (uInt)chunk->capacity;
+    ret = deflate(&stream, (chunk->padding_size == 0) ? Z_FINISH : Z_NO_FLUSH);
+
+    if (ret == Z_OK && chunk->padding_size != 0)
+    {
+        stream.next_in = (Bytef *)savestates_padding;
+        stream.avail_in = (uInt)chunk->padding_size;
+        ret = deflate(&stream, Z_FINISH);
     }
 
-    save->filepath = strdup(filepath);
+    if (ret == Z_STREAM_END)
+        chunk->used = (size_t)stream.total_out;
 
-    if(autoinc_save_slot)
-        savestates_inc_slot();
+    deflateEnd(&stream);
+    return 0;
+}
 
-    save_eventqueue_infos(&dev->r4300.cp0, queue);
+static int savestates_write_gzip(const unsigned char *data, size_t size, size_t padding_size, FILE *f)
+{
+    struct savestate_chunk chunks[SAVESTATE_GZIP_MAX_CHUNKS];
+    SDL_Thread *threads[SAVESTATE_GZIP_MAX_CHUNKS];
+    size_t chunk_size = SAVESTATE_GZIP_CHUNK_SIZE;
+    size_t count = (size + chunk_size - 1) / chunk_size;
+    size_t capacity = 0;
+    size_t i;
+    int written = 1;
 
-    // Allocate memory for the save state data
-    save->size = 16788288 + sizeof(queue) + 4 + 4096;
-    save->data = curr = malloc(save->size);
-    if (save->data == NULL)
+    if (count > SAVESTATE_GZIP_MAX_CHUNKS)
     {
-        free(save->filepath);
-        free(save);
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
+        count = SAVESTATE_GZIP_MAX_CHUNKS;
+        chunk_size = (size + count - 1) / count;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        chunks[i].data = data + i * chunk_size;
+        chunks[i].size = (i == count - 1) ? size - i * chunk_size : chunk_size;
+        chunks[i].padding_size = (i == count - 1) ? padding_size : 0;
+        chunks[i].capacity = compressBound((uLong)(chunks[i].size + chunks[i].padding_size)) + SAVESTATE_GZIP_OVERHEAD;
+        capacity += chunks[i].capacity;
+    }
+
+    if (!savestates_io_reserve(capacity))
         return 0;
+
+    chunks[0].dst = savestates_io_buffer;
+    for (i = 1; i < count; i++)
+        chunks[i].dst = chunks[i - 1].dst + chunks[i - 1].capacity;
+
+    /* the I/O thread compresses the first chunk itself,
+     * chunks without a thread are compressed afterwards */
+    for (i = 1; i < count; i++)
+        threads[i] = SDL_CreateThread(savestates_deflate_chunk, "m64pstatez", &chunks[i]);
+
+    savestates_deflate_chunk(&chunks[0]);
+
+    for (i = 1; i < count; i++)
+    {
+        if (threads[i] != NULL)
+            SDL_WaitThread(threads[i], NULL);
+        else
+            savestates_deflate_chunk(&chunks[i]);
     }
 
-    memset(save->data, 0, save->size);
+    for (i = 0; i < count && written; i++)
+        written = chunks[i].used != 0 && fwrite(chunks[i].dst, 1, chunks[i].used, f) == chunks[i].used;
+
+    return written;
+}
+
+static int savestates_write_m64p(const struct savestate_work *save, FILE *f)
+{
+    /* other builds expect the extra state to be padded with zeroes */
+    size_t padding_size = SAVESTATE_M64P_MAX_SIZE - save->size;
+
+    if (save->codec == M64CODEC_LZ4)
+    {
+        size_t block_size = 0;
+
+        if (savestates_io_lz4 != NULL &&
+            savestates_io_reserve(SAVESTATE_LZ4_HEADER_SIZE + state_codec_bound(M64CODEC_LZ4, save->size)))
+        {
+            block_size = state_codec_compress(savestates_io_lz4, save->data, save->size,
+                                              savestates_io_buffer + SAVESTATE_LZ4_HEADER_SIZE,
+                                              savestates_io_capacity - SAVESTATE_LZ4_HEADER_SIZE);
+        }
+
+        if (block_size != 0)
+        {
+            unsigned char *lz4 = savestates_io_buffer;
+
+            memcpy(lz4, savestate_lz4_magic, 8);
+            lz4[8]  = (unsigned char)(save->size);
+            lz4[9]  = (unsigned char)(save->size >> 8);
+            lz4[10] = (unsigned char)(save->size >> 16);
+            lz4[11] = (unsigned char)(save->size >> 24);
+            lz4[12] = (unsigned char)(block_size);
+            lz4[13] = (unsigned char)(block_size >> 8);
+            lz4[14] = (unsigned char)(block_size >> 16);
+            lz4[15] = (unsigned char)(block_size >> 24);
+
+            block_size += SAVESTATE_LZ4_HEADER_SIZE;
+            return fwrite(lz4, 1, block_size, f) == block_size;
+        }
+
+        /* fall back to gzip, which every build can load */
+    }
+    else if (save->codec == M64CODEC_NONE)
+    {
+        return fwrite(save->data, 1, save->size, f) == save->size &&
+               fwrite(savestates_padding, 1, padding_size, f) == padding_size;
+    }
+
+    return savestates_write_gzip(save->data, save->size, padding_size, f);
+}
+
+/* Writes the state to a temporary file which then replaces the state file,
+ * so a crash or a failed write never leaves a truncated state behind */
+static int savestates_write(const struct savestate_work *save)
+{
+    char *tmppath = formatstr("%s.tmp", save->filepath);
+    zipFile zipfile;
+    FILE *f;
+    int written = 0;
+
+    if (tmppath == NULL)
+        return 0;
+
+    switch (save->type)
+    {
+        case savestates_type_pj64_zip:
+            zipfile = zipOpen(tmppath, APPEND_STATUS_CREATE);
+            if (zipfile == NULL)
+                break;
+            written = zipOpenNewFileInZip(zipfile, namefrompath(save->filepath), NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_DEFAULT_COMPRESSION) == ZIP_OK &&
+                      zipWriteInFileInZip(zipfile, save->data, (unsigned)save->size) == ZIP_OK &&
+                      zipCloseFileInZip(zipfile) == ZIP_OK;
+            written = zipClose(zipfile, "") == ZIP_OK && written;
+            break;
+        default:
+            f = osal_file_open(tmppath, "wb");
+            if (f == NULL)
+                break;
+            if (save->type == savestates_type_m64p)
+                written = savestates_write_m64p(save, f);
+            else
+                written = fwrite(save->data, 1, save->size, f) == save->size;
+            written = fclose(f) == 0 && written;
+            break;
+    }
+
+    if (written)
+        written = osal_file_replace(tmppath, save->filepath) == 0;
+    if (!written)
+        remove(tmppath);
+
+    free(tmppath);
+    return written;
+}
+
+/* Reserves a place in the I/O queue, returns 0 when it's full */
+static int savestates_io_begin(void)
+{
+    int reserved;
+
+    SDL_LockMutex(savestates_io_lock);
+    reserved = savestates_io_count < SAVESTATE_POOL_SIZE;
+    if (reserved)
+        savestates_io_count++;
+    SDL_UnlockMutex(savestates_io_lock);
+
+    return reserved;
+}
+
+static void savestates_io_end(void)
+{
+    SDL_LockMutex(savestates_io_lock);
+    savestates_io_count--;
+    SDL_CondBroadcast(savestates_io_done);
+    SDL_UnlockMutex(savestates_io_lock);
+}
+
+static void savestates_io_complete(struct savestate_work *save)
+{
+    int written = savestates_write(save);
+
+    if (written)
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(save->filepath));
+    else
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not write state file: %s", save->filepath);
+
+    savestates_pool_put(save->data, save->capacity);
+    free(save->filepath);
+    free(save);
+
+    savestates_io_end();
+    StateChanged(M64CORE_STATE_SAVECOMPLETE, written);
+}
+
+static int savestates_io_handler(void *data)
+{
+    struct savestate_work *save;
+
+    for (;;)
+    {
+        SDL_LockMutex(savestates_io_lock);
+        while (list_empty(&savestates_io_queue) && !savestates_io_quit)
+            SDL_CondWait(savestates_io_avail, savestates_io_lock);
+
+        /* only quit once every queued state is written */
+        if (list_empty(&savestates_io_queue))
+        {
+            SDL_UnlockMutex(savestates_io_lock);
+            break;
+        }
+
+        save = list_first_entry(&savestates_io_queue, struct savestate_work, list);
+        list_del_init(&save->list);
+        SDL_UnlockMutex(savestates_io_lock);
+
+        savestates_io_complete(save);
+    }
+
+    return 0;
+}
+
+static void savestates_io_submit(struct savestate_work *save)
+{
+    /* without an I/O thread the state is written synchronously */
+    if (savestates_io_thread == NULL)
+    {
+        savestates_io_complete(save);
+        return;
+    }
+
+    SDL_LockMutex(savestates_io_lock);
+    list_add_tail(&save->list, &savestates_io_queue);
+    SDL_CondSignal(savestates_io_avail);
+    SDL_UnlockMutex(savestates_io_lock);
+}
+
+void savestates_io_wait(void)
+{
+    SDL_LockMutex(savestates_io_lock);
+    while (savestates_io_count > 0)
+        SDL_CondWait(savestates_io_done, savestates_io_lock);
+    SDL_UnlockMutex(savestates_io_lock);
+}
+
+/* Serializes the device state in the Mupen64Plus format (uncompressed)
+ * and returns the number of bytes written. data must be large enough
+ * to hold SAVESTATE_M64P_MAX_SIZE bytes. When with_memory is 0, RDRAM
+ * and the TLB lookup tables are left out of the state. */
+static size_t savestates_save_m64p_data(const struct device* dev, unsigned char *data, int with_memory)
+{
+    unsigned char outbuf[4];
+    int i;
+
+    char queue[1024];
+
+    unsigned char *curr = data;
+
+    /* OK to cast away const qualifier */
+    const uint32_t* cp0_regs = r4300_cp0_regs((struct cp0*)&dev->r4300.cp0);
+
+    save_eventqueue_infos(&dev->r4300.cp0, queue);
 
-    // Write the save state data to memory
     PUTARRAY(savestate_magic, curr, unsigned char, 8);
 
     outbuf[0] = (savestate_latest_version >> 24) & 0xff;
@@ -1709,15 +2226,22 @@ static int savestates_save_m64p(const struct device* dev, char *filepath)
     PUTDATA(curr, uint32_t, dev->dp.dps_regs[DPS_BUFTEST_ADDR_REG]);
     PUTDATA(curr, uint32_t, dev->dp.dps_regs[DPS_BUFTEST_DATA_REG]);
 
-    PUTARRAY(dev->rdram.dram, curr, uint32_t, RDRAM_MAX_SIZE/4);
+    if (with_memory)
+    {
+        PUTARRAY(dev->rdram.dram, curr, uint32_t, RDRAM_MAX_SIZE/4);
+    }
     PUTARRAY(dev->sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
     PUTARRAY(dev->pif.ram, curr, uint8_t, PIF_RAM_SIZE);
 
     PUTDATA(curr, int32_t, dev->cart.use_flashram);
-    curr += 4+8+4+4; // Here used to be flashram state
+    memset(curr, 0, 4+8+4+4); // Here used to be flashram state
+    curr += 4+8+4+4;
 
-    PUTARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
-    PUTARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    if (with_memory)
+    {
+        PUTARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
+        PUTARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    }
 
     /* OK to cast away const qualifier */
     PUTDATA(curr, uint32_t, *r4300_llbit((struct r4300_core*)&dev->r4300));
@@ -1759,7 +2283,7 @@ static int savestates_save_m64p(const struct device* dev, char *filepath)
     }
     PUTDATA(curr, uint32_t, *r4300_pc((struct r4300_core*)&dev->r4300));
 
-    PUTDATA(curr, uint32_t, *r4300_cp0_next_interrupt((struct cp0*)&dev->r4300.cp0));
+    PUTDATA(curr, uint32_t, get_saved_next_interrupt(&dev->r4300.cp0));
     PUTDATA(curr, uint32_t, 0); /* here there used to be next_vi */
     PUTDATA(curr, uint32_t, dev->vi.field);
 
@@ -1853,6 +2377,7 @@ static int savestates_save_m64p(const struct device* dev, char *filepath)
 
     if (disk_id == NULL) {
         PUTDATA(curr, uint32_t, 0);
+        memset(curr, 0, (3+DD_ASIC_REGS_COUNT)*sizeof(uint32_t) + 0x100 + 0x40 + 2*sizeof(int64_t) + 2*sizeof(uint32_t));
         curr += (3+DD_ASIC_REGS_COUNT)*sizeof(uint32_t) + 0x100 + 0x40 + 2*sizeof(int64_t) + 2*sizeof(uint32_t);
     }
     else {
@@ -1915,33 +2440,106 @@ static int savestates_save_m64p(const struct device* dev, char *filepath)
     PUTDATA(curr, uint64_t, *r4300_cp0_latch((struct cp0*)&dev->r4300.cp0));
     PUTDATA(curr, uint64_t, *r4300_cp2_latch((struct cp2*)&dev->r4300.cp2));
 
-    init_work(&save->work, savestates_save_m64p_work);
-    queue_work(&save->work);
+    return (size_t)(curr - data);
+}
 
-    return 1;
+void savestates_init_pool(const struct device* dev)
+{
+    /* serializing without RDRAM and the TLB lookup tables is cheap
+     * and always gives the size savestates_save_m64p_data() writes */
+    unsigned char *data = malloc(savestates_get_snapshot_size());
+    unsigned char *stale[SAVESTATE_POOL_SIZE];
+    unsigned int stale_count = 0;
+    size_t size;
+
+    if (data == NULL)
+        return;
+    size = savestates_save_m64p_data(dev, data, 0) + SAVESTATE_M64P_MEMORY_SIZE;
+    free(data);
+
+    SDL_LockMutex(savestates_pool_lock);
+    if (size != savestates_state_size)
+    {
+        while (savestates_pool_count > 0)
+            stale[stale_count++] = savestates_pool[--savestates_pool_count];
+        savestates_state_size = size;
+
+        /* fault the pages in now rather than while saving */
+        data = malloc(size);
+        if (data != NULL)
+        {
+            memset(data, 0, size);
+            savestates_pool[savestates_pool_count++] = data;
+        }
+    }
+    SDL_UnlockMutex(savestates_pool_lock);
+
+    while (stale_count > 0)
+        free(stale[--stale_count]);
 }
 
-static int savestates_save_pj64(const struct device* dev,
-                                char *filepath, void *handle,
-                                int (*write_func)(void *, const void *, size_t))
+void savestates_free_pool(void)
 {
-    unsigned int i;
-    unsigned int SaveRDRAMSize = RDRAM_MAX_SIZE;
+    SDL_LockMutex(savestates_pool_lock);
+    while (savestates_pool_count > 0)
+        free(savestates_pool[--savestates_pool_count]);
+    /* buffers still in flight get freed when they're returned */
+    savestates_state_size = 0;
+    SDL_UnlockMutex(savestates_pool_lock);
+}
 
-    size_t savestateSize;
-    unsigned char *savestateData, *curr;
+size_t savestates_get_memory_size(void)
+{
+    size_t size;
 
-    const uint32_t* cp0_regs = r4300_cp0_regs((struct cp0*)&dev->r4300.cp0);
+    SDL_LockMutex(savestates_pool_lock);
+    size = (savestates_state_size != 0) ? savestates_state_size : SAVESTATE_M64P_MAX_SIZE;
+    SDL_UnlockMutex(savestates_pool_lock);
 
-    // Allocate memory for the save state data
-    savestateSize = 8 + SaveRDRAMSize + 0x2754;
-    savestateData = curr = (unsigned char *)malloc(savestateSize);
-    if (savestateData == NULL)
+    return size;
+}
+
+int savestates_save_memory(void *buffer, size_t size, size_t *used)
+{
+    size_t required = savestates_get_memory_size();
+
+    if (size < required)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
+        DebugMessage(M64MSG_ERROR, "Buffer is too small for memory state (%u < %u bytes).",
+                     (unsigned int)size, (unsigned int)required);
         return 0;
     }
 
+    *used = savestates_save_m64p_data(&g_dev, (unsigned char *)buffer, 1);
+    return 1;
+}
+
+size_t savestates_get_snapshot_size(void)
+{
+    return SAVESTATE_M64P_MAX_SIZE - SAVESTATE_M64P_MEMORY_SIZE;
+}
+
+int savestates_save_snapshot(void *buffer, size_t size, size_t *used)
+{
+    if (size < savestates_get_snapshot_size())
+        return 0;
+
+    *used = savestates_save_m64p_data(&g_dev, (unsigned char *)buffer, 0);
+    return 1;
+}
+
+/* Serializes the device state in the Project64 format and returns the
+ * number of bytes written, the pool buffers are large enough for it. */
+static size_t savestates_save_pj64_data(const struct device* dev, unsigned char *data)
+{
+    unsigned int i;
+    unsigned int SaveRDRAMSize = RDRAM_MAX_SIZE;
+
+    size_t savestateSize = 8 + SaveRDRAMSize + 0x2754;
+    unsigned char *curr = data;
+
+    const uint32_t* cp0_regs = r4300_cp0_regs((struct cp0*)&dev->r4300.cp0);
+
     // Write the save state data in memory
     PUTARRAY(pj64_magic, curr, unsigned char, 4);
     PUTDATA(curr, unsigned int, SaveRDRAMSize);
@@ -2078,85 +2676,55 @@ static int savestates_save_pj64(const struct device* dev,
     PUTARRAY(dev->rdram.dram, curr, uint32_t, SaveRDRAMSize/4);
     PUTARRAY(dev->sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
 
-    // Write the save state data to the output
-    if (!write_func(handle, savestateData, savestateSize))
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Couldn't write data to Project64 state file %s.", filepath);
-        free(savestateData);
-        return 0;
-    }
-
-    // assert(savestateData+savestateSize == curr)
-    free(savestateData);
-    return 1;
+    // assert(data+savestateSize == curr)
+    return savestateSize;
 }
 
-static int write_data_to_zip(void *zip, const void *buffer, size_t length)
+static int savestates_save_work(const struct device* dev, char *filepath)
 {
-    return zipWriteInFileInZip((zipFile)zip, buffer, (unsigned)length) == ZIP_OK;
-}
-
-static int savestates_save_pj64_zip(const struct device* dev, char *filepath)
-{
-    int retval;
-    zipFile zipfile = NULL;
+    struct savestate_work *save;
 
-    zipfile = zipOpen(filepath, APPEND_STATUS_CREATE);
-    if(zipfile == NULL)
+    /* never stall the emulation thread on the I/O thread */
+    if (!savestates_io_begin())
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not create PJ64 state file: %s", filepath);
-        goto clean_and_exit;
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Previous states are still being written, state not saved.");
+        free(filepath);
+        return 0;
     }
 
-    retval = zipOpenNewFileInZip(zipfile, namefrompath(filepath), NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_DEFAULT_COMPRESSION);
-    if(retval != ZIP_OK)
+    save = malloc(sizeof(*save));
+    if (save != NULL)
+        save->data = savestates_pool_get(&save->capacity);
+    if (save == NULL || save->data == NULL)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Zip error. Could not create state file: %s", filepath);
-        goto clean_and_exit;
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
+        free(save);
+        free(filepath);
+        savestates_io_end();
+        return 0;
     }
 
-    if (!savestates_save_pj64(dev, filepath, zipfile, write_data_to_zip))
-        goto clean_and_exit;
-
-    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(filepath));
-
-    clean_and_exit:
-        if (zipfile != NULL)
-        {
-            zipCloseFileInZip(zipfile); // This may fail, but we don't care
-            zipClose(zipfile, "");
-        }
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 1);
-        return 1;
-}
-
-static int write_data_to_file(void *file, const void *buffer, size_t length)
-{
-    return fwrite(buffer, 1, length, (FILE *)file) == length;
-}
+    save->type = type;
+    save->filepath = filepath;
+    save->codec = (m64p_state_codec)ConfigGetParamInt(g_CoreConfig, "SaveStateCodec");
+    if (save->codec != M64CODEC_NONE && save->codec != M64CODEC_LZ4)
+        save->codec = M64CODEC_ZLIB;
 
-static int savestates_save_pj64_unc(const struct device* dev, char *filepath)
-{
-    FILE *f;
-
-    f = osal_file_open(filepath, "wb");
-    if (f == NULL)
+    // Write the save state data to memory, every byte gets written,
+    // compression and file writes happen on the I/O thread
+    if (type == savestates_type_m64p)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not create PJ64 state file: %s", filepath);
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return 0;
-    }
+        if(autoinc_save_slot)
+            savestates_inc_slot();
 
-    if (!savestates_save_pj64(dev, filepath, f, write_data_to_file))
+        save->size = savestates_save_m64p_data(dev, save->data, 1);
+    }
+    else
     {
-        fclose(f);
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return 0;
+        save->size = savestates_save_pj64_data(dev, save->data);
     }
 
-    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(filepath));
-    fclose(f);
-    StateChanged(M64CORE_STATE_SAVECOMPLETE, 1);
+    savestates_io_submit(save);
     return 1;
 }
 
@@ -2178,22 +2746,13 @@ int savestates_save(void)
     else if (fname == NULL) // Always save slots in M64P format
         type = savestates_type_m64p;
 
+    // the I/O thread reports completion once the state is on disk
     filepath = savestates_generate_path(type);
     if (filepath != NULL)
-    {
-        switch (type)
-        {
-            case savestates_type_m64p: ret = savestates_save_m64p(dev, filepath); break;
-            case savestates_type_pj64_zip: ret = savestates_save_pj64_zip(dev, filepath); break;
-            case savestates_type_pj64_unc: ret = savestates_save_pj64_unc(dev, filepath); break;
-            default: ret = 0; StateChanged(M64CORE_STATE_SAVECOMPLETE, ret); break;
-        }
-        free(filepath);
-    }
-    else
-    {
+        ret = savestates_save_work(dev, filepath);
+
+    if (!ret)
         StateChanged(M64CORE_STATE_SAVECOMPLETE, ret);
-    }
 
     savestates_clear_job();
     return ret;
@@ -2206,10 +2765,59 @@ void savestates_init(void)
         DebugMessage(M64MSG_ERROR, "Could not create savestates list lock");
         return;
     }
+
+    savestates_pool_lock = SDL_CreateMutex();
+    if (!savestates_pool_lock) {
+        DebugMessage(M64MSG_ERROR, "Could not create savestates pool lock");
+        return;
+    }
+
+    savestates_io_lock = SDL_CreateMutex();
+    savestates_io_avail = SDL_CreateCond();
+    savestates_io_done = SDL_CreateCond();
+    if (!savestates_io_lock || !savestates_io_avail || !savestates_io_done) {
+        DebugMessage(M64MSG_ERROR, "Could not create savestates I/O queue");
+        return;
+    }
+
+    INIT_LIST_HEAD(&savestates_io_queue);
+    savestates_io_count = 0;
+    savestates_io_quit = 0;
+
+    savestates_lz4 = state_codec_create(M64CODEC_LZ4);
+    savestates_io_lz4 = state_codec_create(M64CODEC_LZ4);
+
+    savestates_io_thread = SDL_CreateThread(savestates_io_handler, "m64pstate", NULL);
+    if (!savestates_io_thread)
+        DebugMessage(M64MSG_WARNING, "Could not create savestates I/O thread, states will be written synchronously");
 }
 
 void savestates_deinit(void)
 {
+    if (savestates_io_thread != NULL)
+    {
+        SDL_LockMutex(savestates_io_lock);
+        savestates_io_quit = 1;
+        SDL_CondSignal(savestates_io_avail);
+        SDL_UnlockMutex(savestates_io_lock);
+
+        SDL_WaitThread(savestates_io_thread, NULL);
+        savestates_io_thread = NULL;
+    }
+
+    SDL_DestroyCond(savestates_io_done);
+    SDL_DestroyCond(savestates_io_avail);
+    SDL_DestroyMutex(savestates_io_lock);
+    state_codec_destroy(savestates_io_lz4);
+    savestates_io_lz4 = NULL;
+    free(savestates_io_buffer);
+    savestates_io_buffer = NULL;
+    savestates_io_capacity = 0;
+
+    savestates_free_pool();
+    SDL_DestroyMutex(savestates_pool_lock);
     SDL_DestroyMutex(savestates_lock);
+    state_codec_destroy(savestates_lz4);
+    savestates_lz4 = NULL;
     savestates_clear_job();
 }
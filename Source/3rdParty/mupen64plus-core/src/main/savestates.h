@@ -25,6 +25,8 @@
 #ifndef __SAVESTAVES_H__
 #define __SAVESTAVES_H__
 
+#include <stddef.h>
+
 typedef enum _savestates_job
 {
     savestates_job_nothing,
@@ -40,6 +42,8 @@ typedef enum _savestates_type
     savestates_type_pj64_unc
 } savestates_type;
 
+struct device;
+
 savestates_job savestates_get_job(void);
 void savestates_set_job(savestates_job j, savestates_type t, const char *fn);
 void savestates_init(void);
@@ -48,6 +52,31 @@ void savestates_deinit(void);
 int savestates_load(void);
 int savestates_save(void);
 
+/* savestates_save() only serializes the state, it's compressed and written
+ * to disk by the I/O thread. Waits until every state in flight is written. */
+void savestates_io_wait(void);
+
+/* Computes the exact size of a state of the running ROM and allocates the
+ * buffers used by savestates_save(). Called when emulation starts and when
+ * the device configuration changes, savestates_free_pool() when it stops. */
+void savestates_init_pool(const struct device* dev);
+void savestates_free_pool(void);
+
+/* Synchronous, uncompressed savestates to and from a caller provided buffer.
+ * These must only be called from a frame safe point (see main_frame_safe_point).
+ * The size is exact for the running ROM, and the worst case otherwise. */
+size_t savestates_get_memory_size(void);
+int savestates_save_memory(void *buffer, size_t size, size_t *used);
+int savestates_load_memory(void *buffer, size_t size);
+
+/* Same as the memory savestates but without RDRAM and the TLB lookup tables,
+ * RDRAM is left untouched on load. Used by main/snapshots.c. */
+size_t savestates_get_snapshot_size(void);
+int savestates_save_snapshot(void *buffer, size_t size, size_t *used);
+int savestates_load_snapshot(void *buffer, size_t size);
+/* Returns whether savestates_load_snapshot() would accept the buffer */
+int savestates_check_snapshot(const void *buffer, size_t size);
+
 void savestates_select_slot(unsigned int s);
 unsigned int savestates_get_slot(void);
 void savestates_set_autoinc_slot(int b);
@@ -0,0 +1,472 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - snapshots.c                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "snapshots.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "device/device.h"
+#include "device/memory/memory.h"
+#include "device/r4300/r4300_core.h"
+#include "device/rdram/rdram.h"
+#include "main.h"
+#include "plugin/plugin.h"
+#include "savestates.h"
+#include "state_codec.h"
+
+struct snapshot
+{
+    unsigned int id;
+
+    /* register and RCP state, see savestates_save_snapshot() */
+    unsigned char* state;
+    size_t state_size;
+    size_t state_raw_size;
+
+    /* RDRAM pages which changed since the previous snapshot,
+     * with their contents at the previous snapshot,
+     * each compressed to pages_size[i] bytes */
+    uint16_t* pages;
+    uint16_t* pages_size;
+    unsigned int pages_count;
+    unsigned int pages_capacity;
+    unsigned char* pages_data;
+    size_t pages_data_size;
+    size_t pages_data_capacity;
+};
+
+static struct snapshot* l_snapshots = NULL;
+static unsigned int l_count = 0;
+static unsigned int l_used = 0;
+static unsigned int l_next = 0;
+
+/* RDRAM as it was at the newest snapshot */
+static unsigned char* l_shadow = NULL;
+
+/* set when the video plugin writes RDRAM where write protection can't see it */
+static int l_async_plugin_writes = 0;
+
+/* Determinism hashes of the shadow copy. Only the pages which changed get
+ * hashed again, the hash of a region is the xor of its page hashes. */
+enum { SNAPSHOT_PAGES_PER_REGION = RDRAM_DIRTY_PAGES_COUNT / M64P_SNAPSHOT_RDRAM_REGIONS };
+static uint64_t l_page_hashes[RDRAM_DIRTY_PAGES_COUNT];
+static uint64_t l_region_hashes[M64P_SNAPSHOT_RDRAM_REGIONS];
+
+/* compression context and the uncompressed register and RCP state */
+static struct state_codec* l_codec = NULL;
+static unsigned char* l_state = NULL;
+static size_t l_state_capacity = 0;
+
+/* the state is compressed here first, so that a failed save leaves
+ * the slot alone, then it's swapped with the state of the slot */
+static unsigned char* l_spare_state = NULL;
+
+/* bytes allocated by the snapshots and the most they may use */
+static size_t l_memory = 0;
+static size_t l_budget = 0;
+
+static void snapshot_free_pages(struct snapshot* snapshot)
+{
+    l_memory -= (size_t)snapshot->pages_capacity * 2 * sizeof(uint16_t) + snapshot->pages_data_capacity;
+
+    free(snapshot->pages);
+    free(snapshot->pages_size);
+    free(snapshot->pages_data);
+
+    snapshot->pages = NULL;
+    snapshot->pages_size = NULL;
+    snapshot->pages_data = NULL;
+    snapshot->pages_count = 0;
+    snapshot->pages_capacity = 0;
+    snapshot->pages_data_size = 0;
+    snapshot->pages_data_capacity = 0;
+}
+
+static void snapshot_free(struct snapshot* snapshot)
+{
+    snapshot_free_pages(snapshot);
+
+    if (snapshot->state != NULL)
+        l_memory -= l_state_capacity;
+
+    free(snapshot->state);
+    snapshot->state = NULL;
+}
+
+static int snapshot_add_page(struct snapshot* snapshot, uint16_t page, const unsigned char* data)
+{
+    size_t bound = state_codec_bound(state_codec_type(l_codec), RDRAM_DIRTY_PAGE_SIZE);
+    size_t size;
+
+    if (snapshot->pages_count == snapshot->pages_capacity)
+    {
+        unsigned int capacity = (snapshot->pages_capacity == 0) ? 64 : snapshot->pages_capacity * 2;
+        uint16_t* pages = realloc(snapshot->pages, capacity * sizeof(uint16_t));
+        uint16_t* pages_size;
+
+        if (pages == NULL)
+            return 0;
+        snapshot->pages = pages;
+
+        pages_size = realloc(snapshot->pages_size, capacity * sizeof(uint16_t));
+        if (pages_size == NULL)
+            return 0;
+        snapshot->pages_size = pages_size;
+
+        l_memory += (size_t)(capacity - snapshot->pages_capacity) * 2 * sizeof(uint16_t);
+        snapshot->pages_capacity = capacity;
+    }
+
+    if (snapshot->pages_data_capacity - snapshot->pages_data_size < bound)
+    {
+        size_t capacity = (snapshot->pages_data_capacity == 0) ? 64 * bound : snapshot->pages_data_capacity * 2;
+        unsigned char* pages_data = realloc(snapshot->pages_data, capacity);
+
+        if (pages_data == NULL)
+            return 0;
+        snapshot->pages_data = pages_data;
+        l_memory += capacity - snapshot->pages_data_capacity;
+        snapshot->pages_data_capacity = capacity;
+    }
+
+    size = state_codec_compress(l_codec, data, RDRAM_DIRTY_PAGE_SIZE,
+                                snapshot->pages_data + snapshot->pages_data_size, bound);
+    if (size == 0)
+        return 0;
+
+    snapshot->pages[snapshot->pages_count] = page;
+    snapshot->pages_size[snapshot->pages_count] = (uint16_t)size;
+    snapshot->pages_data_size += size;
+    snapshot->pages_count++;
+    return 1;
+}
+
+static int page_changed(const struct rdram* rdram, uint16_t page)
+{
+    size_t offset = (size_t)page << RDRAM_DIRTY_PAGE_SHIFT;
+
+    if (rdram_is_page_dirty(rdram, page))
+        return 1;
+
+    /* only compared when something wrote RDRAM without marking the pages */
+    return rdram->untracked_writes
+        && memcmp((unsigned char*)rdram->dram + offset, l_shadow + offset, RDRAM_DIRTY_PAGE_SIZE) != 0;
+}
+
+/* start tracking the writes which the next snapshot has to find */
+static void track_writes(struct rdram* rdram)
+{
+    rdram_clear_dirty_pages(rdram);
+
+    if (!r4300_track_rdram_writes(&g_dev.r4300) || l_async_plugin_writes)
+        rdram->untracked_writes = 1;
+}
+
+static void page_hash_update(uint16_t page)
+{
+    size_t offset = (size_t)page << RDRAM_DIRTY_PAGE_SHIFT;
+    /* seeded with the page so that moving data around changes the hash */
+    uint64_t hash = XXH3_64bits_withSeed(l_shadow + offset, RDRAM_DIRTY_PAGE_SIZE, page);
+
+    l_region_hashes[page / SNAPSHOT_PAGES_PER_REGION] ^= l_page_hashes[page] ^ hash;
+    l_page_hashes[page] = hash;
+}
+
+static void snapshots_apply_budget(void)
+{
+    unsigned int oldest;
+
+    /* the newest snapshot is always kept */
+    while (l_budget != 0 && l_memory > l_budget && l_used > 1)
+    {
+        oldest = (l_next + l_count - l_used) % l_count;
+        snapshot_free(&l_snapshots[oldest]);
+        l_used--;
+
+        /* nothing is older than the next snapshot anymore, so its undo log is useless */
+        snapshot_free_pages(&l_snapshots[(oldest + 1) % l_count]);
+    }
+}
+
+int snapshots_init(unsigned int count, m64p_state_codec codec)
+{
+    snapshots_deinit();
+
+    if (count == 0)
+        return 1;
+
+    l_snapshots = calloc(count, sizeof(struct snapshot));
+    l_shadow = malloc(RDRAM_MAX_SIZE);
+    l_codec = state_codec_create(codec);
+    l_state = malloc(savestates_get_snapshot_size());
+    if (l_snapshots == NULL || l_shadow == NULL || l_codec == NULL || l_state == NULL)
+    {
+        snapshots_deinit();
+        return 0;
+    }
+    l_count = count;
+
+    /* without it, plugin writes are found by comparing against the shadow copy */
+    if (!rdram_track_plugin_writes(&g_dev.rdram, 1))
+        DebugMessage(M64MSG_WARNING, "Failed to track plugin writes to RDRAM");
+
+    l_async_plugin_writes = plugin_gfx_writes_rdram_async();
+    if (l_async_plugin_writes)
+        DebugMessage(M64MSG_INFO, "Video plugin writes RDRAM asynchronously, snapshots compare all of RDRAM");
+
+    /* the states are allocated by the first save in their slot,
+     * so that a large ring only costs what it actually holds */
+    l_state_capacity = state_codec_bound(codec, savestates_get_snapshot_size());
+
+    return 1;
+}
+
+void snapshots_deinit(void)
+{
+    unsigned int i;
+
+    if (l_snapshots != NULL)
+    {
+        for (i = 0; i < l_count; ++i)
+        {
+            free(l_snapshots[i].state);
+            free(l_snapshots[i].pages);
+            free(l_snapshots[i].pages_size);
+            free(l_snapshots[i].pages_data);
+        }
+        free(l_snapshots);
+    }
+
+    free(l_shadow);
+    free(l_state);
+    free(l_spare_state);
+    state_codec_destroy(l_codec);
+    rdram_track_plugin_writes(&g_dev.rdram, 0);
+
+    l_snapshots = NULL;
+    l_shadow = NULL;
+    l_state = NULL;
+    l_spare_state = NULL;
+    l_codec = NULL;
+    l_count = 0;
+    l_used = 0;
+    l_async_plugin_writes = 0;
+    l_next = 0;
+    l_state_capacity = 0;
+    l_memory = 0;
+    l_budget = 0;
+}
+
+void snapshots_set_budget(size_t budget)
+{
+    l_budget = budget;
+}
+
+int snapshots_save(unsigned int id, size_t *size, size_t *raw_size, unsigned int *pages,
+                   unsigned int *state_hash, unsigned int *rdram_hashes)
+{
+    struct rdram* rdram = &g_dev.rdram;
+    struct snapshot* snapshot;
+    unsigned char* state;
+    size_t state_size;
+    size_t state_raw_size;
+    unsigned int i;
+    uint16_t page;
+
+    if (l_snapshots == NULL)
+        return 0;
+
+    if (l_spare_state == NULL)
+    {
+        l_spare_state = malloc(l_state_capacity);
+        if (l_spare_state == NULL)
+            return 0;
+        l_memory += l_state_capacity;
+    }
+
+    if (!savestates_save_snapshot(l_state, savestates_get_snapshot_size(), &state_raw_size))
+        return 0;
+
+    state_size = state_codec_compress(l_codec, l_state, state_raw_size, l_spare_state, l_state_capacity);
+    if (state_size == 0)
+        return 0;
+
+    /* the oldest snapshot gets replaced when the ring is full,
+     * its undo log is only needed to go further back */
+    snapshot = &l_snapshots[l_next];
+    state = snapshot->state;
+    snapshot->state = l_spare_state;
+    l_spare_state = state;
+
+    snapshot->id = id;
+    snapshot->state_size = state_size;
+    snapshot->state_raw_size = state_raw_size;
+    snapshot->pages_count = 0;
+    snapshot->pages_data_size = 0;
+
+    if (l_used == 0)
+    {
+        memcpy(l_shadow, rdram->dram, RDRAM_MAX_SIZE);
+
+        memset(l_page_hashes, 0, sizeof(l_page_hashes));
+        memset(l_region_hashes, 0, sizeof(l_region_hashes));
+        for (page = 0; page < RDRAM_DIRTY_PAGES_COUNT; ++page)
+            page_hash_update(page);
+    }
+    else
+    {
+        for (page = 0; page < RDRAM_DIRTY_PAGES_COUNT; ++page)
+        {
+            size_t offset = (size_t)page << RDRAM_DIRTY_PAGE_SHIFT;
+
+            if (!page_changed(rdram, page))
+                continue;
+
+            if (!snapshot_add_page(snapshot, page, l_shadow + offset))
+            {
+                /* the shadow copy is already partly updated, drop the ring,
+                 * the next save copies RDRAM in full and starts over */
+                DebugMessage(M64MSG_ERROR, "Failed to allocate snapshot memory");
+                l_used = 0;
+                return 0;
+            }
+
+            memcpy(l_shadow + offset, (unsigned char*)rdram->dram + offset, RDRAM_DIRTY_PAGE_SIZE);
+            page_hash_update(page);
+        }
+    }
+
+    track_writes(rdram);
+
+    l_next = (l_next + 1) % l_count;
+    if (l_used < l_count)
+        l_used++;
+    else if (l_budget != 0)
+        snapshot_free_pages(&l_snapshots[l_next]);
+
+    if (size != NULL)
+        *size = snapshot->state_size + snapshot->pages_data_size;
+    if (raw_size != NULL)
+        *raw_size = snapshot->state_raw_size + (size_t)snapshot->pages_count * RDRAM_DIRTY_PAGE_SIZE;
+    if (pages != NULL)
+        *pages = snapshot->pages_count;
+    if (state_hash != NULL)
+        *state_hash = (unsigned int)XXH3_64bits(l_state, snapshot->state_raw_size);
+    if (rdram_hashes != NULL)
+    {
+        for (i = 0; i < M64P_SNAPSHOT_RDRAM_REGIONS; ++i)
+            rdram_hashes[i] = (unsigned int)l_region_hashes[i];
+    }
+
+    snapshots_apply_budget();
+    return 1;
+}
+
+int snapshots_load(unsigned int id)
+{
+    struct rdram* rdram = &g_dev.rdram;
+    unsigned char* dram = (unsigned char*)rdram->dram;
+    struct snapshot* snapshot = NULL;
+    unsigned int newer;
+    unsigned int index;
+    unsigned int i;
+    uint16_t page;
+
+    if (l_snapshots == NULL)
+        return 0;
+
+    /* look for the snapshot, newest first */
+    for (newer = 0; newer < l_used; ++newer)
+    {
+        index = (l_next + l_count - 1 - newer) % l_count;
+        if (l_snapshots[index].id == id)
+        {
+            snapshot = &l_snapshots[index];
+            break;
+        }
+    }
+
+    if (snapshot == NULL)
+        return 0;
+
+    /* nothing changes until the state is known to be good */
+    if (!state_codec_decompress(l_codec, snapshot->state, snapshot->state_size, l_state, snapshot->state_raw_size)
+        || !savestates_check_snapshot(l_state, snapshot->state_raw_size))
+    {
+        DebugMessage(M64MSG_ERROR, "Failed to decompress snapshot state");
+        return 0;
+    }
+
+    /* go back to the newest snapshot */
+    for (page = 0; page < RDRAM_DIRTY_PAGES_COUNT; ++page)
+    {
+        size_t offset = (size_t)page << RDRAM_DIRTY_PAGE_SHIFT;
+
+        if (page_changed(rdram, page))
+            memcpy(dram + offset, l_shadow + offset, RDRAM_DIRTY_PAGE_SIZE);
+    }
+
+    /* then undo the newer snapshots, newest first */
+    for (; newer > 0; --newer)
+    {
+        struct snapshot* undo = &l_snapshots[(l_next + l_count - 1) % l_count];
+        const unsigned char* data = undo->pages_data;
+
+        for (i = 0; i < undo->pages_count; ++i)
+        {
+            size_t offset = (size_t)undo->pages[i] << RDRAM_DIRTY_PAGE_SHIFT;
+
+            if (!state_codec_decompress(l_codec, data, undo->pages_size[i], l_shadow + offset, RDRAM_DIRTY_PAGE_SIZE))
+            {
+                /* RDRAM is lost, nothing older can be restored */
+                DebugMessage(M64MSG_ERROR, "Failed to decompress snapshot page");
+                l_used = 0;
+                return -1;
+            }
+            memcpy(dram + offset, l_shadow + offset, RDRAM_DIRTY_PAGE_SIZE);
+            page_hash_update(undo->pages[i]);
+            data += undo->pages_size[i];
+        }
+
+        /* the undone snapshot is gone, it'll be saved again when the frame is replayed */
+        if (l_budget != 0)
+            snapshot_free(undo);
+        l_next = (l_next + l_count - 1) % l_count;
+        l_used--;
+    }
+
+    if (!savestates_load_snapshot(l_state, snapshot->state_raw_size))
+    {
+        DebugMessage(M64MSG_ERROR, "Failed to load snapshot state");
+        l_used = 0;
+        return -1;
+    }
+
+    track_writes(rdram);
+    return 1;
+}
@@ -0,0 +1,65 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - snapshots.h                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_SNAPSHOTS_H
+#define M64P_MAIN_SNAPSHOTS_H
+
+#include <stddef.h>
+
+#include "api/m64p_types.h"
+
+/* Ring of in-memory snapshots of the last frames, used for rollback.
+ *
+ * Each snapshot holds the register and RCP state, and the RDRAM pages
+ * which changed since the previous snapshot, as they were at the previous
+ * snapshot (an undo log). The changed pages are the ones marked dirty in
+ * RDRAM: the r4300 emulators, DMAs and cheats mark what they write, and
+ * plugin writes are caught by write protecting RDRAM while plugins run.
+ * A copy of RDRAM at the newest snapshot is kept to build the undo log,
+ * it's also compared against when writes couldn't be tracked (the old
+ * dynarec, no memory protection, video plugins which write RDRAM from the
+ * GPU or from their own thread). The state and the pages are compressed
+ * one by one with the codec chosen at init.
+ *
+ * With a budget, the oldest snapshots are dropped as soon as the ring uses
+ * more than budget bytes, which lets a large ring (rewind) follow the actual
+ * compressed sizes. The RDRAM copy is not part of the budget.
+ *
+ * Saving also hashes the register and RCP state and, incrementally, the
+ * RDRAM pages which changed, for desync detection. */
+
+int snapshots_init(unsigned int count, m64p_state_codec codec);
+void snapshots_deinit(void);
+
+/* 0 disables the budget, it's reset by snapshots_init */
+void snapshots_set_budget(size_t budget);
+
+/* These must only be called from a frame safe point (see main_frame_safe_point) */
+int snapshots_save(unsigned int id, size_t *size, size_t *raw_size, unsigned int *pages,
+                   unsigned int *state_hash, unsigned int *rdram_hashes);
+
+/* Returns 1 when the snapshot was restored, and 0 when it wasn't found or
+ * couldn't be restored, the machine is left untouched then. Returns -1 when
+ * restoring failed after RDRAM was changed, the machine state is lost and
+ * the ring is emptied, only a full state can make the machine consistent. */
+int snapshots_load(unsigned int id);
+
+#endif /* M64P_MAIN_SNAPSHOTS_H */
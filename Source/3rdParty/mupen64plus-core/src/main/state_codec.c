@@ -0,0 +1,375 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - state_codec.c                                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "state_codec.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+/* LZ4 block format constants */
+enum { LZ4_MIN_MATCH     = 4 };
+enum { LZ4_LAST_LITERALS = 5 };
+enum { LZ4_MF_LIMIT      = 12 };
+enum { LZ4_MAX_OFFSET    = 65535 };
+enum { LZ4_HASH_LOG      = 12 };
+
+struct state_codec
+{
+    m64p_state_codec codec;
+
+    /* zlib */
+    z_stream deflate_stream;
+    z_stream inflate_stream;
+    int deflate_init;
+    int inflate_init;
+
+    /* LZ4, positions relative to the start of the input. The table is
+     * never cleared, stale entries are rejected by the match check. */
+    uint32_t lz4_table[1 << LZ4_HASH_LOG];
+};
+
+struct state_codec* state_codec_create(m64p_state_codec codec)
+{
+    struct state_codec* ctx;
+
+    if (codec != M64CODEC_NONE && codec != M64CODEC_ZLIB && codec != M64CODEC_LZ4)
+        return NULL;
+
+    ctx = calloc(1, sizeof(*ctx));
+    if (ctx == NULL)
+        return NULL;
+
+    ctx->codec = codec;
+
+    if (codec == M64CODEC_ZLIB)
+    {
+        /* level 1 favors speed, states are mostly zeroes anyway */
+        if (deflateInit(&ctx->deflate_stream, 1) != Z_OK)
+        {
+            free(ctx);
+            return NULL;
+        }
+        ctx->deflate_init = 1;
+
+        if (inflateInit(&ctx->inflate_stream) != Z_OK)
+        {
+            state_codec_destroy(ctx);
+            return NULL;
+        }
+        ctx->inflate_init = 1;
+    }
+
+    return ctx;
+}
+
+void state_codec_destroy(struct state_codec* ctx)
+{
+    if (ctx == NULL)
+        return;
+
+    if (ctx->deflate_init)
+        deflateEnd(&ctx->deflate_stream);
+    if (ctx->inflate_init)
+        inflateEnd(&ctx->inflate_stream);
+
+    free(ctx);
+}
+
+m64p_state_codec state_codec_type(const struct state_codec* ctx)
+{
+    return ctx->codec;
+}
+
+const char* state_codec_name(m64p_state_codec codec)
+{
+    switch (codec)
+    {
+        case M64CODEC_NONE: return "none";
+        case M64CODEC_ZLIB: return "zlib";
+        case M64CODEC_LZ4:  return "lz4";
+        default:            return "unknown";
+    }
+}
+
+size_t state_codec_bound(m64p_state_codec codec, size_t size)
+{
+    switch (codec)
+    {
+        case M64CODEC_ZLIB: return (size_t)compressBound((uLong)size);
+        case M64CODEC_LZ4:  return size + (size / 255) + 16;
+        default:            return size;
+    }
+}
+
+static uint32_t lz4_read32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t lz4_hash(uint32_t sequence)
+{
+    return (sequence * UINT32_C(2654435761)) >> (32 - LZ4_HASH_LOG);
+}
+
+static uint8_t* lz4_write_length(uint8_t* op, size_t length)
+{
+    while (length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+static size_t lz4_compress(uint32_t* table, const uint8_t* src, size_t size, uint8_t* dst, size_t capacity)
+{
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* const end = src + size;
+    const uint8_t* const mflimit = (size > LZ4_MF_LIMIT) ? end - LZ4_MF_LIMIT : src;
+    const uint8_t* const matchlimit = (size > LZ4_LAST_LITERALS) ? end - LZ4_LAST_LITERALS : src;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + capacity;
+    size_t literals;
+
+    while (ip < mflimit)
+    {
+        uint32_t sequence = lz4_read32(ip);
+        uint32_t h = lz4_hash(sequence);
+        size_t position = (size_t)(ip - src);
+        size_t candidate = table[h];
+        const uint8_t* ref = src + candidate;
+        const uint8_t* mp;
+        uint8_t* token;
+        size_t offset;
+        size_t match_length;
+
+        table[h] = (uint32_t)position;
+
+        if (candidate >= position || position - candidate > LZ4_MAX_OFFSET || lz4_read32(ref) != sequence)
+        {
+            /* skip faster through incompressible data */
+            ip += 1 + ((size_t)(ip - anchor) >> 6);
+            continue;
+        }
+
+        offset = position - candidate;
+        mp = ip + LZ4_MIN_MATCH;
+        ref += LZ4_MIN_MATCH;
+        while (mp < matchlimit && *mp == *ref)
+        {
+            mp++;
+            ref++;
+        }
+
+        literals = (size_t)(ip - anchor);
+        match_length = (size_t)(mp - ip) - LZ4_MIN_MATCH;
+
+        /* token + literal length + literals + offset + match length */
+        if ((size_t)(oend - op) < 1 + (literals / 255 + 1) + literals + 2 + (match_length / 255 + 1))
+            return 0;
+
+        token = op++;
+        if (literals >= 15)
+        {
+            *token = 15 << 4;
+            op = lz4_write_length(op, literals - 15);
+        }
+        else
+        {
+            *token = (uint8_t)(literals << 4);
+        }
+        memcpy(op, anchor, literals);
+        op += literals;
+
+        *op++ = (uint8_t)(offset & 0xff);
+        *op++ = (uint8_t)(offset >> 8);
+
+        if (match_length >= 15)
+        {
+            *token |= 15;
+            op = lz4_write_length(op, match_length - 15);
+        }
+        else
+        {
+            *token |= (uint8_t)match_length;
+        }
+
+        ip = anchor = mp;
+    }
+
+    /* the last sequence only holds literals */
+    literals = (size_t)(end - anchor);
+    if ((size_t)(oend - op) < 1 + (literals / 255 + 1) + literals)
+        return 0;
+
+    if (literals >= 15)
+    {
+        *op++ = 15 << 4;
+        op = lz4_write_length(op, literals - 15);
+    }
+    else
+    {
+        *op++ = (uint8_t)(literals << 4);
+    }
+    memcpy(op, anchor, literals);
+    op += literals;
+
+    return (size_t)(op - dst);
+}
+
+static int lz4_read_length(const uint8_t** ip, const uint8_t* iend, size_t* length)
+{
+    uint8_t byte;
+
+    do
+    {
+        if (*ip >= iend)
+            return 0;
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+
+    return 1;
+}
+
+static int lz4_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size)
+{
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + size;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + dst_size;
+
+    while (ip < iend)
+    {
+        uint8_t token = *ip++;
+        size_t literals = token >> 4;
+        size_t match_length = token & 15;
+        size_t offset;
+        const uint8_t* ref;
+
+        if (literals == 15 && !lz4_read_length(&ip, iend, &literals))
+            return 0;
+        if (literals > (size_t)(iend - ip) || literals > (size_t)(oend - op))
+            return 0;
+        memcpy(op, ip, literals);
+        op += literals;
+        ip += literals;
+
+        /* the last sequence has no match */
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return 0;
+        offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst))
+            return 0;
+
+        if (match_length == 15 && !lz4_read_length(&ip, iend, &match_length))
+            return 0;
+        match_length += LZ4_MIN_MATCH;
+        if (match_length > (size_t)(oend - op))
+            return 0;
+
+        ref = op - offset;
+        if (offset >= match_length)
+        {
+            memcpy(op, ref, match_length);
+            op += match_length;
+        }
+        else
+        {
+            /* overlapping match, repeats the last offset bytes */
+            while (match_length--)
+                *op++ = *ref++;
+        }
+    }
+
+    return op == oend;
+}
+
+size_t state_codec_compress(struct state_codec* ctx,
+                            const void* src, size_t size,
+                            void* dst, size_t capacity)
+{
+    switch (ctx->codec)
+    {
+        case M64CODEC_NONE:
+            if (capacity < size)
+                return 0;
+            memcpy(dst, src, size);
+            return size;
+
+        case M64CODEC_ZLIB:
+            if (deflateReset(&ctx->deflate_stream) != Z_OK)
+                return 0;
+            ctx->deflate_stream.next_in = (Bytef*)src;
+            ctx->deflate_stream.avail_in = (uInt)size;
+            ctx->deflate_stream.next_out = (Bytef*)dst;
+            ctx->deflate_stream.avail_out = (uInt)capacity;
+            if (deflate(&ctx->deflate_stream, Z_FINISH) != Z_STREAM_END)
+                return 0;
+            return (size_t)ctx->deflate_stream.total_out;
+
+        case M64CODEC_LZ4:
+            return lz4_compress(ctx->lz4_table, (const uint8_t*)src, size, (uint8_t*)dst, capacity);
+
+        default:
+            return 0;
+    }
+}
+
+int state_codec_decompress(struct state_codec* ctx,
+                           const void* src, size_t size,
+                           void* dst, size_t dst_size)
+{
+    switch (ctx->codec)
+    {
+        case M64CODEC_NONE:
+            if (size != dst_size)
+                return 0;
+            memcpy(dst, src, size);
+            return 1;
+
+        case M64CODEC_ZLIB:
+            if (inflateReset(&ctx->inflate_stream) != Z_OK)
+                return 0;
+            ctx->inflate_stream.next_in = (Bytef*)src;
+            ctx->inflate_stream.avail_in = (uInt)size;
+            ctx->inflate_stream.next_out = (Bytef*)dst;
+            ctx->inflate_stream.avail_out = (uInt)dst_size;
+            return inflate(&ctx->inflate_stream, Z_FINISH) == Z_STREAM_END
+                && ctx->inflate_stream.total_out == dst_size;
+
+        case M64CODEC_LZ4:
+            return lz4_decompress((const uint8_t*)src, size, (uint8_t*)dst, dst_size);
+
+        default:
+            return 0;
+    }
+}
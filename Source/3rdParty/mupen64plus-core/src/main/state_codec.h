@@ -0,0 +1,56 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - state_codec.h                                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_STATE_CODEC_H
+#define M64P_MAIN_STATE_CODEC_H
+
+#include <stddef.h>
+
+#include "api/m64p_types.h"
+
+/* Compression of savestates and snapshots.
+ *
+ * A context holds the codec's working memory (zlib streams, LZ4 hash table)
+ * so it can be reused for every frame without allocations.
+ * M64CODEC_LZ4 produces raw LZ4 blocks. */
+
+struct state_codec;
+
+struct state_codec* state_codec_create(m64p_state_codec codec);
+void state_codec_destroy(struct state_codec* ctx);
+
+m64p_state_codec state_codec_type(const struct state_codec* ctx);
+const char* state_codec_name(m64p_state_codec codec);
+
+/* Worst case compressed size of size bytes */
+size_t state_codec_bound(m64p_state_codec codec, size_t size);
+
+/* Returns the compressed size, or 0 when dst is too small */
+size_t state_codec_compress(struct state_codec* ctx,
+                            const void* src, size_t size,
+                            void* dst, size_t capacity);
+
+/* Returns 1 when src decompressed to exactly dst_size bytes */
+int state_codec_decompress(struct state_codec* ctx,
+                           const void* src, size_t size,
+                           void* dst, size_t dst_size);
+
+#endif /* M64P_MAIN_STATE_CODEC_H */
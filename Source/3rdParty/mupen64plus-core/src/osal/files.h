@@ -26,6 +26,7 @@
 #if !defined (OSAL_FILES_H)
 #define OSAL_FILES_H
 
+#include <stdint.h>
 #include <zlib.h>
 
 /* some file-related preprocessor definitions */
@@ -67,5 +68,16 @@ extern const char * osal_get_user_cachepath(void);
 extern FILE * osal_file_open (const char *filename, const char *mode);
 extern gzFile osal_gzopen(const char *filename, const char *mode);
 
+/* Flushes tmppath to disk and renames it to filepath, atomically replacing
+ * filepath if it exists, so filepath never holds a partially written file.
+ * Returns zero on success, nonzero on failure.
+ */
+extern int osal_file_replace(const char *tmppath, const char *filepath);
+
+/* Retrieves the modification time in seconds since the epoch and the size
+ * in bytes of filename. Returns zero on success, nonzero on failure.
+ */
+extern int osal_file_info(const char *filename, int64_t *mtime, int64_t *size);
+
 #endif /* OSAL_FILES_H */
 
@@ -23,6 +23,7 @@
  * functions
  */
 
+#include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -241,3 +242,32 @@ gzFile osal_gzopen(const char *filename, const char *mode)
 {
     return gzopen(filename, mode);
 }
+
+int osal_file_replace(const char *tmppath, const char *filepath)
+{
+    int fd;
+    int ret;
+
+    fd = open(tmppath, O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    ret = fsync(fd);
+    close(fd);
+    if (ret != 0)
+        return -1;
+
+    return rename(tmppath, filepath);
+}
+
+int osal_file_info(const char *filename, int64_t *mtime, int64_t *size)
+{
+    struct stat fileinfo;
+
+    if (stat(filename, &fileinfo) != 0)
+        return -1;
+
+    *mtime = (int64_t)fileinfo.st_mtime;
+    *size = (int64_t)fileinfo.st_size;
+    return 0;
+}
@@ -220,3 +220,40 @@ gzFile osal_gzopen(const char *filename, const char *mode)
     MultiByteToWideChar(CP_UTF8, 0, filename, -1, wstr_filename, PATH_MAX);
     return gzopen_w(wstr_filename, mode);
 }
+
+int osal_file_replace(const char *tmppath, const char *filepath)
+{
+    wchar_t wstr_tmppath[PATH_MAX];
+    wchar_t wstr_filepath[PATH_MAX];
+    HANDLE file;
+    BOOL flushed;
+
+    MultiByteToWideChar(CP_UTF8, 0, tmppath, -1, wstr_tmppath, PATH_MAX);
+    MultiByteToWideChar(CP_UTF8, 0, filepath, -1, wstr_filepath, PATH_MAX);
+
+    file = CreateFileW(wstr_tmppath, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return -1;
+
+    flushed = FlushFileBuffers(file);
+    CloseHandle(file);
+    if (!flushed)
+        return -1;
+
+    return MoveFileExW(wstr_tmppath, wstr_filepath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+}
+
+int osal_file_info(const char *filename, int64_t *mtime, int64_t *size)
+{
+    wchar_t wstr_filename[PATH_MAX];
+    struct _stat64 fileinfo;
+
+    MultiByteToWideChar(CP_UTF8, 0, filename, -1, wstr_filename, PATH_MAX);
+
+    if (_wstat64(wstr_filename, &fileinfo) != 0)
+        return -1;
+
+    *mtime = (int64_t)fileinfo.st_mtime;
+    *size = (int64_t)fileinfo.st_size;
+    return 0;
+}
@@ -24,7 +24,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define M64P_CORE_PROTOTYPES 1
 #include "api/callbacks.h"
+#include "api/m64p_config.h"
 #include "api/m64p_common.h"
 #include "api/m64p_plugin.h"
 #include "api/m64p_types.h"
@@ -575,6 +577,32 @@ m64p_error plugin_start(m64p_plugin_type type)
     return M64ERR_INTERNAL;
 }
 
+int plugin_gfx_writes_rdram_async(void)
+{
+    const char* name = NULL;
+    m64p_handle section;
+
+    if (!l_GfxAttached)
+        return 0;
+
+    (*gfx.getVersion)(NULL, NULL, NULL, &name, NULL);
+    if (name == NULL)
+        return 0;
+
+    /* parallel-RDP renders on the GPU, which writes RDRAM directly */
+    if (strncmp(name, "parallel", 8) == 0)
+        return 1;
+
+    /* the threaded backend of GLideN64 runs after the calls returned */
+    if (strncmp(name, "GLideN64", 8) == 0)
+    {
+        return ConfigOpenSection("Video-GLideN64", &section) == M64ERR_SUCCESS
+            && ConfigGetParamBool(section, "ThreadedVideo");
+    }
+
+    return 0;
+}
+
 m64p_error plugin_check(void)
 {
     if (!l_GfxAttached)
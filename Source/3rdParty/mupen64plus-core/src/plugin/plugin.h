@@ -31,6 +31,10 @@ extern m64p_error plugin_connect(m64p_plugin_type, m64p_dynlib_handle plugin_han
 extern m64p_error plugin_start(m64p_plugin_type);
 extern m64p_error plugin_check(void);
 
+/* Returns whether the video plugin may write RDRAM outside of its calls or
+ * without going through the CPU, so that write protection can't see it */
+extern int plugin_gfx_writes_rdram_async(void);
+
 enum { NUM_CONTROLLER = 4 };
 extern CONTROL Controls[NUM_CONTROLLER];
 
@@ -0,0 +1,255 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rom_bench.c                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Micro-benchmark of the byte-swapping and hashing done when a ROM image is
+ * opened, see open_rom(). Build it with "make rom_bench" in projects/unix and
+ * run it with the image size in MB and the number of runs:
+ *
+ *   ./rom_bench [size] [runs]
+ *
+ * It checks swap_copy() against a plain byte by byte swap first, then reports
+ * the throughput of every step, and of opening an unknown ROM image (XXH3 and
+ * MD5 in one pass) and a known one (XXH3 only). The images are random data in
+ * .n64 format.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include "main/rom_swap.h"
+#include "md5.h"
+
+/* open_rom() converts and hashes the image in parts of this size */
+#define PART_SIZE 16384
+
+typedef void (*bench_func)(uint8_t* dst, const uint8_t* src, size_t len);
+
+static XXH128_hash_t l_hash;
+static md5_byte_t l_digest[16];
+
+static void swap_bytewise(uint8_t* dst, const uint8_t* src, size_t len, size_t width)
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0; i + width <= len; i += width)
+    {
+        for (j = 0; j < width; j++)
+            dst[i + j] = src[i + width - 1 - j];
+    }
+    memcpy(dst + i, src + i, len - i);
+}
+
+static void bench_bytewise_v64(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    swap_bytewise(dst, src, len, 2);
+}
+
+static void bench_bytewise_n64(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    swap_bytewise(dst, src, len, 4);
+}
+
+static void bench_swap_v64(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    swap_copy(dst, src, len, 2);
+}
+
+static void bench_swap_n64(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    swap_copy(dst, src, len, 4);
+}
+
+static void bench_xxh3(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    (void)dst;
+    l_hash = XXH3_128bits(src, len);
+}
+
+static void bench_md5(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    md5_state_t state;
+
+    (void)dst;
+    md5_init(&state);
+    md5_append(&state, (const md5_byte_t*)src, (int)len);
+    md5_finish(&state, l_digest);
+}
+
+/* converts a .n64 image in parts, hashes every part and stores it
+ * in host byte order, like open_rom() on a little endian host */
+static void open_image(uint8_t* dst, const uint8_t* src, size_t len, int with_md5)
+{
+    uint32_t part[PART_SIZE / 4];
+    XXH3_state_t hash_state;
+    md5_state_t state;
+    size_t offset;
+    size_t part_len;
+
+    XXH3_128bits_reset(&hash_state);
+    if (with_md5)
+        md5_init(&state);
+
+    for (offset = 0; offset < len; offset += part_len)
+    {
+        part_len = len - offset;
+        if (part_len > sizeof(part))
+            part_len = sizeof(part);
+
+        swap_copy(part, src + offset, part_len, 4);
+        XXH3_128bits_update(&hash_state, part, part_len);
+        if (with_md5)
+            md5_append(&state, (const md5_byte_t*)part, (int)part_len);
+        swap_copy(dst + offset, part, part_len, 4);
+    }
+
+    l_hash = XXH3_128bits_digest(&hash_state);
+    if (with_md5)
+        md5_finish(&state, l_digest);
+}
+
+static void bench_open_unknown(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    open_image(dst, src, len, 1);
+}
+
+static void bench_open_known(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    open_image(dst, src, len, 0);
+}
+
+static void run(const char* name, bench_func func, uint8_t* dst, const uint8_t* src, size_t len, int runs)
+{
+    double best = 0.0;
+    int i;
+
+    for (i = 0; i < runs; i++)
+    {
+        clock_t start = clock();
+        func(dst, src, len);
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        if (i == 0 || seconds < best)
+            best = seconds;
+    }
+
+    if (best <= 0.0)
+        printf("%-24s too fast to measure\n", name);
+    else
+        printf("%-24s %8.3f ms %10.1f MB/s\n", name, best * 1000.0, (double)len / (1024.0 * 1024.0) / best);
+}
+
+static int check_swap(uint8_t* dst, uint8_t* expected, const uint8_t* src, size_t len, size_t width)
+{
+    /* odd lengths and offsets cover the unaligned heads and the tails */
+    static const size_t offsets[] = { 0, 1, 3 };
+    static const size_t lengths[] = { 0, 1, 2, 3, 15, 17, 31, 33, 4099 };
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++)
+    {
+        for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++)
+        {
+            swap_bytewise(expected, src + offsets[i], lengths[j], width);
+            swap_copy(dst, src + offsets[i], lengths[j], width);
+            if (memcmp(dst, expected, lengths[j]) != 0)
+                return 0;
+        }
+    }
+
+    swap_bytewise(expected, src, len, width);
+    swap_copy(dst, src, len, width);
+    if (memcmp(dst, expected, len) != 0)
+        return 0;
+
+    /* in place, as done when probing ROM images */
+    memcpy(dst, src, len);
+    swap_copy(dst, dst, len, width);
+    return memcmp(dst, expected, len) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t size = (size_t)((argc > 1) ? atoi(argv[1]) : 64) * 1024 * 1024;
+    int runs = (argc > 2) ? atoi(argv[2]) : 10;
+    uint8_t* src;
+    uint8_t* dst;
+    uint8_t* expected;
+    uint32_t seed = 0x12345678;
+    size_t i;
+
+    if (size == 0 || runs <= 0)
+    {
+        fprintf(stderr, "Usage: %s [size in MB] [runs]\n", argv[0]);
+        return 1;
+    }
+
+    src = malloc(size);
+    dst = malloc(size);
+    expected = malloc(size);
+    if (src == NULL || dst == NULL || expected == NULL)
+    {
+        fprintf(stderr, "Couldn't allocate %u MB\n", (unsigned int)(size >> 20) * 3);
+        return 1;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        src[i] = (uint8_t)seed;
+    }
+
+    if (!check_swap(dst, expected, src, size, 2) || !check_swap(dst, expected, src, size, 4))
+    {
+        fprintf(stderr, "swap_copy() doesn't match the byte by byte swap\n");
+        return 1;
+    }
+
+    printf("%u MB, best of %d runs\n", (unsigned int)(size >> 20), runs);
+    run("bytewise swap (.v64)", bench_bytewise_v64, dst, src, size, runs);
+    run("bytewise swap (.n64)", bench_bytewise_n64, dst, src, size, runs);
+    run("swap_copy (.v64)", bench_swap_v64, dst, src, size, runs);
+    run("swap_copy (.n64)", bench_swap_n64, dst, src, size, runs);
+    run("XXH3-128", bench_xxh3, dst, src, size, runs);
+    run("MD5", bench_md5, dst, src, size, runs);
+    run("open unknown ROM", bench_open_unknown, dst, src, size, runs);
+    run("open known ROM", bench_open_known, dst, src, size, runs);
+
+    /* also keeps the hashing from being optimized away */
+    printf("XXH3-128 %016llx%016llx, MD5 ", (unsigned long long)l_hash.high64, (unsigned long long)l_hash.low64);
+    for (i = 0; i < 16; i++)
+        printf("%02X", l_digest[i]);
+    printf("\n");
+
+    free(expected);
+    free(dst);
+    free(src);
+    return 0;
+}
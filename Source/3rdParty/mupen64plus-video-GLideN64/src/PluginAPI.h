@@ -52,6 +52,8 @@ public:
 	void GetUserConfigPath(wchar_t * _strPath);
 #endif // M64P_GLIDENUI
 	bool isRomOpen() const { return m_bRomOpen; }
+	// whether the core re-emulates frames which were already presented
+	bool isResimulating() const;
 
 #ifndef MUPENPLUSAPI
 	// Zilmar
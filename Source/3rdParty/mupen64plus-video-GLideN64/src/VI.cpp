@@ -11,6 +11,7 @@
 #include "FrameBufferInfo.h"
 #include "Config.h"
 #include "Performance.h"
+#include "PluginAPI.h"
 #include "Debugger.h"
 #include "DebugDump.h"
 #include "osal_keys.h"
@@ -261,6 +262,7 @@ void VI_UpdateScreen()
 
 	checkHotkeys();
 
+	const bool bResimulating = api().isResimulating();
 	bool bVIUpdated = false;
 	if (*REG.VI_ORIGIN != VI.lastOrigin) {
 		VI_UpdateSize();
@@ -317,7 +319,9 @@ void VI_UpdateScreen()
 				}
 				FrameBuffer_CopyFromRDRAM(*REG.VI_ORIGIN & 0xffffff, bCFB);
 			}
-			frameBufferList().renderBuffer();
+			// resimulated frames were already presented
+			if (!bResimulating)
+				frameBufferList().renderBuffer();
 			frameBufferList().clearBuffersChanged();
 			VI.lastOrigin = *REG.VI_ORIGIN;
 		}
@@ -334,7 +338,7 @@ void VI_UpdateScreen()
 			bNeedRender = (gDP.changed & CHANGED_COLORBUFFER) != 0;
 			break;
 		}
-		if (bNeedRender)
+		if (bNeedRender && !bResimulating)
 			frameBufferList().renderBuffer();
 
 		gDP.changed &= ~CHANGED_COLORBUFFER;
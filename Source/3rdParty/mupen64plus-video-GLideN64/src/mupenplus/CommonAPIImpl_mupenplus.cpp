@@ -58,6 +58,15 @@ void _getWSPath(const char * _path, wchar_t * _strPath, bool cutLastPathSeperato
 	}
 }
 
+bool PluginAPI::isResimulating() const
+{
+	int resimulating = 0;
+	if (CoreDoCommandFunc == nullptr ||
+		CoreDoCommandFunc(M64CMD_CORE_STATE_QUERY, M64CORE_RESIMULATING, &resimulating) != M64ERR_SUCCESS)
+		return false;
+	return resimulating != 0;
+}
+
 void PluginAPI::GetUserDataPath(wchar_t * _strPath)
 {
 	_getWSPath(ConfigGetUserDataPath(), _strPath);
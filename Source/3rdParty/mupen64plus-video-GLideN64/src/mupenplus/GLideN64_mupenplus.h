@@ -53,6 +53,7 @@ extern ptr_VidExt_GL_SwapBuffers        CoreVideo_GL_SwapBuffers;
 extern ptr_VidExt_GL_GetDefaultFramebuffer CoreVideo_GL_GetDefaultFramebuffer;
 
 extern ptr_PluginGetVersion             CoreGetVersion;
+extern ptr_CoreDoCommand                CoreDoCommandFunc;
 
 extern void*                            CoreDebugCallbackContext;
 extern ptr_DebugCallback                CoreDebugCallback;
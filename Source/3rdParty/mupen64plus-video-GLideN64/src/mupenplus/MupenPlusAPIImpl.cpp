@@ -48,6 +48,7 @@ ptr_VidExt_GL_SwapBuffers        CoreVideo_GL_SwapBuffers = nullptr;
 ptr_VidExt_GL_GetDefaultFramebuffer CoreVideo_GL_GetDefaultFramebuffer = nullptr;
 
 ptr_PluginGetVersion             CoreGetVersion = nullptr;
+ptr_CoreDoCommand                CoreDoCommandFunc = nullptr;
 
 void*                            CoreDebugCallbackContext = nullptr;
 ptr_DebugCallback                CoreDebugCallback        = nullptr;
@@ -99,6 +100,7 @@ m64p_error PluginAPI::PluginStartup(m64p_dynlib_handle _CoreLibHandle, void* Con
 	CoreVideo_GL_GetDefaultFramebuffer = (ptr_VidExt_GL_GetDefaultFramebuffer) DLSYM(_CoreLibHandle, "VidExt_GL_GetDefaultFramebuffer");
 
 	CoreGetVersion = (ptr_PluginGetVersion) DLSYM(_CoreLibHandle, "PluginGetVersion");
+	CoreDoCommandFunc = (ptr_CoreDoCommand) DLSYM(_CoreLibHandle, "CoreDoCommand");
 
 #ifndef M64P_GLIDENUI
 	if (Config_SetDefault()) {
@@ -30,6 +30,11 @@ int PluginAPI::InitiateGFX(const GFX_INFO & _gfxInfo)
 	return TRUE;
 }
 
+bool PluginAPI::isResimulating() const
+{
+	return false;
+}
+
 void PluginAPI::FindPluginPath(wchar_t * _strPath)
 {
 	if (_strPath == NULL)
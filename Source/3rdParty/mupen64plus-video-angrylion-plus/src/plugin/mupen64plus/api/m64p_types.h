@@ -137,7 +137,9 @@ typedef enum {
   M64CORE_AUDIO_MUTE,
   M64CORE_INPUT_GAMESHARK,
   M64CORE_STATE_LOADCOMPLETE,
-  M64CORE_STATE_SAVECOMPLETE
+  M64CORE_STATE_SAVECOMPLETE,
+  M64CORE_SCREENSHOT_CAPTURED,
+  M64CORE_RESIMULATING
 } m64p_core_param;
 
 typedef enum {
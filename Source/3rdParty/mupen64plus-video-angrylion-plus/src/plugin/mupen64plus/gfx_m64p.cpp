@@ -49,6 +49,9 @@ ptr_ConfigGetParamBool     ConfigGetParamBool = NULL;
 ptr_ConfigSetParameter     ConfigSetParameter = NULL;
 ptr_PluginGetVersion       CoreGetVersion = NULL;
 
+typedef m64p_error (*ptr_CoreDoCommand)(m64p_command, int, void *);
+static ptr_CoreDoCommand   CoreDoCommand = NULL;
+
 static bool warn_hle;
 static bool plugin_initialized;
 void (*debug_callback)(void *, int, const char *);
@@ -95,6 +98,7 @@ EXPORT m64p_error CALL PluginStartup(m64p_dynlib_handle _CoreLibHandle, void *Co
     ConfigSetDefaultInt(configVideoAngrylionPlus, KEY_SCREEN_HEIGHT, 480, "Height of output window or fullscreen height");
 
     CoreGetVersion = (ptr_PluginGetVersion)DLSYM(CoreLibHandle, "PluginGetVersion");
+    CoreDoCommand = (ptr_CoreDoCommand)DLSYM(CoreLibHandle, "CoreDoCommand");
 
     n64video_config_init(&config);
 
@@ -248,9 +252,27 @@ EXPORT void CALL ShowCFB (void)
 {
 }
 
+static bool is_resimulating(void)
+{
+    int resimulating = 0;
+    if (CoreDoCommand == NULL ||
+        CoreDoCommand(M64CMD_CORE_STATE_QUERY, M64CORE_RESIMULATING, &resimulating) != M64ERR_SUCCESS) {
+        return false;
+    }
+    return resimulating != 0;
+}
+
 EXPORT void CALL UpdateScreen (void)
 {
     struct n64video_frame_buffer fb;
+
+    // the VI only reads RDRAM, so resimulated
+    // frames, which were already presented,
+    // can skip filtering and presentation
+    if (is_resimulating()) {
+        return;
+    }
+
     n64video_update_screen(&fb);
 
     if (fb.valid) {
@@ -38,6 +38,7 @@
 
 #include "m64p_types.h"
 #include "m64p_config.h"
+#include "m64p_frontend.h"
 
 #include <string.h>
 #include <stdint.h>
@@ -70,10 +71,12 @@ m64p_handle configVideoParallel = NULL;
 
 uint32_t rdram_size;
 static ptr_PluginGetVersion CoreGetVersion = NULL;
+static ptr_CoreDoCommand CoreDoCommand = NULL;
 
 void plugin_init(void)
 {
     CoreGetVersion = (ptr_PluginGetVersion)DLSYM(CoreLibHandle, "PluginGetVersion");
+    CoreDoCommand = (ptr_CoreDoCommand)DLSYM(CoreLibHandle, "CoreDoCommand");
 
     int core_version;
     CoreGetVersion(NULL, &core_version, NULL, NULL, NULL);
@@ -91,6 +94,17 @@ void plugin_close(void)
 {
 }
 
+static bool is_resimulating(void)
+{
+    int resimulating = 0;
+    if (CoreDoCommand == NULL ||
+        CoreDoCommand(M64CMD_CORE_STATE_QUERY, M64CORE_RESIMULATING, &resimulating) != M64ERR_SUCCESS)
+    {
+        return false;
+    }
+    return resimulating != 0;
+}
+
 void DebugMessage(int level, const char *message, ...)
 {
     char msgbuf[1024];
@@ -343,12 +357,14 @@ EXPORT void CALL RomClosed(void)
 
 EXPORT void CALL ShowCFB(void)
 {
-    vk_rasterize();
+    vk_rasterize(true);
 }
 
 EXPORT void CALL UpdateScreen(void)
 {
-    vk_rasterize();
+    // resimulated frames were already presented,
+    // the RDP keeps processing commands regardless
+    vk_rasterize(!is_resimulating());
 }
 
 EXPORT void CALL ViStatusChanged(void)
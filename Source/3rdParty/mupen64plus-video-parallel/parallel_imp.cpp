@@ -229,7 +229,7 @@ static void render_frame(Vulkan::Device &device)
 	device.submit(cmd);
 }
 
-void vk_rasterize()
+void vk_rasterize(bool present)
 {
 	processor->set_vi_register(RDP::VIRegister::Control, *GET_GFX_INFO(VI_STATUS_REG));
 	processor->set_vi_register(RDP::VIRegister::Origin, *GET_GFX_INFO(VI_ORIGIN_REG));
@@ -251,9 +251,14 @@ void vk_rasterize()
 	quirks.set_native_resolution_tex_rect(vk_native_tex_rect);
 	processor->set_quirks(quirks);
 
-	auto &device = wsi->get_device();
-	render_frame(device);
-	(*render_callback)(1);
+	// the frame context is cycled regardless,
+	// so that frame resources keep getting recycled
+	if (present)
+	{
+		auto &device = wsi->get_device();
+		render_frame(device);
+		(*render_callback)(1);
+	}
 	wsi->end_frame();
 	wsi->begin_frame();
 }
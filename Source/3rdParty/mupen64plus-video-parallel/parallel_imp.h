@@ -23,7 +23,7 @@ extern "C"
     extern bool vk_interlacing;
     extern bool vk_synchronous;
 
-    void vk_rasterize();
+    void vk_rasterize(bool present);
     void vk_process_commands();
     bool vk_init();
     void vk_destroy();
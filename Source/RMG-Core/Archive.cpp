@@ -8,13 +8,17 @@
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #define CORE_INTERNAL
+#include "Directories.hpp"
 #include "Archive.hpp"
 #include "Library.hpp"
 #include "String.hpp"
 #include "Error.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
+#include <climits>
+#include <mutex>
 
 // lzma includes
 #include <3rdParty/lzma/7zVersion.h>
@@ -34,6 +38,36 @@
 //
 
 #define UNZIP_READ_SIZE 67108860 /* 64 MiB */
+#define ARCHIVE_READ_SIZE 1048576 /* 1 MiB */
+#define EXTRACTED_DISKS_MAX 8
+
+//
+// Local Structures
+//
+
+struct CoreArchiveStream
+{
+    bool IsZip = false;
+
+    // zip stream
+    unzFile ZipFile = nullptr;
+
+    // 7zip stream, 7zip archives are decompressed
+    // in blocks, so the block containing the file
+    // is decompressed when it's read for the first time
+    ISzAlloc      AllocImp;
+    ISzAlloc      AllocTempImp;
+    CFileInStream ArchiveStream;
+    CLookToRead2  LookStream;
+    CSzArEx       Db;
+    uint32_t      FileIndex        = 0;
+    uint32_t      BlockIndex       = 0xFFFFFFFF;
+    uint8_t*      BlockBuffer      = nullptr;
+    size_t        BlockBufferSize  = 0;
+    size_t        FileOffset       = 0;
+    size_t        FileSize         = 0;
+    size_t        ReadOffset       = 0;
+};
 
 //
 // Local Functions
@@ -43,17 +77,20 @@ static voidpf zlib_filefunc_open(voidpf opaque, const void* filename, int mode)
 {
     std::filesystem::path path = *(std::filesystem::path*)filename;
 
-    // we need a static filestream
-    static std::ifstream fileStream;
+    // every opened file needs its own filestream,
+    // because archives may be read from several
+    // threads at the same time
+    std::ifstream* fileStream = new std::ifstream();
 
     // attempt to open file
-    fileStream.open(path, std::ios::binary);
-    if (!fileStream.is_open())
+    fileStream->open(path, std::ios::binary);
+    if (!fileStream->is_open())
     {
+        delete fileStream;
         return nullptr;
     }
 
-    return (voidpf)&fileStream;
+    return (voidpf)fileStream;
 }
 
 static uLong zlib_filefunc_read(voidpf opaque, voidpf stream, void* buf, uLong size)
@@ -97,7 +134,9 @@ static int zlib_filefunc_close(voidpf opaque, voidpf stream)
 {
     std::ifstream* fileStream = (std::ifstream*)stream;
     fileStream->close();
-    return fileStream->fail() ? -1 : 0;
+    bool failed = fileStream->fail();
+    delete fileStream;
+    return failed ? -1 : 0;
 }
 
 static int zlib_filefunc_testerror(voidpf opaque, voidpf stream)
@@ -105,19 +144,8 @@ static int zlib_filefunc_testerror(voidpf opaque, voidpf stream)
     return errno;
 }
 
-//
-// Exported Functions
-//
-
-CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer)
+static void zlib_filefunc_fill(zlib_filefunc64_def& filefuncs)
 {
-    std::string  error;
-    std::fstream fileStream;
-
-    unzFile           zipFile;
-    unz_global_info64 zipInfo;
-
-    zlib_filefunc64_def filefuncs;
     filefuncs.zopen64_file = zlib_filefunc_open;
     filefuncs.zread_file   = zlib_filefunc_read;
     filefuncs.zwrite_file  = nullptr;
@@ -126,6 +154,29 @@ CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::pa
     filefuncs.zclose_file  = zlib_filefunc_close;
     filefuncs.zerror_file  = zlib_filefunc_testerror;
     filefuncs.opaque       = nullptr;
+}
+
+static bool is_supported_file(std::filesystem::path fileNamePath, bool& isDisk)
+{
+    std::string fileExtension = fileNamePath.has_extension() ? fileNamePath.extension().string() : "";
+    fileExtension = CoreLowerString(fileExtension);
+
+    isDisk = (fileExtension == ".ndd" || fileExtension == ".d64");
+    return isDisk ||
+           fileExtension == ".z64" ||
+           fileExtension == ".v64" ||
+           fileExtension == ".n64";
+}
+
+static bool open_zip_stream(std::filesystem::path file, CoreArchiveStream*& stream, CoreArchiveFileInfo& info)
+{
+    std::string error;
+
+    unzFile           zipFile;
+    unz_global_info64 zipInfo;
+
+    zlib_filefunc64_def filefuncs;
+    zlib_filefunc_fill(filefuncs);
 
     zipFile = unzOpen2_64((const void*)&file, &filefuncs);
     if (zipFile == nullptr)
@@ -149,6 +200,7 @@ CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::pa
 
     if (unzGetGlobalInfo64(zipFile, &zipInfo) != UNZ_OK)
     {
+        unzClose(zipFile);
         error = "CoreReadZipFile: unzGetGlobalInfo Failed!";
         CoreSetError(error);
         return false;
@@ -156,18 +208,18 @@ CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::pa
 
     for (uint64_t i = 0; i < zipInfo.number_entry; i++)
     {
-        unz_file_info fileInfo;
-        char          fileName[PATH_MAX];
+        unz_file_info64 fileInfo;
+        char            fileName[PATH_MAX];
 
         // if we can't retrieve file info,
         // skip the file
-        if (unzGetCurrentFileInfo(zipFile, &fileInfo, fileName, PATH_MAX, nullptr, 0, nullptr, 0) != UNZ_OK)
+        if (unzGetCurrentFileInfo64(zipFile, &fileInfo, fileName, PATH_MAX, nullptr, 0, nullptr, 0) != UNZ_OK)
         {
             continue;
         }
 
         // make sure file has supported file format,
-        // if it does, read it in memory
+        // if it does, open it
         std::filesystem::path fileNamePath;
         // Windows sometimes throws an exception when assigning a string to a path
         // due to being unable to convert the character sequence.
@@ -180,48 +232,25 @@ CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::pa
         {
             // ignore exception
         }
-        std::string fileExtension = fileNamePath.has_extension() ? fileNamePath.extension().string() : "";
-        fileExtension = CoreLowerString(fileExtension);
-        if (fileExtension == ".z64" ||
-            fileExtension == ".v64" ||
-            fileExtension == ".n64" ||
-            fileExtension == ".ndd" ||
-            fileExtension == ".d64")
+        bool isDisk = false;
+        if (is_supported_file(fileNamePath, isDisk))
         {
-            std::vector<char> buffer(UNZIP_READ_SIZE);
-            int bytes_read = 0;
-
-            outBuffer.reserve(UNZIP_READ_SIZE);
-
             if (unzOpenCurrentFile(zipFile) != UNZ_OK)
             {
+                unzClose(zipFile);
                 error = "CoreReadZipFile Failed: unzOpenCurrentFile Failed!";
                 CoreSetError(error);
                 return false;
             }
 
-            do
-            {
-                bytes_read = unzReadCurrentFile(zipFile, buffer.data(), UNZIP_READ_SIZE);
-                if (bytes_read < 0)
-                {
-                    unzCloseCurrentFile(zipFile);
-                    unzClose(zipFile);
-                    error = "CoreReadZipFile Failed: unzReadCurrentFile Failed: ";
-                    error += std::to_string(bytes_read);
-                    CoreSetError(error);
-                    return false;
-                }
-                else if (bytes_read > 0)
-                {
-                    outBuffer.insert(outBuffer.end(), buffer.begin(), std::next(buffer.begin(), bytes_read));
-                }
-            } while (bytes_read > 0);
+            info.FileName = fileNamePath;
+            info.IsDisk   = isDisk;
+            info.Size     = fileInfo.uncompressed_size;
+            info.CRC32    = fileInfo.crc;
 
-            extractedFileName = fileNamePath;
-            isDisk            = (fileExtension == ".ndd" || fileExtension == ".d64");
-            unzCloseCurrentFile(zipFile);
-            unzClose(zipFile);
+            stream = new CoreArchiveStream();
+            stream->IsZip   = true;
+            stream->ZipFile = zipFile;
             return true;
         }
 
@@ -247,33 +276,40 @@ CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::pa
     return false;
 }
 
-CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer)
+static void close_7zip_stream(CoreArchiveStream* stream)
+{
+    SzArEx_Free(&stream->Db, &stream->AllocImp);
+    ISzAlloc_Free(&stream->AllocImp, stream->LookStream.buf);
+    File_Close(&stream->ArchiveStream.file);
+    ISzAlloc_Free(&stream->AllocImp, stream->BlockBuffer);
+    delete stream;
+}
+
+static bool open_7zip_stream(std::filesystem::path file, CoreArchiveStream*& stream, CoreArchiveFileInfo& info)
 {
     std::string  error;
 
     const ISzAlloc alloc = { SzAlloc, SzFree };
     const size_t bufSize = ((size_t)1 << 18);
 
-    ISzAlloc allocImp;
-    ISzAlloc allocTempImp;
+    static std::once_flag crcTableFlag;
 
-    CFileInStream archiveStream;
-    CLookToRead2 lookStream;
-    CSzArEx db;
+    CoreArchiveStream* archive = new CoreArchiveStream();
     SRes res;
 
     // initialize allocator 
-    allocImp     = alloc;
-    allocTempImp = alloc;
+    archive->AllocImp     = alloc;
+    archive->AllocTempImp = alloc;
 
     // try to open file
 #ifdef _WIN32
-    WRes wres = InFile_OpenW(&archiveStream.file, file.wstring().c_str());
+    WRes wres = InFile_OpenW(&archive->ArchiveStream.file, file.wstring().c_str());
 #else
-    WRes wres = InFile_Open(&archiveStream.file, file.string().c_str());
+    WRes wres = InFile_Open(&archive->ArchiveStream.file, file.string().c_str());
 #endif // _WIN32
     if (wres != 0)
     {
+        delete archive;
         error = "CoreRead7zipFile Failed: InFile_Open Failed: ";
         error += std::to_string(wres);
         CoreSetError(error);
@@ -281,62 +317,64 @@ CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::p
     }
 
     // create vtables for streams
-    FileInStream_CreateVTable(&archiveStream);
-    archiveStream.wres = 0;
-    LookToRead2_CreateVTable(&lookStream, 0);
-    lookStream.buf = nullptr;
+    FileInStream_CreateVTable(&archive->ArchiveStream);
+    archive->ArchiveStream.wres = 0;
+    LookToRead2_CreateVTable(&archive->LookStream, 0);
+    archive->LookStream.buf = nullptr;
+
+    // initialize archive, so it
+    // can be freed when we fail
+    SzArEx_Init(&archive->Db);
 
     // allocate memory look reader
-    lookStream.buf = (Byte*)ISzAlloc_Alloc(&allocImp, bufSize);
-    if (lookStream.buf == nullptr)
+    archive->LookStream.buf = (Byte*)ISzAlloc_Alloc(&archive->AllocImp, bufSize);
+    if (archive->LookStream.buf == nullptr)
     {
+        close_7zip_stream(archive);
         error = "CoreRead7zipFile Failed: ISzAlloc_Alloc Failed!";
         CoreSetError(error);
         return false;
     }
 
     // initialize look reader
-    lookStream.bufSize = bufSize;
-    lookStream.realStream = &archiveStream.vt;
-    LookToRead2_INIT(&lookStream);
-
-    // initialize CRC table
-    CrcGenerateTable();
+    archive->LookStream.bufSize = bufSize;
+    archive->LookStream.realStream = &archive->ArchiveStream.vt;
+    LookToRead2_INIT(&archive->LookStream);
 
-    // initialize archive
-    SzArEx_Init(&db);
+    // initialize CRC table once, archives
+    // may be opened from several threads
+    std::call_once(crcTableFlag, CrcGenerateTable);
 
     // try to open file
-    res = SzArEx_Open(&db, &lookStream.vt, &allocImp, &allocTempImp);
+    res = SzArEx_Open(&archive->Db, &archive->LookStream.vt, &archive->AllocImp, &archive->AllocTempImp);
     if (res != SZ_OK)
     {
+        close_7zip_stream(archive);
         error = "CoreRead7zipFile Failed: SzArEx_Open Failed: ";
         error += std::to_string(res);
         CoreSetError(error);
-        SzArEx_Free(&db, &allocImp);
-        ISzAlloc_Free(&allocImp, lookStream.buf);
         return false;
     }
 
-    for (uint32_t i = 0; i < db.NumFiles; i++)
+    for (uint32_t i = 0; i < archive->Db.NumFiles; i++)
     {
         size_t filename_size = 0;
         uint16_t fileName[PATH_MAX];
 
         // skip directories
-        if (SzArEx_IsDir(&db, i))
+        if (SzArEx_IsDir(&archive->Db, i))
         {
             continue;
         }
 
         // skip when filename size exceeds our buffer size
-        filename_size = SzArEx_GetFileNameUtf16(&db, i, nullptr);
+        filename_size = SzArEx_GetFileNameUtf16(&archive->Db, i, nullptr);
         if (filename_size > PATH_MAX)
         {
             continue;
         }
 
-        SzArEx_GetFileNameUtf16(&db, i, fileName);
+        SzArEx_GetFileNameUtf16(&archive->Db, i, fileName);
 
         std::filesystem::path fileNamePath;
         // Windows sometimes throws an exception when assigning a string to a path
@@ -350,86 +388,380 @@ CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::p
         {
             // ignore exception
         }
-        std::string fileExtension = fileNamePath.has_extension() ? fileNamePath.extension().string() : "";
-        fileExtension = CoreLowerString(fileExtension);
-        if (fileExtension == ".z64" ||
-            fileExtension == ".v64" ||
-            fileExtension == ".n64" ||
-            fileExtension == ".ndd" ||
-            fileExtension == ".d64")
+        bool isDisk = false;
+        if (is_supported_file(fileNamePath, isDisk))
         {
-            uint32_t blockIndex = 0xFFFFFFFF;
-            uint8_t* readBuffer = nullptr;
-            size_t   readBufferSize = 0;
-            size_t   offset = 0;
-            size_t   outSizeProcessed = 0;
-
-            res = SzArEx_Extract(&db, &lookStream.vt, i,
-                                    &blockIndex, &readBuffer, &readBufferSize,
-                                    &offset, &outSizeProcessed,
-                                    &allocImp, &allocTempImp);
-            if (res != SZ_OK)
-            {
-                error = "CoreRead7zipFile Failed: SzArEx_Extract Failed: ";
-                error += std::to_string(res);
-                CoreSetError(error);
-
-                SzArEx_Free(&db, &allocImp);
-                ISzAlloc_Free(&allocImp, lookStream.buf);
-                File_Close(&archiveStream.file);
-                ISzAlloc_Free(&allocImp, readBuffer);
-                return false;
-            }
-
-            outBuffer.insert(outBuffer.begin(), readBuffer, readBuffer + outSizeProcessed);
-            extractedFileName = fileNamePath;
-            isDisk            = (fileExtension == ".ndd" || fileExtension == ".d64");
-
-            SzArEx_Free(&db, &allocImp);
-            ISzAlloc_Free(&allocImp, lookStream.buf);
-            File_Close(&archiveStream.file);
-            ISzAlloc_Free(&allocImp, readBuffer);
+            info.FileName = fileNamePath;
+            info.IsDisk   = isDisk;
+            info.Size     = SzArEx_GetFileSize(&archive->Db, i);
+            info.CRC32    = SzBitWithVals_Check(&archive->Db.CRCs, i) ? archive->Db.CRCs.Vals[i] : 0;
+
+            archive->IsZip     = false;
+            archive->FileIndex = i;
+            stream = archive;
             return true;
         }
     }
 
-    // cleanup
-    SzArEx_Free(&db, &allocImp);
-    ISzAlloc_Free(&allocImp, lookStream.buf);
-    File_Close(&archiveStream.file);
+    close_7zip_stream(archive);
 
     error = "CoreRead7zipFile Failed: no valid ROMs found in 7zip!";
     CoreSetError(error);
     return false;
 }
 
-CORE_EXPORT bool CoreReadArchiveFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer)
+static bool read_7zip_stream(CoreArchiveStream* stream, void* buffer, size_t size, size_t& bytesRead)
 {
-	std::string file_extension;
+    std::string error;
+    SRes res;
 
-	file_extension = file.has_extension() ? file.extension().string() : "";
-    file_extension = CoreLowerString(file_extension);
+    if (stream->BlockBuffer == nullptr)
+    {
+        res = SzArEx_Extract(&stream->Db, &stream->LookStream.vt, stream->FileIndex,
+                                &stream->BlockIndex, &stream->BlockBuffer, &stream->BlockBufferSize,
+                                &stream->FileOffset, &stream->FileSize,
+                                &stream->AllocImp, &stream->AllocTempImp);
+        if (res != SZ_OK)
+        {
+            error = "CoreRead7zipFile Failed: SzArEx_Extract Failed: ";
+            error += std::to_string(res);
+            CoreSetError(error);
+            return false;
+        }
+    }
+
+    bytesRead = std::min(size, stream->FileSize - stream->ReadOffset);
+    memcpy(buffer, stream->BlockBuffer + stream->FileOffset + stream->ReadOffset, bytesRead);
+    stream->ReadOffset += bytesRead;
+    return true;
+}
+
+static bool read_zip_stream(CoreArchiveStream* stream, void* buffer, size_t size, size_t& bytesRead)
+{
+    std::string error;
+    int ret;
+
+    bytesRead = 0;
 
-    if (file_extension != ".zip" && file_extension != ".7z")
+    // unzReadCurrentFile may return less than
+    // requested, so keep reading until we have it all
+    while (bytesRead < size)
     {
-        return false;
+        ret = unzReadCurrentFile(stream->ZipFile, (char*)buffer + bytesRead, (unsigned int)std::min(size - bytesRead, (size_t)INT_MAX));
+        if (ret < 0)
+        {
+            error = "CoreReadZipFile Failed: unzReadCurrentFile Failed: ";
+            error += std::to_string(ret);
+            CoreSetError(error);
+            return false;
+        }
+        else if (ret == 0)
+        {
+            break;
+        }
+
+        bytesRead += ret;
+    }
+
+    return true;
+}
+
+static std::filesystem::path get_extracted_disks_directory(void)
+{
+    std::filesystem::path directory;
+    directory = CoreGetUserCacheDirectory();
+    directory += CORE_DIR_SEPERATOR_STR;
+    directory += "extracted_disks";
+    return directory;
+}
+
+// removes the least recently used disks from
+// the extracted disks cache, keeps the newest
+static void prune_extracted_disks(std::filesystem::path directory)
+{
+    std::error_code errorCode;
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> disks;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, errorCode))
+    {
+        if (entry.is_regular_file(errorCode))
+        {
+            disks.push_back({ entry.last_write_time(errorCode), entry.path() });
+        }
+    }
+
+    if (disks.size() <= EXTRACTED_DISKS_MAX)
+    {
+        return;
+    }
+
+    std::sort(disks.begin(), disks.end(), [](const auto& a, const auto& b)
+    {
+        return a.first > b.first;
+    });
+
+    for (size_t i = EXTRACTED_DISKS_MAX; i < disks.size(); i++)
+    {
+        std::filesystem::path parent = disks[i].second.parent_path();
+        std::filesystem::remove(disks[i].second, errorCode);
+        // remove the directory of the disk,
+        // unless it's the cache directory itself
+        if (parent != directory)
+        {
+            std::filesystem::remove(parent, errorCode);
+        }
     }
+}
+
+//
+// Exported Functions
+//
+
+CORE_EXPORT bool CoreOpenArchiveStream(std::filesystem::path file, CoreArchiveStream*& stream, CoreArchiveFileInfo& info)
+{
+    std::string file_extension;
+
+    file_extension = file.has_extension() ? file.extension().string() : "";
+    file_extension = CoreLowerString(file_extension);
 
     if (file_extension == ".zip")
     {
-    	if (!CoreReadZipFile(file, extractedFileName, isDisk, outBuffer))
+        return open_zip_stream(file, stream, info);
+    }
+    else if (file_extension == ".7z")
+    {
+        return open_7zip_stream(file, stream, info);
+    }
+
+    return false;
+}
+
+CORE_EXPORT bool CoreReadArchiveStream(CoreArchiveStream* stream, void* buffer, size_t size, size_t& bytesRead)
+{
+    if (stream->IsZip)
+    {
+        return read_zip_stream(stream, buffer, size, bytesRead);
+    }
+    else
+    {
+        return read_7zip_stream(stream, buffer, size, bytesRead);
+    }
+}
+
+CORE_EXPORT bool CoreReadArchiveStream(CoreArchiveStream* stream, std::vector<char>& outBuffer)
+{
+    size_t offset;
+    size_t bytesRead;
+
+    do
+    {
+        offset = outBuffer.size();
+        outBuffer.resize(offset + ARCHIVE_READ_SIZE);
+
+        if (!CoreReadArchiveStream(stream, outBuffer.data() + offset, ARCHIVE_READ_SIZE, bytesRead))
         {
             return false;
         }
+
+        outBuffer.resize(offset + bytesRead);
+    } while (bytesRead == ARCHIVE_READ_SIZE);
+
+    return true;
+}
+
+CORE_EXPORT void CoreCloseArchiveStream(CoreArchiveStream* stream)
+{
+    if (stream->IsZip)
+    {
+        unzCloseCurrentFile(stream->ZipFile);
+        unzClose(stream->ZipFile);
+        delete stream;
     }
     else
     {
-        if (!CoreRead7zipFile(file, extractedFileName, isDisk, outBuffer))
+        close_7zip_stream(stream);
+    }
+}
+
+CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer)
+{
+    CoreArchiveStream*  stream;
+    CoreArchiveFileInfo info;
+    bool                ret;
+
+    if (!open_zip_stream(file, stream, info))
+    {
+        return false;
+    }
+
+    outBuffer.reserve(info.Size);
+    ret = CoreReadArchiveStream(stream, outBuffer);
+    CoreCloseArchiveStream(stream);
+
+    extractedFileName = info.FileName;
+    isDisk            = info.IsDisk;
+    return ret;
+}
+
+CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer)
+{
+    CoreArchiveStream*  stream;
+    CoreArchiveFileInfo info;
+    bool                ret;
+
+    if (!open_7zip_stream(file, stream, info))
+    {
+        return false;
+    }
+
+    outBuffer.reserve(info.Size);
+    ret = CoreReadArchiveStream(stream, outBuffer);
+    CoreCloseArchiveStream(stream);
+
+    extractedFileName = info.FileName;
+    isDisk            = info.IsDisk;
+    return ret;
+}
+
+CORE_EXPORT bool CoreReadArchiveFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer)
+{
+    CoreArchiveStream*  stream;
+    CoreArchiveFileInfo info;
+    bool                ret;
+
+    if (!CoreOpenArchiveStream(file, stream, info))
+    {
+        return false;
+    }
+
+    outBuffer.reserve(info.Size);
+    ret = CoreReadArchiveStream(stream, outBuffer);
+    CoreCloseArchiveStream(stream);
+
+    extractedFileName = info.FileName;
+    isDisk            = info.IsDisk;
+    return ret;
+}
+
+CORE_EXPORT bool CoreExtractArchiveDisk(std::filesystem::path file, std::filesystem::path& diskFile)
+{
+    std::string           error;
+    std::error_code       errorCode;
+    std::filesystem::path disksDirectory;
+    std::filesystem::path diskDirectory;
+    std::filesystem::path tempFile;
+    std::ofstream         outputStream;
+    std::vector<char>     buffer(ARCHIVE_READ_SIZE);
+    size_t                bytesRead = 0;
+    char                  key[32];
+
+    CoreArchiveStream*  stream;
+    CoreArchiveFileInfo info;
+
+    if (!CoreOpenArchiveStream(file, stream, info))
+    {
+        return false;
+    }
+
+    if (!info.IsDisk)
+    {
+        CoreCloseArchiveStream(stream);
+        error = "CoreExtractArchiveDisk Failed: ";
+        error += "archive doesn't contain a disk!";
+        CoreSetError(error);
+        return false;
+    }
+
+    // the disk keeps its file name, because
+    // the core names the disk save after it
+    snprintf(key, sizeof(key), "%08X_%llX", info.CRC32, (unsigned long long)info.Size);
+    disksDirectory = get_extracted_disks_directory();
+    diskDirectory  = disksDirectory;
+    diskDirectory += CORE_DIR_SEPERATOR_STR;
+    diskDirectory += key;
+    diskFile       = diskDirectory;
+    diskFile      += CORE_DIR_SEPERATOR_STR;
+    diskFile      += info.FileName.filename();
+
+    // re-use the disk when it has been extracted before,
+    // disks without a CRC32 are always extracted
+    if (info.CRC32 != 0 &&
+        std::filesystem::file_size(diskFile, errorCode) == info.Size && !errorCode)
+    {
+        CoreCloseArchiveStream(stream);
+        // mark the disk as recently used
+        std::filesystem::last_write_time(diskFile, std::filesystem::file_time_type::clock::now(), errorCode);
+        return true;
+    }
+
+    // attempt to create extraction directory
+    if (!std::filesystem::is_directory(diskDirectory, errorCode) &&
+        !std::filesystem::create_directories(diskDirectory, errorCode))
+    {
+        CoreCloseArchiveStream(stream);
+        error = "CoreExtractArchiveDisk Failed: ";
+        error += "Failed to create \"";
+        error += diskDirectory.string();
+        error += "\": ";
+        error += errorCode.message();
+        CoreSetError(error);
+        return false;
+    }
+
+    // decompress the disk into a temporary file,
+    // so an incomplete disk is never re-used
+    tempFile = diskFile;
+    tempFile += ".tmp";
+
+    outputStream.open(tempFile, std::ios::trunc | std::ios::binary);
+    if (!outputStream.is_open())
+    {
+        CoreCloseArchiveStream(stream);
+        error = "CoreExtractArchiveDisk Failed: ";
+        error += "failed to open file: ";
+        error += tempFile.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    do
+    {
+        if (!CoreReadArchiveStream(stream, buffer.data(), buffer.size(), bytesRead))
         {
+            outputStream.close();
+            CoreCloseArchiveStream(stream);
+            std::filesystem::remove(tempFile, errorCode);
             return false;
         }
+
+        outputStream.write(buffer.data(), bytesRead);
+    } while (bytesRead == buffer.size());
+
+    outputStream.close();
+    CoreCloseArchiveStream(stream);
+
+    if (outputStream.fail())
+    {
+        std::filesystem::remove(tempFile, errorCode);
+        error = "CoreExtractArchiveDisk Failed: ";
+        error += "failed to write file: ";
+        error += tempFile.string();
+        CoreSetError(error);
+        return false;
     }
 
+    std::filesystem::rename(tempFile, diskFile, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(tempFile, errorCode);
+        error = "CoreExtractArchiveDisk Failed: ";
+        error += "failed to rename file: ";
+        error += tempFile.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    prune_extracted_disks(disksDirectory);
     return true;
 }
 
@@ -447,14 +779,7 @@ CORE_EXPORT bool CoreUnzip(std::filesystem::path file, std::filesystem::path pat
     int bytes_read = 0;
 
     zlib_filefunc64_def filefuncs;
-    filefuncs.zopen64_file = zlib_filefunc_open;
-    filefuncs.zread_file   = zlib_filefunc_read;
-    filefuncs.zwrite_file  = nullptr;
-    filefuncs.ztell64_file = zlib_filefunc_tell;
-    filefuncs.zseek64_file = zlib_filefunc_seek;
-    filefuncs.zclose_file  = zlib_filefunc_close;
-    filefuncs.zerror_file  = zlib_filefunc_testerror;
-    filefuncs.opaque       = nullptr;
+    zlib_filefunc_fill(filefuncs);
 
     zipFile = unzOpen2_64((const void*)&file, &filefuncs);
     if (zipFile == nullptr)
@@ -11,8 +11,38 @@
 #define CORE_ARCHIVE_HPP
 
 #include <filesystem>
+#include <cstdint>
 #include <vector>
 
+struct CoreArchiveFileInfo
+{
+    // file name of the ROM/disk in the archive
+    std::filesystem::path FileName;
+    // whether it's a disk
+    bool IsDisk = false;
+    // size after decompression
+    uint64_t Size = 0;
+    // CRC32 stored in the archive, 0 when unknown
+    uint32_t CRC32 = 0;
+};
+
+// opaque stream of the ROM/disk in an archive file
+struct CoreArchiveStream;
+
+// attempts to open the ROM/disk in a supported archive file
+// as a stream, nothing is decompressed until it's read
+bool CoreOpenArchiveStream(std::filesystem::path file, CoreArchiveStream*& stream, CoreArchiveFileInfo& info);
+
+// attempts to decompress the next size bytes of the stream into buffer,
+// bytesRead is only less than size at the end of the ROM/disk
+bool CoreReadArchiveStream(CoreArchiveStream* stream, void* buffer, size_t size, size_t& bytesRead);
+
+// attempts to decompress the rest of the stream into outBuffer
+bool CoreReadArchiveStream(CoreArchiveStream* stream, std::vector<char>& outBuffer);
+
+// closes the stream
+void CoreCloseArchiveStream(CoreArchiveStream* stream);
+
 // attempts to read the ROM/disk in a zip file into outBuffer
 bool CoreReadZipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer);
 
@@ -22,6 +52,12 @@ bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::path& extract
 // attempts to read the ROM/disk in a supported archive file into outBuffer
 bool CoreReadArchiveFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer);
 
+// attempts to extract the disk in a supported archive file into the
+// extracted disks cache, which is addressed by the size and the CRC32
+// of the disk, so it's only extracted again when it has changed,
+// diskFile receives the path of the extracted disk
+bool CoreExtractArchiveDisk(std::filesystem::path file, std::filesystem::path& diskFile);
+
 // attempts to unzip the file to path
 bool CoreUnzip(std::filesystem::path file, std::filesystem::path path);
 
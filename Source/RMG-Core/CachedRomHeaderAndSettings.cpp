@@ -14,34 +14,46 @@
 #include "RomHeader.hpp"
 #include "Library.hpp"
 #include "File.hpp"
+#include "Rom.hpp"
 
-#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include <cstring>
 #include <fstream>
 #include <vector>
+#include <mutex>
+#include <list>
 
 //
 // Local Defines
 //
 
-#define MAX_FILENAME_LEN 4096
-#define ROMHEADER_NAME_LEN 256
-#define GOODNAME_LEN 256
-#define MD5_LEN 33
-#define GAMEID_LEN 5
-#define REGION_LEN 18
-
 #ifdef _WIN32
-#define CACHE_FILE_MAGIC "RMGCoreHeaderAndSettingsCacheWindows_08"
+#define CACHE_FILE_MAGIC "RMGCoreHeaderAndSettingsCacheWindows_09"
 #else // Linux
-#define CACHE_FILE_MAGIC "RMGCoreHeaderAndSettingsCacheLinux_08"
+#define CACHE_FILE_MAGIC "RMGCoreHeaderAndSettingsCacheLinux_09"
 #endif // _WIN32
-#define CACHE_FILE_ITEMS_MAX 10000
+#define CACHE_FILE_ITEMS_MAX 100000
+// amount of outdated records in the cache file
+// after which the cache file is rewritten
+#define CACHE_FILE_OUTDATED_RECORDS_MAX 1000
 
 //
 // Local Structures
 //
 
+// the cache file consists of the magic followed by records,
+// each record starts with its size and the record type,
+// changed entries are appended to the cache file and a
+// newer record for the same file replaces an older one
+enum class l_CacheRecordType : uint8_t
+{
+    Entry   = 0,
+    Removed = 1
+};
+
+typedef std::filesystem::path::string_type l_CacheKey;
+
 struct l_CacheEntry
 {
     std::filesystem::path fileName;
@@ -51,17 +63,35 @@ struct l_CacheEntry
     CoreRomHeader   header;
     CoreRomSettings settings;
     CoreRomSettings defaultSettings;
+
+    // position in l_CacheOrder
+    std::list<l_CacheKey>::iterator orderIter;
 };
 
 //
 // Local Variables
 //
 
-static bool                      l_CacheEntriesChanged = false;
-static std::vector<l_CacheEntry> l_CacheEntries;
+static std::mutex                                   l_CacheMutex;
+static std::unordered_map<l_CacheKey, l_CacheEntry> l_CacheEntries;
+// keys of the cached entries, oldest first
+static std::list<l_CacheKey>                        l_CacheOrder;
+// keys of the entries which have been added, changed
+// or removed since the cache file was last read or saved
+static std::unordered_set<l_CacheKey>               l_CacheChangedEntries;
+// amount of records in the cache file
+static size_t                                       l_CacheFileRecords = 0;
+// whether the cache file has to be rewritten
+// instead of appending the changed entries
+static bool                                         l_CacheFileRewrite = true;
+
+// serializes retrieving the rom header & settings
+// by opening the rom and reading the settings overlay,
+// because neither can be done from several threads
+static std::mutex l_OpenRomMutex;
 
 //
-// Internal Functions
+// Local Functions
 //
 
 static std::filesystem::path get_cache_file_name()
@@ -75,17 +105,172 @@ static std::filesystem::path get_cache_file_name()
     return file;
 }
 
-static std::vector<l_CacheEntry>::iterator get_cache_entry_iter(std::filesystem::path file, bool checkFileTime = true)
+template<typename T>
+static void write_value(std::vector<char>& buffer, const T& value)
 {
-    CoreFileTime fileTime = CoreGetFileTime(file);
+    const char* data = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), data, data + sizeof(T));
+}
+
+template<typename T>
+static void write_string(std::vector<char>& buffer, const std::basic_string<T>& string)
+{
+    const char* data = reinterpret_cast<const char*>(string.data());
+    write_value(buffer, (uint32_t)string.size());
+    buffer.insert(buffer.end(), data, data + (string.size() * sizeof(T)));
+}
 
-    auto predicate = [file, fileTime, checkFileTime](const auto& entry)
+template<typename T>
+static bool read_value(const char*& data, const char* end, T& value)
+{
+    if ((size_t)(end - data) < sizeof(T))
     {
-        return entry.fileName == file &&
-                (!checkFileTime || entry.fileTime == fileTime);
-    };
+        return false;
+    }
 
-    return std::find_if(l_CacheEntries.begin(), l_CacheEntries.end(), predicate);
+    memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return true;
+}
+
+template<typename T>
+static bool read_string(const char*& data, const char* end, std::basic_string<T>& string)
+{
+    uint32_t size;
+
+    if (!read_value(data, end, size) ||
+        (size_t)(end - data) / sizeof(T) < size)
+    {
+        return false;
+    }
+
+    string.resize(size);
+    memcpy(string.data(), data, size * sizeof(T));
+    data += size * sizeof(T);
+    return true;
+}
+
+static void write_settings(std::vector<char>& buffer, const CoreRomSettings& settings)
+{
+    write_value(buffer, settings.SaveType);
+    write_value(buffer, settings.DisableExtraMem);
+    write_value(buffer, settings.TransferPak);
+    write_value(buffer, settings.CountPerOp);
+    write_value(buffer, settings.SiDMADuration);
+}
+
+static bool read_settings(const char*& data, const char* end, CoreRomSettings& settings)
+{
+    return read_value(data, end, settings.SaveType) &&
+            read_value(data, end, settings.DisableExtraMem) &&
+            read_value(data, end, settings.TransferPak) &&
+            read_value(data, end, settings.CountPerOp) &&
+            read_value(data, end, settings.SiDMADuration);
+}
+
+static void write_record(std::vector<char>& buffer, const l_CacheKey& key, const l_CacheEntry* entry)
+{
+    size_t sizeOffset = buffer.size();
+
+    // the size is filled in afterwards
+    write_value(buffer, (uint32_t)0);
+
+    write_value(buffer, entry != nullptr ? l_CacheRecordType::Entry : l_CacheRecordType::Removed);
+    write_string(buffer, key);
+    if (entry != nullptr)
+    {
+        // file info
+        write_value(buffer, entry->fileTime);
+        // type
+        write_value(buffer, entry->type);
+        // header
+        write_string(buffer, entry->header.Name);
+        write_string(buffer, entry->header.GameID);
+        write_string(buffer, entry->header.Region);
+        write_value(buffer, entry->header.CRC1);
+        write_value(buffer, entry->header.CRC2);
+        write_value(buffer, entry->header.CountryCode);
+        write_value(buffer, entry->header.SystemType);
+        // shared settings
+        write_string(buffer, entry->settings.GoodName);
+        write_string(buffer, entry->settings.MD5);
+        // default settings
+        write_settings(buffer, entry->defaultSettings);
+        // current settings
+        write_settings(buffer, entry->settings);
+    }
+
+    uint32_t size = (uint32_t)(buffer.size() - sizeOffset - sizeof(uint32_t));
+    memcpy(buffer.data() + sizeOffset, &size, sizeof(size));
+}
+
+static bool read_record(const char* data, const char* end, l_CacheRecordType& recordType, l_CacheKey& key, l_CacheEntry& entry)
+{
+    if (!read_value(data, end, recordType) ||
+        !read_string(data, end, key))
+    {
+        return false;
+    }
+
+    if (recordType == l_CacheRecordType::Removed)
+    {
+        return true;
+    }
+
+    if (recordType != l_CacheRecordType::Entry)
+    {
+        return false;
+    }
+
+    entry.fileName = std::filesystem::path(key);
+
+    if (!read_value(data, end, entry.fileTime) ||
+        !read_value(data, end, entry.type) ||
+        !read_string(data, end, entry.header.Name) ||
+        !read_string(data, end, entry.header.GameID) ||
+        !read_string(data, end, entry.header.Region) ||
+        !read_value(data, end, entry.header.CRC1) ||
+        !read_value(data, end, entry.header.CRC2) ||
+        !read_value(data, end, entry.header.CountryCode) ||
+        !read_value(data, end, entry.header.SystemType) ||
+        !read_string(data, end, entry.settings.GoodName) ||
+        !read_string(data, end, entry.settings.MD5) ||
+        !read_settings(data, end, entry.defaultSettings) ||
+        !read_settings(data, end, entry.settings))
+    {
+        return false;
+    }
+
+    entry.defaultSettings.GoodName = entry.settings.GoodName;
+    entry.defaultSettings.MD5      = entry.settings.MD5;
+    return true;
+}
+
+// adds entry to the cache or replaces the entry
+// of the same file, l_CacheMutex must be locked
+static void set_cache_entry(const l_CacheKey& key, l_CacheEntry entry)
+{
+    auto iter = l_CacheEntries.find(key);
+    if (iter != l_CacheEntries.end())
+    {
+        l_CacheOrder.erase((*iter).second.orderIter);
+        l_CacheEntries.erase(iter);
+    }
+
+    entry.orderIter = l_CacheOrder.insert(l_CacheOrder.end(), key);
+    l_CacheEntries.emplace(key, std::move(entry));
+}
+
+// removes the entry of the given file from
+// the cache, l_CacheMutex must be locked
+static void remove_cache_entry(const l_CacheKey& key)
+{
+    auto iter = l_CacheEntries.find(key);
+    if (iter != l_CacheEntries.end())
+    {
+        l_CacheOrder.erase((*iter).second.orderIter);
+        l_CacheEntries.erase(iter);
+    }
 }
 
 //
@@ -95,200 +280,166 @@ static std::vector<l_CacheEntry>::iterator get_cache_entry_iter(std::filesystem:
 CORE_EXPORT void CoreReadRomHeaderAndSettingsCache(void)
 {
     std::ifstream inputStream;
-    char magicBuf[sizeof(CACHE_FILE_MAGIC)];
-    wchar_t fileNameBuf[MAX_FILENAME_LEN];
-    char headerNameBuf[ROMHEADER_NAME_LEN];
-    char gameIDBuf[GAMEID_LEN];
-    char regionBuf[REGION_LEN];
-    char goodNameBuf[GOODNAME_LEN];
-    char md5Buf[MD5_LEN];
-    uint32_t size;
+    std::vector<char> buffer;
+    std::streamoff size;
+    l_CacheRecordType recordType;
+    l_CacheKey key;
     l_CacheEntry cacheEntry;
+    uint32_t recordSize;
 
-    inputStream.open(get_cache_file_name(), std::ios::binary);
+    std::lock_guard<std::mutex> guard(l_CacheMutex);
+
+    l_CacheEntries.clear();
+    l_CacheOrder.clear();
+    l_CacheChangedEntries.clear();
+    l_CacheFileRecords = 0;
+    l_CacheFileRewrite = true;
+
+    inputStream.open(get_cache_file_name(), std::ios::binary | std::ios::ate);
     if (!inputStream.good())
     {
         return;
     }
 
+    // read the whole file at once
+    size = inputStream.tellg();
+    if (size < (std::streamoff)sizeof(CACHE_FILE_MAGIC))
+    {
+        return;
+    }
+    buffer.resize((size_t)size);
+    inputStream.seekg(0, std::ios::beg);
+    inputStream.read(buffer.data(), buffer.size());
+    inputStream.close();
+
     // when magic doesn't match, don't read cache file
-    inputStream.read((char*)magicBuf, sizeof(CACHE_FILE_MAGIC));
-    if (std::string(magicBuf) != std::string(CACHE_FILE_MAGIC))
+    if (memcmp(buffer.data(), CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC)) != 0)
     {
-        inputStream.close();
         return;
     }
 
-    // read all file entries
-#define FREAD(x) inputStream.read((char*)&x, sizeof(x))
-#define FREAD_STR(x, y) inputStream.read((char*)x, y)
-    while (!inputStream.eof())
+    const char* data = buffer.data() + sizeof(CACHE_FILE_MAGIC);
+    const char* end  = buffer.data() + buffer.size();
+
+    // read all records, newer records replace older ones
+    while (data != end)
     {
-        // reset buffers
-        size = 0;
-        memset(fileNameBuf, 0, sizeof(fileNameBuf));
-        memset(headerNameBuf, 0, sizeof(headerNameBuf));
-        memset(gameIDBuf, 0, sizeof(gameIDBuf));
-        memset(regionBuf, 0, sizeof(regionBuf));
-        memset(goodNameBuf, 0, sizeof(goodNameBuf));
-        memset(md5Buf, 0, sizeof(md5Buf));
+        if (!read_value(data, end, recordSize) ||
+            (size_t)(end - data) < recordSize ||
+            !read_record(data, data + recordSize, recordType, key, cacheEntry))
+        {
+            // the cache file is truncated or corrupt,
+            // keep what we've read so far and rewrite it
+            // the next time it's saved
+            return;
+        }
 
-        // file info
-        FREAD(size);
-        FREAD_STR(fileNameBuf, size);
-        cacheEntry.fileName = std::filesystem::path(fileNameBuf);
-        FREAD(cacheEntry.fileTime);
-        // type
-        FREAD(cacheEntry.type);
-        // header
-        FREAD(size);
-        FREAD_STR(headerNameBuf, size);
-        FREAD(size);
-        FREAD_STR(gameIDBuf, size);
-        FREAD(size);
-        FREAD_STR(regionBuf, size);
-        cacheEntry.header.Name = std::string(headerNameBuf);
-        cacheEntry.header.GameID = std::string(gameIDBuf);
-        cacheEntry.header.Region = std::string(regionBuf);
-        FREAD(cacheEntry.header.CRC1);
-        FREAD(cacheEntry.header.CRC2);
-        FREAD(cacheEntry.header.CountryCode);
-        FREAD(cacheEntry.header.SystemType);
-        // shared settings
-        FREAD(size);
-        FREAD_STR(goodNameBuf, size);
-        FREAD(size);
-        FREAD_STR(md5Buf, size);
-        cacheEntry.defaultSettings.GoodName = std::string(goodNameBuf);
-        cacheEntry.defaultSettings.MD5 = std::string(md5Buf);
-        cacheEntry.settings.GoodName = std::string(goodNameBuf);
-        cacheEntry.settings.MD5 = std::string(md5Buf);
-        // default settings
-        FREAD(cacheEntry.defaultSettings.SaveType);
-        FREAD(cacheEntry.defaultSettings.DisableExtraMem);
-        FREAD(cacheEntry.defaultSettings.TransferPak);
-        FREAD(cacheEntry.defaultSettings.CountPerOp);
-        FREAD(cacheEntry.defaultSettings.SiDMADuration);
-        // current settings
-        FREAD(cacheEntry.settings.SaveType);
-        FREAD(cacheEntry.settings.DisableExtraMem);
-        FREAD(cacheEntry.settings.TransferPak);
-        FREAD(cacheEntry.settings.CountPerOp);
-        FREAD(cacheEntry.settings.SiDMADuration);
+        if (recordType == l_CacheRecordType::Entry)
+        {
+            set_cache_entry(key, cacheEntry);
+        }
+        else
+        {
+            remove_cache_entry(key);
+        }
 
-        // add to cached entries
-        l_CacheEntries.push_back(cacheEntry);
+        data += recordSize;
+        l_CacheFileRecords++;
     }
-#undef FREAD
-#undef FREAD_STR
 
-    inputStream.close();
+    l_CacheFileRewrite = false;
 }
 
 CORE_EXPORT bool CoreSaveRomHeaderAndSettingsCache(void)
 {
     std::ofstream outputStream;
-    wchar_t fileNameBuf[MAX_FILENAME_LEN];
-    char headerNameBuf[ROMHEADER_NAME_LEN];
-    char gameIDBuf[GAMEID_LEN];
-    char regionBuf[REGION_LEN];
-    char goodNameBuf[GOODNAME_LEN];
-    char md5Buf[MD5_LEN];
-    uint32_t size;
-    l_CacheEntry cacheEntry;
+    std::vector<char> buffer;
+    std::ios::openmode openMode = std::ios::binary;
+
+    std::lock_guard<std::mutex> guard(l_CacheMutex);
 
     // only save cache when the entries have changed
-    if (!l_CacheEntriesChanged)
+    if (!l_CacheFileRewrite && l_CacheChangedEntries.empty())
     {
         return true;
     }
 
-    outputStream.open(get_cache_file_name(), std::ios::binary);
-    if (!outputStream.good())
+    // rewrite the cache file when it contains
+    // too many outdated records
+    if (l_CacheFileRecords + l_CacheChangedEntries.size() >
+        l_CacheEntries.size() + CACHE_FILE_OUTDATED_RECORDS_MAX)
     {
-        return false;
+        l_CacheFileRewrite = true;
     }
 
-    // write magic header
-    outputStream.write((char*)CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
-
-    // write each entry in the file
-#define FWRITE(x) outputStream.write((char*)&x, sizeof(x))
-#define FWRITE_STR(x, y) outputStream.write((char*)x, y)
-    for (auto iter = l_CacheEntries.cbegin(); iter != l_CacheEntries.end(); iter++)
+    if (l_CacheFileRewrite)
     {
-        cacheEntry = (*iter);
-
-        // reset buffers
-        size = 0;
-        memset(fileNameBuf, 0, sizeof(fileNameBuf));
-        memset(headerNameBuf, 0, sizeof(headerNameBuf));
-        memset(gameIDBuf, 0, sizeof(gameIDBuf));
-        memset(regionBuf, 0, sizeof(regionBuf));
-        memset(goodNameBuf, 0, sizeof(goodNameBuf));
-        memset(md5Buf, 0, sizeof(md5Buf));
-
-        // copy strings into buffers
-        wcsncpy(fileNameBuf, cacheEntry.fileName.wstring().c_str(), MAX_FILENAME_LEN);
-        strncpy(headerNameBuf, cacheEntry.header.Name.c_str(), sizeof(headerNameBuf));
-        strncpy(gameIDBuf, cacheEntry.header.GameID.c_str(), sizeof(gameIDBuf));
-        strncpy(regionBuf, cacheEntry.header.Region.c_str(), sizeof(regionBuf));
-        strncpy(goodNameBuf, cacheEntry.settings.GoodName.c_str(), sizeof(goodNameBuf));
-        strncpy(md5Buf, cacheEntry.settings.MD5.c_str(), sizeof(md5Buf));
+        // write magic header and every entry, oldest first
+        buffer.insert(buffer.end(), CACHE_FILE_MAGIC, CACHE_FILE_MAGIC + sizeof(CACHE_FILE_MAGIC));
+        for (const l_CacheKey& key : l_CacheOrder)
+        {
+            write_record(buffer, key, &l_CacheEntries[key]);
+        }
+        openMode |= std::ios::trunc;
+    }
+    else
+    {
+        // only append the changed entries
+        for (const l_CacheKey& key : l_CacheChangedEntries)
+        {
+            auto iter = l_CacheEntries.find(key);
+            write_record(buffer, key, iter != l_CacheEntries.end() ? &(*iter).second : nullptr);
+        }
+        openMode |= std::ios::app;
+    }
 
-        // file info
-        size = cacheEntry.fileName.wstring().size() * sizeof(wchar_t);
-        FWRITE(size);
-        FWRITE_STR(fileNameBuf, size);
-        FWRITE(cacheEntry.fileTime);
-        // type
-        FWRITE(cacheEntry.type);
-        // header
-        size = cacheEntry.header.Name.size();
-        FWRITE(size);
-        FWRITE_STR(headerNameBuf, size);
-        size = cacheEntry.header.GameID.size();
-        FWRITE(size);
-        FWRITE_STR(gameIDBuf, size);
-        size = cacheEntry.header.Region.size();
-        FWRITE(size);
-        FWRITE_STR(regionBuf, size);
-        FWRITE(cacheEntry.header.CRC1);
-        FWRITE(cacheEntry.header.CRC2);
-        FWRITE(cacheEntry.header.CountryCode);
-        FWRITE(cacheEntry.header.SystemType);
-        // shared settings
-        size = cacheEntry.settings.GoodName.size();
-        FWRITE(size);
-        FWRITE_STR(goodNameBuf, size);
-        size = cacheEntry.settings.MD5.size();
-        FWRITE(size);
-        FWRITE_STR(md5Buf, size);
-        // default settings
-        FWRITE(cacheEntry.defaultSettings.SaveType);
-        FWRITE(cacheEntry.defaultSettings.DisableExtraMem);
-        FWRITE(cacheEntry.defaultSettings.TransferPak);
-        FWRITE(cacheEntry.defaultSettings.CountPerOp);
-        FWRITE(cacheEntry.defaultSettings.SiDMADuration);
-        // current settings
-        FWRITE(cacheEntry.settings.SaveType);
-        FWRITE(cacheEntry.settings.DisableExtraMem);
-        FWRITE(cacheEntry.settings.TransferPak);
-        FWRITE(cacheEntry.settings.CountPerOp);
-        FWRITE(cacheEntry.settings.SiDMADuration);
+    outputStream.open(get_cache_file_name(), openMode);
+    if (!outputStream.good())
+    {
+        return false;
     }
-#undef FWRITE
-#undef FWRITE_STR
 
+    outputStream.write(buffer.data(), buffer.size());
     outputStream.close();
+    if (outputStream.fail())
+    {
+        // we don't know what has been written,
+        // so rewrite it the next time
+        l_CacheFileRewrite = true;
+        return false;
+    }
+
+    if (l_CacheFileRewrite)
+    {
+        l_CacheFileRecords = l_CacheEntries.size();
+        l_CacheFileRewrite = false;
+    }
+    else
+    {
+        l_CacheFileRecords += l_CacheChangedEntries.size();
+    }
+    l_CacheChangedEntries.clear();
     return true;
 }
 
 CORE_EXPORT bool CoreGetCachedRomHeaderAndSettings(std::filesystem::path file, CoreRomType* type, CoreRomHeader* header, CoreRomSettings* defaultSettings, CoreRomSettings* settings)
 {
     bool ret = false;
-    auto iter = get_cache_entry_iter(file);
-    if (iter == l_CacheEntries.end())
+    bool found = false;
+    l_CacheEntry cacheEntry;
+    CoreFileTime fileTime = CoreGetFileTime(file);
+
+    {
+        std::lock_guard<std::mutex> guard(l_CacheMutex);
+        auto iter = l_CacheEntries.find(file.native());
+        found = (iter != l_CacheEntries.end() && (*iter).second.fileTime == fileTime);
+        if (found)
+        {
+            cacheEntry = (*iter).second;
+        }
+    }
+
+    if (!found)
     {
         CoreRomType romType;
         CoreRomHeader romHeader;
@@ -298,16 +449,30 @@ CORE_EXPORT bool CoreGetCachedRomHeaderAndSettings(std::filesystem::path file, C
         // when we haven't found a cached entry,
         // we're gonna attempt to retrieve the
         // rom header and settings and add it
-        // to the cache
-        ret = CoreOpenRom(file) &&
-                CoreGetRomType(romType) &&
-                CoreGetCurrentRomHeader(romHeader) &&
-                CoreGetCurrentRomSettings(romSettings) &&
-                CoreGetCurrentDefaultRomSettings(romDefaultSettings);
-        // always close ROM
-        if (CoreHasRomOpen() && !CoreCloseRom())
+        // to the cache, probing the rom doesn't
+        // touch the opened rom so it can be done
+        // from several threads at once
+        ret = CoreProbeRom(file, romType, romHeader, romDefaultSettings);
+        if (ret)
+        {
+            std::lock_guard<std::mutex> guard(l_OpenRomMutex);
+            romSettings = romDefaultSettings;
+            CoreGetRomSettingsOverlay(romSettings);
+        }
+        else
         {
-            ret = false;
+            // disks have to be opened
+            std::lock_guard<std::mutex> guard(l_OpenRomMutex);
+            ret = CoreOpenRom(file) &&
+                    CoreGetRomType(romType) &&
+                    CoreGetCurrentRomHeader(romHeader) &&
+                    CoreGetCurrentRomSettings(romSettings) &&
+                    CoreGetCurrentDefaultRomSettings(romDefaultSettings);
+            // always close ROM
+            if (CoreHasRomOpen() && !CoreCloseRom())
+            {
+                ret = false;
+            }
         }
         // attempt to add it to the cache, when we've retrieved 
         // the info successfully
@@ -340,19 +505,19 @@ CORE_EXPORT bool CoreGetCachedRomHeaderAndSettings(std::filesystem::path file, C
 
     if (type != nullptr)
     {
-        *type = (*iter).type;
+        *type = cacheEntry.type;
     }
     if (header != nullptr)
     {
-        *header = (*iter).header;
+        *header = cacheEntry.header;
     }
     if (settings != nullptr)
     {
-        *settings = (*iter).settings;
+        *settings = cacheEntry.settings;
     }
     if (defaultSettings != nullptr)
     {
-        *defaultSettings = (*iter).defaultSettings;
+        *defaultSettings = cacheEntry.defaultSettings;
     }
     return true;
 }
@@ -360,44 +525,47 @@ CORE_EXPORT bool CoreGetCachedRomHeaderAndSettings(std::filesystem::path file, C
 CORE_EXPORT bool CoreAddCachedRomHeaderAndSettings(std::filesystem::path file, CoreRomType type, CoreRomHeader header, CoreRomSettings defaultSettings, CoreRomSettings settings)
 {
     l_CacheEntry cacheEntry;
+    CoreFileTime fileTime = CoreGetFileTime(file);
+    l_CacheKey   key      = file.native();
 
-    // try to find existing entry with same filename,
-    // when found, remove it from the cache
-    auto iter = get_cache_entry_iter(file, false);
-    if (iter != l_CacheEntries.end())
+    std::lock_guard<std::mutex> guard(l_CacheMutex);
+
+    // delete oldest item when we're over the item limit,
+    // an existing entry with the same filename is replaced
+    if (l_CacheEntries.find(key) == l_CacheEntries.end() &&
+        l_CacheEntries.size() >= CACHE_FILE_ITEMS_MAX)
     {
-        l_CacheEntries.erase(iter);
-    }
-    else if (l_CacheEntries.size() >= CACHE_FILE_ITEMS_MAX)
-    { // delete first item when we're over the item limit
-        l_CacheEntries.erase(l_CacheEntries.begin());
+        l_CacheChangedEntries.insert(l_CacheOrder.front());
+        remove_cache_entry(l_CacheOrder.front());
     }
 
     cacheEntry.fileName = file;
-    cacheEntry.fileTime = CoreGetFileTime(file);
+    cacheEntry.fileTime = fileTime;
     cacheEntry.type     = type;
     cacheEntry.header   = header;
     cacheEntry.settings = settings;
     cacheEntry.defaultSettings = defaultSettings;
 
-    l_CacheEntries.push_back(cacheEntry);
-    l_CacheEntriesChanged = true;
+    set_cache_entry(key, cacheEntry);
+    l_CacheChangedEntries.insert(key);
     return true;
 }
 
 CORE_EXPORT bool CoreUpdateCachedRomHeaderAndSettings(std::filesystem::path file, CoreRomType type, CoreRomHeader header, CoreRomSettings defaultSettings, CoreRomSettings settings)
 {
-    l_CacheEntry cachedEntry;
+    l_CacheKey key = file.native();
+
+    std::lock_guard<std::mutex> guard(l_CacheMutex);
 
     // try to find existing entry with same filename,
     // when not found, do nothing
-    auto iter = get_cache_entry_iter(file, false);
+    auto iter = l_CacheEntries.find(key);
     if (iter == l_CacheEntries.end())
     {
         return true;
     }
 
-    cachedEntry = (*iter);
+    l_CacheEntry& cachedEntry = (*iter).second;
 
     // check if the cached entry needs to be updated,
     // if it does, then update the entry
@@ -406,11 +574,11 @@ CORE_EXPORT bool CoreUpdateCachedRomHeaderAndSettings(std::filesystem::path file
         cachedEntry.defaultSettings != defaultSettings ||
         cachedEntry.settings != settings)
     {
-        (*iter).type            = type;
-        (*iter).header          = header;
-        (*iter).defaultSettings = defaultSettings;
-        (*iter).settings        = settings;
-        l_CacheEntriesChanged   = true;
+        cachedEntry.type            = type;
+        cachedEntry.header          = header;
+        cachedEntry.defaultSettings = defaultSettings;
+        cachedEntry.settings        = settings;
+        l_CacheChangedEntries.insert(key);
     }
 
     return true;
@@ -425,10 +593,12 @@ CORE_EXPORT bool CoreUpdateCachedRomHeaderAndSettings(std::filesystem::path file
 
     // try to find existing entry with same filename,
     // when not found, do nothing
-    auto iter = get_cache_entry_iter(file, false);
-    if (iter == l_CacheEntries.end())
     {
-        return true;
+        std::lock_guard<std::mutex> guard(l_CacheMutex);
+        if (l_CacheEntries.find(file.native()) == l_CacheEntries.end())
+        {
+            return true;
+        }
     }
 
     // attempt to retrieve required information
@@ -445,7 +615,10 @@ CORE_EXPORT bool CoreUpdateCachedRomHeaderAndSettings(std::filesystem::path file
 
 CORE_EXPORT bool CoreClearRomHeaderAndSettingsCache(void)
 {
+    std::lock_guard<std::mutex> guard(l_CacheMutex);
     l_CacheEntries.clear();
-    l_CacheEntriesChanged = true;
+    l_CacheOrder.clear();
+    l_CacheChangedEntries.clear();
+    l_CacheFileRewrite = true;
     return true;
 }
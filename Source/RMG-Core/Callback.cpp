@@ -9,6 +9,7 @@
  */
 #define CORE_INTERNAL
 #include "ConvertStringEncoding.hpp"
+#include "SaveState.hpp"
 #include "Callback.hpp"
 #include "Library.hpp"
 
@@ -71,6 +72,12 @@ void CoreDebugCallback(void* context, int level, const char* message)
 
 void CoreStateCallback(void* context, m64p_core_param param, int value)
 {
+    // the rewind history can't be replayed past a loaded state
+    if (param == M64CORE_STATE_LOADCOMPLETE && value)
+    {
+        CoreResetRewind();
+    }
+
     if (!l_SetupCallbacks)
     {
         return;
@@ -565,6 +565,21 @@ static bool get_romheader_and_romsettings(const std::filesystem::path& file, Cor
     return true;
 }
 
+//
+// Internal Functions
+//
+
+void CoreGetCheatFilePaths(CoreRomHeader romHeader, CoreRomSettings romSettings, std::filesystem::path& sharedFile, std::filesystem::path& userFile)
+{
+    sharedFile = get_shared_cheat_file_path(romHeader, romSettings);
+
+    userFile = CoreGetUserConfigDirectory();
+    userFile += CORE_DIR_SEPERATOR_STR;
+    userFile += "Cheats-User";
+    userFile += CORE_DIR_SEPERATOR_STR;
+    userFile += get_cheat_file_name(romHeader, romSettings);
+}
+
 //
 // Exported Functions
 //
@@ -10,11 +10,24 @@
 #ifndef CORE_CHEATS_HPP
 #define CORE_CHEATS_HPP
 
+#include "RomHeader.hpp"
+#include "RomSettings.hpp"
+
 #include <string>
 #include <vector>
 #include <cstdint>
 #include <filesystem>
 
+// cheat file paths used by Prefetch.cpp
+#ifdef CORE_INTERNAL
+
+// retrieves the paths of the shared and the user
+// cheat file of the given ROM, without creating
+// the user cheats directory
+void CoreGetCheatFilePaths(CoreRomHeader romHeader, CoreRomSettings romSettings, std::filesystem::path& sharedFile, std::filesystem::path& userFile);
+
+#endif // CORE_INTERNAL
+
 struct CoreCheatCode
 {
     // Cheat Code Address
@@ -18,6 +18,7 @@
 #include "Settings.hpp"
 #include "Library.hpp"
 #include "Plugins.hpp"
+#include "Prefetch.hpp"
 #include "Error.hpp"
 #include "Core.hpp"
 
@@ -182,6 +183,8 @@ CORE_EXPORT bool CoreInit(void)
 
 CORE_EXPORT void CoreShutdown(void)
 {
+    CoreStopPrefetch();
+
     CorePluginsShutdown();
 
     CoreSaveRomHeaderAndSettingsCache();
@@ -8,13 +8,17 @@
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #define CORE_INTERNAL
+#include "SpeedLimiter.hpp"
 #include "MediaLoader.hpp"
 #include "RomSettings.hpp"
 #include "Emulation.hpp"
+#include "SaveState.hpp"
 #include "RomHeader.hpp"
 #include "Settings.hpp"
 #include "Library.hpp"
 #include "Netplay.hpp"
+#include "Callback.hpp"
+#include "Movie.hpp"
 #include "Plugins.hpp"
 #include "Cheats.hpp"
 #include "Error.hpp"
@@ -27,24 +31,15 @@
 
 #include "m64p/Api.hpp"
 
+#include <cstring>
+#include <chrono>
+
 // Constants for rollback netplay
 #define CONTROLLER_COUNT 4      // Max number of controllers 
 #define ROLLBACK_INPUT_BYTES 32  // Size of input data per player
 #define ROLLBACK_VERBOSE false  // Set to true for verbose rollback logging
 #define l_RollbackMaxPlayers 4  // Maximum number of supported players
 
-// Frame callback function type definition
-typedef void (*frame_callback_fn)(unsigned int);
-
-// Frame callback data structure for rollback netplay
-struct m64p_frame_callback_data {
-    uint32_t frame_count;      // Current frame number
-    uint32_t input_sequence;   // Input sequence number
-    uint8_t* input_data;       // Pointer to input data
-    bool is_rollback;          // Whether this frame is a rollback frame
-    frame_callback_fn callback; // Function pointer for frame callback
-};
-
 //
 // Local Functions
 //
@@ -163,8 +158,63 @@ static void apply_pif_rom_settings(void)
     }
 }
 
-// Add a new function to handle frame callbacks for rollback netplay
-static m64p_frame_callback_data* frameCallbackData = nullptr;
+// Launch timing, the time spent in each stage of
+// starting a ROM is reported at the first frame
+static std::chrono::steady_clock::time_point l_LaunchStartTime;
+static std::chrono::steady_clock::time_point l_LaunchStageTime;
+static std::string l_LaunchStages;
+static bool        l_LaunchTimingActive = false;
+
+static void launch_timing_start(void)
+{
+    l_LaunchStartTime    = std::chrono::steady_clock::now();
+    l_LaunchStageTime    = l_LaunchStartTime;
+    l_LaunchStages.clear();
+    l_LaunchTimingActive = true;
+}
+
+static void launch_timing_stage(std::string name)
+{
+    if (!l_LaunchTimingActive)
+    {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+
+    if (!l_LaunchStages.empty())
+    {
+        l_LaunchStages += ", ";
+    }
+    l_LaunchStages += name;
+    l_LaunchStages += " ";
+    l_LaunchStages += std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(time - l_LaunchStageTime).count());
+    l_LaunchStages += " ms";
+
+    l_LaunchStageTime = time;
+}
+
+static void launch_timing_finish(void)
+{
+    if (!l_LaunchTimingActive)
+    {
+        return;
+    }
+
+    launch_timing_stage("first frame");
+
+    std::chrono::milliseconds total = std::chrono::duration_cast<std::chrono::milliseconds>(l_LaunchStageTime - l_LaunchStartTime);
+    CoreAddCallbackMessage(CoreDebugMessageType::Info,
+        "Launch: " + l_LaunchStages + " (total " + std::to_string(total.count()) + " ms)");
+
+    l_LaunchTimingActive = false;
+}
+
+// Resimulation state, the speed limiter and the
+// audio and video output are turned off while
+// frames are resimulated
+static bool l_RollbackResimulating = false;
+static bool l_RollbackSpeedLimiter = true;
 
 // Variables to track inputs
 uint32_t g_currentInputSequence = 0;
@@ -320,29 +370,66 @@ void ApplyControllerInputs(uint8_t* inputData, int playerIndex) {
     memcpy(&g_lastInputs[playerIndex * ROLLBACK_INPUT_BYTES], &input, sizeof(ControllerInput));
 }
 
+static void EmulationInputPollCallback(int Control, unsigned int* Keys)
+{
+    if (CoreIsMovieActive())
+    {
+        CoreMovieInputPollCallback(Control, Keys);
+    }
+    else
+    {
+        CoreRewindInputPollCallback(Control, Keys);
+    }
+}
+
 static void EmulationFrameCallback(unsigned int FrameIndex)
 {
     // This will be called at the end of each video frame
-    
+    launch_timing_finish();
+
     // Handle rollback netplay if active
     if (CoreHasInitRollbackNetplay())
     {
-        // Get inputs from local controller
-        uint8_t inputData[ROLLBACK_INPUT_BYTES * 4]; // Buffer for all players
-        GetControllerInputs(inputData);
-        
-        // Increment input sequence for tracking
-        g_currentInputSequence++;
-        
-        // Process frame using GGPO
-        CoreRollbackNetplayAddLocalInput(inputData);
-        
-        // Store current input for potential use in state save/load
-        memcpy(g_lastInputs, inputData, ROLLBACK_INPUT_BYTES);
-        
-        // Advance the frame in GGPO - this synchronizes with remote player
-        // and possibly triggers rollbacks if needed
-        CoreRollbackNetplayAdvanceFrame();
+        // Start the frame, this synchronizes with the remote players
+        // and loads an older state when a rollback is needed
+        if (!CoreRollbackNetplayAdvanceFrame())
+        {
+            CoreStopEmulation();
+            return;
+        }
+
+        bool resimulating = CoreRollbackNetplayIsResimulating();
+        if (resimulating != l_RollbackResimulating)
+        {
+            if (resimulating)
+            {
+                l_RollbackSpeedLimiter = CoreIsSpeedLimiterEnabled();
+                CoreSetSpeedLimiterState(false);
+            }
+            else
+            {
+                CoreSetSpeedLimiterState(l_RollbackSpeedLimiter);
+            }
+            CoreSetResimulatingState(resimulating);
+            l_RollbackResimulating = resimulating;
+        }
+
+        // Resimulated frames already have their local inputs
+        if (!resimulating)
+        {
+            // Get inputs from local controller
+            uint8_t inputData[ROLLBACK_INPUT_BYTES * 4] = {0}; // Buffer for all players
+            GetControllerInputs(inputData);
+
+            // Increment input sequence for tracking
+            g_currentInputSequence++;
+
+            uint8_t* localInput = &inputData[CoreGetNetplayPlayerIndex() * ROLLBACK_INPUT_BYTES];
+            CoreRollbackNetplayAddLocalInput(localInput);
+
+            // Store current input for potential use in state save/load
+            memcpy(g_lastInputs, localInput, ROLLBACK_INPUT_BYTES);
+        }
         
         // Get synchronized inputs from all players
         uint8_t allInputs[ROLLBACK_INPUT_BYTES * 4]; // Max 4 players
@@ -353,6 +440,17 @@ static void EmulationFrameCallback(unsigned int FrameIndex)
             }
         }
     }
+    else
+    {
+        CoreMovieFrameCallback();
+
+        // movies rely on every polled input,
+        // so they can't be rewound
+        if (!CoreIsMovieActive())
+        {
+            CoreRewindFrameCallback();
+        }
+    }
 }
 
 //
@@ -370,11 +468,15 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
     CoreRomType type;
     bool        netplay = !address.empty();
 
+    launch_timing_start();
+
     if (!CoreOpenRom(n64rom))
     {
         return false;
     }
 
+    launch_timing_stage("open ROM");
+
     if (!CoreApplyRomPluginSettings())
     {
         CoreApplyPluginSettings();
@@ -382,6 +484,8 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
         return false;
     }
 
+    launch_timing_stage("plugin settings");
+
     if (!CoreArePluginsReady())
     {
         CoreApplyPluginSettings();
@@ -396,6 +500,8 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
         return false;
     }
 
+    launch_timing_stage("attach plugins");
+
     if (netplay)
     { // netplay cheats
         if (!CoreApplyNetplayCheats())
@@ -417,6 +523,8 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
         }
     }
 
+    launch_timing_stage("cheats");
+
     if (!CoreGetRomType(type))
     {
         CoreClearCheats();
@@ -441,6 +549,23 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
     // apply pif rom settings
     apply_pif_rom_settings();
 
+    launch_timing_stage("settings");
+
+    // prepare the requested movie,
+    // this has to happen after applying the
+    // core settings because it overrides them
+    if (!CoreMovieStartEmulation(netplay))
+    {
+        CoreClearCheats();
+        CoreDetachPlugins();
+        CoreApplyPluginSettings();
+        CoreCloseRom();
+        CoreResetMediaLoader();
+        return false;
+    }
+
+    launch_timing_stage("movie");
+
 #ifdef DISCORD_RPC
     CoreDiscordRpcUpdate(true);
 #endif // DISCORD_RPC
@@ -462,13 +587,13 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
             {
                 CoreSetError("Failed to initialize rollback netplay");
                 CoreStopEmulation();
+                CoreMovieStopEmulation();
                 return false;
             }
             
             // Register frame callback for rollback
-            frameCallbackData = new m64p_frame_callback_data();
-            frameCallbackData->callback = EmulationFrameCallback;
-            m64p::Core.DoCommand(M64CMD_SET_FRAME_CALLBACK, 0, frameCallbackData);
+            l_RollbackResimulating = false;
+            m64p::Core.DoCommand(M64CMD_SET_FRAME_CALLBACK, 0, (void*)EmulationFrameCallback);
         }
         else
         {
@@ -477,11 +602,26 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
             if (!netplay_ret)
             {
                 CoreStopEmulation();
+                CoreMovieStopEmulation();
                 return false;
             }
         }
     }
 
+    // rewind relies on snapshots, which
+    // aren't available during netplay
+    if (!netplay)
+    {
+        if (!CoreIsMovieActive() && !CoreStartRewind())
+        {
+            CoreAddCallbackMessage(CoreDebugMessageType::Warning, "Failed to start rewind: " + CoreGetError());
+        }
+        m64p::Core.DoCommand(M64CMD_SET_INPUT_POLL_CALLBACK, 0, (void*)EmulationInputPollCallback);
+        m64p::Core.DoCommand(M64CMD_SET_FRAME_CALLBACK, 0, (void*)EmulationFrameCallback);
+    }
+
+    launch_timing_stage("netplay and rewind");
+
     // only start emulation when initializing netplay
     // is successful or if there's no netplay requested
     if (!netplay || netplay_ret)
@@ -494,6 +634,18 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
         }
     }
 
+    l_LaunchTimingActive = false;
+
+    if (!netplay)
+    {
+        m64p::Core.DoCommand(M64CMD_SET_FRAME_CALLBACK, 0, nullptr);
+        m64p::Core.DoCommand(M64CMD_SET_INPUT_POLL_CALLBACK, 0, nullptr);
+        CoreStopRewind();
+    }
+
+    // write the recorded movie
+    CoreMovieStopEmulation();
+
     CoreClearCheats();
     CoreDetachPlugins();
     CoreCloseRom();
@@ -544,10 +696,14 @@ CORE_EXPORT bool CoreStopEmulation(void)
         CoreShutdownRollbackNetplay();
         
         // Clean up frame callback
-        if (frameCallbackData)
+        m64p::Core.DoCommand(M64CMD_SET_FRAME_CALLBACK, 0, nullptr);
+
+        if (l_RollbackResimulating)
         {
-            delete frameCallbackData;
-            frameCallbackData = nullptr;
+            // the core clears the resimulation
+            // state itself when emulation stops
+            CoreSetSpeedLimiterState(l_RollbackSpeedLimiter);
+            l_RollbackResimulating = false;
         }
     }
 
@@ -648,6 +804,14 @@ CORE_EXPORT bool CoreResetEmulation(bool hard)
         return false;
     }
 
+    if (CoreIsMovieActive())
+    {
+        error = "CoreResetEmulation Failed: ";
+        error += "cannot reset emulation while a movie is recorded or played back!";
+        CoreSetError(error);
+        return false;
+    }
+
     ret = m64p::Core.DoCommand(M64CMD_RESET, hard, nullptr);
     if (ret != M64ERR_SUCCESS)
     {
@@ -655,6 +819,11 @@ CORE_EXPORT bool CoreResetEmulation(bool hard)
         error += m64p::Core.ErrorMessage(ret);
         CoreSetError(error);
     }
+    else
+    {
+        // a reset can't be replayed
+        CoreResetRewind();
+    }
 
     return ret == M64ERR_SUCCESS;
 }
@@ -11,10 +11,13 @@
 
 #include "Library.hpp"
 
+#include <mutex>
+
 //
 // Local Variables
 //
 
+static std::mutex  l_ErrorMutex;
 static std::string l_ErrorMessage;
 
 //
@@ -23,10 +26,12 @@ static std::string l_ErrorMessage;
 
 void CoreSetError(std::string error)
 {
+    std::lock_guard<std::mutex> guard(l_ErrorMutex);
     l_ErrorMessage = error;
 }
 
 CORE_EXPORT std::string CoreGetError(void)
 {
+    std::lock_guard<std::mutex> guard(l_ErrorMutex);
     return l_ErrorMessage;
 }
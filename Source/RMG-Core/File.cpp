@@ -20,7 +20,10 @@
 #include <windows.h>
 #include <fileapi.h>
 #else
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 //
@@ -62,6 +65,126 @@ CORE_EXPORT bool CoreReadFile(std::filesystem::path file, std::vector<char>& out
     return true;
 }
 
+CORE_EXPORT bool CoreMapFile(std::filesystem::path file, CoreMappedFile& mappedFile)
+{
+    std::string error;
+
+#ifdef _WIN32
+    HANDLE file_handle;
+    HANDLE mapping_handle;
+    LARGE_INTEGER file_size;
+    void* data;
+
+    file_handle = CreateFileW(file.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        error = "CoreMapFile Failed: ";
+        error += "failed to open file: ";
+        error += std::to_string(GetLastError());
+        CoreSetError(error);
+        return false;
+    }
+
+    if (GetFileSizeEx(file_handle, &file_size) != TRUE || file_size.QuadPart == 0)
+    {
+        CloseHandle(file_handle);
+        error = "CoreMapFile Failed: ";
+        error += "failed to retrieve file size or file is empty";
+        CoreSetError(error);
+        return false;
+    }
+
+    mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file_handle);
+    if (mapping_handle == nullptr)
+    {
+        error = "CoreMapFile Failed: ";
+        error += "CreateFileMappingW Failed: ";
+        error += std::to_string(GetLastError());
+        CoreSetError(error);
+        return false;
+    }
+
+    // the view keeps the mapping alive
+    data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping_handle);
+    if (data == nullptr)
+    {
+        error = "CoreMapFile Failed: ";
+        error += "MapViewOfFile Failed: ";
+        error += std::to_string(GetLastError());
+        CoreSetError(error);
+        return false;
+    }
+
+    mappedFile.Data = (const char*)data;
+    mappedFile.Size = (size_t)file_size.QuadPart;
+#else // Linux
+    int fd;
+    struct stat file_stat;
+    void* data;
+
+    fd = open(file.string().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        error = "CoreMapFile Failed: ";
+        error += "failed to open file: ";
+        error += strerror(errno);
+        error += " (";
+        error += std::to_string(errno);
+        error += ")";
+        CoreSetError(error);
+        return false;
+    }
+
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        close(fd);
+        error = "CoreMapFile Failed: ";
+        error += "failed to retrieve file size or file is empty";
+        CoreSetError(error);
+        return false;
+    }
+
+    // the mapping keeps the file alive
+    data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        error = "CoreMapFile Failed: ";
+        error += "mmap Failed: ";
+        error += strerror(errno);
+        CoreSetError(error);
+        return false;
+    }
+
+    // the file is usually read from start to end once
+    madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+
+    mappedFile.Data = (const char*)data;
+    mappedFile.Size = (size_t)file_stat.st_size;
+#endif // _WIN32
+
+    return true;
+}
+
+CORE_EXPORT void CoreUnmapFile(CoreMappedFile& mappedFile)
+{
+    if (mappedFile.Data == nullptr)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(mappedFile.Data);
+#else // Linux
+    munmap((void*)mappedFile.Data, mappedFile.Size);
+#endif // _WIN32
+
+    mappedFile.Data = nullptr;
+    mappedFile.Size = 0;
+}
+
 CORE_EXPORT bool CoreWriteFile(std::filesystem::path file, std::vector<char>& buffer)
 {
     std::string   error;
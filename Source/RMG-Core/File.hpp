@@ -15,9 +15,23 @@
 
 typedef uint64_t CoreFileTime;
 
+struct CoreMappedFile
+{
+    // read-only view of the file
+    const char* Data = nullptr;
+    size_t      Size = 0;
+};
+
 // attempts to read the file into the buffer
 bool CoreReadFile(std::filesystem::path file, std::vector<char>& outBuffer);
 
+// attempts to map the file read-only into memory,
+// the pages are only read when they're accessed
+bool CoreMapFile(std::filesystem::path file, CoreMappedFile& mappedFile);
+
+// unmaps the file mapped by CoreMapFile
+void CoreUnmapFile(CoreMappedFile& mappedFile);
+
 // attempts to write the buffer to file
 bool CoreWriteFile(std::filesystem::path file, std::vector<char>& buffer);
 
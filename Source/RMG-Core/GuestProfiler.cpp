@@ -0,0 +1,209 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define CORE_INTERNAL
+#include "GuestProfiler.hpp"
+#include "Library.hpp"
+#include "Error.hpp"
+
+#include "m64p/Api.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+
+//
+// Local Variables
+//
+
+static bool l_GuestProfilerRunning = false;
+
+//
+// Local Functions
+//
+
+static bool set_guest_profiler_enabled(bool enabled)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_PROFILER_ENABLE, enabled ? 1 : 0, nullptr);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "set_guest_profiler_enabled: m64p::Core.DoCommand(M64CMD_PROFILER_ENABLE) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    l_GuestProfilerRunning = enabled;
+    return true;
+}
+
+static bool get_guest_profile_report(m64p_profile_report& report, std::vector<m64p_profile_entry>& entries)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    // query the amount of entries first, the second
+    // report may contain a few more, those are cut off
+    report = {nullptr, 0, 0, 0, 0, 0, 0};
+    ret = m64p::Core.DoCommand(M64CMD_PROFILER_REPORT, sizeof(report), &report);
+    if (ret == M64ERR_SUCCESS && report.total_entries > 0)
+    {
+        entries.resize(report.total_entries);
+        report.entries = entries.data();
+        report.size    = (unsigned int)entries.size();
+        ret = m64p::Core.DoCommand(M64CMD_PROFILER_REPORT, sizeof(report), &report);
+    }
+
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "get_guest_profile_report: m64p::Core.DoCommand(M64CMD_PROFILER_REPORT) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    entries.resize(report.count);
+    return true;
+}
+
+static std::string get_function_name(uint32_t address)
+{
+    char name[16];
+
+    if (address == 0)
+    {
+        return "other";
+    }
+
+    snprintf(name, sizeof(name), "n64_%08X", address);
+    return name;
+}
+
+//
+// Exported Functions
+//
+
+CORE_EXPORT bool CoreStartGuestProfiler(void)
+{
+    return set_guest_profiler_enabled(true);
+}
+
+CORE_EXPORT bool CoreStopGuestProfiler(void)
+{
+    return set_guest_profiler_enabled(false);
+}
+
+CORE_EXPORT bool CoreIsGuestProfilerRunning(void)
+{
+    return l_GuestProfilerRunning;
+}
+
+CORE_EXPORT bool CoreGetGuestProfile(CoreGuestProfile& profile)
+{
+    m64p_profile_report report;
+    std::vector<m64p_profile_entry> entries;
+    std::unordered_map<uint32_t, size_t> functionIndexes;
+
+    if (!get_guest_profile_report(report, entries))
+    {
+        return false;
+    }
+
+    profile.Samples        = report.samples;
+    profile.Cycles         = report.cycles;
+    profile.DroppedSamples = report.dropped;
+    profile.Functions.clear();
+    profile.Stacks.clear();
+    profile.Stacks.reserve(entries.size());
+
+    // the entries are sorted by cycles already,
+    // only the functions have to be summed up
+    for (const m64p_profile_entry& entry : entries)
+    {
+        profile.Stacks.push_back({entry.caller, entry.function, entry.samples, entry.cycles});
+
+        auto iter = functionIndexes.find(entry.function);
+        if (iter == functionIndexes.end())
+        {
+            functionIndexes[entry.function] = profile.Functions.size();
+            profile.Functions.push_back({entry.function, entry.samples, entry.cycles});
+        }
+        else
+        {
+            profile.Functions[iter->second].Samples += entry.samples;
+            profile.Functions[iter->second].Cycles  += entry.cycles;
+        }
+    }
+
+    std::stable_sort(profile.Functions.begin(), profile.Functions.end(),
+        [](const CoreGuestProfileFunction& a, const CoreGuestProfileFunction& b)
+        {
+            return a.Cycles > b.Cycles;
+        });
+
+    return true;
+}
+
+CORE_EXPORT bool CoreSaveGuestProfileFlameGraph(std::filesystem::path file)
+{
+    std::string error;
+    CoreGuestProfile profile;
+
+    if (!CoreGetGuestProfile(profile))
+    {
+        return false;
+    }
+
+    std::ofstream outputStream(file);
+    if (!outputStream.is_open())
+    {
+        error = "CoreSaveGuestProfileFlameGraph Failed: ";
+        error += "failed to open file: ";
+        error += file.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    // one line per stack, the frames are separated
+    // by ';' and followed by the weight of the stack
+    for (const CoreGuestProfileStack& stack : profile.Stacks)
+    {
+        if (stack.Caller != 0)
+        {
+            outputStream << get_function_name(stack.Caller) << ";";
+        }
+        outputStream << get_function_name(stack.Function) << " " << stack.Cycles << "\n";
+    }
+
+    outputStream.close();
+    if (outputStream.fail())
+    {
+        error = "CoreSaveGuestProfileFlameGraph Failed: ";
+        error += "failed to write file: ";
+        error += file.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    return true;
+}
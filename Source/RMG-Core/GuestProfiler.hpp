@@ -0,0 +1,70 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_GUESTPROFILER_HPP
+#define CORE_GUESTPROFILER_HPP
+
+#include <filesystem>
+#include <cstdint>
+#include <vector>
+
+struct CoreGuestProfileFunction
+{
+    // guest address of the function,
+    // 0 for the functions which didn't
+    // fit in the profile anymore
+    uint32_t Address = 0;
+    uint32_t Samples = 0;
+    uint64_t Cycles  = 0;
+};
+
+struct CoreGuestProfileStack
+{
+    // guest address of the caller,
+    // 0 when it's unknown
+    uint32_t Caller   = 0;
+    uint32_t Function = 0;
+    uint32_t Samples  = 0;
+    uint64_t Cycles   = 0;
+};
+
+struct CoreGuestProfile
+{
+    uint32_t Samples = 0;
+    uint64_t Cycles  = 0;
+    // samples which were dropped because the
+    // profile wasn't retrieved often enough
+    uint32_t DroppedSamples = 0;
+    // functions with the most cycles first
+    std::vector<CoreGuestProfileFunction> Functions;
+    // calls with the most cycles first
+    std::vector<CoreGuestProfileStack> Stacks;
+};
+
+// starts sampling the emulated CPU,
+// clears the previous profile
+bool CoreStartGuestProfiler(void);
+
+// stops sampling the emulated CPU,
+// the profile is kept until it's started again
+bool CoreStopGuestProfiler(void);
+
+// returns whether the profiler is sampling
+bool CoreIsGuestProfilerRunning(void);
+
+// retrieves the profile, it has to be retrieved
+// every few seconds while the profiler is running
+// or samples are dropped
+bool CoreGetGuestProfile(CoreGuestProfile& profile);
+
+// writes the profile as collapsed stacks,
+// which flamegraph.pl and speedscope can read
+bool CoreSaveGuestProfileFlameGraph(std::filesystem::path file);
+
+#endif // CORE_GUESTPROFILER_HPP
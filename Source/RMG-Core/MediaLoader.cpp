@@ -26,7 +26,6 @@
 // Local Variables
 //
 
-static bool l_HasExtractedDisk = false;
 static std::filesystem::path l_DdDiskFile;
 static std::filesystem::path l_DdRomFile;
 
@@ -148,66 +147,30 @@ CORE_EXPORT bool CoreSetupMediaLoader(void)
 
 CORE_EXPORT void CoreResetMediaLoader(void)
 {
-    std::error_code errorCode;
-
-    // attempt to remove extracted disk file
-    if (l_HasExtractedDisk && !l_DdRomFile.empty())
-    {
-        std::filesystem::remove(l_DdDiskFile, errorCode);
-    }
-
-    l_HasExtractedDisk = false;
     l_DdRomFile  = "";
     l_DdDiskFile = "";
 }
 
 CORE_EXPORT void CoreMediaLoaderSetDiskFile(std::filesystem::path disk)
 {
-    std::error_code error_code;
-    std::vector<char> buf;
     std::string file_extension;
 
     file_extension = disk.has_extension() ? disk.extension().string() : "";
     file_extension = CoreLowerString(file_extension);
 
-    // extract disk when it's in an archive
+    // extract disk when it's in an archive,
+    // do nothing if archive doesn't contain a disk
     if (file_extension == ".zip" || 
         file_extension == ".7z")
     {
-        std::filesystem::path extracted_file;
-        bool                  is_disk = false;
-
-        if (!CoreReadArchiveFile(disk, extracted_file, is_disk, buf))
-        {
-            return;
-        }
-
-        // do nothing if archive doesn't contain a disk
-        if (!is_disk)
-        {
-            return;
-        }
-
-        disk = CoreGetUserCacheDirectory();
-        disk += CORE_DIR_SEPERATOR_STR;
-        disk += "extracted_disks";
-        disk += CORE_DIR_SEPERATOR_STR;
-        disk += extracted_file.filename();
-
-        // attempt to create extraction directory
-        if (!std::filesystem::is_directory(disk.parent_path(), error_code) &&
-            !std::filesystem::create_directory(disk.parent_path(), error_code))
-        {
-            return;
-        }
+        std::filesystem::path extracted_disk;
 
-        // attempt to write temporary file
-        if (!CoreWriteFile(disk, buf))
+        if (!CoreExtractArchiveDisk(disk, extracted_disk))
         {
             return;
         }
 
-        l_HasExtractedDisk = true;
+        disk = extracted_disk;
     }
 
 
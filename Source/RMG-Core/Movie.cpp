@@ -0,0 +1,881 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define CORE_INTERNAL
+#include "SpeedLimiter.hpp"
+#include "RomSettings.hpp"
+#include "Emulation.hpp"
+#include "SaveState.hpp"
+#include "Settings.hpp"
+#include "Callback.hpp"
+#include "Library.hpp"
+#include "Movie.hpp"
+#include "Error.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+//
+// Local Defines
+//
+
+// Movie file layout, all values are little endian:
+//   char[4]   magic
+//   uint32    version
+//   uint32    start, MOVIE_START_*
+//   char[32]  MD5 of the ROM
+//   uint32    frame count
+//   uint32    poll count
+//   uint32    save state size, followed by the save state
+//   uint16    polls of each frame [frame count]
+//   polls     [poll count], uint8 control and uint32 keys
+#define MOVIE_MAGIC   "RMGM"
+#define MOVIE_VERSION 1
+
+#define MOVIE_START_POWERON   0
+#define MOVIE_START_SAVESTATE 1
+
+#define MOVIE_MD5_SIZE 32
+
+// amount of snapshots used to calculate the checksums,
+// a snapshot only stores the pages changed since the last one
+#define MOVIE_CHECKSUM_SNAPSHOTS 2
+
+//
+// Local Structures
+//
+
+enum class MovieMode
+{
+    None = 0,
+    Recording,
+    Playback
+};
+
+struct MoviePoll
+{
+    uint8_t  Control;
+    uint32_t Keys;
+};
+
+//
+// Local Variables
+//
+
+// guards the movie state against the
+// exported functions while emulating,
+// the emulation thread only changes the
+// state from the frame callback
+static std::mutex l_MovieMutex;
+
+static std::atomic<MovieMode> l_MovieMode = MovieMode::None;
+static bool     l_MovieEmulating     = false;
+static bool     l_MovieNetplay       = false;
+static bool     l_MovieStarted       = false;
+static bool     l_MovieFromSaveState = false;
+static bool     l_MovieBenchmark     = false;
+static std::filesystem::path l_MovieFile;
+static std::filesystem::path l_MovieChecksumFile;
+static std::string l_MovieMD5;
+static std::vector<uint8_t>   l_MovieState;
+
+// the polls of frame N start at l_MovieFrames[N],
+// when recording the last entry is the current frame
+static std::vector<MoviePoll> l_MoviePolls;
+static std::vector<uint32_t>  l_MovieFrames;
+static uint32_t l_MovieFrame         = 0;
+static uint32_t l_MovieTotalFrames   = 0;
+static size_t   l_MoviePollPosition  = 0;
+static size_t   l_MoviePollEnd       = 0;
+
+static std::ofstream l_MovieChecksumStream;
+static bool     l_MovieChecksumSnapshots = false;
+
+static bool     l_MovieSpeedLimiter   = true;
+static bool     l_MovieAudioSync      = false;
+static bool     l_MovieRestoreAudio   = false;
+static bool     l_MovieTiming         = false;
+static uint32_t l_MovieTimingFrame    = 0;
+static std::chrono::steady_clock::time_point l_MovieTimingStart;
+static CoreMovieStatistics l_MovieStatistics;
+// set by the input poll callback
+static std::atomic<int64_t> l_MovieDesyncFrame = -1;
+
+// requests made while emulating,
+// handled by the frame callback
+static bool l_MovieRecordRequest = false;
+static bool l_MovieStopRequest   = false;
+static std::filesystem::path l_MovieRequestFile;
+
+//
+// Local Functions
+//
+
+static void movie_write_u16(std::vector<uint8_t>& data, uint16_t value)
+{
+    data.push_back((uint8_t)(value));
+    data.push_back((uint8_t)(value >> 8));
+}
+
+static void movie_write_u32(std::vector<uint8_t>& data, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        data.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+static bool movie_read_u16(const std::vector<uint8_t>& data, size_t& pos, uint16_t& value)
+{
+    if (data.size() - pos < 2)
+    {
+        return false;
+    }
+
+    value = (uint16_t)(data[pos] | (data[pos + 1] << 8));
+    pos += 2;
+    return true;
+}
+
+static bool movie_read_u32(const std::vector<uint8_t>& data, size_t& pos, uint32_t& value)
+{
+    if (data.size() - pos < 4)
+    {
+        return false;
+    }
+
+    value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        value |= (uint32_t)data[pos + i] << (i * 8);
+    }
+    pos += 4;
+    return true;
+}
+
+static void movie_reset(void)
+{
+    l_MovieStarted = false;
+    l_MovieState.clear();
+    l_MoviePolls.clear();
+    l_MovieFrames.clear();
+    l_MovieFrame        = 0;
+    l_MovieTotalFrames  = 0;
+    l_MoviePollPosition = 0;
+    l_MoviePollEnd      = 0;
+    l_MovieTiming       = false;
+    l_MovieStatistics   = {};
+    l_MovieDesyncFrame  = -1;
+}
+
+static bool movie_write_file(void)
+{
+    std::string error;
+    std::vector<uint8_t> data;
+    // the polls of the unfinished frame are dropped
+    uint32_t frames = (uint32_t)l_MovieFrames.size() - 1;
+    uint32_t polls  = l_MovieFrames.back();
+
+    data.reserve(64 + l_MovieState.size() + (frames * 2) + (polls * 5));
+
+    data.insert(data.end(), MOVIE_MAGIC, MOVIE_MAGIC + 4);
+    movie_write_u32(data, MOVIE_VERSION);
+    movie_write_u32(data, l_MovieFromSaveState ? MOVIE_START_SAVESTATE : MOVIE_START_POWERON);
+    l_MovieMD5.resize(MOVIE_MD5_SIZE);
+    data.insert(data.end(), l_MovieMD5.begin(), l_MovieMD5.end());
+    movie_write_u32(data, frames);
+    movie_write_u32(data, polls);
+    movie_write_u32(data, (uint32_t)l_MovieState.size());
+    data.insert(data.end(), l_MovieState.begin(), l_MovieState.end());
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        movie_write_u16(data, (uint16_t)(l_MovieFrames[i + 1] - l_MovieFrames[i]));
+    }
+
+    for (uint32_t i = 0; i < polls; i++)
+    {
+        data.push_back(l_MoviePolls[i].Control);
+        movie_write_u32(data, l_MoviePolls[i].Keys);
+    }
+
+    std::ofstream outputStream(l_MovieFile, std::ios::binary);
+    if (!outputStream.is_open())
+    {
+        error = "movie_write_file Failed: ";
+        error += "failed to open file: ";
+        error += l_MovieFile.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    outputStream.write((const char*)data.data(), data.size());
+    if (outputStream.fail())
+    {
+        error = "movie_write_file Failed: ";
+        error += "failed to write file: ";
+        error += l_MovieFile.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    return true;
+}
+
+static bool movie_read_file(const std::filesystem::path& file)
+{
+    std::string error;
+    std::vector<uint8_t> data;
+    size_t pos = 4;
+    uint32_t version = 0;
+    uint32_t start = 0;
+    uint32_t frames = 0;
+    uint32_t polls = 0;
+    uint32_t stateSize = 0;
+
+    std::ifstream inputStream(file, std::ios::binary);
+    if (!inputStream.is_open())
+    {
+        error = "movie_read_file Failed: ";
+        error += "failed to open file: ";
+        error += file.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    data.assign(std::istreambuf_iterator<char>(inputStream), std::istreambuf_iterator<char>());
+
+    if (data.size() < 4 || std::memcmp(data.data(), MOVIE_MAGIC, 4) != 0 ||
+        !movie_read_u32(data, pos, version) || version != MOVIE_VERSION ||
+        !movie_read_u32(data, pos, start) || start > MOVIE_START_SAVESTATE ||
+        data.size() - pos < MOVIE_MD5_SIZE)
+    {
+        error = "movie_read_file Failed: ";
+        error += "unsupported movie file: ";
+        error += file.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    l_MovieMD5.assign((const char*)&data[pos], MOVIE_MD5_SIZE);
+    pos += MOVIE_MD5_SIZE;
+
+    if (!movie_read_u32(data, pos, frames) ||
+        !movie_read_u32(data, pos, polls) ||
+        !movie_read_u32(data, pos, stateSize) ||
+        data.size() - pos < stateSize ||
+        (start == MOVIE_START_SAVESTATE) != (stateSize != 0))
+    {
+        error = "movie_read_file Failed: ";
+        error += "corrupted movie file: ";
+        error += file.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    l_MovieState.assign(data.begin() + pos, data.begin() + pos + stateSize);
+    pos += stateSize;
+
+    l_MovieFrames.reserve(frames + 1);
+    l_MovieFrames.push_back(0);
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        uint16_t framePolls;
+        if (!movie_read_u16(data, pos, framePolls))
+        {
+            break;
+        }
+        l_MovieFrames.push_back(l_MovieFrames.back() + framePolls);
+    }
+
+    if (l_MovieFrames.size() != frames + 1 ||
+        l_MovieFrames.back() != polls ||
+        data.size() - pos != (size_t)polls * 5)
+    {
+        l_MovieState.clear();
+        l_MovieFrames.clear();
+        error = "movie_read_file Failed: ";
+        error += "corrupted movie file: ";
+        error += file.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    l_MoviePolls.resize(polls);
+    for (uint32_t i = 0; i < polls; i++)
+    {
+        l_MoviePolls[i].Control = data[pos++];
+        movie_read_u32(data, pos, l_MoviePolls[i].Keys);
+    }
+
+    l_MovieFromSaveState = start == MOVIE_START_SAVESTATE;
+    l_MovieTotalFrames   = frames;
+    return true;
+}
+
+static void movie_update_statistics(void)
+{
+    l_MovieStatistics.Frames      = l_MovieFrame;
+    l_MovieStatistics.TotalFrames = (l_MovieMode == MovieMode::Playback) ? l_MovieTotalFrames : l_MovieFrame;
+
+    if (l_MovieTiming)
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - l_MovieTimingStart;
+        l_MovieStatistics.Seconds = elapsed.count();
+        if (l_MovieStatistics.Seconds > 0)
+        {
+            l_MovieStatistics.FramesPerSecond = (l_MovieFrame - l_MovieTimingFrame) / l_MovieStatistics.Seconds;
+        }
+    }
+}
+
+static void movie_set_playback_frame(uint32_t frame)
+{
+    l_MovieFrame = frame;
+    if (frame < l_MovieTotalFrames)
+    {
+        l_MoviePollPosition = l_MovieFrames[frame];
+        l_MoviePollEnd      = l_MovieFrames[frame + 1];
+    }
+    else
+    {
+        l_MoviePollPosition = l_MoviePollEnd = 0;
+    }
+}
+
+static void movie_desync(void)
+{
+    char message[128];
+
+    if (l_MovieDesyncFrame != -1)
+    {
+        return;
+    }
+
+    l_MovieDesyncFrame = l_MovieFrame;
+    snprintf(message, sizeof(message), "Movie desynchronized at frame %u, the game polled different inputs than recorded", l_MovieFrame);
+    CoreAddCallbackMessage(CoreDebugMessageType::Warning, message);
+}
+
+static void movie_start_frames(void)
+{
+    l_MovieStarted = true;
+
+    if (l_MovieMode == MovieMode::Recording)
+    {
+        l_MoviePolls.clear();
+        l_MovieFrames.assign(1, 0);
+        l_MovieFrame = 0;
+    }
+    else
+    {
+        movie_set_playback_frame(0);
+    }
+}
+
+static void movie_write_checksum(void)
+{
+    CoreStateSnapshotHashes hashes;
+    char line[16 + (CORE_SNAPSHOT_RDRAM_REGIONS + 1) * 9];
+    int length;
+    size_t size;
+    size_t rawSize;
+    uint32_t pages;
+
+    if (!l_MovieChecksumStream.is_open())
+    {
+        return;
+    }
+
+    // the snapshot ring is allocated at
+    // the first frame callback of the movie
+    if (!l_MovieChecksumSnapshots)
+    {
+        if (!CoreInitSaveStateSnapshots(MOVIE_CHECKSUM_SNAPSHOTS, CoreStateCodec::None))
+        {
+            CoreAddCallbackMessage(CoreDebugMessageType::Warning, "Failed to write movie checksums: " + CoreGetError());
+            l_MovieChecksumStream.close();
+            return;
+        }
+        l_MovieChecksumSnapshots = true;
+    }
+
+    if (!CoreSaveStateSnapshot(l_MovieFrame, size, rawSize, pages, &hashes))
+    {
+        CoreAddCallbackMessage(CoreDebugMessageType::Warning, "Failed to write movie checksums: " + CoreGetError());
+        l_MovieChecksumStream.close();
+        return;
+    }
+
+    length = snprintf(line, sizeof(line), "%u %08X", l_MovieFrame, hashes.StateHash);
+    for (uint32_t hash : hashes.RdramHashes)
+    {
+        length += snprintf(line + length, sizeof(line) - length, " %08X", hash);
+    }
+    line[length++] = '\n';
+    l_MovieChecksumStream.write(line, length);
+}
+
+// finishes the movie, emulating is false
+// when emulation has already stopped
+static void movie_finish(bool emulating)
+{
+    MovieMode mode = l_MovieMode;
+    char message[160];
+
+    if (mode == MovieMode::None)
+    {
+        return;
+    }
+
+    movie_update_statistics();
+
+    if (mode == MovieMode::Recording && l_MovieStarted)
+    {
+        if (!movie_write_file())
+        {
+            CoreAddCallbackMessage(CoreDebugMessageType::Error, "Failed to write movie: " + CoreGetError());
+        }
+    }
+
+    if (l_MovieStarted)
+    {
+        snprintf(message, sizeof(message), "Movie %s: %u frames in %.3f seconds (%.2f frames/sec)",
+            (mode == MovieMode::Recording) ? "recorded" : "played back",
+            l_MovieStatistics.Frames, l_MovieStatistics.Seconds, l_MovieStatistics.FramesPerSecond);
+        CoreAddCallbackMessage(CoreDebugMessageType::Info, message);
+    }
+
+    l_MovieChecksumStream.close();
+
+    if (emulating)
+    {
+        if (l_MovieChecksumSnapshots)
+        {
+            CoreInitSaveStateSnapshots(0);
+        }
+
+        if (l_MovieBenchmark && l_MovieTiming)
+        {
+            CoreSetSpeedLimiterState(l_MovieSpeedLimiter);
+        }
+
+        // the rewind history doesn't
+        // contain the frames of the movie
+        CoreResetRewind();
+    }
+
+    l_MovieChecksumSnapshots = false;
+    l_MovieMode = MovieMode::None;
+    l_MovieStarted = false;
+    l_MovieState.clear();
+    l_MovieState.shrink_to_fit();
+    l_MoviePolls.clear();
+    l_MoviePolls.shrink_to_fit();
+    l_MovieFrames.clear();
+    l_MovieFrames.shrink_to_fit();
+}
+
+static bool movie_open_checksum_file(void)
+{
+    std::string error;
+
+    if (l_MovieChecksumFile.empty())
+    {
+        return true;
+    }
+
+    l_MovieChecksumStream.open(l_MovieChecksumFile, std::ios::trunc);
+    if (!l_MovieChecksumStream.is_open())
+    {
+        error = "failed to open checksum file: ";
+        error += l_MovieChecksumFile.string();
+        CoreSetError(error);
+        return false;
+    }
+
+    return true;
+}
+
+// starts recording with the current state,
+// called from the frame callback
+static void movie_start_savestate_recording(void)
+{
+    size_t size = 0;
+    CoreRomSettings romSettings;
+
+    if (!CoreGetCurrentDefaultRomSettings(romSettings) ||
+        !CoreGetSaveStateMemorySize(size))
+    {
+        CoreAddCallbackMessage(CoreDebugMessageType::Error, "Failed to start movie recording: " + CoreGetError());
+        return;
+    }
+
+    movie_reset();
+    l_MovieState.resize(size);
+    if (!CoreSaveStateToMemory(l_MovieState.data(), l_MovieState.size(), size))
+    {
+        CoreAddCallbackMessage(CoreDebugMessageType::Error, "Failed to start movie recording: " + CoreGetError());
+        l_MovieState.clear();
+        return;
+    }
+    l_MovieState.resize(size);
+
+    if (!movie_open_checksum_file())
+    {
+        CoreAddCallbackMessage(CoreDebugMessageType::Warning, "Failed to write movie checksums: " + CoreGetError());
+    }
+
+    l_MovieFile          = l_MovieRequestFile;
+    l_MovieMD5           = romSettings.MD5;
+    l_MovieFromSaveState = true;
+    l_MovieBenchmark     = false;
+    l_MovieMode          = MovieMode::Recording;
+    movie_start_frames();
+
+    // the movie can't be rewound
+    CoreResetRewind();
+}
+
+//
+// Internal Functions
+//
+
+void CoreMovieInputPollCallback(int control, unsigned int* keys)
+{
+    if (!l_MovieStarted)
+    {
+        return;
+    }
+
+    if (l_MovieMode == MovieMode::Recording)
+    {
+        l_MoviePolls.push_back({(uint8_t)control, (uint32_t)*keys});
+        return;
+    }
+
+    if (l_MoviePollPosition < l_MoviePollEnd &&
+        l_MoviePolls[l_MoviePollPosition].Control == control)
+    {
+        *keys = l_MoviePolls[l_MoviePollPosition++].Keys;
+    }
+    else if (l_MovieFrame < l_MovieTotalFrames)
+    {
+        movie_desync();
+    }
+}
+
+bool CoreMovieStartEmulation(bool netplay)
+{
+    std::lock_guard<std::mutex> lock(l_MovieMutex);
+    std::string error;
+    CoreRomSettings romSettings;
+
+    l_MovieEmulating     = true;
+    l_MovieNetplay       = netplay;
+    l_MovieRecordRequest = false;
+    l_MovieStopRequest   = false;
+    l_MovieRestoreAudio  = false;
+
+    if (l_MovieMode == MovieMode::None)
+    {
+        return true;
+    }
+
+    if (netplay)
+    {
+        error = "CoreMovieStartEmulation Failed: ";
+        error += "movies aren't supported during netplay!";
+        CoreSetError(error);
+        movie_finish(false);
+        return false;
+    }
+
+    if (!CoreGetCurrentDefaultRomSettings(romSettings))
+    {
+        movie_finish(false);
+        return false;
+    }
+
+    if (l_MovieMode == MovieMode::Recording)
+    {
+        l_MovieMD5 = romSettings.MD5;
+    }
+    else if (l_MovieMD5 != romSettings.MD5)
+    {
+        error = "CoreMovieStartEmulation Failed: ";
+        error += "the movie was recorded with a different ROM!";
+        CoreSetError(error);
+        movie_finish(false);
+        return false;
+    }
+
+    if (!movie_open_checksum_file())
+    {
+        error = "CoreMovieStartEmulation Failed: ";
+        error += CoreGetError();
+        CoreSetError(error);
+        movie_finish(false);
+        return false;
+    }
+
+    // the interrupt timing has to be the
+    // same as when the movie was recorded
+    CoreSettingsSetValue(SettingsID::Core_RandomizeInterrupt, false);
+
+    // audio synchronization is applied when the
+    // audio plugin opens the ROM, so it's disabled
+    // before emulation is started
+    if (l_MovieBenchmark)
+    {
+        l_MovieAudioSync    = CoreSettingsGetBoolValue(SettingsID::Audio_Synchronize);
+        l_MovieRestoreAudio = true;
+        CoreSettingsSetValue(SettingsID::Audio_Synchronize, false);
+    }
+
+    // power-on movies start with the inputs
+    // polled before the first frame callback
+    if (!l_MovieFromSaveState)
+    {
+        movie_start_frames();
+    }
+
+    return true;
+}
+
+void CoreMovieStopEmulation(void)
+{
+    std::lock_guard<std::mutex> lock(l_MovieMutex);
+
+    movie_finish(false);
+
+    if (l_MovieRestoreAudio)
+    {
+        CoreSettingsSetValue(SettingsID::Audio_Synchronize, l_MovieAudioSync);
+        l_MovieRestoreAudio = false;
+    }
+
+    l_MovieEmulating     = false;
+    l_MovieRecordRequest = false;
+    l_MovieStopRequest   = false;
+}
+
+void CoreMovieFrameCallback(void)
+{
+    std::lock_guard<std::mutex> lock(l_MovieMutex);
+
+    if (l_MovieStopRequest)
+    {
+        l_MovieStopRequest = false;
+        movie_finish(true);
+    }
+
+    if (l_MovieRecordRequest)
+    {
+        l_MovieRecordRequest = false;
+        movie_start_savestate_recording();
+        return;
+    }
+
+    if (l_MovieMode == MovieMode::None)
+    {
+        return;
+    }
+
+    if (!l_MovieStarted)
+    {
+        // save state movies start at the first frame callback
+        if (!CoreLoadSaveStateFromMemory(l_MovieState.data(), l_MovieState.size()))
+        {
+            CoreAddCallbackMessage(CoreDebugMessageType::Error, "Failed to start movie playback: " + CoreGetError());
+            movie_finish(true);
+            return;
+        }
+
+        movie_start_frames();
+    }
+    else
+    {
+        movie_write_checksum();
+
+        if (l_MovieMode == MovieMode::Recording)
+        {
+            l_MovieFrames.push_back((uint32_t)l_MoviePolls.size());
+            l_MovieFrame++;
+        }
+        else
+        {
+            // the game polled fewer inputs than recorded
+            if (l_MoviePollPosition < l_MoviePollEnd)
+            {
+                movie_desync();
+            }
+
+            movie_set_playback_frame(l_MovieFrame + 1);
+        }
+    }
+
+    if (!l_MovieTiming)
+    {
+        if (l_MovieBenchmark)
+        {
+            l_MovieSpeedLimiter = CoreIsSpeedLimiterEnabled();
+            CoreSetSpeedLimiterState(false);
+        }
+
+        l_MovieTiming      = true;
+        l_MovieTimingFrame = l_MovieFrame;
+        l_MovieTimingStart = std::chrono::steady_clock::now();
+    }
+
+    movie_update_statistics();
+
+    if (l_MovieMode == MovieMode::Playback && l_MovieFrame >= l_MovieTotalFrames)
+    {
+        bool benchmark = l_MovieBenchmark;
+        movie_finish(true);
+        if (benchmark)
+        {
+            CoreStopEmulation();
+        }
+    }
+}
+
+//
+// Exported Functions
+//
+
+CORE_EXPORT bool CoreStartMovieRecording(std::filesystem::path file, bool fromSaveState)
+{
+    std::lock_guard<std::mutex> lock(l_MovieMutex);
+    std::string error;
+
+    if (l_MovieMode != MovieMode::None || l_MovieRecordRequest)
+    {
+        error = "CoreStartMovieRecording Failed: ";
+        error += "a movie is already being recorded or played back!";
+        CoreSetError(error);
+        return false;
+    }
+
+    if (fromSaveState)
+    {
+        if (!l_MovieEmulating || l_MovieNetplay)
+        {
+            error = "CoreStartMovieRecording Failed: ";
+            error += "emulation isn't running or netplay is active!";
+            CoreSetError(error);
+            return false;
+        }
+
+        l_MovieRequestFile   = file;
+        l_MovieRecordRequest = true;
+        return true;
+    }
+
+    if (l_MovieEmulating)
+    {
+        error = "CoreStartMovieRecording Failed: ";
+        error += "cannot record a movie from power-on while emulation is running!";
+        CoreSetError(error);
+        return false;
+    }
+
+    movie_reset();
+    l_MovieFile          = file;
+    l_MovieFromSaveState = false;
+    l_MovieBenchmark     = false;
+    l_MovieMode          = MovieMode::Recording;
+    return true;
+}
+
+CORE_EXPORT bool CoreStartMoviePlayback(std::filesystem::path file, bool benchmark)
+{
+    std::lock_guard<std::mutex> lock(l_MovieMutex);
+    std::string error;
+
+    if (l_MovieMode != MovieMode::None || l_MovieRecordRequest)
+    {
+        error = "CoreStartMoviePlayback Failed: ";
+        error += "a movie is already being recorded or played back!";
+        CoreSetError(error);
+        return false;
+    }
+
+    if (l_MovieEmulating)
+    {
+        error = "CoreStartMoviePlayback Failed: ";
+        error += "cannot play back a movie while emulation is running!";
+        CoreSetError(error);
+        return false;
+    }
+
+    movie_reset();
+    if (!movie_read_file(file))
+    {
+        return false;
+    }
+
+    l_MovieFile      = file;
+    l_MovieBenchmark = benchmark;
+    l_MovieMode      = MovieMode::Playback;
+    return true;
+}
+
+CORE_EXPORT bool CoreSetMovieChecksumFile(std::filesystem::path file)
+{
+    std::lock_guard<std::mutex> lock(l_MovieMutex);
+    std::string error;
+
+    if (l_MovieMode != MovieMode::None || l_MovieRecordRequest)
+    {
+        error = "CoreSetMovieChecksumFile Failed: ";
+        error += "cannot change the checksum file while a movie is active!";
+        CoreSetError(error);
+        return false;
+    }
+
+    l_MovieChecksumFile = file;
+    return true;
+}
+
+CORE_EXPORT bool CoreStopMovie(void)
+{
+    std::lock_guard<std::mutex> lock(l_MovieMutex);
+
+    if (l_MovieEmulating)
+    {
+        l_MovieRecordRequest = false;
+        l_MovieStopRequest   = true;
+        return true;
+    }
+
+    // nothing has been recorded yet
+    l_MovieMode = MovieMode::None;
+    movie_reset();
+    return true;
+}
+
+CORE_EXPORT bool CoreIsMovieActive(void)
+{
+    return l_MovieMode != MovieMode::None;
+}
+
+CORE_EXPORT bool CoreGetMovieStatistics(CoreMovieStatistics& statistics)
+{
+    std::lock_guard<std::mutex> lock(l_MovieMutex);
+    statistics = l_MovieStatistics;
+    statistics.DesyncFrame = l_MovieDesyncFrame;
+    return true;
+}
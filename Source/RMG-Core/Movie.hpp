@@ -0,0 +1,84 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_MOVIE_HPP
+#define CORE_MOVIE_HPP
+
+#include <filesystem>
+#include <cstdint>
+
+// movie hooks used by Emulation.cpp
+#ifdef CORE_INTERNAL
+
+// prepares the requested movie for the opened ROM,
+// must be called before emulation is started,
+// returns false when the movie can't be used
+bool CoreMovieStartEmulation(bool netplay);
+
+// writes the recorded movie and restores
+// the settings changed for the movie,
+// must be called after emulation has stopped
+void CoreMovieStopEmulation(void);
+
+// records or replays the polled inputs,
+// must be called from the input poll callback
+// while a movie is active
+void CoreMovieInputPollCallback(int control, unsigned int* keys);
+
+// moves the movie to the next frame,
+// must be called from the frame callback
+void CoreMovieFrameCallback(void);
+
+#endif // CORE_INTERNAL
+
+struct CoreMovieStatistics
+{
+    // frames recorded or played back
+    uint32_t Frames = 0;
+    // frames in the movie file
+    uint32_t TotalFrames = 0;
+    // time spent emulating the frames
+    double Seconds = 0;
+    // frames emulated per second
+    double FramesPerSecond = 0;
+    // frame at which the polled inputs stopped
+    // matching the movie, -1 when they matched
+    int64_t DesyncFrame = -1;
+};
+
+// records the inputs polled by the game into file,
+// when fromSaveState is true the movie starts with
+// the state at the next frame and emulation must be
+// running, otherwise the movie starts at power-on
+// and it must be called before emulation is started
+bool CoreStartMovieRecording(std::filesystem::path file, bool fromSaveState);
+
+// replays the movie in file when emulation is started,
+// in benchmark mode the speed limiter and audio
+// synchronization are disabled and emulation is
+// stopped at the end of the movie
+bool CoreStartMoviePlayback(std::filesystem::path file, bool benchmark);
+
+// writes the hashes of the emulated state after every
+// frame of the recorded or replayed movie to file,
+// an empty path disables it
+bool CoreSetMovieChecksumFile(std::filesystem::path file);
+
+// stops recording or replaying the movie,
+// a recording is written to its file
+bool CoreStopMovie(void);
+
+// returns whether a movie is recorded or replayed
+bool CoreIsMovieActive(void);
+
+// retrieves the statistics of the current
+// or the last recorded or replayed movie
+bool CoreGetMovieStatistics(CoreMovieStatistics& statistics);
+
+#endif // CORE_MOVIE_HPP
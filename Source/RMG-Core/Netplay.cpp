@@ -19,13 +19,16 @@
 #include "Emulation.hpp"
 #include "Callback.hpp"
 #include "Settings.hpp"
+#include "SaveState.hpp"
+#include "Directories.hpp"
 
 #include "m64p/Api.hpp"
-#include <zlib.h>
 #include <cstring>
 #include <vector>
 #include <cstdint>
 #include <chrono>
+#include <array>
+#include <fstream>
 
 // Core state query parameters
 #define M64CORE_RANDOM_SEED 13  // Used to query/set the current RNG seed
@@ -33,6 +36,7 @@
 // Forward declarations
 static bool SaveEmulatorState(void** buffer, int* len, int* checksum, int frame);
 static bool LoadEmulatorState(void* buffer, int len);
+static void DumpEmulatorDesync(int frame, int player);
 
 //
 // Local Variables
@@ -57,6 +61,8 @@ struct StateMetrics {
     uint32_t loadCount;
     size_t totalUncompressedSize;
     size_t totalCompressedSize;
+    size_t totalFullStateSize;
+    CoreStateCodec codec;
     
     void reset() {
         totalSaveTimeNs = 0;
@@ -65,18 +71,31 @@ struct StateMetrics {
         loadCount = 0;
         totalUncompressedSize = 0;
         totalCompressedSize = 0;
+        totalFullStateSize = 0;
+    }
+    
+    const char* codecName() const {
+        switch (codec) {
+            case CoreStateCodec::None: return "none";
+            case CoreStateCodec::Zlib: return "zlib";
+            case CoreStateCodec::LZ4:  return "lz4";
+        }
+        return "unknown";
     }
     
     void logMetrics() {
         if (saveCount > 0) {
             double avgSaveTimeMs = (double)totalSaveTimeNs / (saveCount * 1000000.0);
-            double compressionRatio = totalUncompressedSize > 0 ? 
-                (double)totalCompressedSize / totalUncompressedSize : 1.0;
+            double compressionRatio = totalCompressedSize > 0 ? 
+                (double)totalUncompressedSize / totalCompressedSize : 1.0;
+            double fullStateRatio = totalCompressedSize > 0 ?
+                (double)totalFullStateSize / totalCompressedSize : 1.0;
             
             char buffer[256];
             snprintf(buffer, sizeof(buffer), 
-                "State Save Metrics: Avg time=%.2fms, Saves=%u, Compression=%.2f:1",
-                avgSaveTimeMs, saveCount, 1.0 / compressionRatio);
+                "State Save Metrics: Codec=%s, Avg time=%.2fms (%lld ns/frame), Saves=%u, Compression=%.2f:1 (%.2f:1 vs full states)",
+                codecName(), avgSaveTimeMs, (long long)(totalSaveTimeNs / saveCount), saveCount,
+                compressionRatio, fullStateRatio);
             CoreAddCallbackMessage(CoreDebugMessageType::Info, buffer);
         }
         
@@ -120,81 +139,19 @@ struct RollbackStateHeader {
     uint32_t magic;          // Magic number to identify our state format
     uint32_t version;        // State format version
     uint32_t frame;          // Frame number
-    uint32_t uncompressedSize; // Size before compression
-    uint32_t compressedSize;   // Size after compression
+    uint32_t uncompressedSize; // Size of a full savestate
+    uint32_t compressedSize;   // Size of the snapshot in the core
     uint32_t randState;      // RNG state for determinism
     uint32_t inputSequence;  // Input sequence number
     uint32_t reserved[2];    // Reserved for future use
 };
 
 #define ROLLBACK_STATE_MAGIC 0x52424B53 // "RBKS"
-#define ROLLBACK_STATE_VERSION 1
-
-// Calculate CRC32 checksum
-static uint32_t CalculateChecksum(const void* data, size_t size) {
-    return crc32(0L, static_cast<const Bytef*>(data), static_cast<uInt>(size));
-}
+#define ROLLBACK_STATE_VERSION 2
 
-// Compress data using zlib
-static bool CompressData(const void* src, int srcLen, void* dst, int* dstLen) {
-    // Optimize zlib compression level for speed vs. size
-    // Level 1-3: Fast compression
-    // Level 4-6: Balanced
-    // Level 7-9: Better compression but slower
-    const int COMPRESSION_LEVEL = 1; // Fastest compression for real-time performance
-    
-    z_stream strm;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    
-    int ret = deflateInit(&strm, COMPRESSION_LEVEL);
-    if (ret != Z_OK) {
-        return false;
-    }
-    
-    strm.avail_in = srcLen;
-    strm.next_in = (Bytef*)src;
-    strm.avail_out = *dstLen;
-    strm.next_out = (Bytef*)dst;
-    
-    ret = deflate(&strm, Z_FINISH);
-    deflateEnd(&strm);
-    
-    if (ret != Z_STREAM_END) {
-        return false;
-    }
-    
-    *dstLen = strm.total_out;
-    return true;
-}
-
-// Decompress data using zlib
-static bool DecompressData(const void* src, int srcLen, void* dst, int dstLen) {
-    z_stream strm;
-    memset(&strm, 0, sizeof(strm));
-    
-    // Initialize zlib
-    if (inflateInit(&strm) != Z_OK) {
-        return false;
-    }
-    
-    // Set input and output
-    strm.avail_in = srcLen;
-    strm.next_in = static_cast<Bytef*>(const_cast<void*>(src));
-    strm.avail_out = dstLen;
-    strm.next_out = static_cast<Bytef*>(dst);
-    
-    // Decompress
-    int result = inflate(&strm, Z_FINISH);
-    inflateEnd(&strm);
-    
-    if (result != Z_STREAM_END) {
-        return false;
-    }
-    
-    return true;
-}
+// Number of snapshots kept by the core, the rollback engine
+// keeps at most 8 prediction frames + 2 saved states around
+#define ROLLBACK_SNAPSHOT_COUNT 12
 
 // Get the current RNG state from the emulator
 static uint32_t GetEmulatorRngState() {
@@ -218,7 +175,7 @@ static uint32_t GetEmulatorRngState() {
 // State buffer pool to reduce memory allocations
 class StateBufferPool {
 public:
-    StateBufferPool(size_t bufferSize = 8 * 1024 * 1024, size_t maxBuffers = 4)
+    StateBufferPool(size_t bufferSize, size_t maxBuffers)
         : m_bufferSize(bufferSize), m_maxBuffers(maxBuffers)
     {
         // Pre-allocate at least one buffer
@@ -281,8 +238,36 @@ private:
     size_t m_maxBuffers;
 };
 
-// Global state buffer pool
-static StateBufferPool g_stateBufferPool;
+// Global state buffer pool, the emulator state itself
+// lives in the core's snapshot ring so the engine only
+// receives the header
+static StateBufferPool g_stateBufferPool(sizeof(RollbackStateHeader), ROLLBACK_SNAPSHOT_COUNT + 2);
+
+// Exact size of a full savestate, for metrics,
+// only known once the emulator is running
+static size_t g_fullStateSize = 0;
+
+// Hashes of the last saved frames, a frame can be saved
+// again by a rollback so the last save of it is kept,
+// they're dumped when a desync is detected
+#define ROLLBACK_HASH_HISTORY 128
+
+struct RollbackFrameHashes {
+    int frame = -1;
+    CoreStateSnapshotHashes hashes;
+};
+
+static std::array<RollbackFrameHashes, ROLLBACK_HASH_HISTORY> g_frameHashes;
+
+// Combines the snapshot hashes into the checksum
+// the rollback engine compares with the peers
+static uint32_t CombineSnapshotHashes(const CoreStateSnapshotHashes& hashes) {
+    uint32_t checksum = hashes.StateHash;
+    for (uint32_t hash : hashes.RdramHashes) {
+        checksum = ((checksum << 5) | (checksum >> 27)) ^ hash;
+    }
+    return checksum;
+}
 
 // Update the free function to use the buffer pool
 static void FreeEmulatorState(void* buffer) {
@@ -291,7 +276,7 @@ static void FreeEmulatorState(void* buffer) {
 
 static bool AdvanceEmulatorFrame()
 {
-    // This is called by GGPO when it's time to advance the emulator by one frame
+    // This is called by the engine after every started frame
     return true; // The actual advance happens in the emulation loop
 }
 
@@ -404,6 +389,19 @@ CORE_EXPORT bool CoreInitRollbackNetplay(std::string address, int port, int play
         return false;
     }
 
+    // Allocate the snapshot ring in the core
+    int codec = CoreSettingsGetIntValue(SettingsID::Netplay_RollbackStateCodec);
+    if (codec < static_cast<int>(CoreStateCodec::None) || codec > static_cast<int>(CoreStateCodec::LZ4)) {
+        codec = static_cast<int>(CoreStateCodec::LZ4);
+    }
+    g_stateMetrics.reset();
+    g_stateMetrics.codec = static_cast<CoreStateCodec>(codec);
+    g_fullStateSize = 0;
+    g_frameHashes.fill(RollbackFrameHashes());
+    if (!CoreInitSaveStateSnapshots(ROLLBACK_SNAPSHOT_COUNT, g_stateMetrics.codec)) {
+        return false;
+    }
+
     // Store player info
     l_RollbackLocalPlayer = player;
     l_RollbackMaxPlayers = maxPlayers;
@@ -418,12 +416,12 @@ CORE_EXPORT bool CoreInitRollbackNetplay(std::string address, int port, int play
         SaveEmulatorState,
         LoadEmulatorState,
         FreeEmulatorState,
-        AdvanceEmulatorFrame);
+        AdvanceEmulatorFrame,
+        DumpEmulatorDesync);
 
     // Initialize rollback
     int frameDelay = CoreSettingsGetIntValue(SettingsID::Netplay_RollbackFrameDelay);
     if (!l_RollbackNetplay->Initialize(address, port, player, maxPlayers, frameDelay)) {
-        CoreSetError("Failed to initialize rollback netplay");
         delete l_RollbackNetplay;
         l_RollbackNetplay = nullptr;
         return false;
@@ -461,6 +459,15 @@ CORE_EXPORT bool CoreRollbackNetplayAdvanceFrame(void)
     return l_RollbackNetplay->AdvanceFrame();
 }
 
+CORE_EXPORT bool CoreRollbackNetplayIsResimulating(void)
+{
+    if (!l_HasInitRollbackNetplay || !l_RollbackNetplay) {
+        return false;
+    }
+
+    return l_RollbackNetplay->IsResimulating();
+}
+
 CORE_EXPORT bool CoreRollbackNetplayAddLocalInput(const uint8_t* input)
 {
     if (!l_HasInitRollbackNetplay || !l_RollbackNetplay) {
@@ -485,7 +492,7 @@ CORE_EXPORT bool CoreRollbackNetplayApplyInputs(void)
         return false;
     }
 
-    // Get synchronized inputs from GGPO
+    // Get synchronized inputs from the rollback engine
     uint8_t inputs[ROLLBACK_INPUT_BYTES * 4]; // Max 4 players
     if (!l_RollbackNetplay->GetSynchronizedInputs(inputs)) {
         return false;
@@ -579,63 +586,46 @@ static bool SaveEmulatorState(void** buffer, int* len, int* checksum, int frame)
         return false;
     }
     
-    // Use the buffer directly for state saving
-    const size_t maxUncompressedSize = g_stateBufferPool.getBufferSize() - sizeof(RollbackStateHeader) - 1024; // Leave space for header and compression overhead
-    
-    // Save the emulator state to our buffer
-    m64p_error ret = m64p::Core.DoCommand(M64CMD_STATE_SAVE, maxUncompressedSize, stateBuffer + sizeof(RollbackStateHeader) + 1024);
-    if (ret != M64ERR_SUCCESS) {
+    // Save a snapshot which only holds the RDRAM pages
+    // changed since the previous one
+    size_t snapshotSize = 0;
+    size_t snapshotRawSize = 0;
+    uint32_t snapshotPages = 0;
+    RollbackFrameHashes& frameHashes = g_frameHashes[frame % ROLLBACK_HASH_HISTORY];
+    if (!CoreSaveStateSnapshot(static_cast<uint32_t>(frame), snapshotSize, snapshotRawSize, snapshotPages, &frameHashes.hashes)) {
         g_stateBufferPool.releaseBuffer(stateBuffer);
-        CoreSetError("Failed to save emulator state");
+        frameHashes.frame = -1;
         return false;
     }
+    frameHashes.frame = frame;
     
-    // Temporary buffer points to the start of the actual state data
-    uint8_t* tempBuffer = stateBuffer + sizeof(RollbackStateHeader) + 1024;
-    
-    // Find out how big the state actually is
-    size_t actualUncompressedSize = maxUncompressedSize;
-    for (size_t i = maxUncompressedSize; i > 0; i--) {
-        if (tempBuffer[i-1] != 0) {
-            actualUncompressedSize = i;
-            break;
-        }
+    // Track sizes for metrics
+    if (g_fullStateSize == 0) {
+        CoreGetSaveStateMemorySize(g_fullStateSize);
     }
-    
-    // Track uncompressed size for metrics
-    g_stateMetrics.totalUncompressedSize += actualUncompressedSize;
-    
-    // Compress the state in-place (use the free space we left at the beginning)
-    uint8_t* compressedDataStart = stateBuffer + sizeof(RollbackStateHeader);
-    int compressedSize = 1024; // Size of the buffer we reserved for compressed data
-    
-    if (!CompressData(tempBuffer, actualUncompressedSize, compressedDataStart, &compressedSize)) {
-        g_stateBufferPool.releaseBuffer(stateBuffer);
-        CoreSetError("Failed to compress state data");
-        return false;
-    }
-    
-    // Track compressed size for metrics
-    g_stateMetrics.totalCompressedSize += compressedSize;
+    g_stateMetrics.totalUncompressedSize += snapshotRawSize;
+    g_stateMetrics.totalCompressedSize += snapshotSize;
+    g_stateMetrics.totalFullStateSize += g_fullStateSize;
     
     // Set up the header
     RollbackStateHeader* header = reinterpret_cast<RollbackStateHeader*>(stateBuffer);
     header->magic = ROLLBACK_STATE_MAGIC;
     header->version = ROLLBACK_STATE_VERSION;
     header->frame = frame;
-    header->uncompressedSize = actualUncompressedSize;
-    header->compressedSize = compressedSize;
+    header->uncompressedSize = static_cast<uint32_t>(snapshotRawSize);
+    header->compressedSize = static_cast<uint32_t>(snapshotSize);
     header->randState = GetEmulatorRngState();
     header->inputSequence = g_currentInputSequence;
     header->reserved[0] = 0;
     header->reserved[1] = 0;
     
-    // Calculate checksum of the uncompressed data
-    *checksum = CalculateChecksum(tempBuffer, actualUncompressedSize);
+    // The core hashes the state while saving the snapshot,
+    // RDRAM pages are only hashed again when they changed
+    *checksum = static_cast<int>(CombineSnapshotHashes(frameHashes.hashes));
     
     // Set the output parameters
     *buffer = stateBuffer;
-    *len = sizeof(RollbackStateHeader) + compressedSize;
+    *len = sizeof(RollbackStateHeader);
     
     return true;
 }
@@ -646,7 +636,7 @@ static bool LoadEmulatorState(void* buffer, int len) {
     ScopedTimer timer(g_stateMetrics.totalLoadTimeNs);
     g_stateMetrics.loadCount++;
     
-    if (!buffer || len <= sizeof(RollbackStateHeader)) {
+    if (!buffer || len < static_cast<int>(sizeof(RollbackStateHeader))) {
         CoreSetError("Invalid state buffer or size");
         return false;
     }
@@ -665,44 +655,61 @@ static bool LoadEmulatorState(void* buffer, int len) {
         return false;
     }
     
-    // Verify the compressed size matches what we expect
-    if (header->compressedSize + sizeof(RollbackStateHeader) > len) {
-        CoreSetError("State buffer is smaller than expected");
-        return false;
-    }
-    
-    // Get a buffer from the pool for uncompressed data
-    uint8_t* uncompressedBuffer = g_stateBufferPool.getBuffer();
-    if (!uncompressedBuffer) {
-        CoreSetError("Failed to obtain buffer from pool for decompression");
-        return false;
-    }
-    
-    // Decompress the state
-    int uncompressedSize = header->uncompressedSize;
-    if (!DecompressData(
-            static_cast<uint8_t*>(buffer) + sizeof(RollbackStateHeader), 
-            header->compressedSize,
-            uncompressedBuffer,
-            uncompressedSize)) {
-        g_stateBufferPool.releaseBuffer(uncompressedBuffer);
-        CoreSetError("Failed to decompress state data");
-        return false;
-    }
-    
-    // Load the state into the emulator
-    m64p_error ret = m64p::Core.DoCommand(M64CMD_STATE_LOAD, header->uncompressedSize, uncompressedBuffer);
-    if (ret != M64ERR_SUCCESS) {
-        g_stateBufferPool.releaseBuffer(uncompressedBuffer);
-        CoreSetError("Failed to load emulator state");
+    // Restore the snapshot, the core reconstructs
+    // RDRAM from the newer snapshots
+    bool stateLost = false;
+    if (!CoreLoadStateSnapshot(header->frame, &stateLost)) {
+        // there's no full state to resynchronize from,
+        // the failed rollback stops the session instead
+        if (stateLost) {
+            CoreAddCallbackMessage(CoreDebugMessageType::Error,
+                "RollbackNetplay: Emulation state lost while rolling back to frame " + std::to_string(header->frame));
+        }
         return false;
     }
     
     // Update the global input sequence to match the loaded state
     g_currentInputSequence = header->inputSequence;
     
-    // Return the buffer to the pool
-    g_stateBufferPool.releaseBuffer(uncompressedBuffer);
-    
     return true;
-}
\ No newline at end of file
+}
+
+// Writes the hashes of the first divergent frame to a file, comparing
+// it with the file of the remote player shows which part of the state
+// differs, the remote player writes its file for the same frame
+static void DumpEmulatorDesync(int frame, int player) {
+    char message[256];
+    const RollbackFrameHashes& frameHashes = g_frameHashes[frame % ROLLBACK_HASH_HISTORY];
+
+    if (frameHashes.frame != frame) {
+        snprintf(message, sizeof(message),
+            "RollbackNetplay: Desync with player %d detected at frame %d, its hashes are gone",
+            player, frame);
+        CoreAddCallbackMessage(CoreDebugMessageType::Error, message);
+        return;
+    }
+
+    std::filesystem::path path = CoreGetUserDataDirectory();
+    path += "/RollbackDesync-P" + std::to_string(l_RollbackLocalPlayer) + "-F" + std::to_string(frame) + ".txt";
+
+    std::ofstream outputStream(path);
+    if (outputStream.is_open()) {
+        snprintf(message, sizeof(message), "frame %d, local player %d, remote player %d\n", frame, l_RollbackLocalPlayer, player);
+        outputStream << message;
+        snprintf(message, sizeof(message), "checksum %08X\nstate    %08X\n",
+            CombineSnapshotHashes(frameHashes.hashes), frameHashes.hashes.StateHash);
+        outputStream << message;
+
+        const uint32_t regionSize = 0x800000 / CORE_SNAPSHOT_RDRAM_REGIONS;
+        for (int i = 0; i < CORE_SNAPSHOT_RDRAM_REGIONS; i++) {
+            snprintf(message, sizeof(message), "rdram %08X-%08X %08X\n",
+                i * regionSize, (i + 1) * regionSize - 1, frameHashes.hashes.RdramHashes[i]);
+            outputStream << message;
+        }
+    }
+
+    snprintf(message, sizeof(message),
+        "RollbackNetplay: Desync with player %d detected at frame %d, hashes written to ",
+        player, frame);
+    CoreAddCallbackMessage(CoreDebugMessageType::Error, message + path.string());
+}
@@ -30,7 +30,8 @@ bool CoreHasInitNetplay(void);
 // Attempts to shutdown netplay
 bool CoreShutdownNetplay(void);
 
-// Attempts to initialize rollback netplay (GGPO-based)
+// Attempts to initialize rollback netplay, player N uses
+// UDP port + N - 1 so two instances can play over loopback
 bool CoreInitRollbackNetplay(std::string address, int port, int player, int maxPlayers);
 
 // Returns whether rollback netplay has been initialized
@@ -39,9 +40,13 @@ bool CoreHasInitRollbackNetplay(void);
 // Attempts to shutdown rollback netplay
 bool CoreShutdownRollbackNetplay(void);
 
-// Process network events and advance the GGPO frame when using rollback netplay
+// Process network events and start the next frame when using rollback netplay,
+// must be called before adding local inputs for the frame
 bool CoreRollbackNetplayAdvanceFrame(void);
 
+// Returns whether the current frame replays frames after a rollback
+bool CoreRollbackNetplayIsResimulating(void);
+
 // Adds local controller inputs to the rollback system
 bool CoreRollbackNetplayAddLocalInput(const uint8_t* input);
 
@@ -0,0 +1,257 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define CORE_INTERNAL
+#include "Directories.hpp"
+#include "Callback.hpp"
+#include "Prefetch.hpp"
+#include "Settings.hpp"
+#include "Library.hpp"
+#include "Cheats.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+
+//
+// Local Defines
+//
+
+// larger files are skipped, i.e texture packs,
+// because they'd only push the ROM out of the
+// file cache again
+#define PREFETCH_FILE_MAX_SIZE (512 * 1024 * 1024)
+#define PREFETCH_BUFFER_SIZE   (1024 * 1024)
+
+//
+// Local Structures
+//
+
+struct l_PrefetchDirectory
+{
+    std::filesystem::path Directory;
+    // files starting with the prefix are prefetched
+    std::string Prefix;
+};
+
+//
+// Local Variables
+//
+
+static std::thread       l_PrefetchThread;
+static std::atomic<bool> l_PrefetchCanceled = false;
+
+//
+// Local Functions
+//
+
+static std::string get_rom_name(const CoreRomHeader& header)
+{
+    std::string name = header.Name;
+
+    // the video plugin removes the trailing spaces
+    while (!name.empty() && (name.back() == ' ' || name.back() == '\0'))
+    {
+        name.pop_back();
+    }
+
+    return name;
+}
+
+static std::string get_save_file_name(const CoreRomHeader& header, const CoreRomSettings& settings)
+{
+    std::string headerName = get_rom_name(header);
+    std::string fileName;
+
+    // this has to match get_save_filename() in the core
+    while (!headerName.empty() && headerName.front() == ' ')
+    {
+        headerName.erase(headerName.begin());
+    }
+
+    if (CoreSettingsGetIntValue(SettingsID::CoreOverLay_SaveFileNameFormat) == 0)
+    {
+        fileName = headerName;
+    }
+    else if (settings.GoodName.find("(unknown rom)") == std::string::npos)
+    {
+        fileName = settings.GoodName.substr(0, 32) + "-" + settings.MD5.substr(0, 8);
+    }
+    else if (!headerName.empty())
+    {
+        fileName = headerName + "-" + settings.MD5.substr(0, 8);
+    }
+    else
+    {
+        fileName = "unknown-" + settings.MD5.substr(0, 8);
+    }
+
+    for (char& c : fileName)
+    {
+        if (std::strchr(":<>\"/\\|?*", c) != nullptr)
+        {
+            c = '_';
+        }
+    }
+
+    return fileName;
+}
+
+static void add_directory_files(const l_PrefetchDirectory& directory, std::vector<std::filesystem::path>& files)
+{
+    std::error_code errorCode;
+    std::filesystem::directory_iterator iterator(directory.Directory, errorCode);
+    std::filesystem::directory_iterator end;
+
+    for (; !errorCode && iterator != end; iterator.increment(errorCode))
+    {
+        std::string fileName = iterator->path().filename().string();
+        if (fileName.compare(0, directory.Prefix.size(), directory.Prefix) == 0)
+        {
+            files.push_back(iterator->path());
+        }
+    }
+}
+
+static bool prefetch_file(const std::filesystem::path& file, std::vector<char>& buffer, uint64_t& totalSize)
+{
+    std::error_code errorCode;
+    std::ifstream   inputStream;
+
+    uintmax_t fileSize = std::filesystem::file_size(file, errorCode);
+    if (errorCode || fileSize > PREFETCH_FILE_MAX_SIZE)
+    {
+        return false;
+    }
+
+    // reading the file is enough to keep
+    // it in the file cache for a while
+    inputStream.open(file, std::ios::binary);
+    while (inputStream.good() && !l_PrefetchCanceled)
+    {
+        inputStream.read(buffer.data(), buffer.size());
+        totalSize += inputStream.gcount();
+    }
+
+    return !l_PrefetchCanceled;
+}
+
+static void prefetch_thread(std::vector<std::filesystem::path> files, std::vector<l_PrefetchDirectory> directories)
+{
+    std::vector<char> buffer(PREFETCH_BUFFER_SIZE);
+    uint64_t totalSize = 0;
+    size_t   fileCount = 0;
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    for (const l_PrefetchDirectory& directory : directories)
+    {
+        add_directory_files(directory, files);
+    }
+
+    for (const std::filesystem::path& file : files)
+    {
+        if (l_PrefetchCanceled)
+        {
+            return;
+        }
+
+        if (prefetch_file(file, buffer, totalSize))
+        {
+            fileCount++;
+        }
+    }
+
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+
+    char message[256];
+    snprintf(message, sizeof(message), "CorePrefetchRom: prefetched %zu files (%.1f MiB) in %lld ms",
+             fileCount, (double)totalSize / (1024 * 1024), (long long)duration.count());
+    CoreAddCallbackMessage(CoreDebugMessageType::Verbose, message);
+}
+
+//
+// Exported Functions
+//
+
+CORE_EXPORT bool CorePrefetchRom(std::filesystem::path file, CoreRomHeader header, CoreRomSettings settings)
+{
+    std::vector<std::filesystem::path> files;
+    std::vector<l_PrefetchDirectory>   directories;
+    std::filesystem::path sharedCheatFile;
+    std::filesystem::path userCheatFile;
+
+    CoreStopPrefetch();
+
+    // the ROM is what's read first, so it goes first
+    files.push_back(file);
+
+    // the settings have to be read here, because
+    // they can't be read from another thread, the
+    // directories are listed by the prefetch thread
+    if (settings.MD5.size() == 32)
+    {
+        std::string saveFileName = get_save_file_name(header, settings);
+        for (const char* extension : { ".eep", ".sra", ".fla", ".mpk" })
+        {
+            std::filesystem::path saveFile = CoreGetSaveDirectory();
+            saveFile += CORE_DIR_SEPERATOR_STR;
+            saveFile += saveFileName + extension;
+            files.push_back(saveFile);
+        }
+
+        CoreGetCheatFilePaths(header, settings, sharedCheatFile, userCheatFile);
+        files.push_back(sharedCheatFile);
+        files.push_back(userCheatFile);
+    }
+
+    // the caches of GLideN64 are named after the ROM name,
+    // the shader cache uses the hash of the ROM name
+    std::string romName = get_rom_name(header);
+    if (!romName.empty())
+    {
+        char shaderPrefix[32];
+        snprintf(shaderPrefix, sizeof(shaderPrefix), "GLideN64.%x.", (uint32_t)std::hash<std::string>()(romName));
+
+        std::filesystem::path shaderDirectory = CoreGetUserCacheDirectory();
+        shaderDirectory += CORE_DIR_SEPERATOR_STR;
+        shaderDirectory += "shaders";
+        directories.push_back({ shaderDirectory, shaderPrefix });
+
+        std::string textureCacheDirectory = CoreSettingsGetStringValue("Video-GLideN64", "txCachePath");
+        if (!textureCacheDirectory.empty())
+        {
+            std::string texturePrefix = romName + "_";
+            std::replace(texturePrefix.begin(), texturePrefix.end(), ':', '-');
+            std::replace(texturePrefix.begin(), texturePrefix.end(), '/', '-');
+            directories.push_back({ textureCacheDirectory, texturePrefix });
+        }
+    }
+
+    l_PrefetchCanceled = false;
+    l_PrefetchThread = std::thread(prefetch_thread, std::move(files), std::move(directories));
+    return true;
+}
+
+CORE_EXPORT void CoreStopPrefetch(void)
+{
+    if (!l_PrefetchThread.joinable())
+    {
+        return;
+    }
+
+    l_PrefetchCanceled = true;
+    l_PrefetchThread.join();
+}
@@ -0,0 +1,30 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_PREFETCH_HPP
+#define CORE_PREFETCH_HPP
+
+#include "RomHeader.hpp"
+#include "RomSettings.hpp"
+
+#include <filesystem>
+
+// reads the given ROM and the files which are read
+// when it's started (save files, cheat files and the
+// caches of the video plugin) in the background, so
+// they're in the file cache of the operating system
+// when the ROM is started, a prefetch which is still
+// running is canceled
+bool CorePrefetchRom(std::filesystem::path file, CoreRomHeader header, CoreRomSettings settings);
+
+// cancels the running prefetch
+// and waits for it to stop
+void CoreStopPrefetch(void);
+
+#endif // CORE_PREFETCH_HPP
@@ -9,154 +9,369 @@
  */
 #define CORE_INTERNAL
 #include "RollbackNetplay.hpp"
+#include "Callback.hpp"
 #include "Error.hpp"
-#include "Library.hpp"
 
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include <algorithm>
 #include <chrono>
 #include <thread>
-#include <mutex>
+#include <random>
 #include <cstring>
+#include <array>
 #include <vector>
-#include <iostream>
 
-// Constants for GGPO flags not defined in the GGPO header
-#define GGPO_RUNFLAG_ROLLBACK 1
+// Number of frames kept in the input queues, must be
+// a lot larger than the prediction window
+#define ROLLBACK_INPUT_QUEUE_SIZE 128
+
+// Number of saved states, enough to roll back over
+// the whole prediction window
+#define ROLLBACK_STATE_RING_SIZE (ROLLBACK_MAX_PREDICTION_FRAMES + 2)
+
+// Number of frames kept in the checksum histories, they're
+// compared once the checksums of both sides have arrived
+#define ROLLBACK_CHECKSUM_HISTORY 128
+
+// Packets
+#define ROLLBACK_PACKET_MAGIC 0x5242 // "RB"
+#define ROLLBACK_PACKET_SIZE 1200
+#define ROLLBACK_PACKET_MAX_INPUTS 32
+#define ROLLBACK_PACKET_MAX_CHECKSUMS 16
 
-// Forward declaration
-class RollbackNetplayImpl;
+// Timeouts and intervals in milliseconds
+#define ROLLBACK_SYNC_TIMEOUT 30000
+#define ROLLBACK_SYNC_INTERVAL 200
+#define ROLLBACK_DISCONNECT_TIMEOUT 3000
+#define ROLLBACK_QUALITY_INTERVAL 1000
 
-// Implementation class to hide GGPO details
-class RollbackNetplayImpl 
+// Time sync
+#define ROLLBACK_TIMESYNC_WINDOW 40
+#define ROLLBACK_FRAME_TIME_US 16667
+
+enum class RollbackPacketType : uint8_t
 {
-public:
-    RollbackNetplayImpl() : 
-        ggpoSession(nullptr),
-        localPlayer(0),
-        maxPlayers(0),
-        initialized(false),
-        currentFrame(0),
-        currentInputSequence(0),
-        lastSavedFrameInputSequence(0),
-        saveStateFn(nullptr),
-        loadStateFn(nullptr),
-        freeStateFn(nullptr),
-        advanceFrameFn(nullptr)
-    {
-        // Initialize metrics directly instead of calling Reset()
-        metrics.rollbackFrames = 0;
-        metrics.totalRollbacks = 0;
-        metrics.predictedFrames = 0;
-        metrics.maxRollbackFrames = 0;
-        metrics.avgRollbackFrames = 0.0f;
-        metrics.pingMs = 0;
-        metrics.remoteFrameAdvantage = 0;
+    SyncRequest = 1,
+    SyncReply,
+    Input,
+    QualityReport,
+    QualityReply,
+    Checksum,
+    DesyncReport
+};
+
+//
+// Local Functions
+//
+
+static int64_t get_time_ms(void)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void put_u8(std::vector<uint8_t>& packet, uint8_t value)
+{
+    packet.push_back(value);
+}
+
+static void put_u16(std::vector<uint8_t>& packet, uint16_t value)
+{
+    packet.push_back(value & 0xff);
+    packet.push_back(value >> 8);
+}
+
+static void put_u32(std::vector<uint8_t>& packet, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        packet.push_back((value >> (i * 8)) & 0xff);
     }
+}
 
-    ~RollbackNetplayImpl()
+static uint32_t get_u32(const uint8_t* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+//
+// UDP socket
+//
+
+class RollbackSocket
+{
+public:
+    ~RollbackSocket()
     {
-        Shutdown();
+        Close();
     }
 
-    // GGPO callbacks
-    static bool BeginGame_Callback(const char* game)
+    bool Open(int port)
     {
-        // Simply return true to allow the game to start
+#ifdef _WIN32
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+            return false;
+        }
+        wsaStarted = true;
+#endif // _WIN32
+
+        handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (!IsOpen()) {
+            Close();
+            return false;
+        }
+
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<uint16_t>(port));
+
+        if (bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            Close();
+            return false;
+        }
+
+        // the emulation thread must never block on the socket
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        if (ioctlsocket(handle, FIONBIO, &nonBlocking) != 0) {
+#else
+        if (fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) != 0) {
+#endif // _WIN32
+            Close();
+            return false;
+        }
+
         return true;
     }
 
-    static bool SaveGameState_Callback(unsigned char** buffer, int* len, int* checksum, int frame)
+    void Close()
     {
-        auto instance = GetInstance();
-        if (!instance || !instance->saveStateFn)
-            return false;
-            
-        // Track the current input sequence
-        instance->lastSavedFrameInputSequence = instance->currentInputSequence;
-        
-        return instance->saveStateFn((void**)buffer, len, checksum, frame);
+        if (IsOpen()) {
+#ifdef _WIN32
+            closesocket(handle);
+#else
+            close(handle);
+#endif // _WIN32
+        }
+        handle = invalidHandle;
+
+#ifdef _WIN32
+        if (wsaStarted) {
+            WSACleanup();
+            wsaStarted = false;
+        }
+#endif // _WIN32
     }
 
-    static bool LoadGameState_Callback(unsigned char* buffer, int len)
+    bool SendTo(const sockaddr_in& address, const std::vector<uint8_t>& packet)
     {
-        auto instance = GetInstance();
-        if (!instance || !instance->loadStateFn)
-            return false;
-            
-        return instance->loadStateFn(buffer, len);
+        return sendto(handle, reinterpret_cast<const char*>(packet.data()), static_cast<int>(packet.size()), 0,
+                      reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == static_cast<int>(packet.size());
     }
 
-    static void FreeBuffer_Callback(void* buffer)
+    // Returns the packet size, or -1 when there's no packet
+    int Receive(uint8_t* data, int size, sockaddr_in& from)
     {
-        auto instance = GetInstance();
-        if (instance && instance->freeStateFn)
-            instance->freeStateFn(buffer);
+        socklen_t fromSize = sizeof(from);
+        int ret = recvfrom(handle, reinterpret_cast<char*>(data), size, 0,
+                           reinterpret_cast<sockaddr*>(&from), &fromSize);
+        return ret < 0 ? -1 : ret;
     }
 
-    static bool AdvanceFrame_Callback(int)
+    static bool Resolve(const std::string& host, int port, sockaddr_in& address)
     {
-        auto instance = GetInstance();
-        if (!instance || !instance->advanceFrameFn)
+        addrinfo hints;
+        addrinfo* result = nullptr;
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
             return false;
-            
-        // Increment frame counter
-        instance->currentFrame++;
-        
-        return instance->advanceFrameFn();
+        }
+
+        memcpy(&address, result->ai_addr, sizeof(address));
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        freeaddrinfo(result);
+        return true;
     }
 
-    // Add a flag for rollback event detection
-    bool rollbackJustOccurred = false;
+private:
+#ifdef _WIN32
+    typedef SOCKET socket_t;
+    static constexpr socket_t invalidHandle = INVALID_SOCKET;
+    bool wsaStarted = false;
+#else
+    typedef int socket_t;
+    static constexpr socket_t invalidHandle = -1;
+#endif // _WIN32
+    socket_t handle = invalidHandle;
 
-    // Add a method to check if rollback just occurred
-    bool RollbackJustOccurred() {
-        bool result = rollbackJustOccurred;
-        rollbackJustOccurred = false;
-        return result;
+    bool IsOpen() const
+    {
+        return handle != invalidHandle;
     }
+};
 
-    // Modify the OnEvent callback to detect rollbacks
-    static bool OnEvent_Callback(GGPOEvent* event) {
-        auto instance = GetInstance();
-        if (!instance) {
-            return true;
+//
+// Input queue of a single player
+//
+
+class RollbackInputQueue
+{
+public:
+    void Reset()
+    {
+        confirmedFrame = -1;
+        lastUsedFrame = -1;
+        incorrectFrame = -1;
+        memset(inputs, 0, sizeof(inputs));
+        memset(used, 0, sizeof(used));
+    }
+
+    // Adds the confirmed input of a frame, inputs must be added in order
+    void Confirm(int frame, const uint8_t* input)
+    {
+        if (frame != confirmedFrame + 1) {
+            return;
         }
-        
-        // Update metrics based on the event
-        instance->UpdateMetrics(event);
-        
-        // Check for events that might indicate rollback
-        // Note: In the current version of GGPO, there's no direct 'running.flags' to check for rollback
-        // Instead, we'll rely on frame discrepancies during various events to detect rollback
-        if (event->code == GGPO_EVENTCODE_TIMESYNC) {
-            // TimeSyncing can indicate a potential rollback when frames_ahead > 0
-            if (event->u.timesync.frames_ahead > 0) {
-                // We're likely rolling back due to time sync issues
-                int rollbackFrames = event->u.timesync.frames_ahead;
-                
-                if (rollbackFrames > 0) {
-                    // Set the rollback occurred flag
-                    instance->rollbackJustOccurred = true;
-                    
-                    instance->metrics.rollbackFrames += rollbackFrames;
-                    instance->metrics.totalRollbacks++;
-                    
-                    // Update max rollback frames
-                    if (rollbackFrames > instance->metrics.maxRollbackFrames) {
-                        instance->metrics.maxRollbackFrames = rollbackFrames;
-                    }
-                    
-                    // Update average
-                    instance->metrics.avgRollbackFrames = 
-                        (float)instance->metrics.rollbackFrames / instance->metrics.totalRollbacks;
-                    
-                    std::cout << "ROLLBACK: " << rollbackFrames << " frames (max: " 
-                              << instance->metrics.maxRollbackFrames 
-                              << ", avg: " << instance->metrics.avgRollbackFrames << ")" << std::endl;
-                }
-            }
+
+        memcpy(inputs[frame % ROLLBACK_INPUT_QUEUE_SIZE], input, ROLLBACK_INPUT_BYTES);
+        confirmedFrame = frame;
+
+        // the frame was emulated with a prediction which turned out wrong
+        if (frame <= lastUsedFrame &&
+            memcmp(used[frame % ROLLBACK_INPUT_QUEUE_SIZE], input, ROLLBACK_INPUT_BYTES) != 0 &&
+            (incorrectFrame < 0 || frame < incorrectFrame)) {
+            incorrectFrame = frame;
         }
-        
-        return true;
+    }
+
+    // Returns the input for frame, predicted by repeating
+    // the last confirmed input when it isn't known yet
+    const uint8_t* Get(int frame) const
+    {
+        static const uint8_t noInput[ROLLBACK_INPUT_BYTES] = {0};
+
+        if (frame <= confirmedFrame) {
+            return inputs[frame % ROLLBACK_INPUT_QUEUE_SIZE];
+        }
+
+        return confirmedFrame >= 0 ? inputs[confirmedFrame % ROLLBACK_INPUT_QUEUE_SIZE] : noInput;
+    }
+
+    // Records the input frame has been emulated with
+    void Use(int frame, const uint8_t* input)
+    {
+        memcpy(used[frame % ROLLBACK_INPUT_QUEUE_SIZE], input, ROLLBACK_INPUT_BYTES);
+        lastUsedFrame = frame;
+    }
+
+    // Forgets the frames from frame on, they'll be emulated again
+    void Rewind(int frame)
+    {
+        lastUsedFrame = frame - 1;
+        incorrectFrame = -1;
+    }
+
+    int ConfirmedFrame() const
+    {
+        return confirmedFrame;
+    }
+
+    int IncorrectFrame() const
+    {
+        return incorrectFrame;
+    }
+
+private:
+    int confirmedFrame = -1;
+    int lastUsedFrame = -1;
+    int incorrectFrame = -1;
+    uint8_t inputs[ROLLBACK_INPUT_QUEUE_SIZE][ROLLBACK_INPUT_BYTES];
+    uint8_t used[ROLLBACK_INPUT_QUEUE_SIZE][ROLLBACK_INPUT_BYTES];
+};
+
+//
+// Checksum of the state at the start of a frame
+//
+
+struct RollbackChecksum
+{
+    int frame = -1;
+    uint32_t checksum = 0;
+};
+
+//
+// Remote player connection
+//
+
+struct RollbackPeer
+{
+    int player = 0;
+    sockaddr_in address;
+    bool synchronized = false;
+    int64_t lastReceiveTime = 0;
+    int64_t lastQualityTime = 0;
+
+    // last local input frame the peer has confirmed
+    int ackFrame = -1;
+
+    // frame the peer was at in its last input packet
+    // and its frame advantage over us
+    int remoteFrame = 0;
+    int remoteAdvantage = 0;
+
+    int pingMs = 0;
+
+    // frame advantage history for time sync
+    std::array<int, ROLLBACK_TIMESYNC_WINDOW> localAdvantages{};
+    std::array<int, ROLLBACK_TIMESYNC_WINDOW> remoteAdvantages{};
+
+    // checksums received from the peer, and the newest
+    // local checksum frame sent to it
+    std::array<RollbackChecksum, ROLLBACK_CHECKSUM_HISTORY> checksums{};
+    int checksumSentFrame = -1;
+};
+
+//
+// Saved emulator state
+//
+
+struct RollbackSavedState
+{
+    int frame = -1;
+    void* buffer = nullptr;
+    int len = 0;
+    int checksum = 0;
+};
+
+// Implementation class, hides the networking details
+class RollbackNetplayImpl
+{
+public:
+    RollbackNetplayImpl()
+    {
+        metrics.Reset();
+    }
+
+    ~RollbackNetplayImpl()
+    {
+        Shutdown();
     }
 
     bool Initialize(const std::string& address, int port, int player, int numPlayers, int frameDelay)
@@ -165,107 +380,86 @@ public:
             return true;
         }
 
-        // Set up the instance for callbacks
-        if (instancePtr) {
-            CoreSetError("RollbackNetplay: Another instance is already active");
+        if (player < 1 || player > numPlayers || numPlayers > ROLLBACK_MAX_PLAYERS) {
+            CoreSetError("RollbackNetplay: Invalid player number");
+            return false;
+        }
+
+        if (frameDelay < 0 || frameDelay > ROLLBACK_MAX_PREDICTION_FRAMES) {
+            CoreSetError("RollbackNetplay: Invalid frame delay");
             return false;
         }
-        instancePtr = this;
 
-        // Store parameters
         localPlayer = player;
         maxPlayers = numPlayers;
 
-        // Set up GGPO callbacks
-        GGPOSessionCallbacks callbacks;
-        memset(&callbacks, 0, sizeof(callbacks));
-        callbacks.begin_game = BeginGame_Callback;
-        callbacks.save_game_state = SaveGameState_Callback;
-        callbacks.load_game_state = LoadGameState_Callback;
-        callbacks.free_buffer = FreeBuffer_Callback;
-        callbacks.advance_frame = AdvanceFrame_Callback;
-        callbacks.on_event = OnEvent_Callback;
-
-        // Start the session
-        GGPOErrorCode result = ggpo_start_session(
-            &ggpoSession,
-            &callbacks,
-            "mupen64plus",
-            maxPlayers,
-            ROLLBACK_INPUT_BYTES,
-            port);
-
-        if (result != GGPO_OK) {
-            CoreSetError("RollbackNetplay: Failed to start GGPO session");
-            instancePtr = nullptr;
+        if (!socket.Open(port + localPlayer - 1)) {
+            CoreSetError("RollbackNetplay: Failed to open UDP port " + std::to_string(port + localPlayer - 1));
             return false;
         }
 
-        // Set synchronization parameters
-        ggpo_set_disconnect_timeout(ggpoSession, 3000);
-        ggpo_set_disconnect_notify_start(ggpoSession, 1000);
-
-        // Add players
-        for (int i = 0; i < maxPlayers; i++) {
-            GGPOPlayer ggpoPlayer;
-            memset(&ggpoPlayer, 0, sizeof(ggpoPlayer));
-            ggpoPlayer.size = sizeof(GGPOPlayer);
-            ggpoPlayer.player_num = i + 1;
-
-            if (i + 1 == localPlayer) {
-                // Local player
-                ggpoPlayer.type = GGPO_PLAYERTYPE_LOCAL;
-                result = ggpo_add_player(ggpoSession, &ggpoPlayer, &localPlayerHandle);
-            } else {
-                // Remote player
-                ggpoPlayer.type = GGPO_PLAYERTYPE_REMOTE;
-                strncpy(ggpoPlayer.u.remote.ip_address, address.c_str(), sizeof(ggpoPlayer.u.remote.ip_address) - 1);
-                ggpoPlayer.u.remote.port = port;
-                result = ggpo_add_player(ggpoSession, &ggpoPlayer, &remotePlayerHandles[i]);
+        peers.clear();
+        for (int i = 1; i <= maxPlayers; i++) {
+            if (i == localPlayer) {
+                continue;
             }
 
-            if (result != GGPO_OK) {
-                std::string error = "RollbackNetplay: Failed to add player " + std::to_string(i + 1);
-                CoreSetError(error);
-                ggpo_close_session(ggpoSession);
-                ggpoSession = nullptr;
-                instancePtr = nullptr;
+            RollbackPeer peer;
+            peer.player = i;
+            if (!RollbackSocket::Resolve(address, port + i - 1, peer.address)) {
+                CoreSetError("RollbackNetplay: Failed to resolve " + address);
+                socket.Close();
                 return false;
             }
+            peers.push_back(peer);
         }
 
-        // Set frame delay for local player to reduce perceived input lag
-        result = ggpo_set_frame_delay(ggpoSession, localPlayerHandle, frameDelay);
-        if (result != GGPO_OK) {
-            CoreSetError("RollbackNetplay: Failed to set frame delay");
-            ggpo_close_session(ggpoSession);
-            ggpoSession = nullptr;
-            instancePtr = nullptr;
-            return false;
+        for (auto& queue : queues) {
+            queue.Reset();
         }
 
-        initialized = true;
+        // the first frames have no local input because of the delay,
+        // they're sent to the peers like any other input
+        uint8_t noInput[ROLLBACK_INPUT_BYTES] = {0};
+        for (int i = 0; i < frameDelay; i++) {
+            queues[localPlayer - 1].Confirm(i, noInput);
+        }
+
+        std::random_device random;
+        syncNonce = random();
+
+        localChecksums.fill(RollbackChecksum());
+        savedChecksums.fill(RollbackChecksum());
+        checksumFrame = -1;
+        desyncFrame = -1;
+
+        inputDelay = frameDelay;
         currentFrame = 0;
-        
-        std::cout << "RollbackNetplay: Initialized successfully!" << std::endl;
+        resimTargetFrame = 0;
+        frameStarted = false;
+        resimulating = false;
+        synchronized = false;
+        rollbackJustOccurred = false;
+        sleepCooldown = 0;
+        metrics.Reset();
+
+        initialized = true;
         return true;
     }
 
     void Shutdown()
     {
-        if (initialized && ggpoSession != nullptr) {
-            ggpo_close_session(ggpoSession);
-            ggpoSession = nullptr;
-            initialized = false;
-            currentFrame = 0;
-            
-            // Reset the static instance pointer if it's pointing to this instance
-            if (instancePtr == this) {
-                instancePtr = nullptr;
-            }
-            
-            std::cout << "RollbackNetplay: Session closed" << std::endl;
+        if (!initialized) {
+            return;
         }
+
+        for (auto& state : states) {
+            FreeState(state);
+        }
+
+        socket.Close();
+        peers.clear();
+        initialized = false;
     }
 
     bool IsInitialized() const
@@ -273,53 +467,102 @@ public:
         return initialized;
     }
 
-    bool AddLocalInput(const uint8_t* input)
+    bool IsResimulating() const
     {
-        if (!initialized || !ggpoSession) {
+        return resimulating;
+    }
+
+    bool AdvanceFrame()
+    {
+        if (!initialized) {
+            return false;
+        }
+
+        if (frameStarted) {
+            currentFrame++;
+            frameStarted = false;
+        }
+
+        ReceivePackets();
+
+        if (!synchronized && !WaitForPeers()) {
+            return false;
+        }
+
+        if (!CheckPeers()) {
             return false;
         }
 
-        // Increment input sequence
-        currentInputSequence++;
+        if (!resimulating && !WaitForRemoteInputs()) {
+            return false;
+        }
 
-        // Convert input to the format expected by GGPO
-        GGPOErrorCode result = ggpo_add_local_input(
-            ggpoSession,
-            localPlayerHandle,
-            const_cast<void*>(static_cast<const void*>(input)),
-            ROLLBACK_INPUT_BYTES);
+        // roll back to the first frame which used a wrong prediction
+        int incorrectFrame = -1;
+        for (int i = 0; i < maxPlayers; i++) {
+            int frame = queues[i].IncorrectFrame();
+            if (frame >= 0 && (incorrectFrame < 0 || frame < incorrectFrame)) {
+                incorrectFrame = frame;
+            }
+        }
 
-        return (result == GGPO_OK);
+        if (incorrectFrame >= 0 && !Rollback(incorrectFrame)) {
+            return false;
+        }
+
+        resimulating = currentFrame < resimTargetFrame;
+
+        if (!resimulating) {
+            SyncTime();
+        }
+
+        if (!SaveState()) {
+            return false;
+        }
+
+        RecordChecksums();
+
+        if (!resimulating) {
+            SendInputs();
+        }
+
+        UpdateMetrics();
+
+        if (advanceFrameFn) {
+            advanceFrameFn();
+        }
+
+        return true;
     }
 
-    bool GetSynchronizedInputs(uint8_t* inputs)
+    bool AddLocalInput(const uint8_t* input)
     {
-        if (!initialized || !ggpoSession) {
+        if (!initialized) {
             return false;
         }
-        
-        // Get all player inputs synchronized by GGPO
-        GGPOErrorCode result = ggpo_synchronize_input(
-            ggpoSession,
-            inputs,
-            maxPlayers * ROLLBACK_INPUT_BYTES,
-            nullptr);
 
-        return (result == GGPO_OK);
+        // the local inputs of resimulated frames are already known
+        if (resimulating) {
+            return true;
+        }
+
+        queues[localPlayer - 1].Confirm(currentFrame + inputDelay, input);
+        return true;
     }
 
-    bool AdvanceFrame()
+    bool GetSynchronizedInputs(uint8_t* inputs)
     {
-        if (!initialized || !ggpoSession) {
+        if (!initialized) {
             return false;
         }
 
-        // Process GGPO's internal event queue to handle network events
-        GGPOErrorCode result = ggpo_advance_frame(ggpoSession);
-        if (result != GGPO_OK) {
-            return false;
+        for (int i = 0; i < maxPlayers; i++) {
+            const uint8_t* input = queues[i].Get(currentFrame);
+            memcpy(inputs + i * ROLLBACK_INPUT_BYTES, input, ROLLBACK_INPUT_BYTES);
+            queues[i].Use(currentFrame, inputs + i * ROLLBACK_INPUT_BYTES);
         }
-        
+
+        frameStarted = true;
         return true;
     }
 
@@ -327,127 +570,558 @@ public:
         bool (*saveState)(void** buffer, int* len, int* checksum, int frame),
         bool (*loadState)(void* buffer, int len),
         void (*freeState)(void* buffer),
-        bool (*advanceFrame)())
+        bool (*advanceFrame)(),
+        void (*desync)(int frame, int player))
     {
         saveStateFn = saveState;
         loadStateFn = loadState;
         freeStateFn = freeState;
         advanceFrameFn = advanceFrame;
+        desyncFn = desync;
+    }
+
+    bool RollbackJustOccurred()
+    {
+        bool result = rollbackJustOccurred;
+        rollbackJustOccurred = false;
+        return result;
     }
 
-    static RollbackNetplayImpl* GetInstance() {
-        return instancePtr;
+    RollbackNetplay::RollbackMetrics GetMetrics() const
+    {
+        return metrics;
     }
 
-    // Get the current input sequence number
-    uint32_t GetCurrentInputSequence() const {
-        return currentInputSequence;
+private:
+    //
+    // Networking
+    //
+
+    std::vector<uint8_t> CreatePacket(RollbackPacketType type)
+    {
+        std::vector<uint8_t> packet;
+        packet.reserve(ROLLBACK_PACKET_SIZE);
+        put_u16(packet, ROLLBACK_PACKET_MAGIC);
+        put_u8(packet, static_cast<uint8_t>(type));
+        put_u8(packet, static_cast<uint8_t>(localPlayer));
+        return packet;
     }
 
-    // Get the input sequence of the last saved frame (used for state info)
-    uint32_t GetLastSavedFrameInputSequence() const {
-        return lastSavedFrameInputSequence;
+    RollbackPeer* FindPeer(int player)
+    {
+        for (auto& peer : peers) {
+            if (peer.player == player) {
+                return &peer;
+            }
+        }
+        return nullptr;
     }
 
-    // Add a method to update metrics based on GGPO events
-    void UpdateMetrics(GGPOEvent* event) {
-        // Update metrics based on event type
-        switch (event->code) {
-            case GGPO_EVENTCODE_CONNECTION_INTERRUPTED:
-                // Network interrupted events could be tracked here
-                break;
-                
-            case GGPO_EVENTCODE_CONNECTION_RESUMED:
-                // Network resumed events could be tracked here
-                break;
-                
-            case GGPO_EVENTCODE_CONNECTED_TO_PEER:
-                metrics.Reset();
-                break;
-                
-            case GGPO_EVENTCODE_DISCONNECTED_FROM_PEER:
-                // Reset on disconnect
-                metrics.Reset();
-                break;
-                
-            case GGPO_EVENTCODE_TIMESYNC:
-                // Update frame advantage metrics
-                metrics.remoteFrameAdvantage = event->u.timesync.frames_ahead;
-                break;
-                
+    void ReceivePackets()
+    {
+        uint8_t data[ROLLBACK_PACKET_SIZE];
+        sockaddr_in from;
+        int size;
+
+        while ((size = socket.Receive(data, sizeof(data), from)) >= 0) {
+            if (size < 4 || (data[0] | (data[1] << 8)) != ROLLBACK_PACKET_MAGIC) {
+                continue;
+            }
+
+            RollbackPeer* peer = FindPeer(data[3]);
+            if (peer == nullptr) {
+                continue;
+            }
+
+            // follow the peer when its NAT mapping changes
+            peer->address = from;
+            peer->lastReceiveTime = get_time_ms();
+
+            HandlePacket(*peer, static_cast<RollbackPacketType>(data[2]), data + 4, size - 4);
+        }
+    }
+
+    void HandlePacket(RollbackPeer& peer, RollbackPacketType type, const uint8_t* data, int size)
+    {
+        switch (type) {
+            case RollbackPacketType::SyncRequest: {
+                if (size < 4) {
+                    break;
+                }
+                std::vector<uint8_t> reply = CreatePacket(RollbackPacketType::SyncReply);
+                put_u32(reply, get_u32(data));
+                socket.SendTo(peer.address, reply);
+            } break;
+
+            case RollbackPacketType::SyncReply: {
+                if (size >= 4 && get_u32(data) == syncNonce) {
+                    peer.synchronized = true;
+                }
+            } break;
+
+            case RollbackPacketType::Input: {
+                if (size < 17) {
+                    break;
+                }
+                int ackFrame = static_cast<int32_t>(get_u32(data));
+                int remoteFrame = static_cast<int32_t>(get_u32(data + 4));
+                int remoteAdvantage = static_cast<int32_t>(get_u32(data + 8));
+                int startFrame = static_cast<int32_t>(get_u32(data + 12));
+                int count = data[16];
+
+                if (size < 17 + count * ROLLBACK_INPUT_BYTES) {
+                    break;
+                }
+
+                if (ackFrame > peer.ackFrame) {
+                    peer.ackFrame = ackFrame;
+                }
+                peer.remoteFrame = remoteFrame;
+                peer.remoteAdvantage = remoteAdvantage;
+
+                RollbackInputQueue& queue = queues[peer.player - 1];
+                for (int i = 0; i < count; i++) {
+                    queue.Confirm(startFrame + i, data + 17 + i * ROLLBACK_INPUT_BYTES);
+                }
+            } break;
+
+            case RollbackPacketType::QualityReport: {
+                if (size < 4) {
+                    break;
+                }
+                std::vector<uint8_t> reply = CreatePacket(RollbackPacketType::QualityReply);
+                put_u32(reply, get_u32(data));
+                socket.SendTo(peer.address, reply);
+            } break;
+
+            case RollbackPacketType::QualityReply: {
+                if (size >= 4) {
+                    peer.pingMs = static_cast<int>(static_cast<uint32_t>(get_time_ms()) - get_u32(data));
+                }
+            } break;
+
+            case RollbackPacketType::Checksum: {
+                if (size < 1) {
+                    break;
+                }
+                int count = data[0];
+                if (size < 1 + count * 8) {
+                    break;
+                }
+
+                for (int i = 0; i < count; i++) {
+                    int frame = static_cast<int32_t>(get_u32(data + 1 + i * 8));
+                    if (frame < 0) {
+                        continue;
+                    }
+                    RollbackChecksum& checksum = peer.checksums[frame % ROLLBACK_CHECKSUM_HISTORY];
+                    checksum.frame = frame;
+                    checksum.checksum = get_u32(data + 5 + i * 8);
+                    CompareChecksum(peer, frame);
+                }
+            } break;
+
+            case RollbackPacketType::DesyncReport: {
+                if (size >= 4) {
+                    ReportDesync(peer, static_cast<int32_t>(get_u32(data)));
+                }
+            } break;
+
             default:
                 break;
         }
-        
-        // Request GGPO network stats to update ping
-        GGPONetworkStats stats;
-        if (ggpo_get_network_stats(ggpoSession, localPlayerHandle, &stats) == GGPO_OK) {
-            metrics.pingMs = stats.network.ping;
-            metrics.predictedFrames = stats.timesync.remote_frames_behind;
+    }
+
+    void SendInputs()
+    {
+        const RollbackInputQueue& localQueue = queues[localPlayer - 1];
+        int64_t time = get_time_ms();
+
+        for (auto& peer : peers) {
+            // resend everything the peer hasn't confirmed yet
+            int startFrame = peer.ackFrame + 1;
+            int count = std::min(localQueue.ConfirmedFrame() - peer.ackFrame, ROLLBACK_PACKET_MAX_INPUTS);
+            count = std::max(count, 0);
+
+            std::vector<uint8_t> packet = CreatePacket(RollbackPacketType::Input);
+            put_u32(packet, static_cast<uint32_t>(queues[peer.player - 1].ConfirmedFrame()));
+            put_u32(packet, static_cast<uint32_t>(currentFrame));
+            put_u32(packet, static_cast<uint32_t>(LocalAdvantage(peer)));
+            put_u32(packet, static_cast<uint32_t>(startFrame));
+            put_u8(packet, static_cast<uint8_t>(count));
+            for (int i = 0; i < count; i++) {
+                const uint8_t* input = localQueue.Get(startFrame + i);
+                packet.insert(packet.end(), input, input + ROLLBACK_INPUT_BYTES);
+            }
+            socket.SendTo(peer.address, packet);
+
+            // the newest checksums are sent every time new ones
+            // are known, so a lost packet only delays the comparison
+            if (checksumFrame > peer.checksumSentFrame) {
+                SendChecksums(peer);
+            }
+
+            if (time - peer.lastQualityTime >= ROLLBACK_QUALITY_INTERVAL) {
+                std::vector<uint8_t> report = CreatePacket(RollbackPacketType::QualityReport);
+                put_u32(report, static_cast<uint32_t>(time));
+                socket.SendTo(peer.address, report);
+                peer.lastQualityTime = time;
+            }
+        }
+    }
+
+    void SendChecksums(RollbackPeer& peer)
+    {
+        std::vector<uint8_t> packet = CreatePacket(RollbackPacketType::Checksum);
+        std::vector<const RollbackChecksum*> checksums;
+
+        for (int frame = std::max(checksumFrame - ROLLBACK_PACKET_MAX_CHECKSUMS + 1, 0); frame <= checksumFrame; frame++) {
+            const RollbackChecksum& checksum = localChecksums[frame % ROLLBACK_CHECKSUM_HISTORY];
+            if (checksum.frame == frame) {
+                checksums.push_back(&checksum);
+            }
+        }
+
+        put_u8(packet, static_cast<uint8_t>(checksums.size()));
+        for (const RollbackChecksum* checksum : checksums) {
+            put_u32(packet, static_cast<uint32_t>(checksum->frame));
+            put_u32(packet, checksum->checksum);
         }
+        socket.SendTo(peer.address, packet);
+
+        peer.checksumSentFrame = checksumFrame;
     }
 
-    // Add a method to get current metrics
-    RollbackNetplay::RollbackMetrics GetMetrics() const {
-        return metrics;
+    // Waits until every peer answered a sync request
+    bool WaitForPeers()
+    {
+        int64_t startTime = get_time_ms();
+        int64_t lastRequestTime = 0;
+
+        while (true) {
+            ReceivePackets();
+
+            bool allSynchronized = true;
+            for (auto& peer : peers) {
+                allSynchronized = allSynchronized && peer.synchronized;
+            }
+
+            int64_t time = get_time_ms();
+
+            // the peers' requests keep being answered by
+            // ReceivePackets(), in case our reply got lost
+            if (allSynchronized) {
+                for (auto& peer : peers) {
+                    peer.lastReceiveTime = time;
+                }
+                synchronized = true;
+                return true;
+            }
+
+            if (time - startTime >= ROLLBACK_SYNC_TIMEOUT) {
+                CoreSetError("RollbackNetplay: Timed out waiting for the other players");
+                return false;
+            }
+
+            if (time - lastRequestTime >= ROLLBACK_SYNC_INTERVAL) {
+                for (auto& peer : peers) {
+                    if (!peer.synchronized) {
+                        std::vector<uint8_t> request = CreatePacket(RollbackPacketType::SyncRequest);
+                        put_u32(request, syncNonce);
+                        socket.SendTo(peer.address, request);
+                    }
+                }
+                lastRequestTime = time;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
     }
 
-private:
-    // Static instance pointer for callbacks
-    static RollbackNetplayImpl* instancePtr;
+    bool CheckPeers()
+    {
+        int64_t time = get_time_ms();
+
+        for (auto& peer : peers) {
+            if (time - peer.lastReceiveTime >= ROLLBACK_DISCONNECT_TIMEOUT) {
+                CoreSetError("RollbackNetplay: Player " + std::to_string(peer.player) + " disconnected");
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Stalls while the remote inputs are further behind
+    // than the prediction window allows
+    bool WaitForRemoteInputs()
+    {
+        int64_t lastSendTime = 0;
+
+        while (true) {
+            bool ready = true;
+            for (auto& peer : peers) {
+                ready = ready && (currentFrame - queues[peer.player - 1].ConfirmedFrame() <= ROLLBACK_MAX_PREDICTION_FRAMES);
+            }
+
+            if (ready) {
+                return true;
+            }
+
+            // keep the peers informed while we wait,
+            // they might be waiting on us too
+            int64_t time = get_time_ms();
+            if (time - lastSendTime >= ROLLBACK_FRAME_TIME_US / 1000) {
+                SendInputs();
+                lastSendTime = time;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ReceivePackets();
+
+            if (!CheckPeers()) {
+                return false;
+            }
+        }
+    }
+
+    //
+    // Time sync
+    //
+
+    // Estimated frames the peer is ahead of us
+    int LocalAdvantage(const RollbackPeer& peer) const
+    {
+        int pingFrames = (peer.pingMs * 1000) / ROLLBACK_FRAME_TIME_US;
+        return (peer.remoteFrame + pingFrames / 2) - currentFrame;
+    }
+
+    // Sleeps for a frame when we're running ahead of a peer,
+    // which would make it roll back a lot more than us
+    void SyncTime()
+    {
+        int sleepFrames = 0;
+
+        for (auto& peer : peers) {
+            int index = currentFrame % ROLLBACK_TIMESYNC_WINDOW;
+            peer.localAdvantages[index] = LocalAdvantage(peer);
+            peer.remoteAdvantages[index] = peer.remoteAdvantage;
+
+            int localSum = 0;
+            int remoteSum = 0;
+            for (int i = 0; i < ROLLBACK_TIMESYNC_WINDOW; i++) {
+                localSum += peer.localAdvantages[i];
+                remoteSum += peer.remoteAdvantages[i];
+            }
+
+            float advantage = (float)localSum / ROLLBACK_TIMESYNC_WINDOW;
+            float remoteAdvantage = (float)remoteSum / ROLLBACK_TIMESYNC_WINDOW;
+            int frames = (int)((remoteAdvantage - advantage) / 2);
+            sleepFrames = std::max(sleepFrames, frames);
+        }
+
+        if (sleepCooldown > 0) {
+            sleepCooldown--;
+            return;
+        }
+
+        if (sleepFrames > 0) {
+            sleepFrames = std::min(sleepFrames, ROLLBACK_MAX_PREDICTION_FRAMES);
+            std::this_thread::sleep_for(std::chrono::microseconds(sleepFrames * ROLLBACK_FRAME_TIME_US));
+            // give the peer time to report the new advantage
+            sleepCooldown = ROLLBACK_TIMESYNC_WINDOW;
+        }
+    }
+
+    //
+    // States
+    //
+
+    void FreeState(RollbackSavedState& state)
+    {
+        if (state.buffer != nullptr && freeStateFn) {
+            freeStateFn(state.buffer);
+        }
+        state = RollbackSavedState();
+    }
+
+    bool SaveState()
+    {
+        RollbackSavedState& state = states[currentFrame % ROLLBACK_STATE_RING_SIZE];
+
+        // the state we just rolled back to is still there
+        if (state.frame == currentFrame) {
+            return true;
+        }
+
+        FreeState(state);
+
+        if (!saveStateFn || !saveStateFn(&state.buffer, &state.len, &state.checksum, currentFrame)) {
+            CoreSetError("RollbackNetplay: Failed to save state of frame " + std::to_string(currentFrame));
+            state = RollbackSavedState();
+            return false;
+        }
+
+        state.frame = currentFrame;
+
+        // resimulated frames overwrite the checksum of their
+        // mispredicted state, it's only final in RecordChecksums()
+        RollbackChecksum& checksum = savedChecksums[currentFrame % ROLLBACK_CHECKSUM_HISTORY];
+        checksum.frame = currentFrame;
+        checksum.checksum = static_cast<uint32_t>(state.checksum);
+        return true;
+    }
+
+    bool Rollback(int frame)
+    {
+        RollbackSavedState& state = states[frame % ROLLBACK_STATE_RING_SIZE];
+
+        if (state.frame != frame || !loadStateFn || !loadStateFn(state.buffer, state.len)) {
+            CoreSetError("RollbackNetplay: Failed to load state of frame " + std::to_string(frame));
+            return false;
+        }
+
+        int rollbackFrames = currentFrame - frame;
+
+        // the newer states are gone with the rollback
+        for (auto& newerState : states) {
+            if (newerState.frame > frame) {
+                FreeState(newerState);
+            }
+        }
+
+        for (int i = 0; i < maxPlayers; i++) {
+            queues[i].Rewind(frame);
+        }
+
+        resimTargetFrame = std::max(resimTargetFrame, currentFrame);
+        currentFrame = frame;
+
+        rollbackJustOccurred = true;
+        metrics.rollbackFrames += rollbackFrames;
+        metrics.totalRollbacks++;
+        metrics.maxRollbackFrames = std::max(metrics.maxRollbackFrames, rollbackFrames);
+        metrics.avgRollbackFrames = (float)metrics.rollbackFrames / metrics.totalRollbacks;
+        return true;
+    }
+
+    //
+    // Desync detection
+    //
+
+    // The state of a frame is final once the inputs of every
+    // earlier frame are confirmed, it can't be rolled back
+    // anymore so its checksum is compared with the peers'
+    void RecordChecksums()
+    {
+        int finalFrame = currentFrame;
+        for (int i = 0; i < maxPlayers; i++) {
+            finalFrame = std::min(finalFrame, queues[i].ConfirmedFrame() + 1);
+        }
+
+        // only advance past frames which have a checksum,
+        // so none of them is silently left out
+        for (int frame = checksumFrame + 1; frame <= finalFrame; frame++) {
+            const RollbackChecksum& saved = savedChecksums[frame % ROLLBACK_CHECKSUM_HISTORY];
+            if (saved.frame != frame) {
+                break;
+            }
+
+            localChecksums[frame % ROLLBACK_CHECKSUM_HISTORY] = saved;
+            checksumFrame = frame;
+
+            for (auto& peer : peers) {
+                CompareChecksum(peer, frame);
+            }
+        }
+    }
+
+    void CompareChecksum(RollbackPeer& peer, int frame)
+    {
+        const RollbackChecksum& local = localChecksums[frame % ROLLBACK_CHECKSUM_HISTORY];
+        const RollbackChecksum& remote = peer.checksums[frame % ROLLBACK_CHECKSUM_HISTORY];
+
+        if (local.frame == frame && remote.frame == frame && local.checksum != remote.checksum) {
+            ReportDesync(peer, frame);
+        }
+    }
+
+    void ReportDesync(RollbackPeer& peer, int frame)
+    {
+        // every frame after the first divergent one differs too
+        if (desyncFrame >= 0) {
+            return;
+        }
+        desyncFrame = frame;
+
+        // let the peer report the same frame, in case
+        // it hasn't received our checksum yet
+        std::vector<uint8_t> packet = CreatePacket(RollbackPacketType::DesyncReport);
+        put_u32(packet, static_cast<uint32_t>(frame));
+        socket.SendTo(peer.address, packet);
+
+        if (desyncFn) {
+            desyncFn(frame, peer.player);
+        }
+    }
+
+    void UpdateMetrics()
+    {
+        metrics.predictedFrames = 0;
+        metrics.pingMs = 0;
+        metrics.remoteFrameAdvantage = 0;
+
+        for (size_t i = 0; i < peers.size(); i++) {
+            const RollbackPeer& peer = peers[i];
+            int predicted = currentFrame - queues[peer.player - 1].ConfirmedFrame();
+            metrics.predictedFrames = std::max(metrics.predictedFrames, predicted);
+            metrics.pingMs = std::max(metrics.pingMs, peer.pingMs);
+            // advantages can be negative, so the first peer sets the start
+            metrics.remoteFrameAdvantage = (i == 0) ? peer.remoteAdvantage :
+                std::max(metrics.remoteFrameAdvantage, peer.remoteAdvantage);
+        }
+    }
+
+    RollbackSocket socket;
+    std::vector<RollbackPeer> peers;
+    std::array<RollbackInputQueue, ROLLBACK_MAX_PLAYERS> queues;
+    std::array<RollbackSavedState, ROLLBACK_STATE_RING_SIZE> states;
+
+    // Checksums of every saved state, including predicted ones
+    std::array<RollbackChecksum, ROLLBACK_CHECKSUM_HISTORY> savedChecksums;
+
+    // Checksums of the final states, the newest final
+    // frame and the first frame which differed
+    std::array<RollbackChecksum, ROLLBACK_CHECKSUM_HISTORY> localChecksums;
+    int checksumFrame = -1;
+    int desyncFrame = -1;
 
-    // GGPO session
-    GGPOSession* ggpoSession;
-    
     // Player info
-    int localPlayer;
-    int maxPlayers;
-    bool initialized;
-    int currentFrame;
-    
-    // Player handles
-    GGPOPlayerHandle localPlayerHandle;
-    GGPOPlayerHandle remotePlayerHandles[GGPO_MAX_PLAYERS - 1];
-    
+    int localPlayer = 0;
+    int maxPlayers = 0;
+    int inputDelay = 0;
+    bool initialized = false;
+    bool synchronized = false;
+    uint32_t syncNonce = 0;
+
+    // Frame being emulated, and the frame resimulation ends at
+    int currentFrame = 0;
+    int resimTargetFrame = 0;
+    bool frameStarted = false;
+    bool resimulating = false;
+    int sleepCooldown = 0;
+
     // Callback functions
-    bool (*saveStateFn)(void** buffer, int* len, int* checksum, int frame);
-    bool (*loadStateFn)(void* buffer, int len);
-    void (*freeStateFn)(void* buffer);
-    bool (*advanceFrameFn)();
-
-    // Input tracking for determinism
-    uint32_t currentInputSequence;
-    uint32_t lastSavedFrameInputSequence;
-
-    // Metrics tracking
-    struct RollbackMetrics {
-        int rollbackFrames;          // Number of frames rolled back
-        int totalRollbacks;          // Total number of rollback events
-        int predictedFrames;         // Frames that used predicted input
-        int maxRollbackFrames;       // Maximum rollback distance
-        float avgRollbackFrames;     // Average rollback distance
-        int pingMs;                  // Current ping in milliseconds
-        int remoteFrameAdvantage;    // Frame advantage of remote player
-        
-        // Reset metrics
-        void Reset() {
-            rollbackFrames = 0;
-            totalRollbacks = 0;
-            predictedFrames = 0;
-            maxRollbackFrames = 0;
-            avgRollbackFrames = 0.0f;
-            pingMs = 0;
-            remoteFrameAdvantage = 0;
-        }
-    };
-    
-    // Current metrics
+    bool (*saveStateFn)(void** buffer, int* len, int* checksum, int frame) = nullptr;
+    bool (*loadStateFn)(void* buffer, int len) = nullptr;
+    void (*freeStateFn)(void* buffer) = nullptr;
+    bool (*advanceFrameFn)() = nullptr;
+    void (*desyncFn)(int frame, int player) = nullptr;
+
+    bool rollbackJustOccurred = false;
     RollbackNetplay::RollbackMetrics metrics;
 };
 
-// Initialize static instance pointer
-RollbackNetplayImpl* RollbackNetplayImpl::instancePtr = nullptr;
-
 //
 // RollbackNetplay implementation (public interface)
 //
@@ -491,13 +1165,19 @@ bool RollbackNetplay::AdvanceFrame()
     return impl->AdvanceFrame();
 }
 
+bool RollbackNetplay::IsResimulating() const
+{
+    return impl->IsResimulating();
+}
+
 void RollbackNetplay::SetCallbacks(
     bool (*saveState)(void** buffer, int* len, int* checksum, int frame),
     bool (*loadState)(void* buffer, int len),
     void (*freeState)(void* buffer),
-    bool (*advanceFrame)())
+    bool (*advanceFrame)(),
+    void (*desync)(int frame, int player))
 {
-    impl->SetCallbacks(saveState, loadState, freeState, advanceFrame);
+    impl->SetCallbacks(saveState, loadState, freeState, advanceFrame, desync);
 }
 
 RollbackNetplay::RollbackMetrics RollbackNetplay::GetMetrics() const {
@@ -506,4 +1186,4 @@ RollbackNetplay::RollbackMetrics RollbackNetplay::GetMetrics() const {
 
 bool RollbackNetplay::RollbackJustOccurred() {
     return impl->RollbackJustOccurred();
-} 
\ No newline at end of file
+}
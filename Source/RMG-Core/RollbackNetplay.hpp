@@ -10,18 +10,9 @@
 #ifndef CORE_ROLLBACK_NETPLAY_HPP
 #define CORE_ROLLBACK_NETPLAY_HPP
 
-#include "m64p/Api.hpp"
 #include <string>
-#include <vector>
 #include <memory>
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-#include "ggponet.h"
-#ifdef __cplusplus
-}
-#endif
+#include <cstdint>
 
 // Default number of frames to predict ahead
 #define ROLLBACK_MAX_PREDICTION_FRAMES 8
@@ -29,10 +20,19 @@ extern "C" {
 // Number of bytes per player input - must be enough for ControllerInput structure
 #define ROLLBACK_INPUT_BYTES 32
 
+// Maximum number of players in a session
+#define ROLLBACK_MAX_PLAYERS 4
+
 // Forward declaration
 class RollbackNetplayImpl;
 
 // Main rollback netplay class
+//
+// Every frame, the emulator calls AdvanceFrame(), then AddLocalInput()
+// and GetSynchronizedInputs() and emulates the frame with the returned
+// inputs. Remote inputs which haven't arrived yet are predicted, when
+// they turn out to differ the state of the first mispredicted frame is
+// loaded and the following frames are emulated again (resimulated)
 class RollbackNetplay 
 {
 public:
@@ -44,7 +44,7 @@ public:
         int maxRollbackFrames;       // Maximum rollback distance
         float avgRollbackFrames;     // Average rollback distance
         int pingMs;                  // Current ping in milliseconds
-        int remoteFrameAdvantage;    // Frame advantage of remote player
+        int remoteFrameAdvantage;    // Highest frame advantage of the remote players
         
         // Reset metrics to default values
         void Reset() {
@@ -63,8 +63,9 @@ public:
     ~RollbackNetplay();
 
     // Initialize rollback netplay
-    // address: IP address of remote player
-    // port: Local port to use
+    // address: IP address or host name of the remote players
+    // port: Base UDP port, player N uses port + N - 1, so
+    //       two instances can play over loopback
     // player: Local player number (1-4)
     // maxPlayers: Total number of players
     // frameDelay: Number of frames to delay input (reduces rollbacks at cost of input lag)
@@ -76,7 +77,7 @@ public:
     // Returns whether rollback netplay is initialized
     bool IsInitialized() const;
     
-    // Add local input to the system
+    // Add local input to the system, ignored while resimulating
     // input: Controller input data from the emulator
     // Returns true if inputs were accepted
     bool AddLocalInput(const uint8_t* input);
@@ -86,19 +87,30 @@ public:
     // Returns true if inputs are valid
     bool GetSynchronizedInputs(uint8_t* inputs);
     
-    // Advance the frame in GGPO
+    // Start the next frame, processes network events,
+    // waits for remote players when too far ahead, rolls
+    // back on mispredictions and saves the frame's state
+    // Returns false when the session is lost
     bool AdvanceFrame();
+
+    // Returns whether the current frame is being resimulated
+    bool IsResimulating() const;
     
     // Set emulation callback functions
-    // saveState: Function to save emulator state
+    // saveState: Function to save emulator state, checksum receives a hash
+    //            of the state which is compared with the remote players'
+    //            once the inputs of every earlier frame are confirmed
     // loadState: Function to load emulator state
     // freeState: Function to free allocated state memory
-    // advanceFrame: Function to advance emulation frame
+    // advanceFrame: Function called after every started frame
+    // desync: Function called once with the first frame whose
+    //         checksum differs from a remote player's, and that player
     void SetCallbacks(
         bool (*saveState)(void** buffer, int* len, int* checksum, int frame), 
         bool (*loadState)(void* buffer, int len),
         void (*freeState)(void* buffer),
-        bool (*advanceFrame)());
+        bool (*advanceFrame)(),
+        void (*desync)(int frame, int player) = nullptr);
 
     // Get current rollback metrics
     RollbackMetrics GetMetrics() const;
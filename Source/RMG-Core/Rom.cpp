@@ -12,6 +12,7 @@
 #include "MediaLoader.hpp"
 #include "Directories.hpp"
 #include "RomSettings.hpp"
+#include "RomHeader.hpp"
 #include "m64p/Api.hpp"
 #include "Archive.hpp"
 #include "Library.hpp"
@@ -24,6 +25,9 @@
 #include <string>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
+#include <climits>
+#include <fstream>
 
 //
 // Local Variables
@@ -31,10 +35,31 @@
 
 static bool l_HasRomOpen       = false;
 static bool l_HasDisk          = false;
-static bool l_HasExtractedDisk = false;
-static std::filesystem::path l_ExtractedDiskPath;
 static std::filesystem::path l_RomPath;
 
+//
+// Local Functions
+//
+
+static int probe_read_archive(void* context, unsigned char* buffer, int length)
+{
+    size_t bytesRead = 0;
+
+    if (!CoreReadArchiveStream((CoreArchiveStream*)context, buffer, length, bytesRead))
+    {
+        return -1;
+    }
+
+    return (int)bytesRead;
+}
+
+static int probe_read_file(void* context, unsigned char* buffer, int length)
+{
+    std::ifstream* fileStream = (std::ifstream*)context;
+    fileStream->read((char*)buffer, length);
+    return (int)fileStream->gcount();
+}
+
 //
 // Exported Functions
 //
@@ -42,9 +67,9 @@ static std::filesystem::path l_RomPath;
 CORE_EXPORT bool CoreOpenRom(std::filesystem::path file)
 {
     std::string error;
-    std::error_code error_code;
     m64p_error  ret;
     std::vector<char> buf;
+    CoreMappedFile mapped_file;
     std::string file_extension;
 
     if (!m64p::Core.IsHooked())
@@ -66,64 +91,60 @@ CORE_EXPORT bool CoreOpenRom(std::filesystem::path file)
     if (file_extension == ".zip" || 
         file_extension == ".7z")
     {
-        std::filesystem::path extracted_file;
-        bool                  is_disk = false;
+        CoreArchiveStream*  stream;
+        CoreArchiveFileInfo info;
 
-        if (!CoreReadArchiveFile(file, extracted_file, is_disk, buf))
+        if (!CoreOpenArchiveStream(file, stream, info))
         {
             return false;
         }
 
-        if (is_disk)
+        if (info.IsDisk)
         {
             std::filesystem::path disk_file;
-            disk_file = CoreGetUserCacheDirectory();
-            disk_file += "/extracted_disks/";
-            disk_file += extracted_file.filename();
 
-            // attempt to create extraction directory
-            if (!std::filesystem::exists(disk_file.parent_path(), error_code) &&
-                !std::filesystem::create_directory(disk_file.parent_path(), error_code))
+            CoreCloseArchiveStream(stream);
+
+            // disks are extracted into a cache,
+            // so they're only extracted once
+            if (!CoreExtractArchiveDisk(file, disk_file))
             {
-                error = "CoreOpenRom Failed: ";
-                error += "Failed to create \"";
-                error += disk_file.parent_path().string();
-                error += "\": ";
-                error += error_code.message();
-                CoreSetError(error);
                 return false;
             }
 
-            // attempt to write temporary file
-            if (!CoreWriteFile(disk_file, buf))
+            CoreMediaLoaderSetDiskFile(disk_file);
+        }
+        else
+        {
+            buf.reserve(info.Size);
+            bool ret = CoreReadArchiveStream(stream, buf);
+            CoreCloseArchiveStream(stream);
+            if (!ret)
             {
                 return false;
             }
-
-            CoreMediaLoaderSetDiskFile(disk_file);
-
-            l_ExtractedDiskPath = disk_file;
         }
 
-        l_HasDisk          = is_disk;
-        l_HasExtractedDisk = is_disk;
+        l_HasDisk = info.IsDisk;
     }
     else if (file_extension == ".d64" || 
              file_extension == ".ndd")
     {
         CoreMediaLoaderSetDiskFile(file);
-        l_HasDisk          = true;
-        l_HasExtractedDisk = false;
+        l_HasDisk = true;
     }
     else
     {
-        if (!CoreReadFile(file, buf))
+        // map the ROM instead of reading it, the core
+        // copies it into the cartridge ROM while it's
+        // hashed, so the ROM is only read once
+        if (!CoreMapFile(file, mapped_file) &&
+            !CoreReadFile(file, buf))
         {
             return false;
         }
 
-        l_HasDisk          = false;
-        l_HasExtractedDisk = false;
+        l_HasDisk = false;
     }
 
     if (l_HasDisk)
@@ -131,6 +152,12 @@ CORE_EXPORT bool CoreOpenRom(std::filesystem::path file)
         ret = m64p::Core.DoCommand(M64CMD_DISK_OPEN, 0, nullptr);
         error = "CoreOpenRom: m64p::Core.DoCommand(M64CMD_DISK_OPEN) Failed: ";
     }
+    else if (mapped_file.Data != nullptr)
+    {
+        ret = m64p::Core.DoCommand(M64CMD_ROM_OPEN, (int)std::min(mapped_file.Size, (size_t)INT_MAX), (void*)mapped_file.Data);
+        error = "CoreOpenRom: m64p::Core.DoCommand(M64CMD_ROM_OPEN) Failed: ";
+        CoreUnmapFile(mapped_file);
+    }
     else
     {
         ret = m64p::Core.DoCommand(M64CMD_ROM_OPEN, buf.size(), buf.data());
@@ -160,6 +187,87 @@ CORE_EXPORT bool CoreOpenRom(std::filesystem::path file)
     return l_HasRomOpen;
 }
 
+CORE_EXPORT bool CoreProbeRom(std::filesystem::path file, CoreRomType& type, CoreRomHeader& header, CoreRomSettings& defaultSettings)
+{
+    std::string       error;
+    std::error_code   error_code;
+    m64p_error        ret;
+    std::string       file_extension;
+    m64p_rom_header   m64p_header;
+    m64p_rom_settings m64p_settings;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    file_extension = file.has_extension() ? file.extension().string() : "";
+    file_extension = CoreLowerString(file_extension);
+
+    // the ROM is hashed by the core while it's read
+    // or decompressed, so it's never fully in memory
+    if (file_extension == ".zip" ||
+        file_extension == ".7z")
+    {
+        CoreArchiveStream*  stream;
+        CoreArchiveFileInfo info;
+
+        if (!CoreOpenArchiveStream(file, stream, info))
+        {
+            return false;
+        }
+
+        if (info.IsDisk || info.Size > INT_MAX)
+        {
+            CoreCloseArchiveStream(stream);
+            error = "CoreProbeRom Failed: ";
+            error += info.IsDisk ? "cannot probe disk without opening it!" : "ROM is too large!";
+            CoreSetError(error);
+            return false;
+        }
+
+        ret = m64p::Core.ProbeRomStream((int)info.Size, probe_read_archive, stream, &m64p_header, sizeof(m64p_header), &m64p_settings, sizeof(m64p_settings));
+        CoreCloseArchiveStream(stream);
+    }
+    else if (file_extension == ".d64" ||
+             file_extension == ".ndd")
+    {
+        error = "CoreProbeRom Failed: ";
+        error += "cannot probe disk without opening it!";
+        CoreSetError(error);
+        return false;
+    }
+    else
+    {
+        std::ifstream fileStream(file, std::ios::binary);
+        uintmax_t     fileSize = std::filesystem::file_size(file, error_code);
+
+        if (!fileStream.is_open() || error_code || fileSize > INT_MAX)
+        {
+            error = "CoreProbeRom Failed: ";
+            error += "failed to open file: ";
+            error += file.string();
+            CoreSetError(error);
+            return false;
+        }
+
+        ret = m64p::Core.ProbeRomStream((int)fileSize, probe_read_file, &fileStream, &m64p_header, sizeof(m64p_header), &m64p_settings, sizeof(m64p_settings));
+    }
+
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreProbeRom: m64p::Core.ProbeRomStream() Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    type = CoreRomType::Cartridge;
+    CoreConvertRomHeader(m64p_header, header);
+    CoreConvertRomSettings(m64p_settings, defaultSettings);
+    return true;
+}
+
 CORE_EXPORT bool CoreHasRomOpen(void)
 {
     return l_HasRomOpen;
@@ -200,7 +308,6 @@ CORE_EXPORT bool CoreGetRomPath(std::filesystem::path& path)
 CORE_EXPORT bool CoreCloseRom(void)
 {
     std::string error;
-    std::error_code errorCode;
     m64p_error ret;
 
     if (!m64p::Core.IsHooked())
@@ -242,26 +349,7 @@ CORE_EXPORT bool CoreCloseRom(void)
     // clear default ROM settings
     CoreClearCurrentDefaultRomSettings();
 
-    // if removing the temporary extracted disk file
-    // fails, then we shouldn't break the state of
-    // whether we currently have an open ROM/disk,
-    // so we can safely say the ROM/disk isn't open
-    // anymore here
     l_HasRomOpen = false;
 
-    // attempt to clean temporary extracted disk file
-    if (l_HasExtractedDisk)
-    {
-        if (!std::filesystem::remove(l_ExtractedDiskPath, errorCode))
-        {
-            error = "CoreCloseRom: Failed to remove \"";
-            error += l_ExtractedDiskPath.string();
-            error += "\": ";
-            error += errorCode.message();
-            CoreSetError(error);
-            return false;
-        }
-    }
-
     return true;
 }
@@ -12,6 +12,9 @@
 
 #include <filesystem>
 
+#include "RomHeader.hpp"
+#include "RomSettings.hpp"
+
 enum class CoreRomType
 {
     Cartridge = 0,
@@ -21,6 +24,12 @@ enum class CoreRomType
 // opens the given file as ROM
 bool CoreOpenRom(std::filesystem::path file);
 
+// retrieves the type, header and default settings of
+// the given cartridge ROM without opening it, it doesn't
+// touch the opened ROM so it can be called from any thread,
+// disks can only be retrieved by opening them
+bool CoreProbeRom(std::filesystem::path file, CoreRomType& type, CoreRomHeader& header, CoreRomSettings& defaultSettings);
+
 // returns whether core has a ROM opened
 bool CoreHasRomOpen(void);
 
@@ -144,6 +144,21 @@ static CoreSystemType get_systemtype_from_countrycode(uint8_t countryCode)
     return systemType;
 }
 
+//
+// Internal Functions
+//
+
+void CoreConvertRomHeader(const m64p_rom_header& m64p_header, CoreRomHeader& header)
+{
+    header.CRC1        = ntohl(m64p_header.CRC1);
+    header.CRC2        = ntohl(m64p_header.CRC2);
+    header.CountryCode = m64p_header.Country_code;
+    header.Name        = CoreConvertStringEncoding(std::string((char*)m64p_header.Name, 20), CoreStringEncoding::Shift_JIS);
+    header.GameID      = get_gameid_from_header(m64p_header);
+    header.Region      = get_region_from_countrycode((char)header.CountryCode);
+    header.SystemType  = get_systemtype_from_countrycode(header.CountryCode);
+}
+
 //
 // Exported Functions
 //
@@ -168,13 +183,6 @@ CORE_EXPORT bool CoreGetCurrentRomHeader(CoreRomHeader& header)
         return false;
     }
 
-    header.CRC1        = ntohl(m64p_header.CRC1);
-    header.CRC2        = ntohl(m64p_header.CRC2);
-    header.CountryCode = m64p_header.Country_code;
-    header.Name        = CoreConvertStringEncoding(std::string((char*)m64p_header.Name, 20), CoreStringEncoding::Shift_JIS);
-    header.GameID      = get_gameid_from_header(m64p_header);
-    header.Region      = get_region_from_countrycode((char)header.CountryCode);
-    header.SystemType  = get_systemtype_from_countrycode(header.CountryCode);
-
+    CoreConvertRomHeader(m64p_header, header);
     return true;
 }
@@ -13,6 +13,10 @@
 #include <cstdint>
 #include <string>
 
+#ifdef CORE_INTERNAL
+#include "m64p/Api.hpp"
+#endif // CORE_INTERNAL
+
 enum class CoreSystemType
 {
     NTSC = 0,
@@ -42,6 +46,11 @@ struct CoreRomHeader
     }
 };
 
+#ifdef CORE_INTERNAL
+// converts the ROM header retrieved from the core
+void CoreConvertRomHeader(const m64p_rom_header& m64p_header, CoreRomHeader& header);
+#endif // CORE_INTERNAL
+
 // retrieves the currently opened ROM header
 bool CoreGetCurrentRomHeader(CoreRomHeader& header);
 
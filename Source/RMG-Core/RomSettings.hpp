@@ -13,6 +13,10 @@
 #include <cstdint>
 #include <string>
 
+#ifdef CORE_INTERNAL
+#include "m64p/Api.hpp"
+#endif // CORE_INTERNAL
+
 struct CoreRomSettings
 {
     // rom goodname
@@ -42,6 +46,16 @@ struct CoreRomSettings
     }
 };
 
+#ifdef CORE_INTERNAL
+// converts the ROM settings retrieved from the core
+void CoreConvertRomSettings(const m64p_rom_settings& m64p_settings, CoreRomSettings& settings);
+
+// replaces settings with the overridden ROM settings
+// of the ROM with the MD5 of settings, returns false
+// when they aren't overridden
+bool CoreGetRomSettingsOverlay(CoreRomSettings& settings);
+#endif // CORE_INTERNAL
+
 // retrieves the currently opened ROM settings
 bool CoreGetCurrentRomSettings(CoreRomSettings& settings);
 
@@ -8,17 +8,60 @@
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #define CORE_INTERNAL
+#include "SpeedLimiter.hpp"
 #include "Directories.hpp"
 #include "RomSettings.hpp"
+#include "Emulation.hpp"
+#include "Callback.hpp"
 #include "RomHeader.hpp"
 #include "SaveState.hpp"
 #include "Settings.hpp"
 #include "Library.hpp"
+#include "Movie.hpp"
 #include "Error.hpp"
 
 #include "m64p/Api.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+//
+// Local Defines
+//
+
+// upper limit of rewind snapshots, the
+// memory budget is usually reached first
+#define REWIND_SNAPSHOT_COUNT 4096
+
+//
+// Local Variables
+//
+
+// Rewind history, a snapshot is taken every l_RewindInterval
+// frames starting at l_RewindFirstFrame and identified by its frame.
+// The inputs polled during a frame are stored in l_RewindInputs
+// starting at l_RewindInputFrames[frame - l_RewindFirstFrame].
+// Everything except the requests runs on the emulation thread.
+static bool     l_RewindActive            = false;
+static bool     l_RewindStarted           = false;
+static uint32_t l_RewindInterval          = 0;
+static int      l_RewindBudget            = 0;
+static uint32_t l_RewindFrame             = 0;
+static uint32_t l_RewindFirstFrame        = 0;
+static int64_t  l_RewindLastSnapshotFrame = -1;
+static uint32_t l_RewindTargetFrame       = 0;
+static bool     l_RewindSpeedLimiter      = true;
+static std::vector<uint32_t> l_RewindInputs;
+static std::vector<uint32_t> l_RewindInputFrames;
+static size_t   l_RewindReplayPosition    = 0;
+static size_t   l_RewindReplayEnd         = 0;
+
+static std::atomic<bool> l_RewindReplaying     = false;
+static std::atomic<bool> l_RewindPauseOnTarget = false;
+static std::atomic<bool> l_RewindResetPending  = false;
+static std::atomic<int>  l_RewindRequest       = 0;
 
 //
 // Local Functions
@@ -37,6 +80,264 @@ static void str_replace_chars(std::string& str, const std::string replace, const
     }
 }
 
+static void rewind_input_poll_callback(int control, unsigned int* keys)
+{
+    if (l_RewindReplaying)
+    {
+        if (l_RewindReplayPosition < l_RewindReplayEnd)
+        {
+            *keys = l_RewindInputs[l_RewindReplayPosition++];
+        }
+        return;
+    }
+
+    // inputs before the first frame can't be replayed
+    if (!l_RewindInputFrames.empty())
+    {
+        l_RewindInputs.push_back(*keys);
+    }
+}
+
+static bool rewind_init_snapshots(void)
+{
+    return CoreInitSaveStateSnapshots(REWIND_SNAPSHOT_COUNT, CoreStateCodec::LZ4) &&
+            CoreSetSaveStateSnapshotsBudget(l_RewindBudget);
+}
+
+// drops the recorded inputs of the given amount of oldest frames
+static void rewind_drop_frames(size_t frames)
+{
+    frames = std::min(frames, l_RewindInputFrames.size());
+    if (frames == 0)
+    {
+        return;
+    }
+
+    uint32_t offset = (frames < l_RewindInputFrames.size()) ? l_RewindInputFrames[frames] : (uint32_t)l_RewindInputs.size();
+
+    l_RewindInputs.erase(l_RewindInputs.begin(), l_RewindInputs.begin() + offset);
+    l_RewindInputFrames.erase(l_RewindInputFrames.begin(), l_RewindInputFrames.begin() + frames);
+    for (uint32_t& frameOffset : l_RewindInputFrames)
+    {
+        frameOffset -= offset;
+    }
+
+    l_RewindFirstFrame += (uint32_t)frames;
+}
+
+static void rewind_stop_replay(void)
+{
+    if (l_RewindReplaying)
+    {
+        CoreSetSpeedLimiterState(l_RewindSpeedLimiter);
+        CoreSetResimulatingState(false);
+        l_RewindReplaying = false;
+    }
+}
+
+static void rewind_reset_history(void)
+{
+    rewind_stop_replay();
+
+    l_RewindInputs.clear();
+    l_RewindInputFrames.clear();
+    l_RewindFirstFrame = l_RewindFrame;
+    l_RewindLastSnapshotFrame = -1;
+    l_RewindRequest = 0;
+    l_RewindPauseOnTarget = false;
+
+    if (!rewind_init_snapshots())
+    {
+        l_RewindActive = false;
+    }
+}
+
+static void rewind_start(int frames)
+{
+    uint32_t available = l_RewindFrame - l_RewindFirstFrame;
+    uint32_t target    = l_RewindFrame - std::min((uint32_t)frames, available);
+    uint32_t snapshot;
+
+    // snapshots are dropped oldest first when the budget is exceeded,
+    // so the oldest recorded frames are dropped until one is found
+    while (true)
+    {
+        target   = std::max(target, l_RewindFirstFrame);
+        snapshot = target - ((target - l_RewindFirstFrame) % l_RewindInterval);
+        if (snapshot >= l_RewindFrame || (int64_t)snapshot > l_RewindLastSnapshotFrame)
+        {
+            // nothing left to go back to
+            return;
+        }
+
+        bool stateLost = false;
+        if (CoreLoadStateSnapshot(snapshot, &stateLost))
+        {
+            break;
+        }
+
+        if (stateLost)
+        {
+            // the machine is inconsistent and the history is gone,
+            // a hard reset is the only full state left to go back to
+            CoreAddCallbackMessage(CoreDebugMessageType::Error,
+                "Rewind failed and the emulation state was lost, resetting");
+            CoreResetEmulation(true);
+            return;
+        }
+
+        rewind_drop_frames(l_RewindInterval);
+    }
+
+    // the inputs from the target frame on get recorded again
+    if (target - l_RewindFirstFrame < l_RewindInputFrames.size())
+    {
+        l_RewindInputs.resize(l_RewindInputFrames[target - l_RewindFirstFrame]);
+        l_RewindInputFrames.resize(target - l_RewindFirstFrame);
+    }
+
+    l_RewindFrame = snapshot;
+    l_RewindLastSnapshotFrame = snapshot;
+    l_RewindTargetFrame = target;
+
+    if (snapshot < target)
+    {
+        l_RewindSpeedLimiter = CoreIsSpeedLimiterEnabled();
+        CoreSetSpeedLimiterState(false);
+        CoreSetResimulatingState(true);
+        l_RewindReplaying = true;
+    }
+}
+
+//
+// Internal Functions
+//
+
+bool CoreStartRewind(void)
+{
+    l_RewindActive = false;
+
+    if (!CoreSettingsGetBoolValue(SettingsID::Core_Rewind_Enabled))
+    {
+        return true;
+    }
+
+    l_RewindInterval = std::max(1, CoreSettingsGetIntValue(SettingsID::Core_Rewind_Interval));
+    l_RewindBudget   = std::max(1, CoreSettingsGetIntValue(SettingsID::Core_Rewind_BufferSize));
+    l_RewindFrame    = 0;
+    l_RewindStarted  = false;
+    l_RewindResetPending = false;
+    l_RewindReplaying    = false;
+
+    // rewind_reset_history() clears
+    // l_RewindActive when it fails
+    l_RewindActive = true;
+    rewind_reset_history();
+    return l_RewindActive;
+}
+
+void CoreStopRewind(void)
+{
+    if (!l_RewindActive)
+    {
+        return;
+    }
+
+    rewind_stop_replay();
+    l_RewindActive = false;
+    l_RewindInputs.clear();
+    l_RewindInputs.shrink_to_fit();
+    l_RewindInputFrames.clear();
+    l_RewindInputFrames.shrink_to_fit();
+}
+
+void CoreRewindInputPollCallback(int control, unsigned int* keys)
+{
+    if (l_RewindActive)
+    {
+        rewind_input_poll_callback(control, keys);
+    }
+}
+
+void CoreResetRewind(void)
+{
+    l_RewindResetPending = true;
+}
+
+void CoreRewindFrameCallback(void)
+{
+    if (!l_RewindActive)
+    {
+        return;
+    }
+
+    // the first call starts frame 0
+    if (l_RewindStarted)
+    {
+        l_RewindFrame++;
+    }
+    l_RewindStarted = true;
+
+    if (l_RewindResetPending.exchange(false))
+    {
+        rewind_reset_history();
+        if (!l_RewindActive)
+        {
+            return;
+        }
+    }
+
+    if (l_RewindReplaying && l_RewindFrame >= l_RewindTargetFrame)
+    {
+        rewind_stop_replay();
+    }
+
+    if (!l_RewindReplaying)
+    {
+        int frames = l_RewindRequest.exchange(0);
+        if (frames > 0)
+        {
+            rewind_start(frames);
+        }
+
+        if (!l_RewindReplaying && l_RewindPauseOnTarget.exchange(false))
+        {
+            CorePauseEmulation();
+        }
+    }
+
+    if (l_RewindReplaying)
+    {
+        size_t index = l_RewindFrame - l_RewindFirstFrame;
+        l_RewindReplayPosition = l_RewindInputFrames[index];
+        l_RewindReplayEnd = (index + 1 < l_RewindInputFrames.size()) ? l_RewindInputFrames[index + 1] : l_RewindInputs.size();
+        return;
+    }
+
+    if ((l_RewindFrame - l_RewindFirstFrame) % l_RewindInterval == 0 &&
+        (int64_t)l_RewindFrame != l_RewindLastSnapshotFrame)
+    {
+        size_t size;
+        size_t rawSize;
+        uint32_t pages;
+        if (CoreSaveStateSnapshot(l_RewindFrame, size, rawSize, pages))
+        {
+            l_RewindLastSnapshotFrame = l_RewindFrame;
+        }
+    }
+
+    l_RewindInputFrames.push_back((uint32_t)l_RewindInputs.size());
+
+    // inputs older than the oldest possible snapshot aren't needed,
+    // whole intervals are dropped so the snapshot frames stay the same
+    size_t keepFrames = (size_t)REWIND_SNAPSHOT_COUNT * l_RewindInterval;
+    if (l_RewindInputFrames.size() >= keepFrames * 2)
+    {
+        size_t dropFrames = l_RewindInputFrames.size() - keepFrames;
+        rewind_drop_frames(dropFrames - (dropFrames % l_RewindInterval));
+    }
+}
+
 //
 // Exported Functions
 //
@@ -300,3 +601,238 @@ CORE_EXPORT bool CoreLoadSaveState(std::filesystem::path file)
 
     return ret == M64ERR_SUCCESS;
 }
+
+CORE_EXPORT bool CoreGetSaveStateMemorySize(size_t& size)
+{
+    std::string error;
+    m64p_error ret;
+    m64p_state_memory state = {nullptr, 0, 0};
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_SAVE_MEMORY, sizeof(state), &state);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreGetSaveStateMemorySize: m64p::Core.DoCommand(M64CMD_STATE_SAVE_MEMORY) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    size = state.used;
+    return true;
+}
+
+CORE_EXPORT bool CoreSaveStateToMemory(void* buffer, size_t bufferSize, size_t& size)
+{
+    std::string error;
+    m64p_error ret;
+    m64p_state_memory state = {buffer, (unsigned int)bufferSize, 0};
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    if (buffer == nullptr)
+    {
+        error = "CoreSaveStateToMemory Failed: buffer cannot be nullptr!";
+        CoreSetError(error);
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_SAVE_MEMORY, sizeof(state), &state);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSaveStateToMemory: m64p::Core.DoCommand(M64CMD_STATE_SAVE_MEMORY) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    size = state.used;
+    return true;
+}
+
+CORE_EXPORT bool CoreLoadSaveStateFromMemory(void* buffer, size_t size)
+{
+    std::string error;
+    m64p_error ret;
+    m64p_state_memory state = {buffer, (unsigned int)size, 0};
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_LOAD_MEMORY, sizeof(state), &state);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreLoadSaveStateFromMemory: m64p::Core.DoCommand(M64CMD_STATE_LOAD_MEMORY) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
+CORE_EXPORT bool CoreInitSaveStateSnapshots(int count, CoreStateCodec codec)
+{
+    std::string error;
+    m64p_error ret;
+    m64p_state_codec stateCodec = static_cast<m64p_state_codec>(codec);
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_SNAPSHOTS_INIT, count, &stateCodec);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreInitSaveStateSnapshots: m64p::Core.DoCommand(M64CMD_STATE_SNAPSHOTS_INIT) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
+CORE_EXPORT bool CoreSaveStateSnapshot(uint32_t id, size_t& size, size_t& rawSize, uint32_t& pages, CoreStateSnapshotHashes* hashes)
+{
+    std::string error;
+    m64p_error ret;
+    m64p_state_snapshot snapshot = {};
+    snapshot.id = id;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_SNAPSHOT_SAVE, sizeof(snapshot), &snapshot);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSaveStateSnapshot: m64p::Core.DoCommand(M64CMD_STATE_SNAPSHOT_SAVE) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    size    = snapshot.size;
+    rawSize = snapshot.raw_size;
+    pages   = snapshot.pages;
+
+    if (hashes != nullptr)
+    {
+        static_assert(CORE_SNAPSHOT_RDRAM_REGIONS == M64P_SNAPSHOT_RDRAM_REGIONS);
+        hashes->StateHash = snapshot.state_hash;
+        std::memcpy(hashes->RdramHashes, snapshot.rdram_hashes, sizeof(hashes->RdramHashes));
+    }
+    return true;
+}
+
+CORE_EXPORT bool CoreLoadStateSnapshot(uint32_t id, bool* stateLost)
+{
+    std::string error;
+    m64p_error ret;
+    m64p_state_snapshot snapshot = {};
+    snapshot.id = id;
+
+    if (stateLost != nullptr)
+    {
+        *stateLost = false;
+    }
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_SNAPSHOT_LOAD, sizeof(snapshot), &snapshot);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreLoadStateSnapshot: m64p::Core.DoCommand(M64CMD_STATE_SNAPSHOT_LOAD) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+
+        // the core only fails with an internal
+        // error after it changed the machine
+        if (stateLost != nullptr)
+        {
+            *stateLost = (ret == M64ERR_INTERNAL);
+        }
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
+CORE_EXPORT bool CoreSetSaveStateSnapshotsBudget(int megabytes)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_SNAPSHOTS_SET_BUDGET, megabytes, nullptr);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSetSaveStateSnapshotsBudget: m64p::Core.DoCommand(M64CMD_STATE_SNAPSHOTS_SET_BUDGET) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
+CORE_EXPORT bool CoreRewind(int frames)
+{
+    std::string error;
+
+    if (!l_RewindActive)
+    {
+        error = "CoreRewind Failed: ";
+        error += "rewind isn't enabled!";
+        CoreSetError(error);
+        return false;
+    }
+
+    if (frames <= 0)
+    {
+        error = "CoreRewind Failed: ";
+        error += "frames must be larger than 0!";
+        CoreSetError(error);
+        return false;
+    }
+
+    if (CoreIsMovieActive())
+    {
+        error = "CoreRewind Failed: ";
+        error += "cannot rewind while a movie is recorded or played back!";
+        CoreSetError(error);
+        return false;
+    }
+
+    if (CoreIsEmulationPaused())
+    {
+        // the frame which runs before the next
+        // frame callback has to be undone as well
+        l_RewindPauseOnTarget = true;
+        l_RewindRequest += frames + 1;
+        return CoreResumeEmulation();
+    }
+
+    l_RewindRequest += frames;
+    return true;
+}
+
+CORE_EXPORT bool CoreIsRewinding(void)
+{
+    return l_RewindReplaying;
+}
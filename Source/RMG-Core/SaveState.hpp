@@ -14,6 +14,33 @@
 #include "RomSettings.hpp"
 
 #include <filesystem>
+#include <cstdint>
+
+// rewind history used by Emulation.cpp
+#ifdef CORE_INTERNAL
+
+// starts recording the rewind history when
+// rewind is enabled, must be called before
+// emulation is started
+bool CoreStartRewind(void);
+
+// stops recording the rewind history
+void CoreStopRewind(void);
+
+// records or replays the inputs of the rewind
+// history, must be called from the input poll callback
+void CoreRewindInputPollCallback(int control, unsigned int* keys);
+
+// drops the rewind history at the next frame,
+// used when the emulated machine state changes
+// in a way which can't be replayed
+void CoreResetRewind(void);
+
+// records or replays the rewind history,
+// must be called from the frame callback
+void CoreRewindFrameCallback(void);
+
+#endif // CORE_INTERNAL
 
 enum class CoreSaveStateType
 {
@@ -21,6 +48,25 @@ enum class CoreSaveStateType
 	Project64   = 2
 };
 
+enum class CoreStateCodec
+{
+	None = 0,
+	Zlib = 1,
+	LZ4  = 2
+};
+
+#define CORE_SNAPSHOT_RDRAM_REGIONS 32
+
+// determinism hashes of a snapshot, equal on every
+// machine emulating the same frames with the same inputs
+struct CoreStateSnapshotHashes
+{
+	// registers and RCP state
+	uint32_t StateHash = 0;
+	// each 256 KiB region of RDRAM
+	uint32_t RdramHashes[CORE_SNAPSHOT_RDRAM_REGIONS] = {0};
+};
+
 // sets save state slot
 bool CoreSetSaveStateSlot(int slot);
 
@@ -56,4 +102,54 @@ bool CoreLoadSaveState(void);
 // loads saved state from file
 bool CoreLoadSaveState(std::filesystem::path file);
 
+// retrieves the buffer size required
+// for CoreSaveStateToMemory, while emulation
+// is running it's the exact size of a state
+// of the running ROM
+bool CoreGetSaveStateMemorySize(size_t& size);
+
+// synchronously saves state into buffer,
+// size receives the amount of bytes written,
+// can only be called from the frame callback
+bool CoreSaveStateToMemory(void* buffer, size_t bufferSize, size_t& size);
+
+// synchronously loads state from buffer,
+// buffer may be modified,
+// can only be called from the frame callback
+bool CoreLoadSaveStateFromMemory(void* buffer, size_t size);
+
+// allocates a ring of count snapshots in the core,
+// compressed with codec, count 0 frees the ring
+bool CoreInitSaveStateSnapshots(int count, CoreStateCodec codec = CoreStateCodec::None);
+
+// saves a snapshot identified by id, snapshots
+// only store the RDRAM pages changed since the
+// previous snapshot, size receives the stored size
+// and rawSize the size without compression,
+// hashes receives the hashes of the snapshot when
+// it isn't nullptr, can only be called from the
+// frame callback
+bool CoreSaveStateSnapshot(uint32_t id, size_t& size, size_t& rawSize, uint32_t& pages, CoreStateSnapshotHashes* hashes = nullptr);
+
+// restores the snapshot identified by id and drops
+// all newer snapshots, can only be called from the
+// frame callback, stateLost is set when it isn't nullptr
+// and restoring failed halfway, the emulated machine is
+// inconsistent then and no snapshots are left
+bool CoreLoadStateSnapshot(uint32_t id, bool* stateLost = nullptr);
+
+// limits the memory used by the snapshot ring to
+// the given amount of megabytes by dropping the
+// oldest snapshots, 0 disables the limit
+bool CoreSetSaveStateSnapshotsBudget(int megabytes);
+
+// steps back the given amount of frames by restoring
+// the nearest rewind snapshot and replaying the inputs
+// recorded since, when emulation is paused it's resumed
+// until the frame is reached
+bool CoreRewind(int frames);
+
+// returns whether frames are being replayed for a rewind
+bool CoreIsRewinding(void);
+
 #endif // CORE_SAVESTATE_HPP
\ No newline at end of file
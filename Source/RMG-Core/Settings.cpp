@@ -178,6 +178,9 @@ static l_Setting get_setting(SettingsID settingId)
     case SettingsID::Netplay_RollbackFrameDelay:
         setting = {SETTING_SECTION_NETPLAY, "RollbackFrameDelay", 2, "Input delay in frames for rollback netplay"};
         break;
+    case SettingsID::Netplay_RollbackStateCodec:
+        setting = {SETTING_SECTION_NETPLAY, "RollbackStateCodec", 2, "Compression of rollback states (0: None, 1: Zlib, 2: LZ4)"};
+        break;
     case SettingsID::Netplay_ShowRollbackMetrics:
         setting = {SETTING_SECTION_NETPLAY, "ShowRollbackMetrics", true, "Show rollback metrics overlay"};
         break;
@@ -263,6 +266,9 @@ static l_Setting get_setting(SettingsID settingId)
     case SettingsID::Core_UseRollbackNetplay:
         setting = {SETTING_SECTION_M64P, "UseRollbackNetplay", false, "Enable rollback netcode instead of traditional netplay"};
         break;
+    case SettingsID::Core_SaveStateCodec:
+        setting = {SETTING_SECTION_M64P, "SaveStateCodec", 1, "Compression of save states (0 = none, 1 = zlib, 2 = lz4)"};
+        break;
 
     case SettingsID::CoreOverlay_RandomizeInterrupt:
         setting = {SETTING_SECTION_OVERLAY, "RandomizeInterrupt", true};
@@ -347,6 +353,16 @@ static l_Setting get_setting(SettingsID settingId)
         setting = {SETTING_SECTION_GB, "Gameboy_P4_Save", std::string("")};
         break;
 
+    case SettingsID::Core_Rewind_Enabled:
+        setting = {SETTING_SECTION_CORE, "RewindEnabled", false};
+        break;
+    case SettingsID::Core_Rewind_Interval:
+        setting = {SETTING_SECTION_CORE, "RewindInterval", 10, "Frames between rewind snapshots"};
+        break;
+    case SettingsID::Core_Rewind_BufferSize:
+        setting = {SETTING_SECTION_CORE, "RewindBufferSize", 128, "Memory used by rewind snapshots in MB"};
+        break;
+
     case SettingsID::Game_OverrideSettings:
         setting = {"", "OverrideSettings", false};
         break;
@@ -473,6 +489,9 @@ static l_Setting get_setting(SettingsID settingId)
     case SettingsID::KeyBinding_Load:
         setting = {SETTING_SECTION_KEYBIND, "Load", std::string("Ctrl+L")};
         break;
+    case SettingsID::KeyBinding_Rewind:
+        setting = {SETTING_SECTION_KEYBIND, "Rewind", std::string("F8")};
+        break;
     case SettingsID::KeyBinding_Cheats:
         setting = {SETTING_SECTION_KEYBIND, "Cheats", std::string("Ctrl+C")};
         break;
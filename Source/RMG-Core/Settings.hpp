@@ -48,6 +48,7 @@ enum class SettingsID
     Netplay_SelectedServer,
     Netplay_ServerName,
     Netplay_RollbackFrameDelay,
+    Netplay_RollbackStateCodec,
     Netplay_ShowRollbackMetrics,
     Netplay_ShowRollbackFlash,
 
@@ -83,6 +84,11 @@ enum class SettingsID
     Core_Gameboy_P4_Rom,
     Core_Gameboy_P4_Save,
 
+    // Core Rewind Settings
+    Core_Rewind_Enabled,
+    Core_Rewind_Interval,
+    Core_Rewind_BufferSize,
+
     // (mupen64plus) Core Settings
     Core_OverrideGameSpecificSettings,
     Core_RandomizeInterrupt,
@@ -94,6 +100,7 @@ enum class SettingsID
     Core_SiDmaDuration,
     Core_SaveFileNameFormat,
     Core_UseRollbackNetplay,
+    Core_SaveStateCodec,
 
     // (mupen64plus) Overlay Core Settings
     CoreOverlay_RandomizeInterrupt,
@@ -158,6 +165,7 @@ enum class SettingsID
     KeyBinding_SaveAs,
     KeyBinding_LoadState,
     KeyBinding_Load,
+    KeyBinding_Rewind,
     KeyBinding_Cheats,
     KeyBinding_GSButton,
     KeyBinding_SaveStateSlot0,
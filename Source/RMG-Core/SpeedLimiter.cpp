@@ -16,6 +16,32 @@
 
 #include <string>
 
+//
+// Internal Functions
+//
+
+bool CoreSetResimulatingState(bool resimulating)
+{
+    std::string error;
+    m64p_error ret;
+    int value = resimulating ? 1 : 0;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_CORE_STATE_SET, M64CORE_RESIMULATING, &value);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSetResimulatingState: m64p::Core.DoCommand(M64CMD_CORE_STATE_SET) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
 //
 // Exported Functions
 //
@@ -10,6 +10,17 @@
 #ifndef CORE_SPEEDLIMITER_HPP
 #define CORE_SPEEDLIMITER_HPP
 
+// resimulation state used by Emulation.cpp and SaveState.cpp
+#ifdef CORE_INTERNAL
+
+// marks the frames being emulated as resimulated,
+// their audio and video output is skipped by the
+// core and the plugins because it was already
+// presented, emulation must be running
+bool CoreSetResimulatingState(bool resimulating);
+
+#endif // CORE_INTERNAL
+
 // returns whether the speed limiter is enabled
 bool CoreIsSpeedLimiterEnabled(void);
 
@@ -34,6 +34,8 @@ bool CoreApi::Hook(m64p_dynlib_handle handle)
     HOOK_FUNC(handle, Core, AddCheat);
     HOOK_FUNC(handle, Core, CheatEnabled);
     HOOK_FUNC(handle, Core, GetRomSettings);
+    HOOK_FUNC(handle, Core, ProbeRom);
+    HOOK_FUNC(handle, Core, ProbeRomStream);
     HOOK_FUNC(handle, Core, GetAPIVersions);
     HOOK_FUNC(handle, Core, ErrorMessage);
 
@@ -53,6 +55,8 @@ bool CoreApi::Unhook(void)
     UNHOOK_FUNC(Core, AddCheat);
     UNHOOK_FUNC(Core, CheatEnabled);
     UNHOOK_FUNC(Core, GetRomSettings);
+    UNHOOK_FUNC(Core, ProbeRom);
+    UNHOOK_FUNC(Core, ProbeRomStream);
     UNHOOK_FUNC(Core, GetAPIVersions);
     UNHOOK_FUNC(Core, ErrorMessage);
 
@@ -39,6 +39,8 @@ class CoreApi
     ptr_CoreAddCheat AddCheat;
     ptr_CoreCheatEnabled CheatEnabled;
     ptr_CoreGetRomSettings GetRomSettings;
+    ptr_CoreProbeRom ProbeRom;
+    ptr_CoreProbeRomStream ProbeRomStream;
     ptr_CoreGetAPIVersions GetAPIVersions;
     ptr_CoreErrorMessage ErrorMessage;
 
@@ -61,6 +61,7 @@ typedef void (*m64p_frame_callback)(unsigned int FrameIndex);
 typedef void (*m64p_input_callback)(void);
 typedef void (*m64p_audio_callback)(void);
 typedef void (*m64p_vi_callback)(void);
+typedef void (*m64p_input_poll_callback)(int Control, unsigned int *Keys);
 
 typedef enum {
   M64TYPE_INT = 1,
@@ -139,6 +140,7 @@ typedef enum {
   M64CORE_STATE_LOADCOMPLETE,
   M64CORE_STATE_SAVECOMPLETE,
   M64CORE_SCREENSHOT_CAPTURED,
+  M64CORE_RESIMULATING,
 } m64p_core_param;
 
 typedef enum {
@@ -171,7 +173,16 @@ typedef enum {
   M64CMD_PIF_OPEN,
   M64CMD_ROM_SET_SETTINGS,
   M64CMD_DISK_OPEN,
-  M64CMD_DISK_CLOSE
+  M64CMD_DISK_CLOSE,
+  M64CMD_STATE_SAVE_MEMORY,
+  M64CMD_STATE_LOAD_MEMORY,
+  M64CMD_STATE_SNAPSHOTS_INIT,
+  M64CMD_STATE_SNAPSHOT_SAVE,
+  M64CMD_STATE_SNAPSHOT_LOAD,
+  M64CMD_STATE_SNAPSHOTS_SET_BUDGET,
+  M64CMD_SET_INPUT_POLL_CALLBACK,
+  M64CMD_PROFILER_ENABLE,
+  M64CMD_PROFILER_REPORT
 } m64p_command;
 
 typedef struct {
@@ -220,6 +231,70 @@ typedef struct {
   char* (*get_dd_disk)(void* cb_data);
 } m64p_media_loader;
 
+typedef struct {
+  /* Caller owned buffer which holds an uncompressed savestate.
+   * M64CMD_STATE_SAVE_MEMORY with a NULL buffer only sets 'used'
+   * to the buffer size required to save a state, which is exact
+   * for the running ROM. */
+  void *buffer;
+  /* size of buffer in bytes */
+  unsigned int size;
+  /* number of bytes written by M64CMD_STATE_SAVE_MEMORY */
+  unsigned int used;
+} m64p_state_memory;
+
+/* number of RDRAM regions hashed separately by M64CMD_STATE_SNAPSHOT_SAVE */
+#define M64P_SNAPSHOT_RDRAM_REGIONS 32
+
+typedef struct {
+  /* front-end chosen identifier of the snapshot, usually the frame number */
+  unsigned int id;
+  /* bytes used by the snapshot, set by M64CMD_STATE_SNAPSHOT_SAVE */
+  unsigned int size;
+  /* RDRAM pages stored in the snapshot, set by M64CMD_STATE_SNAPSHOT_SAVE */
+  unsigned int pages;
+  /* bytes the snapshot would use uncompressed, set by M64CMD_STATE_SNAPSHOT_SAVE */
+  unsigned int raw_size;
+  /* determinism hashes, equal on every machine emulating the same frames,
+   * set by M64CMD_STATE_SNAPSHOT_SAVE: of the registers and RCP state, and
+   * of each 256 KiB region of RDRAM */
+  unsigned int state_hash;
+  unsigned int rdram_hashes[M64P_SNAPSHOT_RDRAM_REGIONS];
+} m64p_state_snapshot;
+
+typedef struct {
+  /* guest address of the function, 0 for the functions
+   * which didn't fit in the profile anymore */
+  unsigned int function;
+  /* guest address of the function it was called from, or 0 if unknown */
+  unsigned int caller;
+  /* samples and emulated cycles spent in the function */
+  unsigned int samples;
+  unsigned long long cycles;
+} m64p_profile_entry;
+
+typedef struct {
+  /* caller owned array, M64CMD_PROFILER_REPORT fills it
+   * with the entries with the most cycles first */
+  m64p_profile_entry *entries;
+  /* size of entries in elements */
+  unsigned int size;
+  /* number of entries written, and number of entries in the profile */
+  unsigned int count;
+  unsigned int total_entries;
+  /* totals of the profile, and samples dropped because
+   * the profile wasn't retrieved often enough */
+  unsigned int samples;
+  unsigned long long cycles;
+  unsigned int dropped;
+} m64p_profile_report;
+
+typedef enum {
+  M64CODEC_NONE = 0,
+  M64CODEC_ZLIB,
+  M64CODEC_LZ4
+} m64p_state_codec;
+
 /* ----------------------------------------- */
 /* Structures to hold ROM image information  */
 /* ----------------------------------------- */
@@ -10,12 +10,110 @@
 #include "RomSearcherThread.hpp"
 
 #include <RMG-Core/CachedRomHeaderAndSettings.hpp>
+#include <RMG-Core/Directories.hpp>
 
-#include <QElapsedTimer>
 #include <QDirIterator>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QMutex>
+#include <QFile>
+#include <QSet>
+#include <QDir>
+
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <vector>
 
 using namespace Thread;
 
+//
+// Local Defines
+//
+
+#define SNAPSHOT_FILE_MAGIC "RMG_RomSearcherSnapshot_01"
+
+//
+// Local Functions
+//
+
+static QDataStream& operator<<(QDataStream& stream, const RomSearcherThreadDirectory& directory)
+{
+    return stream << directory.ModifiedTime << directory.Directories << directory.Files;
+}
+
+static QDataStream& operator>>(QDataStream& stream, RomSearcherThreadDirectory& directory)
+{
+    return stream >> directory.ModifiedTime >> directory.Directories >> directory.Files;
+}
+
+static QString get_snapshot_file(void)
+{
+    QString file = QString::fromStdString(CoreGetUserCacheDirectory().string());
+    file += CORE_DIR_SEPERATOR_STR;
+    file += "RomSearcherSnapshot.cache";
+    return file;
+}
+
+// returns the ROMs in the directory tree in a stable order,
+// so the maximum amount of files keeps the same ROMs
+static QList<QString> get_roms(const QHash<QString, RomSearcherThreadDirectory>& directories, QString root, int maxItems)
+{
+    QList<QString> roms;
+    QStringList pendingDirectories = { root };
+
+    while (!pendingDirectories.isEmpty() && roms.size() < maxItems)
+    {
+        QString directory = pendingDirectories.takeFirst();
+        auto iter = directories.constFind(directory);
+        if (iter == directories.cend())
+        {
+            continue;
+        }
+
+        QStringList files = iter->Files.keys();
+        files.sort();
+        for (const QString& file : files)
+        {
+            roms.append(directory + "/" + file);
+        }
+
+        QStringList subDirectories = iter->Directories;
+        subDirectories.sort();
+        for (const QString& subDirectory : subDirectories)
+        {
+            pendingDirectories.append(directory + "/" + subDirectory);
+        }
+    }
+
+    if (roms.size() > maxItems)
+    {
+        roms.resize(std::max(maxItems, 0));
+    }
+
+    return roms;
+}
+
+// returns the size and modification time of the ROM,
+// or -1 for both when it isn't in the directory tree
+static QPair<qint64, qint64> get_rom_info(const QHash<QString, RomSearcherThreadDirectory>& directories, QString rom)
+{
+    const qsizetype lastIndexOfSlash = rom.lastIndexOf('/');
+    auto iter = directories.constFind(rom.left(lastIndexOfSlash));
+    if (iter == directories.cend())
+    {
+        return { -1, -1 };
+    }
+
+    return iter->Files.value(rom.mid(lastIndexOfSlash + 1), { -1, -1 });
+}
+
+//
+// Exported Functions
+//
+
 RomSearcherThread::RomSearcherThread(QObject *parent) : QThread(parent)
 {
     qRegisterMetaType<CoreRomType>("CoreRomType");
@@ -44,6 +142,17 @@ void RomSearcherThread::SetMaximumFiles(int value)
     this->maxItems = value;
 }
 
+void RomSearcherThread::SetIncremental(bool value)
+{
+    this->incremental = value;
+}
+
+void RomSearcherThread::SetModifiedDirectoriesOnly(bool value, QStringList directories)
+{
+    this->modifiedDirectoriesOnly = value;
+    this->modifiedDirectories     = directories;
+}
+
 void RomSearcherThread::Stop(void)
 {
     this->stop = true;
@@ -56,10 +165,84 @@ void RomSearcherThread::Stop(void)
 void RomSearcherThread::run(void)
 {
     this->stop = false;
-    this->searchDirectory(this->directory);
+
+    QString directory = QDir::cleanPath(this->directory);
+
+    if (!this->snapshotLoaded)
+    {
+        this->loadSnapshot();
+        this->snapshotLoaded = true;
+    }
+
+    // the snapshot is useless when
+    // it's of another directory tree
+    if (this->snapshotDirectory != directory ||
+        this->snapshotRecursive != this->recursive)
+    {
+        this->snapshot.clear();
+        this->snapshotDirectory = directory;
+        this->snapshotRecursive = this->recursive;
+    }
+
+    this->searchDirectory(directory);
 }
 
-void RomSearcherThread::searchDirectory(QString directory)
+void RomSearcherThread::loadSnapshot(void)
+{
+    QFile file(get_snapshot_file());
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+
+    QDataStream stream(&file);
+    QString magic;
+    QString directory;
+    bool    recursive = false;
+    QHash<QString, RomSearcherThreadDirectory> snapshot;
+
+    stream >> magic;
+    if (magic != SNAPSHOT_FILE_MAGIC)
+    {
+        return;
+    }
+
+    stream >> directory >> recursive >> snapshot;
+    if (stream.status() != QDataStream::Ok)
+    {
+        return;
+    }
+
+    this->snapshotDirectory = directory;
+    this->snapshotRecursive = recursive;
+    this->snapshot          = snapshot;
+}
+
+void RomSearcherThread::saveSnapshot(void)
+{
+    QString fileName = get_snapshot_file();
+
+    if (!QDir().mkpath(QFileInfo(fileName).path()))
+    {
+        return;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << QString(SNAPSHOT_FILE_MAGIC);
+    stream << this->snapshotDirectory << this->snapshotRecursive << this->snapshot;
+    if (stream.status() == QDataStream::Ok)
+    {
+        file.commit();
+    }
+}
+
+void RomSearcherThread::searchDirectory(QString root)
 {
     QStringList filter;
     filter << "*.N64";
@@ -70,63 +253,213 @@ void RomSearcherThread::searchDirectory(QString directory)
     filter << "*.ZIP";
     filter << "*.7Z";
 
-    QDirIterator::IteratorFlag flag = this->recursive ? 
-        QDirIterator::Subdirectories : 
-        QDirIterator::NoIteratorFlags;
-    QDirIterator romDirIt(directory, filter, QDir::Files, flag);
+    QDir::Filters filters = QDir::Files;
+    if (this->recursive)
+    {
+        // subdirectories shouldn't be filtered by name
+        filters |= QDir::AllDirs | QDir::NoDotAndDotDot;
+    }
 
-    CoreRomType     type;
-    CoreRomHeader   header;
-    CoreRomSettings defaultSettings;
-    CoreRomSettings settings;
-    bool            ret;
+    // walk the directory tree, directories which haven't
+    // been modified since the last search are taken from
+    // the snapshot, which saves listing them and querying
+    // every file in them, this matters a lot for directories
+    // on a network share
+    QHash<QString, RomSearcherThreadDirectory> directories;
+    QStringList pendingDirectories = { root };
+    while (!pendingDirectories.isEmpty() && !this->stop)
+    {
+        QString directory   = pendingDirectories.takeFirst();
+        qint64 modifiedTime = QFileInfo(directory).lastModified().toMSecsSinceEpoch();
+        auto   snapshotIter = this->snapshot.constFind(directory);
 
-    QList<QString> roms;
-    while (romDirIt.hasNext())
+        RomSearcherThreadDirectory directoryData;
+
+        if (this->modifiedDirectoriesOnly &&
+            snapshotIter != this->snapshot.cend() &&
+            snapshotIter->ModifiedTime == modifiedTime &&
+            !this->modifiedDirectories.contains(directory))
+        {
+            directoryData = snapshotIter.value();
+        }
+        else
+        {
+            directoryData.ModifiedTime = modifiedTime;
+
+            QDirIterator dirIt(directory, filter, filters);
+            while (dirIt.hasNext())
+            {
+                dirIt.next();
+
+                QFileInfo fileInfo = dirIt.fileInfo();
+                if (fileInfo.isDir())
+                {
+                    // don't follow symlinks, like QDirIterator::Subdirectories
+                    if (!fileInfo.isSymLink())
+                    {
+                        directoryData.Directories.append(fileInfo.fileName());
+                    }
+                }
+                else
+                {
+                    directoryData.Files.insert(fileInfo.fileName(),
+                    {
+                        fileInfo.size(),
+                        fileInfo.lastModified().toMSecsSinceEpoch()
+                    });
+                }
+            }
+        }
+
+        for (const QString& subDirectory : directoryData.Directories)
+        {
+            pendingDirectories.append(directory + "/" + subDirectory);
+        }
+
+        directories.insert(directory, directoryData);
+    }
+
+    if (this->stop)
+    {
+        emit this->Finished(true);
+        return;
+    }
+
+    QList<QString> roms = get_roms(directories, root, this->maxItems);
+    QList<QString> changedRoms;
+    QStringList    removedRoms;
+
+    if (!this->incremental)
+    {
+        changedRoms = roms;
+    }
+    else
+    {
+        QList<QString> oldRoms = get_roms(this->snapshot, root, this->maxItems);
+        QSet<QString>  oldRomsSet(oldRoms.begin(), oldRoms.end());
+        QSet<QString>  romsSet(roms.begin(), roms.end());
+
+        for (const QString& rom : roms)
+        {
+            if (!oldRomsSet.contains(rom))
+            {
+                changedRoms.append(rom);
+            }
+            else if (get_rom_info(this->snapshot, rom) != get_rom_info(directories, rom))
+            {
+                // modified ROMs are removed and added again
+                changedRoms.append(rom);
+                removedRoms.append(rom);
+            }
+        }
+
+        for (const QString& rom : oldRoms)
+        {
+            if (!romsSet.contains(rom))
+            {
+                removedRoms.append(rom);
+            }
+        }
+    }
+
+    if (!removedRoms.isEmpty())
+    {
+        emit this->RomsRemoved(removedRoms);
+    }
+
+    this->searchRoms(changedRoms, directories);
+
+    // only keep the snapshot of a complete search
+    if (this->stop)
+    {
+        emit this->Finished(true);
+        return;
+    }
+
+    if (directories != this->snapshot)
     {
-        roms.push_back(romDirIt.next());
+        this->snapshot = directories;
+        this->saveSnapshot();
     }
 
-    const int romAmount = std::min(this->maxItems, (int)roms.size());
+    emit this->DirectoriesFound(directories.keys());
+    emit this->Finished(false);
+}
 
-    // our ROM data
+void RomSearcherThread::searchRoms(QList<QString> roms, const QHash<QString, RomSearcherThreadDirectory>& directories)
+{
+    const int romAmount = roms.size();
+
+    // our ROM data, filled by the workers
     QList<RomSearcherThreadData> data;
+    QMutex dataMutex;
 
-    // keep track of the time
-    QElapsedTimer timer;
-    timer.start();
+    // retrieving the header and settings of a ROM
+    // which isn't cached yet is mostly spent on reading
+    // and hashing the file, so we use several workers
+    const int workerAmount = std::min(std::clamp((int)std::thread::hardware_concurrency(), 2, 8), romAmount);
+    std::atomic<int> nextRom     = 0;
+    std::atomic<int> romsDone    = 0;
+    std::atomic<int> workersDone = 0;
 
-    for (int i = 0; i < romAmount; i++)
+    auto worker = [&]()
     {
-        QString file = roms.at(i);
+        CoreRomType     type;
+        CoreRomHeader   header;
+        CoreRomSettings settings;
+        int             i;
 
-        if (CoreGetCachedRomHeaderAndSettings(file.toStdU32String(), &type, &header, nullptr, &settings))
+        while (!this->stop && (i = nextRom++) < romAmount)
         {
-            data.push_back(
+            QString file = roms.at(i);
+
+            if (CoreGetCachedRomHeaderAndSettings(file.toStdU32String(), &type, &header, nullptr, &settings))
             {
-                file,
-                type,
-                header,
-                settings
-            });
+                QMutexLocker locker(&dataMutex);
+                data.push_back(
+                {
+                    file,
+                    type,
+                    header,
+                    settings,
+                    // the size is taken from the directory tree,
+                    // so the UI doesn't have to query it
+                    get_rom_info(directories, file).first
+                });
+            }
+
+            romsDone++;
         }
 
-        // we need to give the UI some breathing room,
-        // so when 10ms have passed,
-        // send our data to the UI and
-        // clear our data and restart
-        // the timer
-        if (timer.elapsed() >= 10)
+        workersDone++;
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < workerAmount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+
+    // we need to give the UI some breathing room,
+    // so every 10ms, send our data to the UI and
+    // clear our data
+    int lastRomsDone = 0;
+    while (workersDone < workerAmount)
+    {
+        this->msleep(10);
+
+        QMutexLocker locker(&dataMutex);
+        if (!data.isEmpty() || romsDone != lastRomsDone)
         {
-            emit this->RomsFound(data, (i + 1), romAmount);
+            lastRomsDone = romsDone;
+            emit this->RomsFound(data, lastRomsDone, romAmount);
             data.clear();
-            timer.start();
         }
+    }
 
-        if (this->stop)
-        {
-            break;
-        }
+    for (std::thread& thread : workers)
+    {
+        thread.join();
     }
 
     // when we're done and
@@ -136,7 +469,5 @@ void RomSearcherThread::searchDirectory(QString directory)
     {
         emit this->RomsFound(data, romAmount, romAmount);
     }
-
-    emit this->Finished(this->stop);
 }
 
@@ -14,8 +14,13 @@
 #include <RMG-Core/RomHeader.hpp>
 #include <RMG-Core/Rom.hpp>
 
+#include <QStringList>
 #include <QString>
 #include <QThread>
+#include <QHash>
+#include <QPair>
+
+#include <atomic>
 
 struct RomSearcherThreadData
 {
@@ -23,6 +28,23 @@ struct RomSearcherThreadData
     CoreRomType Type;
     CoreRomHeader Header;
     CoreRomSettings Settings;
+    qint64 FileSize;
+};
+
+struct RomSearcherThreadDirectory
+{
+    qint64 ModifiedTime = 0;
+    // names of the subdirectories
+    QStringList Directories;
+    // size and modification time by ROM file name
+    QHash<QString, QPair<qint64, qint64>> Files;
+
+    bool operator==(const RomSearcherThreadDirectory& other) const
+    {
+        return this->ModifiedTime == other.ModifiedTime &&
+               this->Directories  == other.Directories &&
+               this->Files        == other.Files;
+    }
 };
 
 namespace Thread
@@ -38,6 +60,13 @@ class RomSearcherThread : public QThread
     void SetDirectory(QString);
     void SetRecursive(bool);
     void SetMaximumFiles(int);
+    // when enabled only the ROMs which have been added,
+    // removed or modified since the last search are reported
+    void SetIncremental(bool);
+    // when enabled only directories which have been
+    // modified since the last search, or which are in
+    // the given list, are searched again
+    void SetModifiedDirectoriesOnly(bool, QStringList directories = {});
     void Stop(void);
 
     void run(void) override;
@@ -46,12 +75,33 @@ class RomSearcherThread : public QThread
     QString directory;
     bool recursive = false;
     int  maxItems = 0;
-    bool stop = false;
+    bool incremental = false;
+    bool modifiedDirectoriesOnly = false;
+    QStringList modifiedDirectories;
+    std::atomic<bool> stop = false;
+
+    // directory tree of the last search, it's
+    // stored in the user cache directory so
+    // it can be compared with after a restart
+    QString snapshotDirectory;
+    bool    snapshotRecursive = false;
+    bool    snapshotLoaded    = false;
+    QHash<QString, RomSearcherThreadDirectory> snapshot;
+
+    void loadSnapshot(void);
+    void saveSnapshot(void);
 
     void searchDirectory(QString);
 
+    void searchRoms(QList<QString> roms, const QHash<QString, RomSearcherThreadDirectory>& directories);
+
   signals:
     void RomsFound(QList<RomSearcherThreadData> data, int index, int count);
+    // ROMs which have been removed or modified,
+    // modified ROMs are reported again by RomsFound
+    void RomsRemoved(QStringList files);
+    // every directory which has been searched
+    void DirectoriesFound(QStringList directories);
     void Finished(bool canceled);
 };
 } // namespace Thread
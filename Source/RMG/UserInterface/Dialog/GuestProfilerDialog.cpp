@@ -0,0 +1,185 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "GuestProfilerDialog.hpp"
+#include "Utilities/QtMessageBox.hpp"
+
+#include <RMG-Core/GuestProfiler.hpp>
+#include <RMG-Core/Error.hpp>
+
+#include <QTableWidgetItem>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QHash>
+#include <QIcon>
+
+#include <algorithm>
+
+using namespace UserInterface::Dialog;
+using namespace Utilities;
+
+//
+// Local Defines
+//
+
+#define REFRESH_INTERVAL_MS 1000
+// only the hottest functions are shown
+#define MAX_FUNCTIONS 500
+
+//
+// Local Functions
+//
+
+static QString getFunctionName(uint32_t address)
+{
+    if (address == 0)
+    {
+        return QObject::tr("Other");
+    }
+
+    return "0x" + QString("%1").arg(address, 8, 16, QLatin1Char('0')).toUpper();
+}
+
+static QTableWidgetItem* createNumberItem(QString text)
+{
+    QTableWidgetItem* item = new QTableWidgetItem(text);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+//
+// Exported Functions
+//
+
+GuestProfilerDialog::GuestProfilerDialog(QWidget *parent) : QDialog(parent)
+{
+    // created before setupUi() so its slot is connected by name
+    this->refreshTimer = new QTimer(this);
+    this->refreshTimer->setObjectName("refreshTimer");
+    this->refreshTimer->setInterval(REFRESH_INTERVAL_MS);
+
+    this->setupUi(this);
+    this->setWindowIcon(QIcon(":Resource/RMG.png"));
+    this->setWindowFlags(this->windowFlags() | Qt::WindowMinimizeButtonHint);
+
+    this->tableWidget->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    this->tableWidget->horizontalHeader()->setStretchLastSection(true);
+
+    this->updateButtons();
+}
+
+GuestProfilerDialog::~GuestProfilerDialog(void)
+{
+}
+
+void GuestProfilerDialog::updateButtons(void)
+{
+    this->startStopButton->setText(CoreIsGuestProfilerRunning() ? tr("Stop") : tr("Start"));
+}
+
+void GuestProfilerDialog::refreshProfile(void)
+{
+    CoreGuestProfile profile;
+    QHash<uint32_t, const CoreGuestProfileStack*> topCallers;
+
+    if (!CoreGetGuestProfile(profile))
+    {
+        this->statusLabel->setText(QString::fromStdString(CoreGetError()));
+        return;
+    }
+
+    // the stacks are sorted by cycles, so the
+    // first one with a caller is the top caller
+    for (const CoreGuestProfileStack& stack : profile.Stacks)
+    {
+        if (stack.Caller != 0 && !topCallers.contains(stack.Function))
+        {
+            topCallers.insert(stack.Function, &stack);
+        }
+    }
+
+    const int rowCount = std::min((int)profile.Functions.size(), MAX_FUNCTIONS);
+
+    this->tableWidget->setUpdatesEnabled(false);
+    this->tableWidget->setRowCount(rowCount);
+
+    for (int row = 0; row < rowCount; row++)
+    {
+        const CoreGuestProfileFunction& function = profile.Functions[row];
+        const double percentage = (profile.Cycles == 0) ? 0 : (double)function.Cycles * 100 / profile.Cycles;
+
+        QString topCaller;
+        const CoreGuestProfileStack* stack = topCallers.value(function.Address, nullptr);
+        if (stack != nullptr && function.Cycles != 0)
+        {
+            topCaller = QString("%1 (%2%)").arg(getFunctionName(stack->Caller))
+                            .arg((double)stack->Cycles * 100 / function.Cycles, 0, 'f', 1);
+        }
+
+        this->tableWidget->setItem(row, 0, new QTableWidgetItem(getFunctionName(function.Address)));
+        this->tableWidget->setItem(row, 1, createNumberItem(QString("%1%").arg(percentage, 0, 'f', 2)));
+        this->tableWidget->setItem(row, 2, createNumberItem(QString::number(function.Samples)));
+        this->tableWidget->setItem(row, 3, new QTableWidgetItem(topCaller));
+    }
+
+    this->tableWidget->setUpdatesEnabled(true);
+
+    QString status = tr("%1 samples, %2 cycles").arg(profile.Samples).arg(profile.Cycles);
+    if (profile.DroppedSamples > 0)
+    {
+        status += tr(", %1 samples dropped").arg(profile.DroppedSamples);
+    }
+    this->statusLabel->setText(status);
+}
+
+void GuestProfilerDialog::on_startStopButton_clicked(void)
+{
+    if (CoreIsGuestProfilerRunning())
+    {
+        if (!CoreStopGuestProfiler())
+        {
+            QtMessageBox::Error(this, "CoreStopGuestProfiler() Failed", QString::fromStdString(CoreGetError()));
+        }
+        this->refreshTimer->stop();
+        this->refreshProfile();
+    }
+    else
+    {
+        if (!CoreStartGuestProfiler())
+        {
+            QtMessageBox::Error(this, "CoreStartGuestProfiler() Failed", QString::fromStdString(CoreGetError()));
+        }
+        else
+        {
+            this->refreshTimer->start();
+            this->refreshProfile();
+        }
+    }
+
+    this->updateButtons();
+}
+
+void GuestProfilerDialog::on_exportButton_clicked(void)
+{
+    QString file = QFileDialog::getSaveFileName(this, tr("Export Flame Graph"), "", tr("Collapsed Stacks (*.folded *.txt);;All Files (*)"));
+    if (file.isEmpty())
+    {
+        return;
+    }
+
+    if (!CoreSaveGuestProfileFlameGraph(file.toStdU32String()))
+    {
+        QtMessageBox::Error(this, "CoreSaveGuestProfileFlameGraph() Failed", QString::fromStdString(CoreGetError()));
+    }
+}
+
+void GuestProfilerDialog::on_refreshTimer_timeout(void)
+{
+    this->refreshProfile();
+}
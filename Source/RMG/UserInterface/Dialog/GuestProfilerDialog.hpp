@@ -0,0 +1,48 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef GUESTPROFILERDIALOG_HPP
+#define GUESTPROFILERDIALOG_HPP
+
+#include <QDialog>
+#include <QWidget>
+#include <QTimer>
+
+#include "ui_GuestProfilerDialog.h"
+
+namespace UserInterface
+{
+namespace Dialog
+{
+class GuestProfilerDialog : public QDialog, private Ui::GuestProfilerDialog
+{
+    Q_OBJECT
+
+  private:
+    // the profile is retrieved periodically while the
+    // profiler runs, also when the dialog is hidden,
+    // otherwise the core drops samples
+    QTimer* refreshTimer = nullptr;
+
+    void updateButtons(void);
+    void refreshProfile(void);
+
+  public:
+    GuestProfilerDialog(QWidget* parent = nullptr);
+    ~GuestProfilerDialog(void);
+
+  private slots:
+    void on_startStopButton_clicked(void);
+    void on_exportButton_clicked(void);
+    void on_refreshTimer_timeout(void);
+};
+} // namespace Dialog
+} // namespace UserInterface
+
+#endif // GUESTPROFILERDIALOG_HPP
@@ -294,6 +294,7 @@ void SettingsDialog::loadCoreSettings(void)
     QString ntscPifROM;
     QString palPifRom;
     bool overrideGameSettings = false;
+    bool rewindEnabled = false;
 
     disableExtraMem = CoreSettingsGetBoolValue(SettingsID::CoreOverlay_DisableExtraMem);
     counterFactor = CoreSettingsGetIntValue(SettingsID::CoreOverlay_CountPerOp);
@@ -305,10 +306,12 @@ void SettingsDialog::loadCoreSettings(void)
     ntscPifROM = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::Core_PIF_NTSC));
     palPifRom = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::Core_PIF_PAL));
     overrideGameSettings = CoreSettingsGetBoolValue(SettingsID::Core_OverrideGameSpecificSettings);
+    rewindEnabled = CoreSettingsGetBoolValue(SettingsID::Core_Rewind_Enabled);
 
     this->coreCpuEmulatorComboBox->setCurrentIndex(cpuEmulator);
     this->coreSaveFilenameFormatComboBox->setCurrentIndex(saveFilenameFormat);
     this->coreRandomizeTimingCheckBox->setChecked(randomizeInterrupt);
+    this->coreRewindCheckBox->setChecked(rewindEnabled);
 
     this->usePifRomGroupBox->setChecked(usePIFROM);
     this->ntscPifRomLineEdit->setText(ntscPifROM);
@@ -575,6 +578,7 @@ void SettingsDialog::loadDefaultCoreSettings(void)
     QString ntscPifROM;
     QString palPifRom;
     bool overrideGameSettings;
+    bool rewindEnabled;
 
     disableExtraMem = CoreSettingsGetDefaultBoolValue(SettingsID::CoreOverlay_DisableExtraMem);
     counterFactor = CoreSettingsGetDefaultIntValue(SettingsID::CoreOverlay_CountPerOp);
@@ -586,10 +590,12 @@ void SettingsDialog::loadDefaultCoreSettings(void)
     ntscPifROM = QString::fromStdString(CoreSettingsGetDefaultStringValue(SettingsID::Core_PIF_NTSC));
     palPifRom = QString::fromStdString(CoreSettingsGetDefaultStringValue(SettingsID::Core_PIF_PAL));
     overrideGameSettings = CoreSettingsGetDefaultBoolValue(SettingsID::Core_OverrideGameSpecificSettings);
+    rewindEnabled = CoreSettingsGetDefaultBoolValue(SettingsID::Core_Rewind_Enabled);
 
     this->coreCpuEmulatorComboBox->setCurrentIndex(cpuEmulator);
     this->coreSaveFilenameFormatComboBox->setCurrentIndex(saveFilenameFormat);
     this->coreRandomizeTimingCheckBox->setChecked(randomizeInterrupt);
+    this->coreRewindCheckBox->setChecked(rewindEnabled);
 
     this->usePifRomGroupBox->setChecked(usePIFROM);
     this->ntscPifRomLineEdit->setText(ntscPifROM);
@@ -773,6 +779,7 @@ void SettingsDialog::saveCoreSettings(void)
     QString ntscPifROM = this->ntscPifRomLineEdit->text();
     QString palPifROM = this->palPifRomLineEdit->text();
     bool overrideGameSettings = this->coreOverrideGameSettingsGroup->isChecked();
+    bool rewindEnabled = this->coreRewindCheckBox->isChecked();
 
     CoreSettingsSetValue(SettingsID::CoreOverlay_CPU_Emulator, cpuEmulator);
     CoreSettingsSetValue(SettingsID::CoreOverLay_SaveFileNameFormat, saveFilenameFormat);
@@ -781,6 +788,7 @@ void SettingsDialog::saveCoreSettings(void)
     CoreSettingsSetValue(SettingsID::Core_PIF_NTSC, ntscPifROM.toStdString());
     CoreSettingsSetValue(SettingsID::Core_PIF_PAL, palPifROM.toStdString());
     CoreSettingsSetValue(SettingsID::Core_OverrideGameSpecificSettings, overrideGameSettings);
+    CoreSettingsSetValue(SettingsID::Core_Rewind_Enabled, rewindEnabled);
 
     if (!overrideGameSettings)
     {
@@ -1007,6 +1015,7 @@ void SettingsDialog::commonHotkeySettings(SettingsDialogAction action)
         { this->saveAsKeyButton, SettingsID::KeyBinding_SaveAs },
         { this->loadStateKeyButton, SettingsID::KeyBinding_LoadState },
         { this->loadKeyButton, SettingsID::KeyBinding_Load },
+        { this->rewindKeyButton, SettingsID::KeyBinding_Rewind },
         { this->cheatsKeyButton, SettingsID::KeyBinding_Cheats },
         { this->gsButtonKeyButton, SettingsID::KeyBinding_GSButton },
     };
@@ -1517,6 +1526,7 @@ void SettingsDialog::on_KeybindButton_KeybindingChanged(KeybindButton* button)
         this->saveAsKeyButton, 
         this->loadStateKeyButton,
         this->loadKeyButton,
+        this->rewindKeyButton,
         this->cheatsKeyButton, 
         this->gsButtonKeyButton,
         this->saveState0KeyButton,
@@ -211,6 +211,7 @@ void MainWindow::closeEvent(QCloseEvent *event)
 #endif // NETPLAY
 
     this->logDialog.close();
+    this->guestProfilerDialog.close();
 
     while (this->emulationThread->isRunning())
     {
@@ -784,6 +785,9 @@ void MainWindow::updateActions(bool inEmulation, bool isPaused)
     keyBinding = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::KeyBinding_Load));
     this->action_System_Load->setEnabled(inEmulation && !CoreHasInitNetplay());
     this->action_System_Load->setShortcut(QKeySequence(keyBinding));
+    keyBinding = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::KeyBinding_Rewind));
+    this->action_System_Rewind->setEnabled(inEmulation && !CoreHasInitNetplay() && CoreSettingsGetBoolValue(SettingsID::Core_Rewind_Enabled));
+    this->action_System_Rewind->setShortcut(QKeySequence(keyBinding));
     this->menuCurrent_Save_State->setEnabled(inEmulation);
     keyBinding = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::KeyBinding_Cheats));
     this->action_System_Cheats->setEnabled(inEmulation && !CoreHasInitNetplay());
@@ -1043,6 +1047,7 @@ void MainWindow::configureActions(void)
         this->actionSpeed250, this->actionSpeed275, this->actionSpeed300,
         this->action_System_SaveState, this->action_System_SaveAs,
         this->action_System_LoadState, this->action_System_Load,
+        this->action_System_Rewind,
         this->actionSlot_0, this->actionSlot_1, this->actionSlot_2,
         this->actionSlot_3, this->actionSlot_4, this->actionSlot_5,
         this->actionSlot_6, this->actionSlot_7, this->actionSlot_8,
@@ -1054,7 +1059,7 @@ void MainWindow::configureActions(void)
         this->action_Settings_Settings,
         // View actions
         this->action_View_Fullscreen, this->action_View_RefreshRoms,
-        this->action_View_Log,
+        this->action_View_Log, this->action_View_Profiler,
         // Help actions
         this->action_Help_Github, this->action_Help_About,
     });
@@ -1176,6 +1181,7 @@ void MainWindow::connectActionSignals(void)
     connect(this->action_System_SaveAs, &QAction::triggered, this, &MainWindow::on_Action_System_SaveAs);
     connect(this->action_System_LoadState, &QAction::triggered, this, &MainWindow::on_Action_System_LoadState);
     connect(this->action_System_Load, &QAction::triggered, this, &MainWindow::on_Action_System_Load);
+    connect(this->action_System_Rewind, &QAction::triggered, this, &MainWindow::on_Action_System_Rewind);
     connect(this->action_System_Cheats, &QAction::triggered, this, &MainWindow::on_Action_System_Cheats);
     connect(this->action_System_GSButton, &QAction::triggered, this, &MainWindow::on_Action_System_GSButton);
 
@@ -1195,6 +1201,7 @@ void MainWindow::connectActionSignals(void)
     connect(this->action_View_RefreshRoms, &QAction::triggered, this, &MainWindow::on_Action_View_RefreshRoms);
     connect(this->action_View_ClearRomCache, &QAction::triggered, this, &MainWindow::on_Action_View_ClearRomCache);
     connect(this->action_View_Log, &QAction::triggered, this, &MainWindow::on_Action_View_Log);
+    connect(this->action_View_Profiler, &QAction::triggered, this, &MainWindow::on_Action_View_Profiler);
 
     connect(this->action_Netplay_CreateSession, &QAction::triggered, this, &MainWindow::on_Action_Netplay_CreateSession);
     connect(this->action_Netplay_BrowseSessions, &QAction::triggered, this, &MainWindow::on_Action_Netplay_BrowseSessions);
@@ -1821,6 +1828,18 @@ void MainWindow::on_Action_System_Load(void)
     }
 }
 
+void MainWindow::on_Action_System_Rewind(void)
+{
+    // step back to the previous rewind snapshot,
+    // holding the key repeats the action
+    int frames = CoreSettingsGetIntValue(SettingsID::Core_Rewind_Interval);
+
+    if (!CoreRewind(frames))
+    {
+        this->showErrorMessage("CoreRewind() Failed", QString::fromStdString(CoreGetError()));
+    }
+}
+
 void MainWindow::on_Action_System_CurrentSaveState(int slot)
 {
     if (!CoreSetSaveStateSlot(slot))
@@ -1988,6 +2007,11 @@ void MainWindow::on_Action_View_Log(void)
     this->logDialog.show();
 }
 
+void MainWindow::on_Action_View_Profiler(void)
+{
+    this->guestProfilerDialog.show();
+}
+
 void MainWindow::on_Action_Netplay_CreateSession(void)
 {
 #ifdef NETPLAY
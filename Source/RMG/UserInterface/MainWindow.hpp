@@ -24,6 +24,7 @@
 #include "Dialog/Netplay/NetplaySessionDialog.hpp"
 #endif // NETPLAY
 #include "Dialog/LogDialog.hpp"
+#include "Dialog/GuestProfilerDialog.hpp"
 
 #ifdef UPDATER
 #include <QNetworkReply>
@@ -118,6 +119,7 @@ class MainWindow : public QMainWindow, private Ui::MainWindow
     QString ui_WindowTitle;
 
     Dialog::LogDialog logDialog;
+    Dialog::GuestProfilerDialog guestProfilerDialog;
     
     // Add the rollback overlay widget
     RollbackOverlay* m_rollbackOverlay;
@@ -202,6 +204,7 @@ class MainWindow : public QMainWindow, private Ui::MainWindow
     void on_Action_System_SaveAs(void);
     void on_Action_System_LoadState(void);
     void on_Action_System_Load(void);
+    void on_Action_System_Rewind(void);
     void on_Action_System_CurrentSaveState(int slot);
     void on_Action_System_Cheats(void);
     void on_Action_System_GSButton(void);
@@ -222,6 +225,7 @@ class MainWindow : public QMainWindow, private Ui::MainWindow
     void on_Action_View_RefreshRoms(void);
     void on_Action_View_ClearRomCache(void);
     void on_Action_View_Log(void);
+    void on_Action_View_Profiler(void);
 
     void on_Action_Netplay_CreateSession(void);
     void on_Action_Netplay_BrowseSessions(void);
@@ -0,0 +1,219 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "RomBrowserCoverLoader.hpp"
+
+#include <QImageReader>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QThread>
+#include <QFile>
+#include <QDir>
+
+#include <RMG-Core/Directories.hpp>
+
+#include <algorithm>
+
+using namespace UserInterface::Widget;
+
+RomBrowserCoverLoader::RomBrowserCoverLoader(QObject* parent) : QObject(parent)
+{
+    // decoding covers is mostly spent waiting on
+    // the disk and the image decoder, so a few
+    // threads are enough to keep up with the UI
+    this->threadPool.setMaxThreadCount(std::clamp(QThread::idealThreadCount(), 2, 4));
+}
+
+RomBrowserCoverLoader::~RomBrowserCoverLoader(void)
+{
+    this->Clear();
+    this->threadPool.waitForDone();
+}
+
+void RomBrowserCoverLoader::SetCoversDirectory(QString directory)
+{
+    this->coversDirectory = directory;
+}
+
+void RomBrowserCoverLoader::SetThumbnailsDirectory(QString directory)
+{
+    this->thumbnailsDirectory = directory;
+}
+
+void RomBrowserCoverLoader::SetThumbnailSize(QSize size)
+{
+    this->thumbnailSize = size;
+}
+
+QSize RomBrowserCoverLoader::GetThumbnailSize(void)
+{
+    return this->thumbnailSize;
+}
+
+void RomBrowserCoverLoader::Load(QString file, CoreRomHeader header, CoreRomSettings settings)
+{
+    int     generation          = this->generation;
+    QString coversDirectory     = this->coversDirectory;
+    QString thumbnailsDirectory = this->thumbnailsDirectory;
+    QSize   thumbnailSize       = this->thumbnailSize;
+
+    this->threadPool.start([=, this]()
+    {
+        this->loadCover(generation, file, header, settings, coversDirectory, thumbnailsDirectory, thumbnailSize);
+    });
+}
+
+void RomBrowserCoverLoader::Clear(void)
+{
+    this->generation++;
+    this->threadPool.clear();
+}
+
+int RomBrowserCoverLoader::GetGeneration(void)
+{
+    return this->generation;
+}
+
+void RomBrowserCoverLoader::loadCover(int generation, QString file, CoreRomHeader header, CoreRomSettings settings,
+                                      QString coversDirectory, QString thumbnailsDirectory, QSize thumbnailSize)
+{
+    QImage  thumbnail;
+    QString coverFile;
+
+    // don't bother when the cover isn't needed anymore
+    if (generation != this->generation)
+    {
+        return;
+    }
+
+    // construct basename of file,
+    // by retrieving the last index of '.'
+    // and removing all characters from that index
+    // until the end of the string
+    QString baseName         = QFileInfo(file).fileName();
+    qsizetype lastIndexOfDot = baseName.lastIndexOf(".");
+    if (lastIndexOfDot != -1)
+    { // only remove when index was found
+        baseName.remove(lastIndexOfDot, baseName.size() - lastIndexOfDot);
+    }
+
+    // try to find cover using
+    // 1) basename of file
+    // 2) MD5
+    // 3) good name
+    // 4) internal name
+    for (QString name : {
+        baseName,
+        QString::fromStdString(settings.MD5),
+        QString::fromStdString(settings.GoodName),
+        QString::fromStdString(header.Name) })
+    {
+        // fixup file name
+        QString fixedName = name;
+        for (const QChar c : QString(":<>\"/\\|?*"))
+        {
+            fixedName.replace(c, "_");
+        }
+
+        // skip empty names,
+        // this can i.e happen
+        // when ROMs don't have
+        // an internal ROM name
+        if (fixedName.isEmpty())
+        {
+            continue;
+        }
+
+        // we support jpg & png as file extensions
+        for (QString ext : { ".png", ".jpg", ".jpeg" })
+        {
+            QString coverPath = coversDirectory;
+            coverPath += CORE_DIR_SEPERATOR_STR;
+            coverPath += fixedName;
+            coverPath += ext;
+
+            if (QFile::exists(coverPath))
+            {
+                coverFile = coverPath;
+                break;
+            }
+        }
+
+        if (!coverFile.isEmpty())
+        {
+            break;
+        }
+    }
+
+    if (coverFile.isEmpty())
+    {
+        emit this->CoverLoaded(generation, file, thumbnail, coverFile);
+        return;
+    }
+
+    // thumbnails are cached by the MD5 of the ROM,
+    // the modification time of the cover and the size
+    QString thumbnailFile = thumbnailsDirectory;
+    thumbnailFile += CORE_DIR_SEPERATOR_STR;
+    thumbnailFile += QString::fromStdString(settings.MD5);
+    thumbnailFile += "_";
+    thumbnailFile += QString::number(QFileInfo(coverFile).lastModified().toMSecsSinceEpoch(), 16);
+    thumbnailFile += "_";
+    thumbnailFile += QString::number(thumbnailSize.width());
+    thumbnailFile += "x";
+    thumbnailFile += QString::number(thumbnailSize.height());
+    thumbnailFile += ".png";
+
+    if (!settings.MD5.empty() && thumbnail.load(thumbnailFile))
+    {
+        emit this->CoverLoaded(generation, file, thumbnail, coverFile);
+        return;
+    }
+
+    // only decode the cover at the size we need,
+    // which is a lot faster for JPEG images
+    QImageReader reader(coverFile);
+    QSize coverSize = reader.size();
+    if (coverSize.isValid() &&
+        (coverSize.width() > thumbnailSize.width() || coverSize.height() > thumbnailSize.height()))
+    {
+        reader.setScaledSize(coverSize.scaled(thumbnailSize, Qt::KeepAspectRatio));
+    }
+
+    if (!reader.read(&thumbnail))
+    {
+        // fallback to the placeholder
+        coverFile.clear();
+        emit this->CoverLoaded(generation, file, QImage(), coverFile);
+        return;
+    }
+
+    // the reader may not support scaling
+    if (thumbnail.width() > thumbnailSize.width() ||
+        thumbnail.height() > thumbnailSize.height())
+    {
+        thumbnail = thumbnail.scaled(thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    // write the thumbnail atomically, because
+    // another ROM with the same MD5 may be
+    // reading or writing it at the same time
+    if (!settings.MD5.empty() && QDir().mkpath(thumbnailsDirectory))
+    {
+        QSaveFile saveFile(thumbnailFile);
+        if (saveFile.open(QIODevice::WriteOnly) &&
+            thumbnail.save(&saveFile, "PNG"))
+        {
+            saveFile.commit();
+        }
+    }
+
+    emit this->CoverLoaded(generation, file, thumbnail, coverFile);
+}
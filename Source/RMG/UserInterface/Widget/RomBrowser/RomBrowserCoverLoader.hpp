@@ -0,0 +1,72 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ROMBROWSERCOVERLOADER_HPP
+#define ROMBROWSERCOVERLOADER_HPP
+
+#include <RMG-Core/RomSettings.hpp>
+#include <RMG-Core/RomHeader.hpp>
+
+#include <QThreadPool>
+#include <QObject>
+#include <QString>
+#include <QImage>
+#include <QSize>
+
+#include <atomic>
+
+namespace UserInterface
+{
+namespace Widget
+{
+class RomBrowserCoverLoader : public QObject
+{
+    Q_OBJECT
+
+  public:
+    RomBrowserCoverLoader(QObject* parent);
+    ~RomBrowserCoverLoader(void);
+
+    void SetCoversDirectory(QString directory);
+    void SetThumbnailsDirectory(QString directory);
+    void SetThumbnailSize(QSize size);
+    QSize GetThumbnailSize(void);
+
+    // queues looking up, decoding and downscaling
+    // the cover of the given ROM, CoverLoaded is
+    // emitted when it's done
+    void Load(QString file, CoreRomHeader header, CoreRomSettings settings);
+
+    // drops the queued covers, covers which are being
+    // loaded are emitted with an outdated generation
+    void Clear(void);
+
+    // returns the current generation, it changes
+    // every time the queued covers are dropped
+    int GetGeneration(void);
+
+  private:
+    QThreadPool threadPool;
+    std::atomic<int> generation = 0;
+
+    QString coversDirectory;
+    QString thumbnailsDirectory;
+    QSize   thumbnailSize;
+
+    void loadCover(int generation, QString file, CoreRomHeader header, CoreRomSettings settings,
+                    QString coversDirectory, QString thumbnailsDirectory, QSize thumbnailSize);
+
+  signals:
+    // thumbnail is a null image when no cover was found
+    void CoverLoaded(int generation, QString file, QImage thumbnail, QString coverFile);
+};
+} // namespace Widget
+} // namespace UserInterface
+
+#endif // ROMBROWSERCOVERLOADER_HPP
@@ -8,15 +8,74 @@
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include "RomBrowserGridViewWidget.hpp"
+#include "RomBrowserModel.hpp"
 
+#include <QStyledItemDelegate>
 #include <QDragEnterEvent>
 #include <QDragMoveEvent>
 #include <QMimeData>
 
 using namespace UserInterface::Widget;
 
+//
+// Local Classes
+//
+
+// shows the covers of the model, the covers
+// are only loaded once they're painted
+class RomBrowserCoverDelegate : public QStyledItemDelegate
+{
+  public:
+    RomBrowserCoverDelegate(QObject* parent) : QStyledItemDelegate(parent)
+    {
+    }
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override
+    {
+        const RomBrowserModel* model = qobject_cast<const RomBrowserModel*>(index.model());
+        if (model != nullptr)
+        {
+            model->LoadCover(index.row());
+        }
+
+        QStyledItemDelegate::paint(painter, option, index);
+    }
+
+  protected:
+    void initStyleOption(QStyleOptionViewItem* option, const QModelIndex& index) const override
+    {
+        QStyledItemDelegate::initStyleOption(option, index);
+
+        option->icon = index.data(RomBrowserModel::CoverRole).value<QIcon>();
+        if (option->icon.isNull())
+        {
+            return;
+        }
+
+        QIcon::Mode mode = QIcon::Normal;
+        if (!(option->state & QStyle::State_Enabled))
+        {
+            mode = QIcon::Disabled;
+        }
+        else if (option->state & QStyle::State_Selected)
+        {
+            mode = QIcon::Selected;
+        }
+
+        QSize actualSize = option->icon.actualSize(option->decorationSize, mode, QIcon::Off);
+        option->decorationSize = actualSize.boundedTo(option->decorationSize);
+        option->features |= QStyleOptionViewItem::HasDecoration;
+    }
+};
+
+//
+// Exported Functions
+//
+
 RomBrowserGridViewWidget::RomBrowserGridViewWidget(QWidget* parent) : QListView(parent)
 {
+    this->setItemDelegate(new RomBrowserCoverDelegate(this));
+
 #ifdef DRAG_DROP
     // configure drag & drop
     this->setDragDropMode(QAbstractItemView::DragDropMode::DropOnly);
@@ -0,0 +1,562 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "RomBrowserModel.hpp"
+
+#include <QPixmap>
+#include <QSet>
+
+#include <functional>
+#include <algorithm>
+
+using namespace UserInterface::Widget;
+
+//
+// Local Functions
+//
+
+static QString get_file_name(const QString& file)
+{
+    return file.mid(file.lastIndexOf('/') + 1);
+}
+
+static QString get_file_size_string(qint64 size)
+{
+    QString fileSizeString = QString::number(size / 1048576.0, 'f', 2).append(" MB");
+    if (fileSizeString.size() == 7)
+    {
+        fileSizeString.prepend("  ");
+    }
+    return fileSizeString;
+}
+
+//
+// Exported Functions
+//
+
+RomBrowserModel::RomBrowserModel(QObject* parent, RomBrowserCoverLoader* coverLoader) : QAbstractTableModel(parent)
+{
+    this->coverLoader = coverLoader;
+    this->placeholderCoverIcon = QIcon(QPixmap(":Resource/CoverFallback.png"));
+    connect(this->coverLoader, &RomBrowserCoverLoader::CoverLoaded, this, &RomBrowserModel::on_CoverLoader_CoverLoaded);
+}
+
+RomBrowserModel::~RomBrowserModel(void)
+{
+}
+
+int RomBrowserModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+
+    return this->rows.size();
+}
+
+int RomBrowserModel::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+
+    return Column::ColumnCount;
+}
+
+QVariant RomBrowserModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= this->rows.size())
+    {
+        return QVariant();
+    }
+
+    const int rom = this->rows.at(index.row());
+
+    // the text is only created for the
+    // items which are being shown
+    if (role == Qt::DisplayRole)
+    {
+        return this->getText(rom, index.column());
+    }
+    else if (role == CoverRole)
+    {
+        const QIcon& cover = this->covers.at(rom);
+        return QVariant::fromValue<QIcon>(cover.isNull() ? this->placeholderCoverIcon : cover);
+    }
+
+    return QVariant();
+}
+
+QVariant RomBrowserModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section)
+    {
+    case Column::Name:
+        return "Name";
+    case Column::InternalName:
+        return "Internal Name";
+    case Column::MD5:
+        return "MD5";
+    case Column::GameFormat:
+        return "Format";
+    case Column::FileName:
+        return "File Name";
+    case Column::FileExtension:
+        return "File Ext.";
+    case Column::FileSize:
+        return "File Size";
+    case Column::GameID:
+        return "I.D.";
+    case Column::GameRegion:
+        return "Region";
+    default:
+        return QVariant();
+    }
+}
+
+void RomBrowserModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column >= Column::ColumnCount)
+    {
+        return;
+    }
+
+    this->sortColumn = column;
+    this->sortOrder  = order;
+
+    emit this->layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // keep the selection and the current
+    // item on the same ROMs
+    const QModelIndexList oldIndexes = this->persistentIndexList();
+    QList<int> oldIndexRoms;
+    oldIndexRoms.reserve(oldIndexes.size());
+    for (const QModelIndex& index : oldIndexes)
+    {
+        oldIndexRoms.append(this->rows.at(index.row()));
+    }
+
+    this->sortRows();
+    this->updateRomRows();
+
+    QModelIndexList newIndexes;
+    newIndexes.reserve(oldIndexes.size());
+    for (qsizetype i = 0; i < oldIndexes.size(); i++)
+    {
+        newIndexes.append(this->index(this->romRows.at(oldIndexRoms.at(i)), oldIndexes.at(i).column()));
+    }
+    this->changePersistentIndexList(oldIndexes, newIndexes);
+
+    emit this->layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void RomBrowserModel::AddRoms(const QList<RomSearcherThreadData>& data)
+{
+    QStringList replacedFiles;
+
+    for (const RomSearcherThreadData& romData : data)
+    {
+        if (this->romIndexes.contains(romData.File))
+        {
+            replacedFiles.append(romData.File);
+        }
+    }
+
+    if (!replacedFiles.isEmpty())
+    {
+        this->RemoveRoms(replacedFiles);
+    }
+
+    const int firstRom = this->files.size();
+
+    for (const RomSearcherThreadData& romData : data)
+    {
+        // the name is needed for sorting and filtering,
+        // so it's the only text which is stored
+        QString name = QString::fromStdString(romData.Settings.GoodName);
+        if (name.endsWith("(unknown rom)") ||
+            name.endsWith("(unknown disk)"))
+        {
+            name = get_file_name(romData.File);
+        }
+
+        this->romIndexes.insert(romData.File, this->files.size());
+        this->files.append(romData.File);
+        this->names.append(name);
+        this->types.append(romData.Type);
+        this->headers.append(romData.Header);
+        this->settings.append(romData.Settings);
+        this->fileSizes.append(romData.FileSize);
+        this->coverFiles.append(QString());
+        this->covers.append(QIcon());
+        this->coverStates.append(CoverState::None);
+        this->romRows.append(-1);
+    }
+
+    QList<int> newRows;
+    for (int rom = firstRom; rom < this->files.size(); rom++)
+    {
+        if (this->matchesFilter(rom))
+        {
+            newRows.append(rom);
+        }
+    }
+
+    if (newRows.isEmpty())
+    {
+        return;
+    }
+
+    const int firstRow = this->rows.size();
+    this->beginInsertRows(QModelIndex(), firstRow, firstRow + newRows.size() - 1);
+    for (int rom : newRows)
+    {
+        this->romRows[rom] = this->rows.size();
+        this->rows.append(rom);
+    }
+    this->endInsertRows();
+}
+
+void RomBrowserModel::RemoveRoms(const QStringList& files)
+{
+    QSet<int>  removedRoms;
+    QList<int> removedRows;
+
+    for (const QString& file : files)
+    {
+        auto iter = this->romIndexes.constFind(file);
+        if (iter == this->romIndexes.cend())
+        {
+            continue;
+        }
+
+        removedRoms.insert(iter.value());
+        if (this->romRows.at(iter.value()) != -1)
+        {
+            removedRows.append(this->romRows.at(iter.value()));
+        }
+    }
+
+    if (removedRoms.isEmpty())
+    {
+        return;
+    }
+
+    // remove the rows from the bottom up,
+    // in as few ranges as possible
+    std::sort(removedRows.begin(), removedRows.end(), std::greater<int>());
+    for (qsizetype i = 0; i < removedRows.size();)
+    {
+        int last  = removedRows.at(i);
+        int first = last;
+        while (++i < removedRows.size() && removedRows.at(i) == first - 1)
+        {
+            first--;
+        }
+
+        this->beginRemoveRows(QModelIndex(), first, last);
+        this->rows.remove(first, last - first + 1);
+        this->endRemoveRows();
+    }
+
+    // compact the ROMs, the rows don't
+    // change so the views aren't notified
+    QList<int> newRomIndexes(this->files.size(), -1);
+    int newRom = 0;
+    for (int rom = 0; rom < this->files.size(); rom++)
+    {
+        if (removedRoms.contains(rom))
+        {
+            continue;
+        }
+
+        newRomIndexes[rom] = newRom;
+        if (newRom != rom)
+        {
+            this->files[newRom]       = std::move(this->files[rom]);
+            this->names[newRom]       = std::move(this->names[rom]);
+            this->types[newRom]       = this->types[rom];
+            this->headers[newRom]     = std::move(this->headers[rom]);
+            this->settings[newRom]    = std::move(this->settings[rom]);
+            this->fileSizes[newRom]   = this->fileSizes[rom];
+            this->coverFiles[newRom]  = std::move(this->coverFiles[rom]);
+            this->covers[newRom]      = std::move(this->covers[rom]);
+            this->coverStates[newRom] = this->coverStates[rom];
+        }
+        newRom++;
+    }
+
+    this->files.resize(newRom);
+    this->names.resize(newRom);
+    this->types.resize(newRom);
+    this->headers.resize(newRom);
+    this->settings.resize(newRom);
+    this->fileSizes.resize(newRom);
+    this->coverFiles.resize(newRom);
+    this->covers.resize(newRom);
+    this->coverStates.resize(newRom);
+    this->romRows.resize(newRom);
+
+    for (int& rom : this->rows)
+    {
+        rom = newRomIndexes.at(rom);
+    }
+
+    this->romIndexes.clear();
+    for (int rom = 0; rom < this->files.size(); rom++)
+    {
+        this->romIndexes.insert(this->files.at(rom), rom);
+    }
+
+    this->updateRomRows();
+}
+
+void RomBrowserModel::Clear(void)
+{
+    this->beginResetModel();
+    this->files.clear();
+    this->names.clear();
+    this->types.clear();
+    this->headers.clear();
+    this->settings.clear();
+    this->fileSizes.clear();
+    this->coverFiles.clear();
+    this->covers.clear();
+    this->coverStates.clear();
+    this->romIndexes.clear();
+    this->rows.clear();
+    this->romRows.clear();
+    this->endResetModel();
+}
+
+void RomBrowserModel::SetFilter(QString filter)
+{
+    if (this->filter == filter)
+    {
+        return;
+    }
+
+    this->beginResetModel();
+    this->filter = filter;
+    this->rebuildRows();
+    this->endResetModel();
+}
+
+bool RomBrowserModel::GetRomData(int row, RomBrowserModelData& data) const
+{
+    if (row < 0 || row >= this->rows.size())
+    {
+        return false;
+    }
+
+    const int rom = this->rows.at(row);
+
+    data = RomBrowserModelData(this->files.at(rom), this->types.at(rom), this->headers.at(rom), this->settings.at(rom));
+    data.coverFile = this->coverFiles.at(rom);
+    return true;
+}
+
+QList<RomBrowserModelData> RomBrowserModel::GetAllRomData(void) const
+{
+    QList<RomBrowserModelData> data;
+    data.reserve(this->files.size());
+
+    for (int rom = 0; rom < this->files.size(); rom++)
+    {
+        data.append(RomBrowserModelData(this->files.at(rom), this->types.at(rom), this->headers.at(rom), this->settings.at(rom)));
+        data.last().coverFile = this->coverFiles.at(rom);
+    }
+
+    return data;
+}
+
+void RomBrowserModel::LoadCover(int row) const
+{
+    if (row < 0 || row >= this->rows.size())
+    {
+        return;
+    }
+
+    const int rom = this->rows.at(row);
+    if (this->coverStates.at(rom) != CoverState::None)
+    {
+        return;
+    }
+
+    this->coverStates[rom] = CoverState::Loading;
+    this->coverLoader->Load(this->files.at(rom), this->headers.at(rom), this->settings.at(rom));
+}
+
+void RomBrowserModel::ReloadCover(int row)
+{
+    if (row < 0 || row >= this->rows.size())
+    {
+        return;
+    }
+
+    const int rom = this->rows.at(row);
+
+    this->covers[rom] = QIcon();
+    this->coverFiles[rom].clear();
+    this->coverStates[rom] = CoverState::None;
+
+    emit this->dataChanged(this->index(row, 0), this->index(row, 0), { CoverRole });
+}
+
+void RomBrowserModel::ReloadCovers(void)
+{
+    // covers which are being loaded
+    // are dropped by the cover loader
+    this->coverLoader->Clear();
+    this->coverStates.fill(CoverState::None);
+
+    if (!this->rows.isEmpty())
+    {
+        emit this->dataChanged(this->index(0, 0), this->index(this->rows.size() - 1, 0), { CoverRole });
+    }
+}
+
+bool RomBrowserModel::matchesFilter(int rom) const
+{
+    if (this->filter.isEmpty())
+    {
+        return true;
+    }
+
+    return this->names.at(rom).contains(this->filter, Qt::CaseInsensitive) ||
+           QString::fromStdString(this->headers.at(rom).Name).contains(this->filter, Qt::CaseInsensitive) ||
+           QString::fromStdString(this->settings.at(rom).MD5).contains(this->filter, Qt::CaseInsensitive) ||
+           get_file_name(this->files.at(rom)).contains(this->filter, Qt::CaseInsensitive);
+}
+
+QString RomBrowserModel::getText(int rom, int column) const
+{
+    switch (column)
+    {
+    case Column::Name:
+        return this->names.at(rom);
+    case Column::InternalName:
+        return QString::fromStdString(this->headers.at(rom).Name);
+    case Column::MD5:
+        return QString::fromStdString(this->settings.at(rom).MD5);
+    case Column::GameFormat:
+        return this->types.at(rom) == CoreRomType::Disk ? "Disk" : "Cartridge";
+    case Column::FileName:
+    {
+        QString fileName = get_file_name(this->files.at(rom));
+        qsizetype lastIndexOfDot = fileName.lastIndexOf('.');
+        return lastIndexOfDot == -1 ? fileName : fileName.left(lastIndexOfDot);
+    }
+    case Column::FileExtension:
+    {
+        QString fileName = get_file_name(this->files.at(rom));
+        qsizetype lastIndexOfDot = fileName.lastIndexOf('.');
+        return lastIndexOfDot == -1 ? "." : fileName.mid(lastIndexOfDot).toUpper();
+    }
+    case Column::FileSize:
+        return get_file_size_string(this->fileSizes.at(rom));
+    case Column::GameID:
+        return QString::fromStdString(this->headers.at(rom).GameID);
+    case Column::GameRegion:
+        return QString::fromStdString(this->headers.at(rom).Region);
+    default:
+        return QString();
+    }
+}
+
+void RomBrowserModel::sortRows(void)
+{
+    if (this->sortColumn == -1)
+    {
+        return;
+    }
+
+    const bool ascending = this->sortOrder == Qt::AscendingOrder;
+
+    if (this->sortColumn == Column::FileSize)
+    {
+        std::stable_sort(this->rows.begin(), this->rows.end(), [&](int a, int b)
+        {
+            return ascending ? this->fileSizes.at(a) < this->fileSizes.at(b) :
+                               this->fileSizes.at(b) < this->fileSizes.at(a);
+        });
+        return;
+    }
+
+    // create the sort keys once, instead of
+    // for every comparison
+    QList<QString> keys(this->files.size());
+    for (int rom : this->rows)
+    {
+        keys[rom] = this->getText(rom, this->sortColumn).toCaseFolded();
+    }
+
+    std::stable_sort(this->rows.begin(), this->rows.end(), [&](int a, int b)
+    {
+        return ascending ? keys.at(a) < keys.at(b) :
+                           keys.at(b) < keys.at(a);
+    });
+}
+
+void RomBrowserModel::updateRomRows(void)
+{
+    this->romRows.fill(-1);
+    for (int row = 0; row < this->rows.size(); row++)
+    {
+        this->romRows[this->rows.at(row)] = row;
+    }
+}
+
+void RomBrowserModel::rebuildRows(void)
+{
+    this->rows.clear();
+    for (int rom = 0; rom < this->files.size(); rom++)
+    {
+        if (this->matchesFilter(rom))
+        {
+            this->rows.append(rom);
+        }
+    }
+
+    this->sortRows();
+    this->updateRomRows();
+}
+
+void RomBrowserModel::on_CoverLoader_CoverLoaded(int generation, QString file, QImage thumbnail, QString coverFile)
+{
+    // ignore covers of ROMs which
+    // have been removed or reloaded
+    if (generation != this->coverLoader->GetGeneration())
+    {
+        return;
+    }
+
+    const int rom = this->romIndexes.value(file, -1);
+    if (rom == -1 || this->coverStates.at(rom) != CoverState::Loading)
+    {
+        return;
+    }
+
+    this->covers[rom] = thumbnail.isNull() ? QIcon() : QIcon(QPixmap::fromImage(thumbnail));
+    this->coverFiles[rom] = coverFile;
+    this->coverStates[rom] = CoverState::Loaded;
+
+    const int row = this->romRows.at(rom);
+    if (row != -1)
+    {
+        emit this->dataChanged(this->index(row, 0), this->index(row, 0), { CoverRole });
+    }
+}
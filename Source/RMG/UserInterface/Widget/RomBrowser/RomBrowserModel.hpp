@@ -0,0 +1,162 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ROMBROWSERMODEL_HPP
+#define ROMBROWSERMODEL_HPP
+
+#include "Thread/RomSearcherThread.hpp"
+
+#include "RomBrowserCoverLoader.hpp"
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <QString>
+#include <QImage>
+#include <QIcon>
+#include <QList>
+#include <QHash>
+
+#include <RMG-Core/RomSettings.hpp>
+#include <RMG-Core/RomHeader.hpp>
+#include <RMG-Core/Rom.hpp>
+
+struct RomBrowserModelData
+{
+    QString         file;
+    CoreRomType     type;
+    CoreRomHeader   header;
+    CoreRomSettings settings;
+    QString         coverFile;
+
+    RomBrowserModelData() {}
+
+    RomBrowserModelData(QString file, CoreRomType type, CoreRomHeader header, CoreRomSettings settings)
+    {
+        this->file     = file;
+        this->type     = type;
+        this->header   = header;
+        this->settings = settings;
+    }
+};
+
+Q_DECLARE_METATYPE(RomBrowserModelData);
+
+namespace UserInterface
+{
+namespace Widget
+{
+class RomBrowserModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+  public:
+    enum Column
+    {
+        Name = 0,
+        InternalName,
+        MD5,
+        GameFormat,
+        FileName,
+        FileExtension,
+        FileSize,
+        GameID,
+        GameRegion,
+        ColumnCount
+    };
+
+    // the cover of the ROM as QIcon, only used by the grid view
+    static constexpr int CoverRole = Qt::UserRole + 1;
+
+    RomBrowserModel(QObject* parent, RomBrowserCoverLoader* coverLoader);
+    ~RomBrowserModel(void);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // adds the ROMs, ROMs which are already
+    // in the model are replaced
+    void AddRoms(const QList<RomSearcherThreadData>& data);
+    void RemoveRoms(const QStringList& files);
+    void Clear(void);
+
+    // only shows the ROMs whose name, internal name,
+    // MD5 or file name contain the given text
+    void SetFilter(QString filter);
+
+    // retrieves the data of the ROM in the given row
+    bool GetRomData(int row, RomBrowserModelData& data) const;
+    // retrieves the data of every ROM, including
+    // the ROMs which are filtered out
+    QList<RomBrowserModelData> GetAllRomData(void) const;
+
+    // queues loading the cover of the ROM in the given row,
+    // used by the grid view when the ROM is painted, so
+    // only the covers which have been shown are loaded
+    void LoadCover(int row) const;
+    // drops the cover of the ROM in the given row
+    // and loads it again when it's shown
+    void ReloadCover(int row);
+    // loads every cover again when it's shown,
+    // the current covers are shown until then
+    void ReloadCovers(void);
+
+  private:
+    enum class CoverState : uint8_t
+    {
+        None,
+        Loading,
+        Loaded
+    };
+
+    RomBrowserCoverLoader* coverLoader = nullptr;
+    QIcon placeholderCoverIcon;
+
+    // the ROMs are stored per column, so
+    // sorting and filtering only has to
+    // go through the data it needs
+    QList<QString>         files;
+    QList<QString>         names;
+    QList<CoreRomType>     types;
+    QList<CoreRomHeader>   headers;
+    QList<CoreRomSettings> settings;
+    QList<qint64>          fileSizes;
+    QList<QString>         coverFiles;
+    QList<QIcon>           covers;
+    mutable QList<CoverState> coverStates;
+
+    // ROM index by file
+    QHash<QString, int> romIndexes;
+
+    // ROM index of each row, after filtering
+    // and sorting, and the row of each ROM,
+    // which is -1 when it's filtered out
+    QList<int> rows;
+    QList<int> romRows;
+
+    int           sortColumn = -1;
+    Qt::SortOrder sortOrder  = Qt::AscendingOrder;
+    QString       filter;
+
+    bool matchesFilter(int rom) const;
+    QString getText(int rom, int column) const;
+
+    void sortRows(void);
+    void updateRomRows(void);
+    void rebuildRows(void);
+
+  private slots:
+    void on_CoverLoader_CoverLoaded(int generation, QString file, QImage thumbnail, QString coverFile);
+};
+} // namespace Widget
+} // namespace UserInterface
+
+#endif // ROMBROWSERMODEL_HPP
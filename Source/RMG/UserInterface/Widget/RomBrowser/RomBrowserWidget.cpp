@@ -13,8 +13,10 @@
 #include <QFileDialog>
 #include <QGridLayout>
 #include <QBoxLayout>
+#include <QStorageInfo>
 #include <QScrollBar>
 #include <QPixmap>
+#include <QImage>
 #include <QLabel>
 #include <vector>
 #include <QList>
@@ -24,33 +26,32 @@
 #include <RMG-Core/SaveState.hpp>
 #include <RMG-Core/Settings.hpp>
 #include <RMG-Core/Plugins.hpp>
+#include <RMG-Core/Prefetch.hpp>
 
 using namespace UserInterface::Widget;
 
 //
-// Internal Struct
+// Local Functions
 //
 
-struct RomBrowserModelData
+static bool is_network_directory(QString directory)
 {
-    QString         file;
-    CoreRomType     type;
-    CoreRomHeader   header;
-    CoreRomSettings settings;
-    QString         coverFile;
-
-    RomBrowserModelData() {}
+    if (directory.startsWith("//") || directory.startsWith("\\\\"))
+    {
+        return true;
+    }
 
-    RomBrowserModelData(QString file, CoreRomType type, CoreRomHeader header, CoreRomSettings settings)
+    const QByteArray fileSystemType = QStorageInfo(directory).fileSystemType().toLower();
+    for (const char* networkFileSystemType : { "nfs", "nfs4", "cifs", "smbfs", "smb2", "smb3", "afpfs", "fuse.sshfs", "9p" })
     {
-        this->file     = file;
-        this->type     = type;
-        this->header   = header;
-        this->settings = settings;
+        if (fileSystemType == networkFileSystemType)
+        {
+            return true;
+        }
     }
-};
 
-Q_DECLARE_METATYPE(RomBrowserModelData);
+    return false;
+}
 
 //
 // Exported Functions
@@ -64,8 +65,37 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QStackedWidget(parent)
     // configure rom searcher thread
     this->romSearcherThread = new Thread::RomSearcherThread(this);
     connect(this->romSearcherThread, &Thread::RomSearcherThread::RomsFound, this, &RomBrowserWidget::on_RomBrowserThread_RomsFound);
+    connect(this->romSearcherThread, &Thread::RomSearcherThread::RomsRemoved, this, &RomBrowserWidget::on_RomBrowserThread_RomsRemoved);
+    connect(this->romSearcherThread, &Thread::RomSearcherThread::DirectoriesFound, this, &RomBrowserWidget::on_RomBrowserThread_DirectoriesFound);
     connect(this->romSearcherThread, &Thread::RomSearcherThread::Finished, this, &RomBrowserWidget::on_RomBrowserThread_Finished);
 
+    // configure ROM directory watcher, changes are
+    // collected for a bit before searching for them,
+    // because copying a ROM causes a lot of changes
+    this->romDirectoryWatcher = new QFileSystemWatcher(this);
+    this->romDirectoryChangedTimer = new QTimer(this);
+    this->romDirectoryChangedTimer->setSingleShot(true);
+    this->romDirectoryChangedTimer->setInterval(2000);
+    this->romDirectoryPollTimer = new QTimer(this);
+    this->romDirectoryPollTimer->setInterval(60000);
+    connect(this->romDirectoryWatcher, &QFileSystemWatcher::directoryChanged, this, &RomBrowserWidget::on_RomDirectoryWatcher_directoryChanged);
+    connect(this->romDirectoryChangedTimer, &QTimer::timeout, this, &RomBrowserWidget::on_RomDirectoryChangedTimer_timeout);
+    connect(this->romDirectoryPollTimer, &QTimer::timeout, this, &RomBrowserWidget::on_RomDirectoryPollTimer_timeout);
+
+    // configure ROM prefetch timer, the selected ROM
+    // is only prefetched once the selection has settled,
+    // so scrolling through the list doesn't read every ROM
+    this->romPrefetchTimer = new QTimer(this);
+    this->romPrefetchTimer->setSingleShot(true);
+    this->romPrefetchTimer->setInterval(300);
+    connect(this->romPrefetchTimer, &QTimer::timeout, this, &RomBrowserWidget::on_RomPrefetchTimer_timeout);
+
+    // configure cover loader and the model, items
+    // show the placeholder until their cover has
+    // been loaded
+    this->coverLoader = new Widget::RomBrowserCoverLoader(this);
+    this->model       = new Widget::RomBrowserModel(this, this->coverLoader);
+
     // configure empty widget
     this->emptyWidget = new Widget::RomBrowserEmptyWidget(this);
     this->addWidget(this->emptyWidget);
@@ -81,8 +111,7 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QStackedWidget(parent)
 
     // configure list view widget
     this->listViewWidget = new Widget::RomBrowserListViewWidget(this);
-    this->listViewModel  = new QStandardItemModel(this);
-    this->listViewWidget->setModel(this->listViewModel);
+    this->listViewWidget->setModel(this->model);
     this->listViewWidget->setFrameStyle(QFrame::NoFrame);
     this->listViewWidget->setItemDelegate(new NoFocusDelegate(this));
     this->listViewWidget->setWordWrap(false);
@@ -93,7 +122,11 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QStackedWidget(parent)
     this->listViewWidget->setSelectionMode(QAbstractItemView::SingleSelection);
     this->listViewWidget->setVerticalScrollMode(QAbstractItemView::ScrollMode::ScrollPerPixel);
     this->listViewWidget->verticalHeader()->hide();
-    this->listViewWidget->verticalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    // resizing the rows to their contents requires the
+    // contents of every row, which is too slow for large
+    // ROM lists, every row has the same height anyways
+    this->listViewWidget->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    this->listViewWidget->verticalHeader()->setDefaultSectionSize(this->listViewWidget->fontMetrics().height() + 6);
     this->listViewWidget->horizontalHeader()->setSectionsMovable(true);
     this->listViewWidget->horizontalHeader()->setFirstSectionMovable(true);
     this->listViewWidget->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
@@ -103,6 +136,7 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QStackedWidget(parent)
     this->listViewWidget->horizontalHeader()->setContextMenuPolicy(Qt::ContextMenuPolicy::CustomContextMenu);
     this->addWidget(this->listViewWidget);
     connect(this->listViewWidget, &QTableView::doubleClicked, this, &RomBrowserWidget::on_DoubleClicked);
+    connect(this->listViewWidget->selectionModel(), &QItemSelectionModel::currentChanged, this, &RomBrowserWidget::on_currentChanged);
     connect(this->listViewWidget->horizontalHeader(), &QHeaderView::sortIndicatorChanged, this, &RomBrowserWidget::on_listViewWidget_sortIndicatorChanged);
     connect(this->listViewWidget->horizontalHeader(), &QHeaderView::sectionResized, this, &RomBrowserWidget::on_listViewWidget_sectionResized);
     connect(this->listViewWidget->horizontalHeader(), &QHeaderView::sectionMoved, this, &RomBrowserWidget::on_listViewWidget_sectionMoved);
@@ -111,35 +145,20 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QStackedWidget(parent)
     connect(this->listViewWidget, &Widget::RomBrowserListViewWidget::ZoomOut, this, &RomBrowserWidget::on_ZoomOut);
     connect(this->listViewWidget, &Widget::RomBrowserListViewWidget::FileDropped, this, &RomBrowserWidget::FileDropped);
 
-    // set up list view's columns
-    QStringList labels;
-    labels << "Name";
-    labels << "Internal Name";
-    labels << "MD5";
-    labels << "Format";
-    labels << "File Name";
-    labels << "File Ext.";
-    labels << "File Size";
-    labels << "I.D.";
-    labels << "Region";
-    this->listViewModel->setColumnCount(labels.size());
-    this->listViewModel->setHorizontalHeaderLabels(labels);
-
     // set full names of list view's columns
-    this->columnNames << labels.at(0);
-    this->columnNames << labels.at(1);
-    this->columnNames << labels.at(2);
+    this->columnNames << "Name";
+    this->columnNames << "Internal Name";
+    this->columnNames << "MD5";
     this->columnNames << "Game Format";
-    this->columnNames << labels.at(4);
+    this->columnNames << "File Name";
     this->columnNames << "File Extension";
-    this->columnNames << labels.at(6);
+    this->columnNames << "File Size";
     this->columnNames << "Game I.D.";
     this->columnNames << "Game Region";
 
     // configure grid view widget
     this->gridViewWidget = new Widget::RomBrowserGridViewWidget(this);
-    this->gridViewModel  = new QStandardItemModel(this);
-    this->gridViewWidget->setModel(this->gridViewModel);
+    this->gridViewWidget->setModel(this->model);
     this->gridViewWidget->setFlow(QListView::Flow::LeftToRight);
     this->gridViewWidget->setResizeMode(QListView::Adjust);
 #ifndef DRAG_DROP
@@ -159,6 +178,7 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QStackedWidget(parent)
     this->gridViewWidget->setIconSize(QSize(iconWidth, iconHeight));
     this->addWidget(this->gridViewWidget);
     connect(this->gridViewWidget, &QListView::doubleClicked, this, &RomBrowserWidget::on_DoubleClicked);
+    connect(this->gridViewWidget->selectionModel(), &QItemSelectionModel::currentChanged, this, &RomBrowserWidget::on_currentChanged);
     connect(this->gridViewWidget, &QListView::iconSizeChanged, this, &RomBrowserWidget::on_gridViewWidget_iconSizeChanged);
     connect(this->gridViewWidget, &Widget::RomBrowserGridViewWidget::ZoomIn, this, &RomBrowserWidget::on_ZoomIn);
     connect(this->gridViewWidget, &Widget::RomBrowserGridViewWidget::ZoomOut, this, &RomBrowserWidget::on_ZoomOut);
@@ -260,12 +280,34 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QStackedWidget(parent)
 
 RomBrowserWidget::~RomBrowserWidget()
 {
+    CoreStopPrefetch();
 }
 
 void RomBrowserWidget::RefreshRomList(void)
 {
-    this->listViewModel->removeRows(0, this->listViewModel->rowCount());
-    this->gridViewModel->removeRows(0, this->gridViewModel->rowCount());
+    QString directory = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::RomBrowser_Directory));
+    bool    recursive = CoreSettingsGetBoolValue(SettingsID::RomBrowser_Recursive);
+    int     maxItems  = CoreSettingsGetIntValue(SettingsID::RomBrowser_MaxItems);
+
+    // when the ROM list is complete and its settings
+    // haven't changed, we only have to search for the
+    // ROMs which have been added, removed or modified
+    if (this->romListComplete &&
+        this->romListDirectory == directory &&
+        this->romListRecursive == recursive &&
+        this->romListMaxItems  == maxItems)
+    {
+        this->searchChangedRoms(false);
+        return;
+    }
+
+    this->romListComplete  = false;
+    this->romListDirectory = directory;
+    this->romListRecursive = recursive;
+    this->romListMaxItems  = maxItems;
+
+    this->coverLoader->Clear();
+    this->model->Clear();
 
     this->menu_PlayGameWithDisk->clear();
 
@@ -273,12 +315,20 @@ void RomBrowserWidget::RefreshRomList(void)
     this->coversDirectory += CORE_DIR_SEPERATOR_STR;
     this->coversDirectory += "Covers";
 
+    QString thumbnailsDirectory = QString::fromStdString(CoreGetUserCacheDirectory().string());
+    thumbnailsDirectory += CORE_DIR_SEPERATOR_STR;
+    thumbnailsDirectory += "Thumbnails";
+
+    this->coverLoader->SetCoversDirectory(this->coversDirectory);
+    this->coverLoader->SetThumbnailsDirectory(thumbnailsDirectory);
+    this->coverLoader->SetThumbnailSize(this->getCoverThumbnailSize(this->gridViewWidget->iconSize()));
+
     this->listViewSortSection = CoreSettingsGetIntValue(SettingsID::RomBrowser_ListViewSortSection);
     this->listViewSortOrder   = CoreSettingsGetIntValue(SettingsID::RomBrowser_ListViewSortOrder);
 
-    QString directory = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::RomBrowser_Directory));
     if (directory.isEmpty())
     {
+        this->on_RomBrowserThread_DirectoriesFound({});
         this->setCurrentWidget(this->emptyWidget);
         return;
     }
@@ -286,8 +336,15 @@ void RomBrowserWidget::RefreshRomList(void)
     this->setCurrentWidget(this->loadingWidget);
     this->romSearcherTimer.start();
 
-    this->romSearcherThread->SetMaximumFiles(CoreSettingsGetIntValue(SettingsID::RomBrowser_MaxItems));
-    this->romSearcherThread->SetRecursive(CoreSettingsGetBoolValue(SettingsID::RomBrowser_Recursive));
+    // directories which haven't been modified since
+    // the last search are taken from the snapshot
+    // of the ROM searcher thread, but we need
+    // all ROMs because our ROM list is empty
+    this->romSearcherIncremental = false;
+    this->romSearcherThread->SetIncremental(false);
+    this->romSearcherThread->SetModifiedDirectoriesOnly(true);
+    this->romSearcherThread->SetMaximumFiles(maxItems);
+    this->romSearcherThread->SetRecursive(recursive);
     this->romSearcherThread->SetDirectory(directory);
     this->romSearcherThread->start();
 }
@@ -336,6 +393,7 @@ void RomBrowserWidget::SetGridViewUniformSizes(bool value)
         if (this->gridViewWidget->uniformItemSizes() != value)
         {
             this->gridViewWidget->setUniformItemSizes(value);
+            this->romListComplete = false;
             this->RefreshRomList();
             return;
         }
@@ -347,17 +405,9 @@ void RomBrowserWidget::SetGridViewUniformSizes(bool value)
 QMap<QString, CoreRomSettings> RomBrowserWidget::GetModelData(void)
 {
     QMap<QString, CoreRomSettings> data;
-    QStandardItemModel* model = this->getCurrentModel();
-    RomBrowserModelData modelData;
 
-    if (model == nullptr)
+    for (const RomBrowserModelData& modelData : this->model->GetAllRomData())
     {
-        return data;
-    }
-
-    for (int i = 0; i < model->rowCount(); i++)
-    {
-        modelData = model->item(i)->data().value<RomBrowserModelData>();
         // only add cartridges, 64dd disks aren't supported
         if (modelData.type == CoreRomType::Cartridge)
         {
@@ -368,26 +418,6 @@ QMap<QString, CoreRomSettings> RomBrowserWidget::GetModelData(void)
     return data;
 }
 
-QStandardItemModel* RomBrowserWidget::getCurrentModel(void)
-{
-    QWidget* currentWidget = this->currentWidget();
-    if (currentWidget == this->loadingWidget)
-    {
-        currentWidget = this->currentViewWidget;
-    }
-
-    if (currentWidget == this->listViewWidget)
-    {
-        return this->listViewModel;
-    }
-    else if (currentWidget == this->gridViewWidget)
-    {
-        return this->gridViewModel;
-    }
-
-    return nullptr;
-}
-
 QAbstractItemView* RomBrowserWidget::getCurrentModelView(void)
 {
     QWidget* currentWidget = this->currentWidget();
@@ -410,24 +440,14 @@ QAbstractItemView* RomBrowserWidget::getCurrentModelView(void)
 
 bool RomBrowserWidget::getCurrentData(RomBrowserModelData& data)
 {
-    QStandardItemModel* model = this->getCurrentModel();
-    QAbstractItemView*  view  = this->getCurrentModelView();
-
-    if (model == nullptr || view == nullptr)
-    {
-        return false;
-    }
-
-    QModelIndex    index = view->currentIndex();
-    QStandardItem* item  = model->item(index.row(), 0);
+    QAbstractItemView* view = this->getCurrentModelView();
 
-    if (item == nullptr)
+    if (view == nullptr)
     {
         return false;
     }
 
-    data = item->data().value<RomBrowserModelData>();
-    return true;
+    return this->model->GetRomData(view->currentIndex().row(), data);
 }
 
 
@@ -443,172 +463,33 @@ QString RomBrowserWidget::getCurrentRom(void)
     return data.file;
 }
 
-void RomBrowserWidget::addRomData(QString file, CoreRomType type, CoreRomHeader header, CoreRomSettings settings)
+void RomBrowserWidget::searchChangedRoms(bool modifiedDirectoriesOnly)
 {
-    QString name;
-    QString gameFormat;
-    float fileSize;
-    QString fileSizeString;
-    QString coverFile;
-    QIcon   coverIcon;
-    QVariant itemData;
-    RomBrowserModelData modelData;
-
-    // create item data
-    modelData = RomBrowserModelData(file, type, header, settings);
-
-    // generate name to use in UI
-    name = QString::fromStdString(settings.GoodName);
-    if (name.endsWith("(unknown rom)") ||
-        name.endsWith("(unknown disk)"))
+    if (this->IsRefreshingRomList())
     {
-        name = QFileInfo(file).fileName();
+        return;
     }
 
-    // generate game format to use in UI
-    if (type == CoreRomType::Disk)
-    {
-        gameFormat = "Disk";
-    }
-    else
-    {
-        gameFormat = "Cartridge";
-    }
-
-    // generate file size to use in UI
-    fileSize = QFileInfo(file).size()/1048576.0;
-    fileSizeString = (QString::number(fileSize, 'f', 2)).append(" MB");
-    if (fileSizeString.size() == 7)
-    {
-        fileSizeString = fileSizeString.prepend("  ");
-    }
-
-    // retrieve cover image
-    coverIcon = this->getCurrentCover(file, header, settings, coverFile);
-    modelData.coverFile = coverFile;
-
-    // create item data
-    itemData = QVariant::fromValue<RomBrowserModelData>(modelData);
-
-    QList<QStandardItem*> listViewRow;
-    // goodname
-    QStandardItem* listViewItem1 = new QStandardItem();
-    listViewItem1->setText(name);
-    listViewItem1->setData(itemData);
-    listViewRow.append(listViewItem1);
-    // internal name
-    QStandardItem* listViewItem2 = new QStandardItem();
-    listViewItem2->setText(QString::fromStdString(header.Name));
-    listViewRow.append(listViewItem2);
-    // MD5
-    QStandardItem* listViewItem3 = new QStandardItem();
-    listViewItem3->setText(QString::fromStdString(settings.MD5));
-    listViewRow.append(listViewItem3);
-    // game format
-    QStandardItem* listViewItem4 = new QStandardItem();
-    listViewItem4->setText(gameFormat);
-    listViewRow.append(listViewItem4);
-    // file name
-    QStandardItem* listViewItem5 = new QStandardItem();
-    listViewItem5->setText(QFileInfo(file).completeBaseName());
-    listViewRow.append(listViewItem5);
-    // file extension
-    QStandardItem* listViewItem6 = new QStandardItem();
-    listViewItem6->setText(((QFileInfo(file).suffix()).prepend(".")).toUpper());
-    listViewRow.append(listViewItem6);
-    // file size
-    QStandardItem* listViewItem7 = new QStandardItem();
-    listViewItem7->setText(fileSizeString);
-    listViewRow.append(listViewItem7);
-    // game i.d.
-    QStandardItem* listViewItem8 = new QStandardItem();
-    listViewItem8->setText(QString::fromStdString(header.GameID));
-    listViewRow.append(listViewItem8);
-    // region
-    QStandardItem* listViewItem9 = new QStandardItem();
-    listViewItem9->setText(QString::fromStdString(header.Region));
-    listViewRow.append(listViewItem9);
-    this->listViewModel->appendRow(listViewRow);
-
-    QStandardItem* gridViewItem = new QStandardItem();
-    gridViewItem->setIcon(coverIcon);
-    gridViewItem->setText(name);
-    gridViewItem->setData(itemData);
-    this->gridViewModel->appendRow(gridViewItem);
+    // keep the modified directories around,
+    // so we can search them again when the
+    // search is canceled
+    this->romSearcherModifiedDirectories = this->modifiedRomDirectories.values();
+    this->modifiedRomDirectories.clear();
+
+    this->romSearcherIncremental = true;
+    this->romSearcherThread->SetIncremental(true);
+    this->romSearcherThread->SetModifiedDirectoriesOnly(modifiedDirectoriesOnly, this->romSearcherModifiedDirectories);
+    this->romSearcherThread->start();
 }
 
-QIcon RomBrowserWidget::getCurrentCover(QString file, CoreRomHeader header, CoreRomSettings settings, QString& coverFileName)
+QSize RomBrowserWidget::getCoverThumbnailSize(QSize iconSize)
 {
-    QPixmap pixmap;
-
-    // construct basename of file,
-    // by retrieving the last index of '.'
-    // and removing all characters from that index
-    // until the end of the string
-    QString baseName         = QFileInfo(file).fileName();
-    qsizetype lastIndexOfDot = baseName.lastIndexOf(".");
-    if (lastIndexOfDot != -1)
-    { // only remove when index was found
-        baseName.remove(lastIndexOfDot, baseName.size() - lastIndexOfDot);
-    }
-
-    // try to load cover using
-    // 1) basename of file
-    // 2) MD5
-    // 3) good name
-    // 4) internal name
-    bool foundCover = false;
-    for (QString name : { 
-        baseName,
-        QString::fromStdString(settings.MD5), 
-        QString::fromStdString(settings.GoodName), 
-        QString::fromStdString(header.Name) })
-    {
-        // fixup file name
-        QString fixedName = name;
-        for (const QChar c : QString(":<>\"/\\|?*"))
-        {
-            fixedName.replace(c, "_");
-        }
-
-        // skip empty names,
-        // this can i.e happen
-        // when ROMs don't have 
-        // an internal ROM name
-        if (fixedName.isEmpty())
-        {
-            continue;
-        }
-
-        // we support jpg & png as file extensions
-        for (QString ext : { ".png", ".jpg", ".jpeg" })
-        {
-            QString coverPath = this->coversDirectory;
-            coverPath += CORE_DIR_SEPERATOR_STR;
-            coverPath += fixedName;
-            coverPath += ext;
-
-            if (QFile::exists(coverPath) && 
-                pixmap.load(coverPath))
-            {
-                coverFileName = coverPath;
-                foundCover = true;
-                break;
-            }
-        }
-
-        if (foundCover)
-        {
-            break;
-        }
-    }
-    // fallback
-    if (!foundCover)
-    {
-        pixmap.load(":Resource/CoverFallback.png");
-    }
-
-    return QIcon(pixmap);
+    // round the size up, so zooming in a bit
+    // doesn't require new thumbnails
+    QSize size = iconSize * this->devicePixelRatioF();
+    size.setWidth(((size.width() + 63) / 64) * 64);
+    size.setHeight(((size.height() + 63) / 64) * 64);
+    return size;
 }
 
 void RomBrowserWidget::timerEvent(QTimerEvent* event)
@@ -624,9 +505,8 @@ void RomBrowserWidget::on_DoubleClicked(const QModelIndex& index)
 
 void RomBrowserWidget::customContextMenuRequested(QPoint position)
 {
-    QStandardItemModel* model = this->getCurrentModel();
-    QAbstractItemView*  view = this->getCurrentModelView();
-    if (view == nullptr || model == nullptr)
+    QAbstractItemView* view = this->getCurrentModelView();
+    if (view == nullptr)
     {
         return;
     }
@@ -696,7 +576,7 @@ void RomBrowserWidget::generateColumnsMenu(void)
 {
     this->menu_Columns->clear();
 
-    for (int i = 0; i < this->listViewModel->columnCount(); i++)
+    for (int i = 0; i < this->model->columnCount(); i++)
     {
         int column = this->listViewWidget->horizontalHeader()->logicalIndex(i);
 
@@ -713,20 +593,18 @@ void RomBrowserWidget::generateColumnsMenu(void)
 void RomBrowserWidget::generatePlayWithDiskMenu(void)
 {
     QAction* playGameWithAction;
-    QStandardItemModel* model = this->getCurrentModel();
     RomBrowserModelData modelData;
     int count = 0;
 
     this->menu_PlayGameWithDisk->clear();
 
-    if (model == nullptr)
+    for (int i = 0; i < this->model->rowCount(); i++)
     {
-        return;
-    }
+        if (!this->model->GetRomData(i, modelData))
+        {
+            continue;
+        }
 
-    for (int i = 0; i < model->rowCount(); i++)
-    {
-        modelData = model->item(i)->data().value<RomBrowserModelData>();
         if (modelData.type == CoreRomType::Disk)
         {
             if (count == 0)
@@ -736,8 +614,8 @@ void RomBrowserWidget::generatePlayWithDiskMenu(void)
             }
 
             playGameWithAction = new QAction(this);
-            playGameWithAction->setText(model->item(i)->text());
-            playGameWithAction->setData(model->item(i)->data());
+            playGameWithAction->setText(this->model->index(i, 0).data().toString());
+            playGameWithAction->setData(QVariant::fromValue<RomBrowserModelData>(modelData));
             this->menu_PlayGameWithDisk->addAction(playGameWithAction);
 
             // only add 10 disks to menu,
@@ -824,7 +702,7 @@ void RomBrowserWidget::on_listViewWidget_sectionResized(int logicalIndex, int ol
             CoreSettingsSetValue(SettingsID::RomBrowser_ColumnVisibility, columnVisibility);
 
             int lastVisibleColumn = -1;
-            for (int i = 0; i < this->listViewModel->columnCount(); i++)
+            for (int i = 0; i < this->model->columnCount(); i++)
             {
                 int column = this->listViewWidget->horizontalHeader()->logicalIndex(i);
                 if (!this->listViewWidget->horizontalHeader()->isSectionHidden(column))
@@ -864,6 +742,17 @@ void RomBrowserWidget::on_gridViewWidget_iconSizeChanged(const QSize& size)
 {
     CoreSettingsSetValue(SettingsID::RomBrowser_GridViewIconWidth, size.width());
     CoreSettingsSetValue(SettingsID::RomBrowser_GridViewIconHeight, size.height());
+
+    // reload the covers when the
+    // thumbnails are too small
+    QSize thumbnailSize = this->getCoverThumbnailSize(size);
+    QSize currentThumbnailSize = this->coverLoader->GetThumbnailSize();
+    if (thumbnailSize.width() > currentThumbnailSize.width() ||
+        thumbnailSize.height() > currentThumbnailSize.height())
+    {
+        this->coverLoader->SetThumbnailSize(thumbnailSize);
+        this->model->ReloadCovers();
+    }
 }
 
 void RomBrowserWidget::on_ZoomIn(void)
@@ -891,20 +780,90 @@ void RomBrowserWidget::on_ZoomOut(void)
 void RomBrowserWidget::on_RomBrowserThread_RomsFound(QList<RomSearcherThreadData> data, int index, int count)
 {
     // add every item to our dataset
-    for (qsizetype i = 0; i < data.size(); i++)
-    {
-        this->addRomData(data[i].File, data[i].Type, data[i].Header, data[i].Settings);
-    }
+    this->model->AddRoms(data);
 
     // update loading widget
     this->loadingWidget->SetCurrentRomIndex(index, count);
 }
 
+void RomBrowserWidget::on_RomBrowserThread_RomsRemoved(QStringList files)
+{
+    this->model->RemoveRoms(files);
+}
+
+void RomBrowserWidget::on_RomBrowserThread_DirectoriesFound(QStringList directories)
+{
+    QStringList   watchedDirectoriesList = this->romDirectoryWatcher->directories();
+    QSet<QString> watchedDirectories(watchedDirectoriesList.begin(), watchedDirectoriesList.end());
+    QSet<QString> foundDirectories(directories.begin(), directories.end());
+
+    QStringList removedDirectories = (watchedDirectories - foundDirectories).values();
+    QStringList addedDirectories   = (foundDirectories - watchedDirectories).values();
+
+    if (!removedDirectories.isEmpty())
+    {
+        this->romDirectoryWatcher->removePaths(removedDirectories);
+    }
+
+    QStringList failedDirectories;
+    if (!addedDirectories.isEmpty())
+    {
+        failedDirectories = this->romDirectoryWatcher->addPaths(addedDirectories);
+    }
+
+    // changes made by other machines aren't reported
+    // for network shares, so we have to poll those,
+    // which only queries the modification time of
+    // every directory, unless one has been modified
+    if (!directories.isEmpty() &&
+        (!failedDirectories.isEmpty() || is_network_directory(this->romListDirectory)))
+    {
+        this->romDirectoryPollTimer->start();
+    }
+    else
+    {
+        this->romDirectoryPollTimer->stop();
+    }
+}
+
 void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
 {
+    if (this->romSearcherIncremental)
+    {
+        // the ROM list is still complete when the search
+        // is canceled, because searching again replaces
+        // and removes the same ROMs, so only remember
+        // which directories have been modified
+        if (canceled)
+        {
+            for (const QString& directory : this->romSearcherModifiedDirectories)
+            {
+                this->modifiedRomDirectories.insert(directory);
+            }
+            this->romDirectoryChangedTimer->start();
+            return;
+        }
+
+        this->listViewSortSection = CoreSettingsGetIntValue(SettingsID::RomBrowser_ListViewSortSection);
+        this->listViewSortOrder   = CoreSettingsGetIntValue(SettingsID::RomBrowser_ListViewSortOrder);
+
+        this->model->sort(this->listViewSortSection, (Qt::SortOrder)this->listViewSortOrder);
+
+        this->generatePlayWithDiskMenu();
+
+        if (this->model->rowCount() == 0)
+        {
+            this->setCurrentWidget(this->emptyWidget);
+        }
+        else if (this->currentWidget() == this->emptyWidget)
+        {
+            this->setCurrentWidget(this->currentViewWidget);
+        }
+        return;
+    }
+
     // sort data
-    this->listViewModel->sort(this->listViewSortSection, (Qt::SortOrder)this->listViewSortOrder);
-    this->gridViewModel->sort(0, Qt::SortOrder::AscendingOrder);
+    this->model->sort(this->listViewSortSection, (Qt::SortOrder)this->listViewSortOrder);
 
     // retrieve column settings
     std::vector<int> columnSizes = CoreSettingsGetIntListValue(SettingsID::RomBrowser_ColumnSizes);
@@ -916,10 +875,10 @@ void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
 
     // reset column sizes setting in config file if number of values is incorrect
     if (!columnSizes.empty() && 
-        columnSizes.size() != this->listViewModel->columnCount())
+        columnSizes.size() != this->model->columnCount())
     {
         columnSizes.clear();
-        columnSizes.resize(this->listViewModel->columnCount(), -1);
+        columnSizes.resize(this->model->columnCount(), -1);
         CoreSettingsSetValue(SettingsID::RomBrowser_ColumnSizes, columnSizes);
     }
 
@@ -942,10 +901,10 @@ void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
 
     // reset column order setting in config file if number of values is incorrect
     if (!columnOrder.empty() &&
-        columnOrder.size() != this->listViewModel->columnCount())
+        columnOrder.size() != this->model->columnCount())
     {
         columnOrder.clear();
-        for (int i = 0; i < this->listViewModel->columnCount(); i++)
+        for (int i = 0; i < this->model->columnCount(); i++)
         {
             columnOrder.push_back(i);
         }
@@ -960,10 +919,10 @@ void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
 
     // reset column visibility setting in config file if number of values is incorrect
     if (!columnVisibility.empty() &&
-        columnVisibility.size() != this->listViewModel->columnCount())
+        columnVisibility.size() != this->model->columnCount())
     {
         columnVisibility.clear();
-        columnVisibility.resize(this->listViewModel->columnCount(), 0);
+        columnVisibility.resize(this->model->columnCount(), 0);
         for (int i = 0; i < 3; i++)
         {
             columnVisibility.at(i) = 1;
@@ -994,7 +953,9 @@ void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
         return;
     }
 
-    if (this->listViewModel->rowCount() == 0)
+    this->romListComplete = true;
+
+    if (this->model->rowCount() == 0)
     {
         this->setCurrentWidget(this->emptyWidget);
         return;
@@ -1012,6 +973,66 @@ void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
     this->setCurrentWidget(this->currentViewWidget);
 }
 
+void RomBrowserWidget::on_RomDirectoryWatcher_directoryChanged(const QString& directory)
+{
+    this->modifiedRomDirectories.insert(directory);
+    this->romDirectoryChangedTimer->start();
+}
+
+void RomBrowserWidget::on_RomDirectoryChangedTimer_timeout(void)
+{
+    // a full refresh picks up the changes
+    if (!this->romListComplete)
+    {
+        return;
+    }
+
+    // try again later when we're already searching
+    // or when the ROM browser isn't visible,
+    // i.e during emulation
+    if (this->IsRefreshingRomList() || !this->isVisible())
+    {
+        this->romDirectoryChangedTimer->start();
+        return;
+    }
+
+    this->searchChangedRoms(true);
+}
+
+void RomBrowserWidget::on_RomDirectoryPollTimer_timeout(void)
+{
+    if (!this->romListComplete ||
+        this->IsRefreshingRomList() ||
+        !this->isVisible())
+    {
+        return;
+    }
+
+    this->searchChangedRoms(true);
+}
+
+void RomBrowserWidget::on_currentChanged(const QModelIndex& current, const QModelIndex& previous)
+{
+    if (!current.isValid())
+    {
+        return;
+    }
+
+    this->romPrefetchTimer->start();
+}
+
+void RomBrowserWidget::on_RomPrefetchTimer_timeout(void)
+{
+    RomBrowserModelData data;
+
+    if (!this->getCurrentData(data))
+    {
+        return;
+    }
+
+    CorePrefetchRom(data.file.toStdU32String(), data.header, data.settings);
+}
+
 void RomBrowserWidget::on_Action_PlayGame(void)
 {
     emit this->PlayGame(this->getCurrentRom());
@@ -1110,7 +1131,7 @@ void RomBrowserWidget::on_Action_ResetColumnSizes(void)
     std::vector<int> columnVisibility = CoreSettingsGetIntListValue(SettingsID::RomBrowser_ColumnVisibility);
     this->listViewWidget->horizontalHeader()->setStretchLastSection(false);
 
-    for (int i = 0; i < this->listViewModel->columnCount(); i++)
+    for (int i = 0; i < this->model->columnCount(); i++)
     {
         this->listViewWidget->horizontalHeader()->setSectionHidden(i, false);
     }
@@ -1131,11 +1152,11 @@ void RomBrowserWidget::on_Action_SetCoverImage(void)
 {
     QString sourceFile;
     QFileInfo sourceFileInfo;
-    QString coverFile;
 
-    QStandardItemModel* model = this->getCurrentModel();
-    QAbstractItemView*  view  = this->getCurrentModelView();
-    if (model == nullptr || view == nullptr)
+    RomBrowserModelData data;
+
+    QAbstractItemView* view = this->getCurrentModelView();
+    if (view == nullptr)
     {
         return;
     }
@@ -1154,9 +1175,11 @@ void RomBrowserWidget::on_Action_SetCoverImage(void)
     // retrieve file info
     sourceFileInfo = QFileInfo(sourceFile);
 
-    QModelIndex         index = view->currentIndex();
-    QStandardItem*      item  = model->item(index.row(), index.column());
-    RomBrowserModelData data  = model->itemData(index).last().value<RomBrowserModelData>();
+    QModelIndex index = view->currentIndex();
+    if (!this->model->GetRomData(index.row(), data))
+    {
+        return;
+    }
 
     // construct new file name (for the cover)
     QString newFileName = this->coversDirectory;
@@ -1185,24 +1208,24 @@ void RomBrowserWidget::on_Action_SetCoverImage(void)
     QFile::copy(sourceFile, newFileName);
 
     // update item
-    item->setIcon(this->getCurrentCover(data.file, data.header, data.settings, coverFile));
-    data.coverFile = coverFile;
-    item->setData(QVariant::fromValue<RomBrowserModelData>(data));
+    this->model->ReloadCover(index.row());
 }
 
 void RomBrowserWidget::on_Action_RemoveCoverImage(void)
 {
-    QStandardItemModel* model = this->getCurrentModel();
-    QAbstractItemView*  view  = this->getCurrentModelView();
-    if (model == nullptr || view == nullptr)
+    RomBrowserModelData data;
+
+    QAbstractItemView* view = this->getCurrentModelView();
+    if (view == nullptr)
     {
         return;
     }
 
-    QModelIndex         index = view->currentIndex();
-    QStandardItem*      item  = model->item(index.row(), index.column());
-    RomBrowserModelData data  = model->itemData(index).last().value<RomBrowserModelData>();
-    QString coverFile;
+    QModelIndex index = view->currentIndex();
+    if (!this->model->GetRomData(index.row(), data))
+    {
+        return;
+    }
 
     if (!data.coverFile.isEmpty() && QFile::exists(data.coverFile))
     {
@@ -1210,7 +1233,5 @@ void RomBrowserWidget::on_Action_RemoveCoverImage(void)
     }
 
     // update item
-    item->setIcon(this->getCurrentCover(data.file, data.header, data.settings, coverFile));
-    data.coverFile = coverFile;
-    item->setData(QVariant::fromValue<RomBrowserModelData>(data));
+    this->model->ReloadCover(index.row());
 }
@@ -17,8 +17,10 @@
 #include "RomBrowserGridViewWidget.hpp"
 #include "RomBrowserLoadingWidget.hpp"
 #include "RomBrowserEmptyWidget.hpp"
+#include "RomBrowserCoverLoader.hpp"
+#include "RomBrowserModel.hpp"
 
-#include <QStandardItemModel>
+#include <QFileSystemWatcher>
 #include <QStackedWidget>
 #include <QGridLayout>
 #include <QListWidget>
@@ -26,12 +28,14 @@
 #include <QTableView>
 #include <QAction>
 #include <QString>
+#include <QTimer>
+#include <QImage>
+#include <QIcon>
 #include <QList>
 #include <QMenu>
+#include <QHash>
 #include <QMap>
-
-// forward declaration of internal struct
-struct RomBrowserModelData;
+#include <QSet>
 
 namespace UserInterface
 {
@@ -60,15 +64,34 @@ class RomBrowserWidget : public QStackedWidget
     Widget::RomBrowserEmptyWidget*    emptyWidget    = nullptr;
     Widget::RomBrowserLoadingWidget*  loadingWidget  = nullptr;
 
+    // the list view and the grid view share the model
+    Widget::RomBrowserModel*          model          = nullptr;
     Widget::RomBrowserListViewWidget* listViewWidget = nullptr;
-    QStandardItemModel* listViewModel                = nullptr;
     Widget::RomBrowserGridViewWidget* gridViewWidget = nullptr;
-    QStandardItemModel* gridViewModel                = nullptr;
 
     QWidget* currentViewWidget = nullptr;
 
     QElapsedTimer romSearcherTimer;
     Thread::RomSearcherThread* romSearcherThread = nullptr;
+    bool romSearcherIncremental = false;
+    QStringList romSearcherModifiedDirectories;
+
+    // settings of the ROM list, when the ROM list is
+    // complete and its settings haven't changed, only
+    // ROMs which have changed are searched for
+    bool    romListComplete = false;
+    QString romListDirectory;
+    bool    romListRecursive = false;
+    int     romListMaxItems  = 0;
+
+    // the ROM directories are watched for changes,
+    // when they can't be watched or when they're on
+    // a network share, they're polled instead
+    QFileSystemWatcher* romDirectoryWatcher   = nullptr;
+    QTimer* romDirectoryChangedTimer          = nullptr;
+    QTimer* romDirectoryPollTimer             = nullptr;
+    QTimer* romPrefetchTimer                  = nullptr;
+    QSet<QString> modifiedRomDirectories;
   
     int listViewSortSection = 0;
     int listViewSortOrder = 0;
@@ -96,21 +119,23 @@ class RomBrowserWidget : public QStackedWidget
 
     QString coversDirectory;
 
-    QStandardItemModel* getCurrentModel(void);
-    QAbstractItemView*  getCurrentModelView(void);
+    Widget::RomBrowserCoverLoader* coverLoader = nullptr;
+
+    QAbstractItemView* getCurrentModelView(void);
     bool getCurrentData(RomBrowserModelData& data);
 
     QString getCurrentRom(void);
 
-    void addRomData(QString file, CoreRomType type, CoreRomHeader header, CoreRomSettings settings);
+    void searchChangedRoms(bool modifiedDirectoriesOnly);
 
-    QIcon getCurrentCover(QString file, CoreRomHeader header, CoreRomSettings settings, QString& coverFileName);
+    QSize getCoverThumbnailSize(QSize iconSize);
 
   protected:
     void timerEvent(QTimerEvent *event) Q_DECL_OVERRIDE;
 
   private slots:
     void on_DoubleClicked(const QModelIndex& index);
+    void on_currentChanged(const QModelIndex& current, const QModelIndex& previous);
     void customContextMenuRequested(QPoint position);
     void generateColumnsMenu(void);
     void generatePlayWithDiskMenu(void);
@@ -127,8 +152,15 @@ class RomBrowserWidget : public QStackedWidget
     void on_ZoomOut(void);
 
     void on_RomBrowserThread_RomsFound(QList<RomSearcherThreadData> data, int index, int count);
+    void on_RomBrowserThread_RomsRemoved(QStringList files);
+    void on_RomBrowserThread_DirectoriesFound(QStringList directories);
     void on_RomBrowserThread_Finished(bool canceled);
 
+    void on_RomDirectoryWatcher_directoryChanged(const QString& directory);
+    void on_RomDirectoryChangedTimer_timeout(void);
+    void on_RomDirectoryPollTimer_timeout(void);
+    void on_RomPrefetchTimer_timeout(void);
+
     void on_Action_PlayGame(void);
     void on_Action_PlayGameWith(void);
     void on_Menu_PlayGameWithDisk(QAction* action);
@@ -28,6 +28,8 @@
 #endif
 
 #include <RMG-Core/Directories.hpp>
+#include <RMG-Core/Error.hpp>
+#include <RMG-Core/Movie.hpp>
 #include <RMG-Core/Version.hpp>
 
 //
@@ -222,6 +224,10 @@ int main(int argc, char **argv)
     QCommandLineOption quitAfterEmulationOption({"q", "quit-after-emulation"}, "Quits RMG when emulation has finished");
     QCommandLineOption loadStateSlot("load-state-slot", "Loads save state slot when launching the ROM", "Slot Number");
     QCommandLineOption diskOption("disk", "64DD Disk to open ROM in combination with", "64DD Disk");
+    QCommandLineOption recordMovieOption("record-movie", "Records the inputs from power-on into a movie file", "Movie");
+    QCommandLineOption playMovieOption("play-movie", "Plays back the inputs of a movie file", "Movie");
+    QCommandLineOption movieChecksumsOption("movie-checksums", "Writes the state checksums of every frame of the movie to a file", "File");
+    QCommandLineOption benchmarkOption("benchmark", "Plays back the movie as fast as possible and prints the frames per second, implies --nogui and --quit-after-emulation");
 
 #ifndef PORTABLE_INSTALL
     parser.addOption(libPathOption);
@@ -235,6 +241,10 @@ int main(int argc, char **argv)
     parser.addOption(quitAfterEmulationOption);
     parser.addOption(loadStateSlot);
     parser.addOption(diskOption);
+    parser.addOption(recordMovieOption);
+    parser.addOption(playMovieOption);
+    parser.addOption(movieChecksumsOption);
+    parser.addOption(benchmarkOption);
     parser.addPositionalArgument("ROM", "ROM to open");
 
     // parse arguments
@@ -273,14 +283,41 @@ int main(int argc, char **argv)
     CoreAddCallbackMessage(CoreDebugMessageType::Info, 
             "Initializing on " + QGuiApplication::platformName().toStdString());
 
+    // benchmarks replay a movie without any user interaction
+    bool benchmark = parser.isSet(benchmarkOption);
+    if (benchmark && (args.empty() || !parser.isSet(playMovieOption)))
+    {
+        std::cerr << "--benchmark requires a ROM and --play-movie" << std::endl;
+        return 1;
+    }
+
     // initialize window
-    if (!window.Init(&app, !parser.isSet(noGuiOption), !args.empty()))
+    if (!window.Init(&app, !benchmark && !parser.isSet(noGuiOption), !args.empty()))
     {
         return 1;
     }
 
     if (!args.empty())
     {
+        bool movie = true;
+        if (parser.isSet(movieChecksumsOption))
+        {
+            movie = CoreSetMovieChecksumFile(parser.value(movieChecksumsOption).toStdU32String());
+        }
+        if (movie && parser.isSet(playMovieOption))
+        {
+            movie = CoreStartMoviePlayback(parser.value(playMovieOption).toStdU32String(), benchmark);
+        }
+        else if (movie && parser.isSet(recordMovieOption))
+        {
+            movie = CoreStartMovieRecording(parser.value(recordMovieOption).toStdU32String(), false);
+        }
+        if (!movie)
+        {
+            std::cerr << CoreGetError() << std::endl;
+            return 1;
+        }
+
         bool parsedNumber = false;
         int saveStateSlot = parser.value(loadStateSlot).toInt(&parsedNumber);
         if (parser.value(loadStateSlot).isEmpty() || !parsedNumber ||
@@ -289,11 +326,35 @@ int main(int argc, char **argv)
             saveStateSlot = -1;
         }
 
-        window.OpenROM(args.at(0), parser.value(diskOption), parser.isSet(fullscreenOption), parser.isSet(quitAfterEmulationOption), saveStateSlot);
+        window.OpenROM(args.at(0), parser.value(diskOption), parser.isSet(fullscreenOption), 
+                       benchmark || parser.isSet(quitAfterEmulationOption), saveStateSlot);
     }
 
     // show window
     window.show();
 
-    return app.exec();
+    int ret = app.exec();
+
+    if (benchmark)
+    {
+        CoreMovieStatistics statistics;
+        CoreGetMovieStatistics(statistics);
+
+        std::cout << "frames: " << statistics.Frames << "/" << statistics.TotalFrames << std::endl;
+        std::cout << "seconds: " << statistics.Seconds << std::endl;
+        std::cout << "fps: " << statistics.FramesPerSecond << std::endl;
+        if (statistics.DesyncFrame != -1)
+        {
+            std::cout << "desync: frame " << statistics.DesyncFrame << std::endl;
+        }
+
+        // an incomplete or desynchronized
+        // playback is a failed benchmark
+        if (ret == 0 && (statistics.Frames != statistics.TotalFrames || statistics.DesyncFrame != -1))
+        {
+            ret = 1;
+        }
+    }
+
+    return ret;
 }